@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <duktape.h>
+
+#include "dukdemo/util/deleters.h"
+
+#include "Harness.h"
+
+
+namespace dukdemo {
+namespace bench {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+void
+Registry::add(std::string name, SetupFn setup)
+{
+	m_benchmarks.push_back(Benchmark{std::move(name), std::move(setup)});
+}
+
+
+double
+timeBatch(BatchFn const& batch, std::size_t iterations)
+{
+	auto const start = Clock::now();
+	batch(iterations);
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+
+Result
+runBenchmark(Benchmark const& benchmark, Options const& options)
+{
+	constexpr double nsPerSecond = 1e9;
+	constexpr std::size_t maxIterations = std::size_t(1u) << 30u;
+
+	auto const batch = benchmark.setup();
+
+	// Grow the batch until it runs for long enough to time reliably.
+	std::size_t iterations = 1u;
+	while (
+		iterations < maxIterations &&
+		timeBatch(batch, iterations) < options.minBatchSeconds
+	)
+	{
+		iterations *= 2u;
+	}
+
+	std::vector<double> nsPerOp;
+	nsPerOp.reserve(options.repetitions);
+	for (unsigned i = 0u; i < std::max(options.repetitions, 1u); ++i)
+	{
+		nsPerOp.push_back(
+			timeBatch(batch, iterations) * nsPerSecond / double(iterations));
+	}
+	std::sort(nsPerOp.begin(), nsPerOp.end());
+
+	Result result;
+	result.name = benchmark.name;
+	result.iterations = iterations;
+	result.nsPerOp = nsPerOp[nsPerOp.size() / 2u];
+	result.minNsPerOp = nsPerOp.front();
+	return result;
+}
+
+
+std::vector<Result>
+run(Registry const& registry, Options const& options, std::ostream& progress)
+{
+	std::vector<Result> results;
+	for (auto const& benchmark: registry.benchmarks())
+	{
+		if (benchmark.name.find(options.filter) == std::string::npos)
+		{
+			continue;
+		}
+		progress << benchmark.name << std::endl;
+		results.push_back(runBenchmark(benchmark, options));
+	}
+	return results;
+}
+
+
+void
+writeText(std::ostream& out, std::vector<Result> const& results)
+{
+	std::size_t width = 4u;
+	for (auto const& result: results)
+	{
+		width = std::max(width, result.name.size());
+	}
+
+	out << std::left << std::setw(int(width)) << "name"
+		<< std::right << std::setw(14) << "ns/op"
+		<< std::setw(14) << "min ns/op"
+		<< std::setw(12) << "iterations" << '\n';
+	out << std::fixed << std::setprecision(1);
+	for (auto const& result: results)
+	{
+		out << std::left << std::setw(int(width)) << result.name
+			<< std::right << std::setw(14) << result.nsPerOp
+			<< std::setw(14) << result.minNsPerOp
+			<< std::setw(12) << result.iterations << '\n';
+	}
+}
+
+
+/** Write a string as a JSON string literal. */
+void
+writeJsonString(std::ostream& out, std::string const& str)
+{
+	out << '"';
+	for (char const c: str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out << '\\';
+		}
+		out << c;
+	}
+	out << '"';
+}
+
+
+void
+writeJson(std::ostream& out, std::vector<Result> const& results)
+{
+	out << "{\n\t\"benchmarks\": [";
+	out << std::setprecision(6);
+	char const* pSeparator = "\n";
+	for (auto const& result: results)
+	{
+		out << pSeparator << "\t\t{\"name\": ";
+		writeJsonString(out, result.name);
+		out << ", \"iterations\": " << result.iterations
+			<< ", \"ns_per_op\": " << result.nsPerOp
+			<< ", \"min_ns_per_op\": " << result.minNsPerOp << '}';
+		pSeparator = ",\n";
+	}
+	out << "\n\t]\n}\n";
+}
+
+
+void
+writeCsv(std::ostream& out, std::vector<Result> const& results)
+{
+	out << "name,iterations,ns_per_op,min_ns_per_op\n";
+	out << std::setprecision(6);
+	for (auto const& result: results)
+	{
+		// Benchmark names never contain commas or quotes.
+		out << result.name << ',' << result.iterations << ','
+			<< result.nsPerOp << ',' << result.minNsPerOp << '\n';
+	}
+}
+
+
+duk_ret_t
+decodeJson(duk_context* pContext, void*)
+{
+	duk_json_decode(pContext, -1);
+	return 1;
+}
+
+
+double
+getNumberProp(duk_context* pContext, duk_idx_t objIdx, char const* pName)
+{
+	duk_get_prop_string(pContext, objIdx, pName);
+	if (!duk_is_number(pContext, -1))
+	{
+		throw std::runtime_error{
+			std::string{"Baseline entry has no numeric "} + pName};
+	}
+	auto const value = duk_get_number(pContext, -1);
+	duk_pop(pContext);
+	return value;
+}
+
+
+std::vector<Result>
+readJson(std::string const& json)
+{
+	std::unique_ptr<duk_context, util::DukContextDeleter> pContext{
+		duk_create_heap_default()};
+	auto* const pCtx = pContext.get();
+	if (!pCtx)
+	{
+		throw std::runtime_error{"Failed to create duktape context"};
+	}
+
+	duk_push_lstring(pCtx, json.data(), json.size());
+	if (duk_safe_call(pCtx, decodeJson, nullptr, 1, 1) != DUK_EXEC_SUCCESS)
+	{
+		throw std::runtime_error{duk_safe_to_string(pCtx, -1)};
+	}
+
+	if (!duk_is_object(pCtx, -1) ||
+			!duk_get_prop_string(pCtx, -1, "benchmarks") ||
+			!duk_is_array(pCtx, -1))
+	{
+		throw std::runtime_error{"Baseline has no benchmarks array"};
+	}
+
+	auto const count = duk_get_length(pCtx, -1);
+	std::vector<Result> results(count);
+	for (duk_size_t i = 0u; i < count; ++i)
+	{
+		duk_get_prop_index(pCtx, -1, duk_uarridx_t(i));
+		auto const entryIdx = duk_normalize_index(pCtx, -1);
+		if (!duk_get_prop_string(pCtx, entryIdx, "name") ||
+				!duk_is_string(pCtx, -1))
+		{
+			throw std::runtime_error{"Baseline entry has no name"};
+		}
+		auto& result = results[i];
+		result.name = duk_get_string(pCtx, -1);
+		duk_pop(pCtx);
+		result.iterations =
+			std::size_t(getNumberProp(pCtx, entryIdx, "iterations"));
+		result.nsPerOp = getNumberProp(pCtx, entryIdx, "ns_per_op");
+		result.minNsPerOp = getNumberProp(pCtx, entryIdx, "min_ns_per_op");
+		duk_pop(pCtx);
+	}
+	return results;
+}
+
+
+std::size_t
+compare(
+	std::ostream& out,
+	std::vector<Result> const& baseline,
+	std::vector<Result> const& current,
+	double threshold
+)
+{
+	std::unordered_map<std::string, Result const*> baselineByName;
+	std::size_t width = 4u;
+	for (auto const& result: baseline)
+	{
+		baselineByName.emplace(result.name, &result);
+		width = std::max(width, result.name.size());
+	}
+	for (auto const& result: current)
+	{
+		width = std::max(width, result.name.size());
+	}
+
+	out << std::left << std::setw(int(width)) << "name"
+		<< std::right << std::setw(14) << "base ns/op"
+		<< std::setw(14) << "ns/op"
+		<< std::setw(10) << "change" << '\n';
+	out << std::fixed << std::setprecision(1);
+
+	std::size_t regressions = 0u;
+	for (auto const& result: current)
+	{
+		out << std::left << std::setw(int(width)) << result.name << std::right;
+		auto const found = baselineByName.find(result.name);
+		if (found == baselineByName.end())
+		{
+			out << std::setw(14) << '-' << std::setw(14) << result.nsPerOp
+				<< "       new\n";
+			continue;
+		}
+
+		auto const base = found->second->nsPerOp;
+		auto const change = base > 0.0 ? result.nsPerOp / base - 1.0 : 0.0;
+		out << std::setw(14) << base << std::setw(14) << result.nsPerOp
+			<< std::setw(9) << std::showpos << change * 100.0 << '%'
+			<< std::noshowpos;
+		if (change > threshold)
+		{
+			out << "  REGRESSION";
+			++regressions;
+		}
+		out << '\n';
+		baselineByName.erase(found);
+	}
+
+	for (auto const& missing: baselineByName)
+	{
+		out << std::left << std::setw(int(width)) << missing.first
+			<< std::right << std::setw(14) << missing.second->nsPerOp
+			<< std::setw(14) << '-' << "   missing\n";
+	}
+	return regressions;
+}
+
+
+} // namespace bench
+} // namespace dukdemo
@@ -0,0 +1,144 @@
+#ifndef DUKDEMO_BENCH__HARNESS__H
+#define DUKDEMO_BENCH__HARNESS__H
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+namespace dukdemo {
+namespace bench {
+
+
+/**
+ * Run a benchmark body a number of times.
+ *
+ * The whole call is timed, so per-iteration set up should be kept out of it.
+ */
+using BatchFn = std::function<void(std::size_t iterations)>;
+
+
+/**
+ * Prepare a benchmark, returning the body to time.
+ *
+ * Any state the body needs should be owned by the returned function object,
+ * and is destroyed once the benchmark has finished.
+ */
+using SetupFn = std::function<BatchFn()>;
+
+
+struct Benchmark
+{
+	std::string name{};
+	SetupFn setup{};
+};
+
+
+/** The timings for a single benchmark. */
+struct Result
+{
+	std::string name{};
+
+	/** The number of iterations in each timed batch. */
+	std::size_t iterations = 0u;
+
+	/** The median time per iteration over all batches, in nanoseconds. */
+	double nsPerOp = 0.0;
+
+	/** The fastest time per iteration over all batches, in nanoseconds. */
+	double minNsPerOp = 0.0;
+};
+
+
+struct Options
+{
+	/** The minimum wall-clock time for each timed batch. */
+	double minBatchSeconds = 0.05;
+
+	/** The number of timed batches per benchmark. */
+	unsigned repetitions = 5u;
+
+	/** Only run benchmarks whose names contain this string. */
+	std::string filter{};
+};
+
+
+class Registry
+{
+public:
+	void
+	add(std::string name, SetupFn setup);
+
+	inline std::vector<Benchmark> const&
+	benchmarks() const noexcept
+	{ return m_benchmarks; }
+
+private:
+	std::vector<Benchmark> m_benchmarks{};
+};
+
+
+/**
+ * Run each registered benchmark matching the filter.
+ *
+ * @param registry the benchmarks.
+ * @param options the batch sizes and filter.
+ * @param progress a stream to log each benchmark's name to as it runs.
+ */
+std::vector<Result>
+run(Registry const& registry, Options const& options, std::ostream& progress);
+
+
+void
+writeText(std::ostream& out, std::vector<Result> const& results);
+
+
+void
+writeJson(std::ostream& out, std::vector<Result> const& results);
+
+
+void
+writeCsv(std::ostream& out, std::vector<Result> const& results);
+
+
+/**
+ * Read results previously written by @ref writeJson.
+ *
+ * @throws std::runtime_error if the JSON is malformed.
+ */
+std::vector<Result>
+readJson(std::string const& json);
+
+
+/**
+ * Compare results against a baseline, writing a report.
+ *
+ * @param out the stream to write the report to.
+ * @param baseline the saved results.
+ * @param current the new results.
+ * @param threshold the relative slowdown, e.g. 0.1 for 10%, above which a
+ * benchmark counts as a regression.
+ * @returns the number of regressions.
+ */
+std::size_t
+compare(
+	std::ostream& out,
+	std::vector<Result> const& baseline,
+	std::vector<Result> const& current,
+	double threshold
+);
+
+
+/** Stop the compiler optimising away a benchmarked computation. */
+template <typename T>
+inline void
+doNotOptimize(T const& value) noexcept
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+} // namespace bench
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_BENCH__HARNESS__H
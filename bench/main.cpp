@@ -0,0 +1,239 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <easylogging++.h>
+
+#include "Harness.h"
+#include "scene.h"
+#include "scripting.h"
+
+
+constexpr char const* const pUsage =
+	"Usage: dukdemo-bench [--filter STR] [--min-time SECONDS] "
+	"[--repetitions N]\n"
+	"                     [--format text|json|csv] [--out FILE]\n"
+	"                     [--baseline FILE.json] [--threshold PERCENT]\n"
+	"\n"
+	"Runs the binding micro-benchmarks. With --baseline, compares against\n"
+	"results saved with --format json and exits with status 1 if any\n"
+	"benchmark is more than --threshold percent (default 10) slower.\n";
+
+
+INITIALIZE_EASYLOGGINGPP
+
+
+struct Arguments
+{
+	dukdemo::bench::Options options{};
+	std::string format{"text"};
+	std::string outPath{};
+	std::string baselinePath{};
+	double threshold = 0.1;
+};
+
+
+/**
+ * Parse an option's value as a real number. Malformed and out of range
+ * values, or trailing characters, are usage errors.
+ */
+static double
+parseDouble(char const* pValue)
+{
+	std::size_t length = 0u;
+	try
+	{
+		double const value = std::stod(pValue, &length);
+		if (pValue[length] == '\0')
+		{
+			return value;
+		}
+	}
+	catch (std::logic_error const&)
+	{
+	}
+	throw std::invalid_argument{pUsage};
+}
+
+
+/**
+ * Parse an option's value as a count, like @ref parseDouble. `std::stoul`
+ * negates values with a minus sign, so those are rejected too.
+ */
+static unsigned
+parseCount(char const* pValue)
+{
+	std::size_t length = 0u;
+	try
+	{
+		unsigned long const value = std::stoul(pValue, &length);
+		bool const valid =
+			pValue[length] == '\0' &&
+			!std::strchr(pValue, '-') &&
+			value <= std::numeric_limits<unsigned>::max();
+		if (valid)
+		{
+			return unsigned(value);
+		}
+	}
+	catch (std::logic_error const&)
+	{
+	}
+	throw std::invalid_argument{pUsage};
+}
+
+
+Arguments
+parseArguments(int argc, char const* const argv[])
+{
+	Arguments args;
+	for (int i = 1; i < argc; ++i)
+	{
+		char const* const pArg = argv[i];
+		if (i + 1 >= argc)
+		{
+			throw std::invalid_argument{pUsage};
+		}
+		char const* const pValue = argv[++i];
+
+		if (std::strcmp(pArg, "--filter") == 0)
+		{
+			args.options.filter = pValue;
+		}
+		else if (std::strcmp(pArg, "--min-time") == 0)
+		{
+			args.options.minBatchSeconds = parseDouble(pValue);
+		}
+		else if (std::strcmp(pArg, "--repetitions") == 0)
+		{
+			args.options.repetitions = parseCount(pValue);
+		}
+		else if (std::strcmp(pArg, "--format") == 0)
+		{
+			args.format = pValue;
+		}
+		else if (std::strcmp(pArg, "--out") == 0)
+		{
+			args.outPath = pValue;
+		}
+		else if (std::strcmp(pArg, "--baseline") == 0)
+		{
+			args.baselinePath = pValue;
+		}
+		else if (std::strcmp(pArg, "--threshold") == 0)
+		{
+			args.threshold = parseDouble(pValue) / 100.0;
+		}
+		else
+		{
+			throw std::invalid_argument{pUsage};
+		}
+	}
+
+	if (args.format != "text" && args.format != "json" && args.format != "csv")
+	{
+		throw std::invalid_argument{pUsage};
+	}
+	return args;
+}
+
+
+std::string
+readFile(std::string const& path)
+{
+	std::ifstream file{path, std::ios::in | std::ios::binary};
+	if (!file)
+	{
+		throw std::runtime_error{"Unable to open " + path};
+	}
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+
+void
+writeResults(
+	std::ostream& out,
+	std::string const& format,
+	std::vector<dukdemo::bench::Result> const& results
+)
+{
+	if (format == "json")
+	{
+		dukdemo::bench::writeJson(out, results);
+	}
+	else if (format == "csv")
+	{
+		dukdemo::bench::writeCsv(out, results);
+	}
+	else
+	{
+		dukdemo::bench::writeText(out, results);
+	}
+}
+
+
+int
+runBenchmarks(Arguments const& args)
+{
+	// Read the baseline first, so a bad path fails before a long run.
+	std::vector<dukdemo::bench::Result> baseline;
+	if (!args.baselinePath.empty())
+	{
+		baseline = dukdemo::bench::readJson(readFile(args.baselinePath));
+	}
+
+	dukdemo::bench::Registry registry;
+	dukdemo::bench::registerScriptingBenchmarks(registry);
+	dukdemo::bench::registerSceneBenchmarks(registry);
+	auto const results = dukdemo::bench::run(registry, args.options, std::cerr);
+
+	if (args.outPath.empty())
+	{
+		writeResults(std::cout, args.format, results);
+	}
+	else
+	{
+		std::ofstream out{args.outPath};
+		if (!out)
+		{
+			throw std::runtime_error{"Unable to write " + args.outPath};
+		}
+		writeResults(out, args.format, results);
+	}
+
+	if (baseline.empty())
+	{
+		return 0;
+	}
+
+	// Keep the comparison readable when results go to stdout as JSON/CSV.
+	auto& reportOut = args.outPath.empty() ? std::cerr : std::cout;
+	auto const regressions =
+		dukdemo::bench::compare(reportOut, baseline, results, args.threshold);
+	return regressions == 0u ? 0 : 1;
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	try
+	{
+		return runBenchmarks(parseArguments(argc, argv));
+	}
+	catch (std::invalid_argument const& err)
+	{
+		std::cerr << err.what();
+		return 2;
+	}
+	catch (std::exception const& err)
+	{
+		LOG(ERROR) << err.what();
+		return 1;
+	}
+}
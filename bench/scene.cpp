@@ -0,0 +1,266 @@
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Box2D/Dynamics/b2World.h>
+
+#include <duktape.h>
+
+#include "dukdemo/util/deleters.h"
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/JsonScene.h"
+#include "dukdemo/scene/WorldState.h"
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/Prefab.h"
+
+#include "Harness.h"
+#include "scene.h"
+
+
+namespace dukdemo {
+namespace bench {
+
+
+namespace ds = dukdemo::scripting;
+
+
+/** Numbers of bodies in generated scenes. */
+constexpr unsigned sceneSizes[] = {100u, 1000u};
+
+
+/** A JSON scene of a static chain floor and `count` mixed dynamic bodies. */
+std::string
+sceneJson(unsigned count)
+{
+	std::string json{
+		"{\"name\": \"bench\", \"bodies\": [\n"
+		"{\"type\": \"static\", \"fixtures\": [{\"friction\": 0.6, \"shape\": "
+		"{\"type\": \"chain\", \"vertices\": "
+		"[[-50, 0], [-25, -2], [0, 0], [25, -2], [50, 0]]}}]}"
+	};
+	for (unsigned i = 0u; i < count; ++i)
+	{
+		auto const x = std::to_string(int(i % 100u) - 50);
+		auto const y = std::to_string(1u + i / 100u);
+		json += ",\n{\"type\": \"dynamic\", \"position\": [" + x + ", " + y +
+			"], \"angle\": 0.25, \"fixtures\": [{\"density\": 1.5, "
+			"\"restitution\": 0.2, \"shape\": ";
+		json += i % 2u == 0u
+			? "{\"type\": \"circle\", \"radius\": 0.5, \"position\": [0, 0]}"
+			: "{\"type\": \"polygon\", \"vertices\": "
+			"[[-0.5, -0.5], [0.5, -0.5], [0.5, 0.5], [-0.5, 0.5]]}";
+		json += "}]}";
+	}
+	return json + "\n]}";
+}
+
+
+/** A heap set up as the demo's are, with no bindings. */
+class Heap
+{
+public:
+	Heap()
+		:	m_enumNameCache{}
+		,	m_heapState{}
+		,	m_pContext{}
+	{
+		m_heapState.pEnumNameCache = &m_enumNameCache;
+		m_pContext.reset(ds::createHeap(&m_heapState));
+		if (!m_pContext)
+		{
+			throw std::runtime_error{"Failed to create duktape context"};
+		}
+	}
+
+	inline duk_context*
+	context() const noexcept
+	{ return m_pContext.get(); }
+
+private:
+	ds::EnumNameCache m_enumNameCache;
+	ds::HeapState m_heapState;
+	std::unique_ptr<duk_context, util::DukContextDeleter> m_pContext;
+};
+
+
+/** Decode a scene with `JSON.parse`, then load each body as a prefab. */
+SetupFn
+duktapeSceneBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		auto const pHeap = std::make_shared<Heap>();
+		auto const json = sceneJson(count);
+		return [pHeap, json](std::size_t iterations) {
+			auto* const pCtx = pHeap->context();
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				duk_push_lstring(pCtx, json.data(), json.size());
+				duk_json_decode(pCtx, -1);
+				duk_get_prop_string(pCtx, -1, "bodies");
+				auto const length = duk_get_length(pCtx, -1);
+				for (duk_size_t j = 0u; j < length; ++j)
+				{
+					duk_get_prop_index(pCtx, -1, duk_uarridx_t(j));
+					ds::Prefab prefab;
+					doNotOptimize(ds::loadPrefab(pCtx, -1, &prefab));
+					doNotOptimize(&prefab);
+					duk_pop(pCtx);
+				}
+				duk_pop_2(pCtx);
+			}
+		};
+	};
+}
+
+
+/** Parse a scene natively, from the same JSON. */
+SetupFn
+nativeSceneBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		auto const json = sceneJson(count);
+		return [json](std::size_t iterations) {
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				std::istringstream in{json};
+				doNotOptimize(scene::parseJsonScene(
+					in,
+					[](ds::Prefab const& prefab) { doNotOptimize(&prefab); }));
+			}
+		};
+	};
+}
+
+
+/** Create a scene's bodies in a fresh world, from its JSON. */
+SetupFn
+loadJsonSceneBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		auto const json = sceneJson(count);
+		return [json](std::size_t iterations) {
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				b2World world{b2Vec2{0.0f, -9.8f}};
+				std::istringstream in{json};
+				doNotOptimize(scene::loadJsonScene(in, world));
+			}
+		};
+	};
+}
+
+
+/** Create a scene's bodies in a fresh world, from its binary form. */
+SetupFn
+loadBinarySceneBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		std::istringstream json{sceneJson(count)};
+		std::ostringstream out;
+		if (!scene::convertJsonScene(json, out))
+		{
+			throw std::runtime_error{"Invalid benchmark scene"};
+		}
+
+		// Keep the scene aligned, as it would be when mapped.
+		auto const bytes = out.str();
+		std::vector<std::uint32_t> words(bytes.size() / sizeof(std::uint32_t));
+		std::memcpy(words.data(), bytes.data(), bytes.size());
+		return [words, size = bytes.size()](std::size_t iterations) {
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				b2World world{b2Vec2{0.0f, -9.8f}};
+				doNotOptimize(
+					scene::loadBinaryScene(words.data(), size, world));
+			}
+		};
+	};
+}
+
+
+/** A world holding a scene, stepped until its bodies have settled. */
+std::shared_ptr<b2World>
+settledWorld(unsigned count)
+{
+	auto pWorld = std::make_shared<b2World>(b2Vec2{0.0f, -9.8f});
+	std::istringstream json{sceneJson(count)};
+	if (!scene::loadJsonScene(json, *pWorld))
+	{
+		throw std::runtime_error{"Invalid benchmark scene"};
+	}
+	for (int i = 0; i < 60; ++i)
+	{
+		pWorld->Step(1.0f / 60.0f, 8, 3);
+	}
+	return pWorld;
+}
+
+
+/** Capture a world's state into a reused buffer. */
+SetupFn
+saveWorldStateBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		auto const pWorld = settledWorld(count);
+		auto const pIds = std::make_shared<scene::BodySerials>();
+		auto const pState = std::make_shared<std::vector<unsigned char>>();
+		return [pWorld, pIds, pState](std::size_t iterations) {
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				scene::saveWorldState(*pWorld, *pIds, *pState);
+				doNotOptimize(pState->data());
+			}
+		};
+	};
+}
+
+
+/** Restore a world to its own state, reusing every body and fixture. */
+SetupFn
+restoreWorldStateBenchmark(unsigned count)
+{
+	return [count]() -> BatchFn {
+		auto const pWorld = settledWorld(count);
+		auto const pIds = std::make_shared<scene::BodySerials>();
+		auto const pState = std::make_shared<std::vector<unsigned char>>();
+		scene::saveWorldState(*pWorld, *pIds, *pState);
+		return [pWorld, pIds, pState](std::size_t iterations) {
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				doNotOptimize(
+					scene::restoreWorldState(
+						*pWorld, pState->data(), pState->size(), *pIds));
+			}
+		};
+	};
+}
+
+
+void
+registerSceneBenchmarks(Registry& registry)
+{
+	for (unsigned const count: sceneSizes)
+	{
+		auto const suffix = "/" + std::to_string(count);
+		registry.add(
+			"parseJsonScene/duktape" + suffix, duktapeSceneBenchmark(count));
+		registry.add(
+			"parseJsonScene/native" + suffix, nativeSceneBenchmark(count));
+		registry.add("loadScene/json" + suffix, loadJsonSceneBenchmark(count));
+		registry.add(
+			"loadScene/binary" + suffix, loadBinarySceneBenchmark(count));
+		registry.add(
+			"saveWorldState" + suffix, saveWorldStateBenchmark(count));
+		registry.add(
+			"restoreWorldState" + suffix, restoreWorldStateBenchmark(count));
+	}
+}
+
+
+} // namespace bench
+} // namespace dukdemo
@@ -0,0 +1,19 @@
+#ifndef DUKDEMO_BENCH__SCENE__H
+#define DUKDEMO_BENCH__SCENE__H
+
+
+namespace dukdemo {
+namespace bench {
+
+
+class Registry;
+
+
+/** Register benchmarks for loading scenes and saving world states. */
+void
+registerSceneBenchmarks(Registry& registry);
+
+
+} // namespace bench
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_BENCH__SCENE__H
@@ -0,0 +1,372 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include <duktape.h>
+
+#include "dukdemo/util/deleters.h"
+#include "dukdemo/scripting/util.h"
+#include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/World.h"
+
+#include "Harness.h"
+#include "scripting.h"
+
+
+namespace dukdemo {
+namespace bench {
+
+
+namespace ds = dukdemo::scripting;
+
+
+constexpr char const* const pMinimalBodyDef = "({})";
+constexpr char const* const pSparseBodyDef =
+	"({type: 'dynamic', position: [1, 2]})";
+constexpr char const* const pFullBodyDef = R"JS(({
+	type: 2,
+	position: [1, 2],
+	angle: 3.21,
+	linearVelocity: [8, 9],
+	angularVelocity: 1.2345,
+	linearDamping: 0.0123,
+	angularDamping: 1.4,
+	allowSleep: false,
+	awake: true,
+	fixedRotation: true,
+	bullet: true,
+	active: true,
+	gravityScale: 10
+}))JS";
+
+
+constexpr char const* const pMinimalFixtureDef = "({})";
+constexpr char const* const pFullFixtureDef = R"JS(({
+	friction: 1.23,
+	restitution: 4.56,
+	density: 7.89,
+	categoryBits: 123,
+	maskBits: 456,
+	groupIndex: 789
+}))JS";
+
+
+/** Sizes for polygon shapes, up to `b2_maxPolygonVertices`. */
+constexpr unsigned polygonSizes[] = {3u, 8u};
+
+
+/** Sizes for chain shapes. */
+constexpr unsigned chainSizes[] = {4u, 64u, 1024u};
+
+
+/**
+ * A heap with the World and Body bindings, a global `world`, and a value to
+ * benchmark against at a fixed value stack index.
+ */
+class Fixture
+{
+public:
+	/**
+	 * @param source a JS expression evaluating to the benchmark's input.
+	 * @param cacheEnumNames whether the heap has an @ref EnumNameCache, as
+	 * the demo's heaps do.
+	 */
+	explicit Fixture(std::string const& source, bool cacheEnumNames = true)
+		:	m_world{b2Vec2{0.0f, -9.8f}}
+		,	m_enumNameCache{}
+		,	m_bodyTable{}
+		,	m_heapState{}
+		,	m_pContext{}
+		,	m_valueIdx{0}
+	{
+		m_heapState.pBodyTable = &m_bodyTable;
+		if (cacheEnumNames)
+		{
+			m_heapState.pEnumNameCache = &m_enumNameCache;
+		}
+		m_pContext.reset(ds::createHeap(&m_heapState));
+		auto* const pCtx = m_pContext.get();
+		if (!pCtx)
+		{
+			throw std::runtime_error{"Failed to create duktape context"};
+		}
+		ds::world::init(pCtx);
+		ds::body::init(pCtx);
+		ds::world::pushWorldWithoutFinalizer(pCtx, &m_world);
+		duk_put_global_string(pCtx, "world");
+
+		if (duk_peval_string(pCtx, source.c_str()) != 0)
+		{
+			throw std::runtime_error{duk_safe_to_string(pCtx, -1)};
+		}
+		m_valueIdx = duk_normalize_index(pCtx, -1);
+	}
+
+	inline duk_context*
+	context() const noexcept
+	{ return m_pContext.get(); }
+
+	/** The value stack index of the benchmark input. */
+	inline duk_idx_t
+	valueIdx() const noexcept
+	{ return m_valueIdx; }
+
+private:
+	// Declared first so that it outlives any body wrappers in the heap.
+	b2World m_world;
+	ds::EnumNameCache m_enumNameCache;
+	ds::BodyTable m_bodyTable;
+	ds::HeapState m_heapState;
+	std::unique_ptr<duk_context, util::DukContextDeleter> m_pContext;
+	duk_idx_t m_valueIdx;
+};
+
+
+/** Benchmark a loader against the JS value produced by `source`. */
+template <typename Result>
+SetupFn
+loaderBenchmark(
+	std::string source,
+	bool (*load)(duk_context*, duk_idx_t, Result*),
+	bool cacheEnumNames = true
+)
+{
+	return [source, load, cacheEnumNames]() -> BatchFn {
+		auto const pFixture =
+			std::make_shared<Fixture>(source, cacheEnumNames);
+		return [pFixture, load](std::size_t iterations) {
+			auto* const pCtx = pFixture->context();
+			auto const idx = pFixture->valueIdx();
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				// Chain shapes can only be created once, so use a fresh result.
+				Result result;
+				doNotOptimize(load(pCtx, idx, &result));
+				doNotOptimize(&result);
+			}
+		};
+	};
+}
+
+
+/** Benchmark calling a JS function of one argument, the iteration count. */
+SetupFn
+scriptBenchmark(std::string source)
+{
+	return [source]() -> BatchFn {
+		auto const pFixture = std::make_shared<Fixture>(source);
+		return [pFixture](std::size_t iterations) {
+			auto* const pCtx = pFixture->context();
+			duk_dup(pCtx, pFixture->valueIdx());
+			duk_push_number(pCtx, double(iterations));
+			if (duk_pcall(pCtx, 1) != 0)
+			{
+				throw std::runtime_error{duk_safe_to_string(pCtx, -1)};
+			}
+			duk_pop(pCtx);
+		};
+	};
+}
+
+
+/**
+ * A JS expression for `count` vertices on a circle, as a nested array or a
+ * flat typed array.
+ */
+std::string
+vertexSource(unsigned count, char const* pTypedArray)
+{
+	std::string source{
+		"(function (n) {"
+		"  var v = [];"
+		"  for (var i = 0; i < n; ++i) {"
+		"    var a = 2 * Math.PI * i / n;"
+		"    v.push([10 * Math.cos(a), 10 * Math.sin(a)]);"
+		"  }"
+	};
+	if (pTypedArray)
+	{
+		source += std::string{"return new "} + pTypedArray +
+			"([].concat.apply([], v));";
+	}
+	else
+	{
+		source += "return v;";
+	}
+	return source + "})(" + std::to_string(count) + ")";
+}
+
+
+/** Call `getPointerFromThis` `iterations` times, with `this` bound. */
+duk_ret_t
+getPointerFromThisLoop(duk_context* pContext)
+{
+	auto const iterations = duk_require_uint(pContext, 0);
+	for (duk_uint_t i = 0u; i < iterations; ++i)
+	{
+		doNotOptimize(ds::getPointerFromThis(pContext, ds::g_ownWorldPtrSym));
+	}
+	return 0;
+}
+
+
+SetupFn
+getPointerFromThisBenchmark()
+{
+	return []() -> BatchFn {
+		auto const pFixture = std::make_shared<Fixture>("world");
+		duk_push_c_function(pFixture->context(), getPointerFromThisLoop, 1);
+		return [pFixture](std::size_t iterations) {
+			auto* const pCtx = pFixture->context();
+			duk_dup(pCtx, -1); // The loop function.
+			duk_dup(pCtx, pFixture->valueIdx()); // The world, as `this`.
+			duk_push_uint(pCtx, duk_uint_t(iterations));
+			duk_call_method(pCtx, 1);
+			duk_pop(pCtx);
+		};
+	};
+}
+
+
+SetupFn
+writeVec2ToArrayBenchmark()
+{
+	return []() -> BatchFn {
+		auto const pFixture = std::make_shared<Fixture>("[0, 0]");
+		return [pFixture](std::size_t iterations) {
+			auto* const pCtx = pFixture->context();
+			auto const idx = pFixture->valueIdx();
+			b2Vec2 vec{1.5f, -2.5f};
+			for (std::size_t i = 0u; i < iterations; ++i)
+			{
+				ds::writeVec2ToArray(pCtx, idx, vec);
+				vec.x += 1.0f;
+			}
+		};
+	};
+}
+
+
+void
+registerScriptingBenchmarks(Registry& registry)
+{
+	registry.add(
+		"loadVec2/array", loaderBenchmark<b2Vec2>("[1.5, -2.5]", ds::loadVec2));
+	registry.add(
+		"loadVec2/Float32Array",
+		loaderBenchmark<b2Vec2>(
+			"new Float32Array([1.5, -2.5])", ds::loadVec2));
+	registry.add(
+		"loadVec2/Float64Array",
+		loaderBenchmark<b2Vec2>(
+			"new Float64Array([1.5, -2.5])", ds::loadVec2));
+
+	registry.add(
+		"loadBodyDef/minimal",
+		loaderBenchmark<b2BodyDef>(pMinimalBodyDef, ds::loadBodyDef));
+	registry.add(
+		"loadBodyDef/sparse",
+		loaderBenchmark<b2BodyDef>(pSparseBodyDef, ds::loadBodyDef));
+	registry.add(
+		"loadBodyDef/type/index",
+		loaderBenchmark<b2BodyDef>("({type: 2})", ds::loadBodyDef));
+	registry.add(
+		"loadBodyDef/type/name",
+		loaderBenchmark<b2BodyDef>("({type: 'dynamic'})", ds::loadBodyDef));
+	registry.add(
+		"loadBodyDef/type/name/uncached",
+		loaderBenchmark<b2BodyDef>(
+			"({type: 'dynamic'})", ds::loadBodyDef, false));
+	registry.add(
+		"loadBodyDef/full",
+		loaderBenchmark<b2BodyDef>(pFullBodyDef, ds::loadBodyDef));
+
+	registry.add(
+		"loadFixtureDefWithoutShape/minimal",
+		loaderBenchmark<b2FixtureDef>(
+			pMinimalFixtureDef, ds::loadFixtureDefWithoutShape));
+	registry.add(
+		"loadFixtureDefWithoutShape/full",
+		loaderBenchmark<b2FixtureDef>(
+			pFullFixtureDef, ds::loadFixtureDefWithoutShape));
+
+	registry.add(
+		"loadCircle",
+		loaderBenchmark<b2CircleShape>(
+			"({radius: 5.4321, position: [1.2345, 6.789]})", ds::loadCircle));
+	registry.add(
+		"loadEdge",
+		loaderBenchmark<b2EdgeShape>(
+			"({prev: [-2, -2], v1: [-1, -1], v2: [1, 1], next: [2, 2]})",
+			ds::loadEdge));
+
+	for (unsigned const count: polygonSizes)
+	{
+		auto const suffix = "/" + std::to_string(count);
+		registry.add(
+			"loadPolygon/array" + suffix,
+			loaderBenchmark<b2PolygonShape>(
+				"({vertices: " + vertexSource(count, nullptr) + "})",
+				ds::loadPolygon));
+		registry.add(
+			"loadPolygon/Float32Array" + suffix,
+			loaderBenchmark<b2PolygonShape>(
+				"({vertices: " + vertexSource(count, "Float32Array") + "})",
+				ds::loadPolygon));
+	}
+
+	for (unsigned const count: chainSizes)
+	{
+		auto const suffix = "/" + std::to_string(count);
+		registry.add(
+			"loadChain/array" + suffix,
+			loaderBenchmark<b2ChainShape>(
+				"({vertices: " + vertexSource(count, nullptr) + "})",
+				ds::loadChain));
+		registry.add(
+			"loadChain/Float32Array" + suffix,
+			loaderBenchmark<b2ChainShape>(
+				"({vertices: " + vertexSource(count, "Float32Array") + "})",
+				ds::loadChain));
+		registry.add(
+			"loadChain/Float64Array" + suffix,
+			loaderBenchmark<b2ChainShape>(
+				"({vertices: " + vertexSource(count, "Float64Array") + "})",
+				ds::loadChain));
+	}
+
+	for (auto const* const pDef: {pMinimalBodyDef, pFullBodyDef})
+	{
+		registry.add(
+			pDef == pMinimalBodyDef
+				? "createDestroyBody/minimal"
+				: "createDestroyBody/full",
+			scriptBenchmark(
+				std::string{"(function (def) {"
+				"  return function (n) {"
+				"    for (var i = 0; i < n; ++i) {"
+				"      world.destroyBody(world.createBody(def));"
+				"    }"
+				"  };"
+				"})"} + pDef));
+	}
+
+	registry.add("getPointerFromThis", getPointerFromThisBenchmark());
+	registry.add("writeVec2ToArray", writeVec2ToArrayBenchmark());
+}
+
+
+} // namespace bench
+} // namespace dukdemo
@@ -0,0 +1,19 @@
+#ifndef DUKDEMO_BENCH__SCRIPTING__H
+#define DUKDEMO_BENCH__SCRIPTING__H
+
+
+namespace dukdemo {
+namespace bench {
+
+
+class Registry;
+
+
+/** Register benchmarks for the loaders and JS bindings. */
+void
+registerScriptingBenchmarks(Registry& registry);
+
+
+} // namespace bench
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_BENCH__SCRIPTING__H
@@ -0,0 +1,206 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__BATCHRENDERER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__RENDER__BATCHRENDERER__H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <Box2D/Common/b2Math.h>
+
+#include "dukdemo/sim/Snapshot.h"
+
+
+struct b2Color;
+
+
+namespace dukdemo {
+
+namespace render {
+
+
+/**
+ * Draws world snapshots with a few instanced draw calls.
+ *
+ * Rather than tessellating every shape on the CPU, each shape becomes one
+ * instance of a shared unit mesh: circles scale a unit circle, rectangular
+ * polygons scale a unit box, and edges and chain segments scale a unit
+ * segment. Other polygons are drawn by their own program, which builds the
+ * triangles from up to eight vertices in the instance data. Each frame only
+ * the per-instance data is uploaded, and each kind of shape is drawn with
+ * one call for its fill and one for its outline.
+ *
+ * Static bodies are kept in separate instance buffers, uploaded only when a
+ * snapshot's static geometry version changes, so per-frame uploads scale
+ * with the number of moving bodies alone.
+ *
+ * Creating a renderer needs a current GL context, which must outlive it.
+ */
+class BatchRenderer
+{
+public:
+	struct Stats
+	{
+		std::size_t circles = 0u;
+		std::size_t boxes = 0u;
+		std::size_t polygons = 0u;
+		std::size_t segments = 0u;
+
+		/** Draw calls made by the latest @ref render. */
+		std::size_t drawCalls = 0u;
+
+		/** Bytes of instance data uploaded by the latest @ref update. */
+		std::size_t uploadedBytes = 0u;
+
+		/** The number of times static geometry has been uploaded. */
+		std::size_t staticUploads = 0u;
+	};
+
+	BatchRenderer();
+
+	BatchRenderer(BatchRenderer const&) = delete;
+	BatchRenderer& operator=(BatchRenderer const&) = delete;
+
+	~BatchRenderer() noexcept;
+
+	/**
+	 * Rebuild and upload the instance data for a snapshot.
+	 *
+	 * @param snapshot the snapshot to draw.
+	 * @param alpha the interpolation factor: 0 before the snapshot's latest
+	 * step, 1 after it.
+	 */
+	void
+	update(sim::Snapshot const& snapshot, float alpha);
+
+	/**
+	 * Draw the instances from the latest @ref update.
+	 *
+	 * @param pMVP the model-view-projection matrix, column major.
+	 */
+	void
+	render(GLfloat const* pMVP);
+
+	inline Stats const&
+	stats() const noexcept
+	{ return m_stats; }
+
+private:
+	/** A program and its uniform locations. */
+	struct Program
+	{
+		GLuint id;
+		GLint mvpLoc;
+		GLint colourScaleLoc;
+		GLint outlineLoc;
+	};
+
+	/** A unit mesh's fill triangles and outline lines. */
+	struct Mesh
+	{
+		GLint fillFirst;
+		GLsizei fillCount;
+		GLint outlineFirst;
+		GLsizei outlineCount;
+	};
+
+	/** Per-instance data for a unit mesh. */
+	struct Instance
+	{
+		/** Translation, then rotation cosine and sine. */
+		GLfloat placement[4];
+		GLfloat scale[2];
+		GLfloat colour[4];
+	};
+
+	/** Per-instance data for a polygon drawn without a mesh. */
+	struct PolygonInstance
+	{
+		GLfloat placement[4];
+		GLfloat colour[4];
+		GLfloat vertices[16];
+		GLfloat vertexCount;
+	};
+
+	/** Instances in a GL buffer, and the vertex array drawing them. */
+	struct InstanceBuffer
+	{
+		GLuint vertexArray;
+		GLuint buffer;
+		GLsizei count;
+	};
+
+	/** Instances of one unit mesh. */
+	struct Batch
+	{
+		Mesh mesh;
+
+		/** Instances collected before upload. */
+		std::vector<Instance> instances;
+
+		InstanceBuffer staticInstances;
+		InstanceBuffer dynamicInstances;
+	};
+
+	/** Get a program's uniform locations. */
+	static Program
+	getProgram(GLuint programID);
+
+	void
+	initBatch(Batch& batch, Mesh const& mesh);
+
+	void
+	initPolygonBuffer(InstanceBuffer& buffer);
+
+	/** Upload the collected instances, replacing a buffer's contents. */
+	void
+	upload(
+		InstanceBuffer& target,
+		void const* pInstances,
+		std::size_t count,
+		std::size_t instanceSize,
+		GLenum usage
+	);
+
+	/** Upload every collected instance to static or dynamic buffers. */
+	void
+	uploadAll(bool isStatic);
+
+	void
+	drawBatch(Batch const& batch);
+
+	/** Collect the instances for some bodies. */
+	void
+	collect(sim::Snapshot::Geometry const& geometry, float alpha);
+
+	/** Add a shape's instance to the appropriate batch. */
+	void
+	addShape(
+		sim::Snapshot::Geometry const& geometry,
+		std::size_t shapeIndex,
+		b2Transform const& xf,
+		b2Color const& colour
+	);
+
+	Program m_instancedProgram;
+	Program m_polygonProgram;
+	GLuint m_meshBuffer;
+
+	Batch m_circles;
+	Batch m_boxes;
+	Batch m_segments;
+
+	std::vector<PolygonInstance> m_polygons;
+	InstanceBuffer m_staticPolygons;
+	InstanceBuffer m_dynamicPolygons;
+
+	/** The version of the uploaded static geometry; zero for none. */
+	std::uint64_t m_staticVersion;
+
+	Stats m_stats;
+};
+
+
+} // namespace render
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__BATCHRENDERER__H
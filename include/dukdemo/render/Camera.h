@@ -0,0 +1,78 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__CAMERA__H
+#define DUKDEMO_INCLUDE__DUKDEMO__RENDER__CAMERA__H
+#include <glm/mat4x4.hpp>
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2Math.h>
+
+
+namespace dukdemo {
+namespace render {
+
+
+/**
+ * An orthographic camera looking down on the world plane.
+ *
+ * Because the projection is orthographic, the visible region is exactly an
+ * axis-aligned box, which can be passed straight to `b2World::QueryAABB`.
+ */
+class Camera
+{
+public:
+	static constexpr float s_minHalfHeight = 0.5f;
+	static constexpr float s_maxHalfHeight = 5000.0f;
+
+	/**
+	 * @param centre the world point at the centre of the view.
+	 * @param halfHeight half the view's height, in world units.
+	 * @param aspectRatio the view's width divided by its height.
+	 */
+	Camera(
+		b2Vec2 const& centre,
+		float halfHeight,
+		float aspectRatio
+	) noexcept;
+
+	inline b2Vec2 const&
+	centre() const noexcept
+	{ return m_centre; }
+
+	inline void
+	setCentre(b2Vec2 const& centre) noexcept
+	{ m_centre = centre; }
+
+	/** Move the view by a fraction of its height. */
+	inline void
+	pan(b2Vec2 const& fraction) noexcept
+	{ m_centre += 2.0f * m_halfHeight * fraction; }
+
+	inline float
+	halfHeight() const noexcept
+	{ return m_halfHeight; }
+
+	/** Scale the view's size; factors below one zoom in. */
+	void
+	zoom(float factor) noexcept;
+
+	/**
+	 * Get the region of the world in view.
+	 *
+	 * @param margin extra world units to include around each edge.
+	 */
+	b2AABB
+	visibleAABB(float margin = 0.0f) const noexcept;
+
+	/** Get the matrix transforming world points to clip space. */
+	glm::mat4
+	viewProjection() const;
+
+private:
+	b2Vec2 m_centre;
+	float m_halfHeight;
+	float m_aspectRatio;
+};
+
+
+} // namespace render
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__CAMERA__H
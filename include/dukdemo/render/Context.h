@@ -1,11 +1,14 @@
 #ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__CONTEXT__H
 #define DUKDEMO_INCLUDE__DUKDEMO__RENDER__CONTEXT__H
+#include <cstddef>
 #include <type_traits>
 #include <memory>
 #include <functional>
 
 #include <SDL2/SDL_video.h>
 
+#include "dukdemo/util/FrameProfiler.h"
+
 
 namespace dukdemo {
 namespace render {
@@ -63,6 +66,12 @@ public:
 		m_onRender = onRender;
 	}
 
+	/**
+	 * Time swapping buffers as the "swap" phase; null to stop. The profiler
+	 * must outlive the context, or be unset first.
+	 */
+	void setProfiler(util::FrameProfiler* pProfiler);
+
 	void render();
 
 	inline SDL_Window* window() noexcept
@@ -83,6 +92,8 @@ public:
 
 private:
 	RenderFn m_onRender;
+	util::FrameProfiler* m_pProfiler;
+	std::size_t m_swapPhase;
 
 	std::unique_ptr<SDL_Window, Deleter> m_pWindow;
 	std::unique_ptr<GLContext, Deleter> m_pGLContext;
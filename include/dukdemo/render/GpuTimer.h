@@ -0,0 +1,107 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__GPUTIMER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__RENDER__GPUTIMER__H
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "dukdemo/util/FrameProfiler.h"
+
+
+namespace dukdemo {
+namespace render {
+
+
+/**
+ * Times phases of a frame on the GPU with `GL_TIME_ELAPSED` queries.
+ *
+ * Queries alternate between two sets, one per frame. Results are read a
+ * frame later, once the GPU has usually finished with them, and any still
+ * pending are dropped rather than waited for, so timing never stalls the
+ * pipeline. Only one phase can be timed at a time.
+ *
+ * Timer queries need OpenGL 3.3 or `ARB_timer_query`; without them, timing
+ * does nothing. Creating a timer needs a current GL context, which must
+ * outlive it.
+ */
+class GpuTimer
+{
+public:
+	/** @param profiler receives the GPU time of each phase. */
+	explicit GpuTimer(util::FrameProfiler& profiler);
+
+	GpuTimer(GpuTimer const&) = delete;
+	GpuTimer& operator=(GpuTimer const&) = delete;
+
+	~GpuTimer() noexcept;
+
+	/** Whether the context supports timer queries. */
+	inline bool
+	supported() const noexcept
+	{ return m_supported; }
+
+	/** Start timing a phase. */
+	void
+	begin(std::size_t phase);
+
+	/** Stop timing the current phase. */
+	void
+	end() noexcept;
+
+	/** Record the previous frame's timings, then start a new frame. */
+	void
+	endFrame();
+
+	/** The number of timings dropped because they weren't ready. */
+	inline std::size_t
+	dropped() const noexcept
+	{ return m_dropped; }
+
+private:
+	struct Query
+	{
+		GLuint id;
+		std::size_t phase;
+	};
+
+	/** Queries issued during one frame. */
+	struct QuerySet
+	{
+		/** Every query created for the set; the first `used` were issued. */
+		std::vector<Query> queries{};
+		std::size_t used = 0u;
+	};
+
+	util::FrameProfiler& m_profiler;
+	bool m_supported;
+	std::array<QuerySet, 2u> m_sets;
+	std::size_t m_current;
+	std::size_t m_dropped;
+};
+
+
+/** Times a phase on the GPU, from construction until destruction. */
+class ScopedGpuTimer
+{
+public:
+	inline
+	ScopedGpuTimer(GpuTimer& timer, std::size_t phase)
+		:	m_timer(timer)
+	{ m_timer.begin(phase); }
+
+	ScopedGpuTimer(ScopedGpuTimer const&) = delete;
+	ScopedGpuTimer& operator=(ScopedGpuTimer const&) = delete;
+
+	inline
+	~ScopedGpuTimer() noexcept
+	{ m_timer.end(); }
+
+private:
+	GpuTimer& m_timer;
+};
+
+
+} // namespace render
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__GPUTIMER__H
@@ -0,0 +1,36 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__DRAW__H
+#define DUKDEMO_INCLUDE__DUKDEMO__RENDER__DRAW__H
+#include "dukdemo/sim/Snapshot.h"
+
+
+class b2Draw;
+struct b2Color;
+
+
+namespace dukdemo {
+namespace render {
+
+
+/** Get the colour `b2World::DrawDebugData` uses for a body. */
+b2Color
+getBodyColour(sim::Snapshot::Body const& body);
+
+
+/**
+ * Draw the shapes in a world snapshot.
+ *
+ * Equivalent to the shapes drawn by `b2World::DrawDebugData`, except that
+ * each body is drawn part way between its poses before and after the
+ * snapshot's latest step.
+ *
+ * @param snapshot the snapshot to draw.
+ * @param draw the debug drawer to draw with.
+ * @param alpha the interpolation factor: 0 before the step, 1 after it.
+ */
+void
+drawSnapshot(sim::Snapshot const& snapshot, b2Draw& draw, float alpha);
+
+
+} // namespace render
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__RENDER__DRAW__H
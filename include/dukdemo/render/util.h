@@ -12,6 +12,36 @@ namespace render {
 GLuint const createProgram();
 
 
+/**
+ * Create a GL program drawing instances of a unit mesh.
+ *
+ * The mesh position is attribute 0. Per-instance attributes are the colour
+ * (1), placement (2: translation, then rotation cosine and sine) and scale
+ * (3). Uniforms are `MVP` and `colourScale`, which multiplies the colour.
+ */
+GLuint const createInstancedProgram();
+
+
+/**
+ * Create a GL program drawing convex polygons of up to eight vertices, one
+ * per instance, without a mesh.
+ *
+ * Per-instance attributes are the colour (1), placement (2), local vertices
+ * (4-7, two per attribute) and vertex count (8). Uniforms are `MVP`,
+ * `colourScale` and `outline`: draw 18 vertices as `GL_TRIANGLES` for the
+ * fill, or 16 as `GL_LINES` with `outline` set.
+ */
+GLuint const createPolygonProgram();
+
+
+/**
+ * Link a vertex and fragment shader into a program.
+ *
+ * @throw std::runtime_error if linking fails.
+ */
+GLuint const linkProgram(GLuint const vertShaderID, GLuint const fragShaderID);
+
+
 /** Get the info log of an OpenGL object. */
 std::string
 getLog(
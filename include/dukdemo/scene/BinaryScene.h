@@ -0,0 +1,256 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__BINARYSCENE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCENE__BINARYSCENE__H
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+
+class b2Body;
+class b2Fixture;
+class b2Shape;
+class b2World;
+struct b2FixtureDef;
+
+
+namespace dukdemo {
+
+
+namespace scripting {
+struct Prefab;
+} // namespace scripting
+
+
+namespace scene {
+
+
+/*
+ * A binary scene is a @ref BinarySceneHeader followed by three flat arrays:
+ * the header's `bodyCount` @ref BinaryBody records, then its `fixtureCount`
+ * @ref BinaryFixture records, then its `vertexCount` vertices, each two
+ * floats. Every field is little-endian, and every record is a multiple of
+ * four bytes, so the arrays can be read in place from a mapped file.
+ *
+ * Bodies own consecutive runs of the fixtures, in order, and fixtures own
+ * consecutive runs of the vertices. A fixture's vertices depend on its shape:
+ *
+ *  - circle: its position;
+ *  - edge: `v0`, `v1`, `v2` and `v3`;
+ *  - polygon: its centroid, then its hull, then the hull's normals;
+ *  - chain: its previous and next vertices, then its vertices. A loop is
+ *    stored as Box2D holds it, closed and with both neighbours set.
+ *
+ * Shapes are stored as Box2D holds them, so loading needs no hull or normal
+ * computation.
+ */
+
+
+/** The first four bytes of a binary scene. */
+constexpr char const g_binarySceneMagic[4] = {'D', 'K', 'S', 'N'};
+
+
+/** Bumped whenever the layout changes; other versions are rejected. */
+constexpr std::uint32_t g_binarySceneVersion = 1u;
+
+
+struct BinarySceneHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t bodyCount;
+	std::uint32_t fixtureCount;
+	std::uint32_t vertexCount;
+	std::uint32_t reserved;
+};
+
+
+struct BinaryBody
+{
+	/** A `b2BodyType`. */
+	std::uint32_t type;
+	float position[2];
+	float angle;
+	float linearVelocity[2];
+	float angularVelocity;
+	float linearDamping;
+	float angularDamping;
+	float gravityScale;
+
+	// Each is 0 or 1.
+	std::uint8_t allowSleep;
+	std::uint8_t awake;
+	std::uint8_t fixedRotation;
+	std::uint8_t bullet;
+	std::uint8_t active;
+	std::uint8_t reserved[3];
+
+	/** The number of fixtures, following the previous body's. */
+	std::uint32_t fixtureCount;
+};
+
+
+struct BinaryFixture
+{
+	/** Bits of @ref flags. */
+	enum Flag : std::uint8_t
+	{
+		/** An edge's `v0` or a chain's previous vertex is set. */
+		HasPrev = 1u << 0u,
+
+		/** An edge's `v3` or a chain's next vertex is set. */
+		HasNext = 1u << 1u,
+
+		IsSensor = 1u << 2u,
+	};
+
+	float friction;
+	float restitution;
+	float density;
+	std::uint16_t categoryBits;
+	std::uint16_t maskBits;
+	std::int16_t groupIndex;
+
+	/** A `b2Shape::Type`. */
+	std::uint8_t shapeType;
+	std::uint8_t flags;
+	float radius;
+
+	/** The number of vertices, following the previous fixture's. */
+	std::uint32_t vertexCount;
+};
+
+
+/** The number of vertices a shape is stored with. */
+std::uint32_t
+binaryVertexCount(b2Shape const& shape) noexcept;
+
+
+/**
+ * Store a fixture as a binary scene does.
+ *
+ * @param def the fixture's properties and shape.
+ * @param pCoords where to write the shape's vertices, with room for
+ * @ref binaryVertexCount of them.
+ * @returns the fixture's record.
+ */
+BinaryFixture
+storeBinaryFixture(b2FixtureDef const& def, float* pCoords) noexcept;
+
+
+/**
+ * Check whether a shape is exactly the one a fixture record stores.
+ *
+ * @param shape the shape.
+ * @param fixture the fixture's record.
+ * @param pCoords the fixture's vertices, of which there must be enough.
+ */
+bool
+matchesBinaryShape(
+	b2Shape const& shape,
+	BinaryFixture const& fixture,
+	float const* pCoords
+) noexcept;
+
+
+/**
+ * Check a stored fixture, and its shape, as strictly as the JSON loaders.
+ *
+ * @param fixture the fixture's record.
+ * @param pCoords the fixture's vertices, of which there must be enough.
+ */
+bool
+validateBinaryFixture(
+	BinaryFixture const& fixture,
+	float const* pCoords
+) noexcept;
+
+
+/**
+ * Create a fixture from a record which has passed
+ * @ref validateBinaryFixture.
+ *
+ * @param pBody the body to add the fixture to.
+ * @param fixture the fixture's record.
+ * @param pCoords the fixture's vertices, aligned to four bytes.
+ */
+b2Fixture*
+createBinaryFixture(
+	b2Body* pBody,
+	BinaryFixture const& fixture,
+	float const* pCoords
+);
+
+
+/** Accumulates bodies, then writes them out as a binary scene. */
+class BinarySceneWriter
+{
+public:
+	BinarySceneWriter();
+
+	/** Add a body and its fixtures, at the prefab's position and angle. */
+	void
+	add(scripting::Prefab const& body);
+
+	/**
+	 * Write the scene.
+	 *
+	 * @returns false iff the stream failed.
+	 */
+	bool
+	write(std::ostream& out) const;
+
+	inline std::size_t
+	bodyCount() const noexcept
+	{ return m_bodies.size(); }
+
+private:
+	std::vector<BinaryBody> m_bodies;
+	std::vector<BinaryFixture> m_fixtures;
+	std::vector<float> m_coords;
+};
+
+
+/**
+ * Convert a JSON scene to a binary scene.
+ *
+ * @param json the JSON; see @ref parseJsonScene.
+ * @param out the stream to write the binary scene to.
+ * @returns false iff the JSON scene is invalid, in which case nothing is
+ * written.
+ * @throws std::runtime_error if the JSON is malformed or writing fails.
+ */
+bool
+convertJsonScene(std::istream& json, std::ostream& out);
+
+
+/**
+ * Create the bodies of a binary scene in a world.
+ *
+ * The whole scene is validated before any body is created, as strictly as
+ * the JSON loaders, and polygons must be convex.
+ *
+ * @param pData the scene, aligned to four bytes.
+ * @param size the size of the scene in bytes.
+ * @param world the world to add bodies to.
+ * @returns false iff the scene is invalid, in which case the world is left
+ * as it was.
+ */
+bool
+loadBinaryScene(void const* pData, std::size_t size, b2World& world);
+
+
+/**
+ * Map a binary scene file and create its bodies in a world.
+ *
+ * @param pPath the file's path.
+ * @param world the world to add bodies to.
+ * @returns false iff the scene is invalid, leaving the world as it was.
+ * @throws std::runtime_error if the file can't be mapped.
+ */
+bool
+loadBinarySceneFile(char const* pPath, b2World& world);
+
+
+} // namespace scene
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__BINARYSCENE__H
@@ -0,0 +1,136 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONREADER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONREADER__H
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+namespace dukdemo {
+namespace scene {
+
+
+/**
+ * Reads JSON from a stream one value at a time, without building a tree.
+ *
+ * The caller walks the document: @ref peek says what the next value is,
+ * containers are entered with @ref beginObject or @ref beginArray and walked
+ * with @ref nextKey or @ref nextElement, and unwanted values are passed over
+ * with @ref skipValue. Only the current string or number is held in memory.
+ *
+ * Malformed JSON throws `std::runtime_error`, giving the byte offset, as does
+ * reading a value as the wrong type.
+ */
+class JsonReader
+{
+public:
+	enum class Type
+	{
+		Object,
+		Array,
+		String,
+		Number,
+		Boolean,
+		Null,
+	};
+
+	/** The deepest nesting of objects and arrays accepted. */
+	static constexpr std::size_t s_maxDepth = 1000u;
+
+	/** @param in the stream to read, which must outlive the reader. */
+	explicit JsonReader(std::istream& in);
+
+	JsonReader(JsonReader const&) = delete;
+	JsonReader& operator=(JsonReader const&) = delete;
+
+	/** Get the type of the next value, without reading it. */
+	Type
+	peek();
+
+	/** Enter an object; then call @ref nextKey until it returns false. */
+	void
+	beginObject();
+
+	/**
+	 * Read the key of the current object's next member.
+	 *
+	 * @param key set to the key. Its value is read next.
+	 * @returns false at the end of the object, which is then left.
+	 */
+	bool
+	nextKey(std::string& key);
+
+	/** Enter an array; then call @ref nextElement until it returns false. */
+	void
+	beginArray();
+
+	/**
+	 * Move to the current array's next element, which is read next.
+	 *
+	 * @returns false at the end of the array, which is then left.
+	 */
+	bool
+	nextElement();
+
+	/** Read a string, decoding escapes into UTF-8. */
+	void
+	readString(std::string& value);
+
+	double
+	readNumber();
+
+	bool
+	readBoolean();
+
+	void
+	readNull();
+
+	/** Read and discard the next value, including any nested values. */
+	void
+	skipValue();
+
+	/** Check that nothing but whitespace follows the document. */
+	void
+	finish();
+
+	/** The number of bytes read so far. */
+	inline std::size_t
+	offset() const noexcept
+	{ return m_offset; }
+
+private:
+	[[noreturn]] void
+	fail(char const* pMessage) const;
+
+	/** Skip whitespace, then peek at the next character; EOF at the end. */
+	int
+	peekToken();
+
+	int
+	get();
+
+	void
+	expect(char c);
+
+	/** Read the separator before a container's next item; false at its end. */
+	bool
+	nextItem(char end);
+
+	/** Read four hex digits of a `\u` escape. */
+	unsigned
+	readHex();
+
+	std::streambuf* m_pBuffer;
+	std::size_t m_offset;
+
+	/** For each open container, whether an item has been read. */
+	std::vector<bool> m_hasItem;
+
+	/** Holds skipped strings and numbers being parsed. */
+	std::string m_scratch;
+};
+
+
+} // namespace scene
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONREADER__H
@@ -0,0 +1,66 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONSCENE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONSCENE__H
+#include <functional>
+#include <iosfwd>
+
+
+class b2World;
+
+
+namespace dukdemo {
+
+
+namespace scripting {
+struct Prefab;
+} // namespace scripting
+
+
+namespace scene {
+
+
+/** Called with each body of a scene as soon as it has been parsed. */
+using BodyCallback = std::function<void(scripting::Prefab const& body)>;
+
+
+/**
+ * Parse a JSON scene from a stream, without building any JS values.
+ *
+ * A scene is an object whose `bodies` array holds prefab definitions (see
+ * @ref scripting::loadPrefab): body definitions with a `fixtures` array of
+ * fixture definitions, each with a `shape`. Other properties are ignored.
+ * Properties are validated exactly as by the Duktape loaders, using the same
+ * schemas, so a scene is valid iff `loadPrefab` would accept each body.
+ *
+ * Bodies are passed on one at a time, so memory use is bounded by the
+ * largest body rather than the scene.
+ *
+ * @note Unlike `JSON.parse`, where a repeated key's last value wins, every
+ * value of a repeated key must be valid.
+ *
+ * @param in the JSON.
+ * @param onBody called with each body, in order.
+ * @returns false iff a body is invalid. Parsing stops there, and bodies
+ * before it have already been passed on.
+ * @throws std::runtime_error if the JSON is malformed.
+ */
+bool
+parseJsonScene(std::istream& in, BodyCallback const& onBody);
+
+
+/**
+ * Create the bodies of a JSON scene in a world, as they're parsed.
+ *
+ * @param in the JSON; see @ref parseJsonScene.
+ * @param world the world to add bodies to.
+ * @returns false iff the scene is invalid, in which case the world is left
+ * as it was.
+ * @throws std::runtime_error if the JSON is malformed, leaving the world as
+ * it was.
+ */
+bool
+loadJsonScene(std::istream& in, b2World& world);
+
+
+} // namespace scene
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__JSONSCENE__H
@@ -0,0 +1,249 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__WORLDSTATE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCENE__WORLDSTATE__H
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+class b2Body;
+class b2World;
+
+
+namespace dukdemo {
+namespace scene {
+
+
+/*
+ * A world state is a @ref WorldStateHeader followed by flat arrays: the
+ * header's `bodyCount` @ref BodyState records, its `contactCount`
+ * @ref ContactState records, its `fixtureCount` @ref BinaryFixture records,
+ * and its `vertexCount` vertices. Fixtures and their vertices are laid out as
+ * in a binary scene (see @ref BinaryScene.h), and the byte order is the same.
+ *
+ * Bodies are identified by ids from a @ref BodyIds, and fixtures by their
+ * body and their position in its fixture list. A state restored with other
+ * ids than it was captured with still restores the world, but its bodies
+ * are matched arbitrarily, so more of them may be replaced.
+ */
+
+
+/** The first four bytes of a world state. */
+constexpr char const g_worldStateMagic[4] = {'D', 'K', 'W', 'S'};
+
+
+/** Bumped whenever the layout changes; other versions are rejected. */
+constexpr std::uint32_t g_worldStateVersion = 2u;
+
+
+struct WorldStateHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t bodyCount;
+	std::uint32_t contactCount;
+	std::uint32_t fixtureCount;
+	std::uint32_t vertexCount;
+	float gravity[2];
+};
+
+
+struct BodyState
+{
+	/** The body's id when captured; see @ref BodyIds. */
+	std::uint64_t id;
+
+	/** A `b2BodyType`. */
+	std::uint32_t type;
+	float position[2];
+	float angle;
+	float linearVelocity[2];
+	float angularVelocity;
+	float linearDamping;
+	float angularDamping;
+	float gravityScale;
+
+	// The body's `b2MassData`.
+	float mass;
+	float center[2];
+	float inertia;
+
+	// Each is 0 or 1.
+	std::uint8_t awake;
+	std::uint8_t sleepingAllowed;
+	std::uint8_t bullet;
+	std::uint8_t fixedRotation;
+	std::uint8_t active;
+	std::uint8_t reserved[3];
+
+	/** The number of fixtures, following the previous body's. */
+	std::uint32_t fixtureCount;
+	std::uint32_t reserved2;
+};
+
+
+/**
+ * A contact's warm starting impulses and overridden properties.
+ *
+ * Sorted by bodies, then fixtures, then child indices, so a live contact's
+ * state can be found by a binary search.
+ */
+struct ContactState
+{
+	/** The ids of the fixtures' bodies when captured. */
+	std::uint64_t bodyA;
+	std::uint64_t bodyB;
+
+	/** The fixtures' positions in their bodies' fixture lists. */
+	std::uint32_t fixtureA;
+	std::uint32_t fixtureB;
+	std::int32_t childA;
+	std::int32_t childB;
+
+	float friction;
+	float restitution;
+	float tangentSpeed;
+
+	std::uint8_t pointCount;
+	std::uint8_t reserved[3];
+
+	// For each manifold point.
+	std::uint32_t pointIds[2];
+	float normalImpulses[2];
+	float tangentImpulses[2];
+};
+
+
+/**
+ * Identifies bodies across the saves and restores of a world.
+ *
+ * Box2D reuses the memory of destroyed bodies, so a body's address may be
+ * taken by a later one; an id must never be. Ids need only be unique among
+ * the bodies of one world.
+ */
+class BodyIds
+{
+public:
+	virtual ~BodyIds() = default;
+
+	/** Get a body's id, giving it one if it has none. */
+	virtual std::uint64_t
+	idOf(b2Body const& body) = 0;
+
+	/** Give a body recreated by a restore the id it was captured with. */
+	virtual void
+	assign(b2Body const& body, std::uint64_t id) = 0;
+
+	/** Forget a body about to be destroyed, e.g. by a restore. */
+	virtual void
+	forget(b2Body const& body) = 0;
+};
+
+
+/**
+ * Numbers bodies as they're first seen, never reusing a number.
+ *
+ * Bodies destroyed other than by a restore must be forgotten first.
+ * Otherwise a body created later at the same address takes their number,
+ * unless it's given its own by @ref issue.
+ */
+class BodySerials: public BodyIds
+{
+public:
+	BodySerials();
+
+	/**
+	 * Number a newly created body, replacing any number left by a destroyed
+	 * body at its address.
+	 */
+	std::uint64_t
+	issue(b2Body const& body);
+
+	std::uint64_t
+	idOf(b2Body const& body) override;
+
+	/** Later numbers are all greater than the id. */
+	void
+	assign(b2Body const& body, std::uint64_t id) override;
+
+	void
+	forget(b2Body const& body) override;
+
+private:
+	std::unordered_map<b2Body const*, std::uint64_t> m_serials;
+	std::uint64_t m_nextSerial;
+};
+
+
+/** The size of a world's state, as captured by @ref saveWorldState. */
+std::size_t
+worldStateSize(b2World const& world) noexcept;
+
+
+/**
+ * Capture a world's state into a contiguous buffer.
+ *
+ * Captures each body's type, transform, velocities, damping, mass, flags and
+ * fixtures, and each contact's impulses, friction and restitution. Joints,
+ * user data, accumulated forces and sleep timers aren't captured.
+ *
+ * @param world the world.
+ * @param ids gives the bodies ids, which are recorded.
+ * @param state resized to hold the state, keeping its capacity, so capturing
+ * into the same buffer repeatedly needn't allocate.
+ */
+void
+saveWorldState(
+	b2World const& world,
+	BodyIds& ids,
+	std::vector<unsigned char>& state
+);
+
+
+/**
+ * Capture a world's state into a buffer, e.g. one owned by a script heap.
+ *
+ * @param pData the buffer, aligned to eight bytes.
+ * @param size the buffer's size, which must be @ref worldStateSize.
+ */
+void
+saveWorldState(
+	b2World const& world,
+	BodyIds& ids,
+	void* pData,
+	std::size_t size
+);
+
+
+/**
+ * Restore a world to a captured state.
+ *
+ * Live bodies whose ids match bodies in the state are updated in place, and
+ * keep their fixtures if their shapes are unchanged, so restoring a world
+ * whose bodies have only moved allocates nothing. Other live bodies are
+ * destroyed, and bodies missing from the world are recreated with their
+ * recorded ids, so restoring the state again keeps them.
+ *
+ * Contacts which still exist get back their impulses, so stepping warm
+ * starts as it did. Lost contacts are found again by the next step.
+ *
+ * @param world the world, which mustn't be stepping.
+ * @param pData the state, aligned to eight bytes.
+ * @param size the size of the state in bytes.
+ * @param ids the ids the state was captured with. Each body destroyed is
+ * forgotten first, and each body recreated is assigned its id.
+ * @returns false iff the state is invalid, or the world is locked, in which
+ * case the world is left as it was.
+ */
+bool
+restoreWorldState(
+	b2World& world,
+	void const* pData,
+	std::size_t size,
+	BodyIds& ids
+);
+
+
+} // namespace scene
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCENE__WORLDSTATE__H
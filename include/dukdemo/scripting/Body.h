@@ -16,14 +16,40 @@ void
 init(duk_context* pContext);
 
 
+/**
+ * Push a `Body` object onto the stack, wrapping an existing @ref b2Body.
+ *
+ * The object is a `DataView` over the body's handle in the heap's
+ * @ref BodyTable, so resolving it needs no property lookup. Throws if the
+ * heap has no table.
+ *
+ * @param pContext the duktape context.
+ * @param pBody a pointer to the Box2D body.
+ */
 duk_idx_t
 pushBodyWithoutFinalizer(duk_context* pContext, b2Body* pBody);
 
 
+/**
+ * Push a `Body` object onto the stack, wrapping an existing @ref b2Body.
+ *
+ * @param pContext the duktape context.
+ * @param pBody a pointer to the Box2D body. The body will be destroyed when
+ * the JS object is finalized.
+ */
 duk_idx_t
 pushBodyWithFinalizer(duk_context* pContext, b2Body* pBody);
 
 
+/**
+ * Get the @ref b2Body pointer from a body object on the value stack.
+ *
+ * @returns the body, or `nullptr` if it has been destroyed.
+ */
+b2Body*
+getBodyPtrAt(duk_context* pContext, duk_idx_t bodyIdx);
+
+
 /**
  * Remove and destroy a body at a given index.
  *
@@ -34,7 +60,11 @@ void
 destroyBodyAt(duk_context* pContext, duk_idx_t bodyIdx);
 
 
-/** Get the @ref b2Body pointer from the body object represented by `this`. */
+/**
+ * Get the @ref b2Body pointer from the body object represented by `this`.
+ *
+ * @returns the body, or `nullptr` if it has been destroyed.
+ */
 b2Body*
 getOwnBodyPtr(duk_context* pContext);
 
@@ -0,0 +1,109 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__BODYTABLE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__BODYTABLE__H
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <duk_config.h>
+
+
+class b2Body;
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * A dense slot map of @ref b2Body pointers with generation counters.
+ *
+ * `Body` objects store a handle into this table instead of a raw pointer.
+ * Removing a body bumps the generation of its slot, so any handle still
+ * referring to it resolves to `nullptr` rather than a dangling pointer.
+ *
+ * Each Duktape heap has its own table, attached through its @ref HeapState,
+ * so a table is only ever used by the thread running its heap. Bodies are
+ * also indexed by address, so wrapping the same body twice yields the same
+ * handle; their user data is left alone.
+ */
+class BodyTable
+{
+public:
+	/**
+	 * A body handle: the slot index in the low 32 bits, and the generation
+	 * in the bits above. Handles fit in 53 bits so they survive a round trip
+	 * through a JS number.
+	 */
+	using Handle = std::uint64_t;
+
+	/** A handle which never refers to a body. */
+	constexpr static Handle s_invalidHandle = 0u;
+
+	BodyTable();
+
+	/**
+	 * Insert a body, or find the slot it already occupies.
+	 *
+	 * @returns the body's handle.
+	 */
+	Handle
+	insert(b2Body* pBody);
+
+	/**
+	 * Look up a body.
+	 *
+	 * @returns the body if the handle is live; otherwise `nullptr`.
+	 */
+	b2Body*
+	get(Handle handle) const noexcept;
+
+	/**
+	 * Find the handle of a body.
+	 *
+	 * @returns the body's handle if it is in the table; otherwise
+	 * @ref s_invalidHandle.
+	 */
+	Handle
+	find(b2Body const* pBody) const noexcept;
+
+	/**
+	 * Remove a body, invalidating every handle to it.
+	 *
+	 * @note The body itself is not destroyed.
+	 * @returns the removed body if the handle was live; otherwise `nullptr`.
+	 */
+	b2Body*
+	remove(Handle handle) noexcept;
+
+	/** Get the number of live bodies. */
+	inline std::size_t
+	size() const noexcept
+	{ return m_size; }
+
+private:
+	struct Slot
+	{
+		b2Body* pBody;
+		std::uint32_t generation;
+		std::uint32_t nextFree;
+	};
+
+	std::vector<Slot> m_slots;
+	std::unordered_map<b2Body const*, std::uint32_t> m_indices;
+	std::uint32_t m_freeHead;
+	std::size_t m_size;
+};
+
+
+/**
+ * Get the table of a heap's bodies, from its @ref HeapState.
+ *
+ * @returns the table, or `nullptr` if the heap has none.
+ */
+BodyTable*
+getBodyTable(duk_context* pContext);
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__BODYTABLE__H
@@ -0,0 +1,166 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__ENUMTABLE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__ENUMTABLE__H
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <duk_config.h>
+
+#include "dukdemo/util/PerfectHash.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * The names of an enumeration's values, in order, indexed by a perfect hash.
+ *
+ * Define one at compile time with @ref makeEnumTable, then decode values with
+ * @ref getEnum and the table's @ref enumNames.
+ */
+template <std::size_t N>
+struct EnumTable
+{
+	std::array<char const*, N> names;
+	util::PerfectHash<N> index;
+};
+
+
+/** Fails to compile if names are repeated. */
+template <std::size_t N>
+constexpr EnumTable<N>
+makeEnumTable(char const* const (&names)[N])
+{
+	std::array<char const*, N> nameArray{};
+	for (std::size_t i = 0u; i < N; ++i)
+	{
+		nameArray[i] = names[i];
+	}
+	return EnumTable<N>{nameArray, util::PerfectHash<N>{nameArray}};
+}
+
+
+/** An @ref EnumTable, independent of its size. */
+struct EnumNames
+{
+	/** The names, which also identify the table. */
+	char const* const* pNames;
+
+	duk_uint_t count;
+
+	/** Find a name's value; `count` if it's not in the table. */
+	std::size_t (*pFind)(char const* pName, std::size_t length) noexcept;
+};
+
+
+template <auto const& table>
+std::size_t
+findEnumName(char const* pName, std::size_t length) noexcept
+{ return table.index.find(pName, length); }
+
+
+/** Get the @ref EnumNames of a table with static storage. */
+template <auto const& table>
+constexpr EnumNames
+enumNames() noexcept
+{
+	return EnumNames{
+		table.names.data(),
+		duk_uint_t(table.names.size()),
+		findEnumName<table>};
+}
+
+
+/**
+ * A heap's interned copies of enumeration names.
+ *
+ * Duktape interns strings, so while a heap holds a name, every JS string with
+ * the same contents is the same string. Once a table's names are pinned in
+ * the heap stash, a string is decoded by comparing its data pointer against
+ * theirs, without hashing or reading it.
+ *
+ * Attach one to a heap through @ref HeapState::pEnumNameCache. It's cleared
+ * when a heap is created with it, so it must only be used by one heap at a
+ * time.
+ */
+class EnumNameCache
+{
+public:
+	EnumNameCache();
+
+	/**
+	 * Find a string in a table, pinning the table's names in the heap on
+	 * first use.
+	 *
+	 * Pinning runs in a protected call. If it fails, e.g. when the heap is
+	 * out of memory, the name is found by hashing instead, and the table is
+	 * pinned again next time.
+	 *
+	 * @param pString the string's data, from the heap.
+	 * @param length the string's length in bytes.
+	 * @returns the name's value, or `names.count` if it's not in the table.
+	 * @throws std::bad_alloc if the table can't be recorded.
+	 */
+	duk_uint_t
+	find(
+		duk_context* pContext,
+		EnumNames const& names,
+		char const* pString,
+		std::size_t length);
+
+	/** Forget every table's pointers, e.g. for a new heap. */
+	void
+	clear() noexcept;
+
+private:
+	struct Table
+	{
+		char const* const* pNames;
+
+		/** The interned data of each name, in order. */
+		std::vector<char const*> interned;
+
+		/** Whether every name has been pinned and recorded. */
+		bool pinned;
+	};
+
+	/** The arguments of @ref intern. */
+	struct InternCall
+	{
+		EnumNames const* pNames;
+		Table* pTable;
+	};
+
+	/**
+	 * Pin a table's names in the heap and record their pointers in its
+	 * entry, which is allocated beforehand. Only marks it pinned once done.
+	 *
+	 * Run with duk_safe_call, with an @ref InternCall as udata.
+	 */
+	static duk_ret_t
+	intern(duk_context* pContext, void* udata);
+
+	std::vector<Table> m_tables;
+};
+
+
+/**
+ * Get an enumerated value from the value stack.
+ *
+ * The value may be an index into the table or one of its names. Names are
+ * found through the heap's @ref EnumNameCache, if it has one, or otherwise
+ * through the table's perfect hash.
+ *
+ * @param pContext the duktape context.
+ * @param idx the value stack index of the value.
+ * @param names the enumeration's names, from @ref enumNames.
+ * @returns the value, or `names.count` if it's invalid.
+ */
+duk_uint_t
+getEnum(duk_context* pContext, duk_idx_t idx, EnumNames const& names) noexcept;
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__ENUMTABLE__H
@@ -0,0 +1,135 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__EXECBUDGET__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__EXECBUDGET__H
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include <duk_config.h>
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * Per-call and per-frame time budgets for script execution.
+ *
+ * Calls made through @ref pcall are timed against the call budget and the
+ * remainder of the frame budget. When Duktape is built with
+ * `DUKTAPE_EXEC_TIMEOUT`, its interrupt hook polls @ref expired and aborts
+ * an overrunning call with a RangeError. Otherwise, overruns are only
+ * detected once the call returns.
+ *
+ * A heap uses the budget once it's attached through @ref HeapState.
+ */
+class ExecBudget
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Duration = std::chrono::duration<double>;
+
+	/** Overrun counts for one call site. */
+	struct SiteStats
+	{
+		/** Calls which exceeded the call budget. */
+		std::size_t callOverruns = 0u;
+
+		/** Calls which exceeded, or were skipped due to, the frame budget. */
+		std::size_t frameOverruns = 0u;
+	};
+
+	struct Stats
+	{
+		std::size_t calls = 0u;
+		std::size_t callOverruns = 0u;
+		std::size_t frameOverruns = 0u;
+
+		/** Calls not made because the frame budget was already spent. */
+		std::size_t skippedCalls = 0u;
+
+		/** Overruns by call site name. */
+		std::map<std::string, SiteStats> sites{};
+	};
+
+	/** Whether overrunning calls are interrupted, or only detected. */
+	static constexpr bool
+	isEnforced() noexcept
+	{
+#ifdef DUKDEMO_EXEC_TIMEOUT
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	ExecBudget();
+
+	/** Set the budget for each call; zero for no limit. */
+	inline void
+	setCallBudget(Duration budget) noexcept
+	{ m_callBudget = budget; }
+
+	/** Set the budget for each frame; zero for no limit. */
+	inline void
+	setFrameBudget(Duration budget) noexcept
+	{ m_frameBudget = budget; }
+
+	/** Start a new frame, resetting the frame budget. */
+	void
+	beginFrame() noexcept;
+
+	/** End the frame; calls outside a frame only have the call budget. */
+	void
+	endFrame() noexcept;
+
+	/**
+	 * Call a function within the budgets, like `duk_pcall`.
+	 *
+	 * If the frame budget is already spent, the call is skipped: the function
+	 * and its arguments are replaced by a RangeError.
+	 *
+	 * Once a top-level call returns, the JS samples that came due during it
+	 * are recorded; see @ref takeDueSamples.
+	 *
+	 * @param pContext the duktape context.
+	 * @param nargs the number of arguments above the function.
+	 * @param pSite a name for the call site, used in the overrun counts.
+	 * @returns `DUK_EXEC_SUCCESS` or `DUK_EXEC_ERROR`, as for `duk_pcall`.
+	 */
+	duk_int_t
+	pcall(duk_context* pContext, duk_idx_t nargs, char const* pSite);
+
+	/**
+	 * Check whether the current call has run out of time.
+	 *
+	 * Called from Duktape's interrupt hook. Once a call has timed out, this
+	 * keeps returning true until @ref pcall returns.
+	 */
+	bool
+	expired() noexcept;
+
+	inline Stats const&
+	stats() const noexcept
+	{ return m_stats; }
+
+	inline void
+	resetStats()
+	{ m_stats = Stats{}; }
+
+private:
+	Duration m_callBudget;
+	Duration m_frameBudget;
+	Clock::time_point m_frameDeadline;
+	Clock::time_point m_deadline;
+	bool m_timedOut;
+
+	/** The number of calls through @ref pcall in progress. */
+	std::size_t m_depth;
+	Stats m_stats;
+};
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__EXECBUDGET__H
@@ -0,0 +1,153 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__GCSCHEDULER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__GCSCHEDULER__H
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <duk_config.h>
+
+#include "dukdemo/util/RollingHistogram.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** When a @ref GcScheduler may collect, and when it must. */
+struct GcOptions
+{
+	/**
+	 * Only collect in idle time once this many frames have passed since the
+	 * last collection...
+	 */
+	std::size_t minFramesBetween = 30u;
+
+	/**
+	 * ...or the live bytes have grown this much; zero to only wait for the
+	 * frames. Needs a heap allocator.
+	 */
+	std::size_t minGrowthBytes = std::size_t{256u} << 10u;
+
+	/** Collect at least this often, even without idle time. */
+	std::size_t maxFramesBetween = 300u;
+
+	/**
+	 * Collect regardless once the live bytes have grown this much since the
+	 * last collection; zero for no limit. Needs a heap allocator.
+	 */
+	std::size_t maxGrowthBytes = std::size_t{8u} << 20u;
+};
+
+
+/**
+ * Runs Duktape's mark-and-sweep between frames, in otherwise idle time.
+ *
+ * When Duktape is built with `DUKTAPE_MANUAL_GC`, it never starts a full
+ * collection by itself, except when an allocation fails. Reference counting
+ * still frees most garbage immediately, so only cycles wait for a
+ * collection. Call @ref endFrame after each frame with the time left before
+ * the next is due: garbage is collected there if the time allows and enough
+ * may have built up since the last collection, or regardless once a
+ * collection is overdue.
+ *
+ * After a collection, long-lived objects such as prototypes can also be
+ * compacted, shrinking their property tables to fit.
+ *
+ * Collections are timed into the "gc" phase of the heap's
+ * @ref HeapState::pProfiler, if any, and growth is measured with its
+ * @ref HeapState::pAllocator.
+ */
+class GcScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Duration = std::chrono::duration<double>;
+
+	struct Stats
+	{
+		std::size_t frames = 0u;
+		std::size_t collections = 0u;
+
+		/** Collections run without enough idle time, being overdue. */
+		std::size_t forcedCollections = 0u;
+
+		/** Long-lived objects compacted. */
+		std::size_t compactions = 0u;
+
+		double totalSeconds = 0.0;
+
+		/** Time spent collecting in each recent frame, including none. */
+		util::RollingHistogram secondsPerFrame{600u};
+	};
+
+	/** Whether Duktape only runs mark-and-sweep when asked to. */
+	static constexpr bool
+	isAutomaticGcSuppressed() noexcept
+	{
+#ifdef DUKDEMO_MANUAL_GC
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	explicit GcScheduler(GcOptions const& options = GcOptions{});
+
+	/**
+	 * Compact a global object after the next collection.
+	 *
+	 * @param pGlobalKey the object's key on the global object. Its own
+	 * properties shouldn't change afterwards.
+	 */
+	void
+	addLongLived(char const* pGlobalKey);
+
+	/**
+	 * Finish a frame, collecting garbage if there's time and it's worthwhile,
+	 * or it's overdue.
+	 *
+	 * @param pContext the heap's context.
+	 * @param idle the time left before the next frame is due.
+	 * @returns whether garbage was collected.
+	 */
+	bool
+	endFrame(duk_context* pContext, Duration idle);
+
+	/** Collect garbage now, then compact any pending long-lived objects. */
+	void
+	collect(duk_context* pContext);
+
+	/**
+	 * The idle time needed to collect: the longest recent collection, decaying
+	 * with each later one. Zero before the first.
+	 */
+	inline Duration
+	estimatedCost() const noexcept
+	{ return m_estimatedCost; }
+
+	inline Stats const&
+	stats() const noexcept
+	{ return m_stats; }
+
+private:
+	GcOptions m_options;
+	std::vector<std::string> m_longLived;
+	bool m_compactionPending;
+	std::size_t m_framesSinceCollection;
+
+	/** The heap's live bytes after the last collection. */
+	std::size_t m_bytesAfterCollection;
+
+	Duration m_estimatedCost;
+
+	/** Time spent collecting during the current frame. */
+	double m_frameSeconds;
+
+	Stats m_stats;
+};
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__GCSCHEDULER__H
@@ -0,0 +1,116 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAP__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAP__H
+#include <cstdint>
+
+#include <duk_config.h>
+
+
+namespace dukdemo {
+
+
+namespace util {
+class FrameProfiler;
+} // namespace util
+
+
+namespace scripting {
+
+
+class BodyTable;
+class EnumNameCache;
+class ExecBudget;
+class HeapAllocator;
+class JsSampler;
+
+
+/**
+ * Native state for a Duktape heap, shared with its hooks.
+ *
+ * Passed to Duktape as the heap udata. Each member is optional.
+ */
+struct HeapState
+{
+	/**
+	 * Resolves the handles held by `Body` objects; see @ref BodyTable.
+	 * Required by the physics bindings.
+	 */
+	BodyTable* pBodyTable = nullptr;
+
+	/** Bounds script execution time; see @ref ExecBudget. */
+	ExecBudget* pExecBudget = nullptr;
+
+	/**
+	 * Allocates the heap's memory; see @ref HeapAllocator.
+	 *
+	 * Only read when the heap is created.
+	 */
+	HeapAllocator* pAllocator = nullptr;
+
+	/**
+	 * Samples the call stack while scripts run; see @ref JsSampler. Attached
+	 * when the heap is created.
+	 */
+	JsSampler* pSampler = nullptr;
+
+	/** Frame timings readable from scripts; see @ref profiler::init. */
+	util::FrameProfiler* pProfiler = nullptr;
+
+	/**
+	 * Decodes enumeration names by their interned pointers; see
+	 * @ref EnumNameCache. Cleared when the heap is created.
+	 */
+	EnumNameCache* pEnumNameCache = nullptr;
+
+	/**
+	 * The static geometry version of the heap's worlds, e.g. a
+	 * @ref sim::SimulationThread's. Incremented by the physics bindings
+	 * whenever they create, destroy or restore static bodies.
+	 */
+	std::uint64_t* pStaticVersion = nullptr;
+};
+
+
+/**
+ * Create a Duktape heap with native state attached.
+ *
+ * The typed array prototypes the loaders accept are stashed before any script
+ * runs, so coordinate buffers are only recognised in heaps created here.
+ *
+ * @param pState the heap's state, which must outlive the heap. May be null,
+ * in which case no native state is attached.
+ * @returns the new heap's initial context, or `nullptr` on failure.
+ */
+duk_context*
+createHeap(HeapState* pState);
+
+
+/**
+ * Get the state a heap was created with.
+ *
+ * @returns the state, or `nullptr` if there is none.
+ */
+HeapState*
+getHeapState(duk_context* pContext);
+
+
+/** Note a change to a heap's static geometry; see @ref HeapState. */
+void
+bumpStaticVersion(duk_context* pContext) noexcept;
+
+
+/**
+ * Record the JS samples that came due during a top-level call, if the heap
+ * has a sampler.
+ *
+ * Called once the call has returned, as the interrupt hook can't capture
+ * stacks. The samples are charged to the call site.
+ *
+ * @param pSite a name for the call site, used as the sampled frame.
+ */
+void
+takeDueSamples(duk_context* pContext, char const* pSite) noexcept;
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAP__H
@@ -0,0 +1,160 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAPALLOCATOR__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAPALLOCATOR__H
+#include <array>
+#include <cstddef>
+#include <vector>
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * A size-class pool allocator for a Duktape heap.
+ *
+ * Small allocations (Body wrappers, property tables, short strings) are
+ * carved from large chunks and recycled through per-class free lists, so
+ * they rarely reach the system allocator. Each chunk serves one class and is
+ * aligned to its own size, so a block's class is found from its address and
+ * pooled blocks need no header. Larger allocations fall through to
+ * `std::malloc`, behind a header recording their size. Every allocation is
+ * counted, and an optional limit caps the live bytes: beyond it allocations
+ * fail, which Duktape handles by collecting garbage and then throwing an
+ * out-of-memory error.
+ *
+ * Attach to a heap through @ref HeapState. Not thread safe; use one allocator
+ * per heap, and destroy the heap first.
+ */
+class HeapAllocator
+{
+public:
+	/** The payload sizes of the pooled size classes, in bytes. */
+	static constexpr std::array<std::size_t, 8> s_classSizes{
+		{16u, 32u, 48u, 64u, 96u, 128u, 192u, 256u}};
+
+	static constexpr std::size_t s_classCount = s_classSizes.size();
+
+	struct ClassStats
+	{
+		/** Allocations served by this class. */
+		std::size_t allocations = 0u;
+
+		/** Allocations served without a system allocation. */
+		std::size_t hits = 0u;
+
+		/** Blocks currently allocated. */
+		std::size_t liveBlocks = 0u;
+
+		inline double
+		hitRate() const noexcept
+		{ return allocations ? double(hits) / double(allocations) : 0.0; }
+	};
+
+	struct Stats
+	{
+		/**
+		 * Bytes currently allocated: the class size of each pooled block, and
+		 * the size requested for each large one.
+		 */
+		std::size_t bytesLive = 0u;
+
+		/** The highest value of @ref bytesLive. */
+		std::size_t peakBytes = 0u;
+
+		std::size_t allocations = 0u;
+		std::size_t reallocations = 0u;
+		std::size_t frees = 0u;
+
+		/** Calls to the system allocator, for both chunks and large blocks. */
+		std::size_t systemAllocations = 0u;
+
+		/** Allocations too large for any size class. */
+		std::size_t largeAllocations = 0u;
+
+		/** Allocations refused due to the memory limit. */
+		std::size_t limitFailures = 0u;
+
+		std::array<ClassStats, s_classCount> classes{};
+	};
+
+	/**
+	 * @param memoryLimit the maximum live bytes; zero for no limit.
+	 * @param chunkSize the size of each chunk the pools are carved from,
+	 * rounded up to a power of two.
+	 */
+	explicit HeapAllocator(
+		std::size_t memoryLimit = 0u,
+		std::size_t chunkSize = 64u * 1024u
+	);
+
+	HeapAllocator(HeapAllocator const&) = delete;
+	HeapAllocator& operator=(HeapAllocator const&) = delete;
+
+	~HeapAllocator() noexcept;
+
+	void*
+	allocate(std::size_t size) noexcept;
+
+	void*
+	reallocate(void* pMemory, std::size_t size) noexcept;
+
+	void
+	deallocate(void* pMemory) noexcept;
+
+	inline Stats const&
+	stats() const noexcept
+	{ return m_stats; }
+
+	inline std::size_t
+	memoryLimit() const noexcept
+	{ return m_memoryLimit; }
+
+	inline void
+	setMemoryLimit(std::size_t limit) noexcept
+	{ m_memoryLimit = limit; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	struct Pool
+	{
+		FreeBlock* pFree = nullptr;
+		char* pCursor = nullptr;
+		char* pEnd = nullptr;
+	};
+
+	struct Chunk
+	{
+		char* pBase;
+		std::size_t sizeClass;
+	};
+
+	void*
+	allocateBlock(std::size_t sizeClass) noexcept;
+
+	void*
+	allocateLarge(std::size_t size) noexcept;
+
+	/** Get the class of a pooled block, or the class count if it's large. */
+	std::size_t
+	getBlockClass(void* pMemory) const noexcept;
+
+	bool
+	reserve(std::size_t size) noexcept;
+
+	std::size_t m_memoryLimit;
+	std::size_t m_chunkSize;
+	std::array<Pool, s_classCount> m_pools;
+
+	/** Every chunk, sorted by address. */
+	std::vector<Chunk> m_chunks;
+	Stats m_stats;
+};
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__HEAPALLOCATOR__H
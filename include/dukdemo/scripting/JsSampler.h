@@ -0,0 +1,156 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__JSSAMPLER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__JSSAMPLER__H
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+
+#include <duk_config.h>
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * A sampling profiler for the scripts running in a heap.
+ *
+ * @ref sample captures a context's JS call stack, each frame's function name,
+ * file name and line. Samples are counted by stack, and can be written in the
+ * folded format read by flame graph tools.
+ *
+ * When Duktape is built with `DUKTAPE_EXEC_TIMEOUT`, its interrupt hook calls
+ * @ref poll every few thousand bytecode instructions. The Duktape API can't
+ * be used from the hook, so it only counts the samples that have come due.
+ * When a top-level call made through @ref ExecBudget::pcall returns, they're
+ * recorded against its call site (see @ref takeDueSamples). The interrupt
+ * rate bounds the resolution, so the interval is a minimum.
+ *
+ * A heap uses the sampler once it's attached through @ref HeapState.
+ */
+class JsSampler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Duration = std::chrono::duration<double>;
+
+	/** The most frames kept per sample; deeper frames are dropped. */
+	static constexpr int s_maxDepth = 64;
+
+	/** Whether samples are taken automatically while scripts run. */
+	static constexpr bool
+	isAutomatic() noexcept
+	{
+#ifdef DUKDEMO_EXEC_TIMEOUT
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/** @param interval the minimum time between samples. */
+	explicit JsSampler(Duration interval = std::chrono::milliseconds{1});
+
+	JsSampler(JsSampler const&) = delete;
+	JsSampler& operator=(JsSampler const&) = delete;
+
+	/**
+	 * Set the heap whose scripts are sampled. Done by @ref createHeap.
+	 *
+	 * @param pContext any context of the heap, or null to stop sampling.
+	 */
+	inline void
+	attach(duk_context* pContext) noexcept
+	{ m_pContext = pContext; }
+
+	inline void
+	setInterval(Duration interval) noexcept
+	{ m_interval = interval; }
+
+	/**
+	 * Count a sample as due if the interval has passed. Safe to call from
+	 * the interrupt hook: it neither calls Duktape nor allocates.
+	 */
+	void
+	poll() noexcept;
+
+	/** The number of samples due but not yet taken. */
+	inline std::size_t
+	pending() const noexcept
+	{ return m_pending; }
+
+	/**
+	 * Record the samples that are due against a call site.
+	 *
+	 * @param pContext the context; must be safe to use the Duktape API on,
+	 * so not called from the interrupt hook.
+	 * @param pSite the innermost frame's label, below any running script's
+	 * frames.
+	 */
+	void
+	takePending(duk_context* pContext, char const* pSite) noexcept;
+
+	/**
+	 * Capture a context's current call stack.
+	 *
+	 * @param count the number of samples to record for the stack.
+	 * @returns whether a sample was recorded; false if no script is running
+	 * or the stack couldn't be read.
+	 */
+	bool
+	sample(duk_context* pContext, std::size_t count = 1u) noexcept;
+
+	/** The number of samples recorded. */
+	inline std::size_t
+	samples() const noexcept
+	{ return m_samples; }
+
+	/**
+	 * Write each distinct stack and its count, outermost frame first, e.g.
+	 * `update (scene.js:3);step (scene.js:12) 42`.
+	 */
+	void
+	writeFolded(std::ostream& out) const;
+
+	/**
+	 * Write the folded stacks to a file, replacing it.
+	 *
+	 * @throws std::runtime_error if the file can't be written.
+	 */
+	void
+	dump(std::string const& path) const;
+
+	void
+	clear() noexcept;
+
+private:
+	/** Called by @ref sample in a protected call, so errors are caught. */
+	static duk_ret_t
+	captureStack(duk_context* pContext, void* udata);
+
+	duk_context* m_pContext;
+	Duration m_interval;
+	Clock::time_point m_nextSample;
+
+	/** Samples counted by @ref poll, waiting for a call to return. */
+	std::size_t m_pending;
+
+	/** The samples to record for the stack being captured. */
+	std::size_t m_count;
+
+	/** The innermost frame of the stack being captured, if any. */
+	char const* m_pSite;
+
+	/** Sample counts by folded stack. */
+	std::unordered_map<std::string, std::size_t> m_stacks;
+	std::size_t m_samples;
+
+	/** The stack being captured, kept to reuse its storage. */
+	std::string m_stack;
+};
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__JSSAMPLER__H
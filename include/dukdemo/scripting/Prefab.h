@@ -0,0 +1,106 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PREFAB__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PREFAB__H
+#include <memory>
+#include <vector>
+
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+
+#include <duk_config.h>
+
+
+class b2World;
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** A fixture definition which owns its shape. */
+struct PrefabFixture
+{
+	b2FixtureDef def{};
+	std::unique_ptr<b2Shape> pShape{};
+};
+
+
+/**
+ * A body definition and its fixtures, validated and converted once.
+ *
+ * Instantiating a prefab needs no JS object parsing at all.
+ */
+struct Prefab
+{
+	b2BodyDef bodyDef{};
+	std::vector<PrefabFixture> fixtures{};
+};
+
+
+/**
+ * Load a prefab from an object on the value stack.
+ *
+ * The object is a body definition (see @ref loadBodyDef) with an optional
+ * `fixtures` array. Each fixture is a fixture definition (see @ref
+ * loadFixtureDefWithoutShape) with a required `shape` property (see @ref
+ * loadShape).
+ *
+ * @param pContext the duktape context.
+ * @param defIdx the value stack index of the JS prefab definition.
+ * @param pPrefab a pointer to the prefab to load into.
+ * @returns false iff the JS object is invalid.
+ */
+bool
+loadPrefab(duk_context* pContext, duk_idx_t defIdx, Prefab* pPrefab);
+
+
+/**
+ * Create a body and its fixtures from a prefab.
+ *
+ * @param world the world to create the body in.
+ * @param prefab the prefab to instantiate.
+ * @param position the body's position, overriding the prefab's.
+ * @param angle the body's angle, overriding the prefab's.
+ * @returns the new body, or `nullptr` if the world is locked.
+ */
+b2Body*
+createBodyFromPrefab(
+	b2World& world,
+	Prefab const& prefab,
+	b2Vec2 const& position,
+	float angle
+);
+
+
+namespace prefab {
+
+
+/**
+ * Push a `Prefab` object onto the stack.
+ *
+ * Prefab objects are opaque: they can only be passed back to native code.
+ *
+ * @param pContext the duktape context.
+ * @param pPrefab the prefab. It is destroyed when the JS object is finalized.
+ */
+duk_idx_t
+pushPrefab(duk_context* pContext, std::unique_ptr<Prefab> pPrefab);
+
+
+/**
+ * Get the @ref Prefab from a `Prefab` object on the value stack.
+ *
+ * @returns the prefab, or `nullptr` if the value is not a `Prefab` object.
+ */
+Prefab const*
+getPrefabPtrAt(duk_context* pContext, duk_idx_t prefabIdx);
+
+
+/** Finalize a `Prefab` object. */
+duk_ret_t
+finalizer(duk_context* pContext);
+
+
+} // namespace prefab
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PREFAB__H
@@ -0,0 +1,52 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PROFILER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PROFILER__H
+#include <duk_config.h>
+
+
+namespace dukdemo {
+namespace scripting {
+namespace profiler {
+
+
+/**
+ * Initialise the global `profiler` object.
+ *
+ * `profiler.stats()` returns the frame timings of the heap's
+ * @ref HeapState::pProfiler, or `undefined` if it has none:
+ *
+ *     {
+ *         frames: 1234,
+ *         phases: {
+ *             step: {
+ *                 cpu: {mean: 0.1, p50: 0.1, p95: 0.2, p99: 0.3, max: 0.5,
+ *                     samples: 600},
+ *                 gpu: {...}
+ *             },
+ *             ...
+ *         },
+ *         counters: {
+ *             drawn_fixtures: {latest: 120, mean: 118.5, samples: 600},
+ *             ...
+ *         }
+ *     }
+ *
+ * Times are in milliseconds. A phase without GPU timings has no `gpu`.
+ * Counters, such as the demo's drawn fixtures and culled bodies, give their
+ * latest value and mean per frame.
+ */
+void
+init(duk_context* pContext);
+
+
+namespace methods {
+
+
+duk_ret_t
+stats(duk_context* pContext);
+
+
+} // namespace methods
+} // namespace profiler
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__PROFILER__H
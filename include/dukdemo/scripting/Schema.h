@@ -0,0 +1,152 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCHEMA__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCHEMA__H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <duk_config.h>
+
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/util/PerfectHash.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** How a @ref SchemaField is read from JS and stored. */
+enum class FieldType : std::uint8_t
+{
+	/** A finite number, stored as a `float`. */
+	Float,
+
+	/** A boolean, stored as a `bool`. */
+	Bool,
+
+	/** A number, stored as an `int16`. */
+	Int16,
+
+	/** A number below 65535, stored as a `uint16`. */
+	Uint16,
+
+	/** Anything @ref loadVec2 accepts, stored as a `b2Vec2`. */
+	Vec2,
+
+	/** A name or index in the field's @ref EnumTable, stored as an `int`. */
+	Enum,
+};
+
+
+/** A property of a JS object and the member it's loaded into. */
+struct SchemaField
+{
+	char const* pName;
+
+	/** The member's offset in the loaded object, from `offsetof`. */
+	std::size_t offset;
+
+	FieldType type;
+
+	/** For @ref FieldType::Enum, the enumeration's names. */
+	EnumNames const* pEnum = nullptr;
+};
+
+
+/**
+ * The properties loaded into a type, indexed by a perfect hash of their names.
+ *
+ * Define one at compile time with @ref makeSchema, then load objects with
+ * @ref loadSchemaFields and the schema's @ref findField.
+ */
+template <std::size_t N>
+struct Schema
+{
+	std::array<SchemaField, N> fields;
+	util::PerfectHash<N> index;
+};
+
+
+/**
+ * Define a schema, e.g.
+ * `constexpr auto schema = makeSchema({{"angle", offsetof(b2BodyDef, angle),
+ * FieldType::Float}});`
+ *
+ * Fails to compile if field names are repeated.
+ */
+template <std::size_t N>
+constexpr Schema<N>
+makeSchema(SchemaField const (&fields)[N])
+{
+	std::array<SchemaField, N> fieldArray{};
+	std::array<char const*, N> names{};
+	for (std::size_t i = 0u; i < N; ++i)
+	{
+		fieldArray[i] = fields[i];
+		names[i] = fields[i].pName;
+	}
+	return Schema<N>{fieldArray, util::PerfectHash<N>{names}};
+}
+
+
+/** Find a field by name; null if it's not in the schema. */
+using FieldLookup =
+	SchemaField const* (*)(char const* pName, std::size_t length) noexcept;
+
+
+/** A @ref FieldLookup for a schema with static storage. */
+template <auto const& schema>
+SchemaField const*
+findField(char const* pName, std::size_t length) noexcept
+{
+	auto const index = schema.index.find(pName, length);
+	return index < schema.fields.size() ? &schema.fields[index] : nullptr;
+}
+
+
+/**
+ * Load a value from the value stack into a field.
+ *
+ * @param pContext the duktape context.
+ * @param valueIdx the value stack index of the value.
+ * @param field the field to load.
+ * @param pObject the object holding the field.
+ * @returns false iff the value is invalid for the field, leaving it unchanged.
+ */
+bool
+loadField(
+	duk_context* pContext,
+	duk_idx_t valueIdx,
+	SchemaField const& field,
+	void* pObject
+) noexcept;
+
+
+/**
+ * Load the properties of an object on the value stack which are in a schema.
+ *
+ * The object's own enumerable string keys are enumerated once, and each is
+ * looked up in the schema, so the cost follows the properties present rather
+ * than the size of the schema. Other properties, and those set to
+ * `undefined`, are ignored.
+ *
+ * @note Loading stops at the first invalid property, so on failure some
+ * fields may already have been written. Load into a copy to be atomic.
+ *
+ * @param pContext the duktape context.
+ * @param objectIdx the value stack index of the JS object.
+ * @param lookup the schema's fields, e.g. `findField<schema>`.
+ * @param pObject the object to overwrite fields in.
+ * @returns false iff a property is invalid.
+ */
+bool
+loadSchemaFields(
+	duk_context* pContext,
+	duk_idx_t objectIdx,
+	FieldLookup lookup,
+	void* pObject
+) noexcept;
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCHEMA__H
@@ -0,0 +1,105 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCRIPTCACHE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCRIPTCACHE__H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <duk_config.h>
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/**
+ * An on-disk cache of compiled scripts.
+ *
+ * Scripts are compiled once and serialized with `duk_dump_function`. Later
+ * runs load the bytecode with `duk_load_function`, skipping parsing. Entries
+ * are keyed by a hash of the source and file name, by `DUK_VERSION` and by
+ * the `DUKTAPE_EXEC_TIMEOUT` and `DUKTAPE_MANUAL_GC` build options, so editing
+ * a script or rebuilding Duktape never loads stale bytecode. Entries are
+ * written to a unique temporary file and renamed into place, so processes
+ * may share a cache directory.
+ *
+ * @warning Duktape does not validate bytecode, so the cache directory must
+ * not be writable by untrusted users.
+ */
+class ScriptCache
+{
+public:
+	using Key = std::uint64_t;
+
+	struct Stats
+	{
+		/** Scripts loaded from the cache. */
+		std::size_t hits = 0u;
+
+		/** Scripts compiled from source. */
+		std::size_t misses = 0u;
+
+		/** Compiled scripts which couldn't be written to the cache. */
+		std::size_t writeFailures = 0u;
+	};
+
+	/**
+	 * @param directory an existing directory to keep cache files in.
+	 */
+	explicit ScriptCache(std::string directory);
+
+	/**
+	 * Push a compiled program function onto the value stack.
+	 *
+	 * Loads cached bytecode if there is any for this source, file name and
+	 * Duktape build. Otherwise, compiles the source and caches the result.
+	 *
+	 * @param pContext the duktape context.
+	 * @param source the script source.
+	 * @param pFileName the file name, used in error messages.
+	 * @returns false iff the source fails to compile, in which case the error
+	 * is pushed instead.
+	 */
+	bool
+	pushFunction(
+		duk_context* pContext,
+		std::string const& source,
+		char const* pFileName
+	);
+
+	/** Get the path of the cache file for a script. */
+	std::string
+	pathFor(std::string const& source, char const* pFileName) const;
+
+	inline Stats const&
+	stats() const noexcept
+	{ return m_stats; }
+
+	/** Hash a script's source and file name. */
+	static Key
+	hash(std::string const& source, char const* pFileName) noexcept;
+
+private:
+	bool
+	load(
+		duk_context* pContext,
+		std::string const& path,
+		Key key,
+		std::size_t sourceSize
+	) const;
+
+	bool
+	store(
+		duk_context* pContext,
+		std::string const& path,
+		Key key,
+		std::size_t sourceSize
+	) const;
+
+	std::string m_directory;
+	Stats m_stats;
+};
+
+
+} // namespace scripting
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__SCRIPTCACHE__H
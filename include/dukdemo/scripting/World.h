@@ -1,8 +1,11 @@
 #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__WORLD__H
 #define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__WORLD__H
+#include <memory>
+
 #include <duk_config.h>
 
 
+class b2Body;
 class b2World;
 
 
@@ -11,6 +14,20 @@ namespace scripting {
 namespace world {
 
 
+/** How the `Body` objects created by a `World` are destroyed. */
+enum class BodyLifetime
+{
+	/** Each `Body` object has a finalizer which destroys its @ref b2Body. */
+	finalized,
+
+	/**
+	 * `Body` objects have no finalizer. The @ref b2Body instances live until
+	 * destroyed explicitly, or until the `World` object is finalized.
+	 */
+	worldOwned,
+};
+
+
 /**
  * Initialise the World constructor and prototype.
  *
@@ -21,16 +38,51 @@ void
 init(duk_context* pContext);
 
 
-/** Get the @ref b2World pointer owned by `this`. */
+/**
+ * Get the @ref b2World pointer owned by `this`.
+ *
+ * Throws a `TypeError` if the world has been detached.
+ */
 b2World*
 getOwnWorldPtr(duk_context* pContext);
 
 
+/**
+ * Detach a `World` object from its @ref b2World.
+ *
+ * Invalidates the handles of all the world's bodies and clears the world
+ * pointer, so later calls on the object throw. Call this before destroying a
+ * world pushed by @ref pushWorldWithoutFinalizer. Does nothing if the world
+ * is already detached.
+ *
+ * @param pContext the duktape context.
+ * @param worldIdx the value stack index of the `World` object.
+ */
+void
+detach(duk_context* pContext, duk_idx_t worldIdx);
+
+
+/**
+ * Forget the serial of a body about to be destroyed, which identifies it in
+ * its world's snapshots.
+ *
+ * @param pContext the duktape context.
+ * @param bodyIdx the value stack index of the `Body` object. Its world is
+ * found through its `world` property; if that isn't a `World` object, this
+ * does nothing.
+ * @param body the body.
+ */
+void
+forgetBody(duk_context* pContext, duk_idx_t bodyIdx, b2Body const& body);
+
+
 /**
  * Push a `World` object onto the stack, wrapping an existing @ref b2World.
  *
  * @note The Box2D world is **not** destroyed after the JS object goes out of
- * scope. If a finalizer is required, use @ref pushWorldWithFinalizer.
+ * scope. If a finalizer is required, use @ref pushWorldWithFinalizer. The
+ * object must be passed to @ref detach before the world is destroyed.
+ * @note Bodies created by this world use @ref BodyLifetime::finalized.
  *
  * @param pContext the duktape context.
  * @param pWorld a pointer to the Box2D world.
@@ -42,6 +94,8 @@ pushWorldWithoutFinalizer(duk_context* pContext, b2World* pWorld);
 /**
  * Push a `World` object onto the stack, wrapping an existing @ref b2World.
  *
+ * @note Bodies created by this world use @ref BodyLifetime::worldOwned.
+ *
  * @param pContext the duktape context.
  * @param pWorld a pointer to the Box2D world. The pointer will be released and
  * the @ref b2World instance destroyed when the JS object is finalized.
@@ -53,16 +107,28 @@ pushWorldWithFinalizer(duk_context* pContext, std::unique_ptr<b2World> pWorld);
 /**
  * Construct a `World` object.
  *
- * Requires a `gravity` array argument.
+ * Requires a `gravity` array argument. The world owns its bodies, as with
+ * @ref pushWorldWithFinalizer.
  */
 duk_ret_t
 constructor(duk_context* pContext);
 
 
+/**
+ * Compile a prefab definition into a `Prefab` object.
+ *
+ * Exposed as `World.compilePrefab`. Requires an object as accepted by @ref
+ * loadPrefab: a body definition with an optional array of `fixtures`.
+ */
+duk_ret_t
+compilePrefab(duk_context* pContext);
+
+
 /**
  * Finalize a `World` object.
  *
- * Destructs the owned @ref b2World.
+ * Detaches the object as by @ref detach, then destructs the owned @ref
+ * b2World and with it every @ref b2Body.
  */
 duk_ret_t
 finalizer(duk_context* pContext);
@@ -100,6 +166,29 @@ duk_ret_t
 createBody(duk_context* pContext);
 
 
+/**
+ * Create many `Body` objects at once.
+ *
+ * Requires an array of objects representing @ref b2BodyDef instances. Every
+ * definition is validated before any bodies are created. Returns an array of
+ * `Body` objects in the same order as the definitions. Throws a `RangeError`
+ * for more than 65536 definitions.
+ */
+duk_ret_t
+createBodies(duk_context* pContext);
+
+
+/**
+ * Create a new `Body` object from a `Prefab`.
+ *
+ * Requires a `Prefab` object, followed by optional `x`, `y` and `angle`
+ * arguments which override the prefab's position and angle. Throws an
+ * `Error` if the world is stepping.
+ */
+duk_ret_t
+spawn(duk_context* pContext);
+
+
 /**
  * Destroy a `Body`, removing its @ref b2Body.
  *
@@ -109,6 +198,47 @@ duk_ret_t
 destroyBody(duk_context* pContext);
 
 
+/**
+ * Write the transform of every body into a `Float32Array`.
+ *
+ * Requires a `Float32Array` as the first argument. If the optional second
+ * argument is `true`, velocities are written too. Each body is packed as
+ * `[x, y, angle]`, or `[x, y, angle, vx, vy, angularVelocity]` with
+ * velocities, in the order of the @ref b2World body list. Only as many
+ * bodies as fit in the array are written.
+ *
+ * Returns the number of bodies in the world, so callers can detect when the
+ * array needs to grow.
+ */
+duk_ret_t
+readTransforms(duk_context* pContext);
+
+
+/**
+ * Capture the state of a `World` into a buffer.
+ *
+ * Returns a plain buffer holding the state, as written by @ref
+ * scene::saveWorldState, with bodies identified by their handles. Bodies
+ * without a handle are given one.
+ */
+duk_ret_t
+snapshot(duk_context* pContext);
+
+
+/**
+ * Restore a `World` to a state captured by `snapshot`.
+ *
+ * Requires the buffer returned by `snapshot`. Bodies which still exist are
+ * updated in place, keeping their `Body` objects. Bodies created since the
+ * snapshot are destroyed and their handles invalidated, and destroyed
+ * bodies are recreated without `Body` objects. Throws a `TypeError`, leaving
+ * the world as it was, if the buffer isn't a valid state or the world is
+ * stepping.
+ */
+duk_ret_t
+restore(duk_context* pContext);
+
+
 /** Return a string representing this `World`. */
 duk_ret_t
 toString(duk_context* pContext);
@@ -1,5 +1,8 @@
 #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__LOADERS__H
 #define DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__LOADERS__H
+#include <cstddef>
+#include <memory>
+
 #include "Box2D/Common/b2Math.h"
 #include <Box2D/Collision/Shapes/b2Shape.h>
 
@@ -20,9 +23,16 @@ namespace dukdemo {
 namespace scripting {
 
 
+struct EnumNames;
+struct SchemaField;
+
+
 /**
  * Load coordinates from an object on the value stack.
  *
+ * The object may be an array, or a `Float32Array`/`Float64Array` whose first
+ * two elements are read directly. Typed array coordinates must be finite.
+ *
  * @param pContext the duktape context.
  * @param pResult a pointer to the b2Vec2 to store values in.
  * @param vecIdx the value stack index of the JS property.
@@ -164,43 +174,35 @@ loadOptionalBoolProp(
 
 
 /**
- * Lookup a name in a table.
- *
- * Used for translating strings into enumerated values.
+ * Find a b2BodyDef property read by @ref loadBodyDef, for loaders which don't
+ * go through JS objects.
  *
- * @param pCandidate the name to look up.
- * @param pNameTable the name table.
- * @param tableSize the number of entries in the table.
- * @returns the index of the name if found; otherwise `tableSize`.
+ * @returns the property's field, or `nullptr` if there's no such property.
  */
-duk_uint_t
-lookupName(
-	char const* const pCandidate,
-	char const* const* const pNameTable,
-	duk_uint_t const tableSize
-) noexcept;
+SchemaField const*
+findBodyDefField(char const* pName, std::size_t length) noexcept;
 
 
 /**
- * Get an enumerated value.
+ * Find a b2FixtureDef property read by @ref loadFixtureDefWithoutShape.
  *
- * @param pContext the duktape context.
- * @param idx the value stack index of the owning object.
- * @param pNameTable the name table, organised in the enumeration order.
- * @param tableSize the number of entries in the table.
+ * @returns the property's field, or `nullptr` if there's no such property.
  */
-duk_uint_t
-getEnum(
-	duk_context* pContext,
-	duk_idx_t idx,
-	char const* const* const pNameTable,
-	duk_uint_t tableSize
-) noexcept;
+SchemaField const*
+findFixtureDefField(char const* pName, std::size_t length) noexcept;
+
+
+/** The names of each @ref b2Shape::Type, as read by @ref getShapeType. */
+EnumNames const&
+getShapeTypeNames() noexcept;
 
 
 /**
  * Load values from an object on the value stack into a b2BodyDef.
  *
+ * Only the object's own enumerable properties are read, in a single pass
+ * over its keys, so sparse definitions load quickly.
+ *
  * @note Does not attempt to load any user data.
  *
  * @param pContext the duktape context.
@@ -217,20 +219,22 @@ loadBodyDef(
 
 
 /**
- * Load values from an object on the value stack into a b2AABB.
+ * Load values from an object on the value stack into a b2Filter.
  *
  * @param pContext the duktape context.
- * @param pDef a pointer to the filter definition to overwrite values in.
+ * @param pFilter a pointer to the filter to overwrite values in.
  * @param index the value stack index of the JS filter definition.
  * @returns false iff the JS object is invalid.
  */
 bool
-loadFilter(duk_context* pContext, duk_idx_t defIdx, b2AABB* pAABB) noexcept;
+loadFilter(duk_context* pContext, duk_idx_t index, b2Filter* pFilter) noexcept;
 
 
 /**
  * Load values from an object on the value stack into a b2FixtureDef.
  *
+ * As with @ref loadBodyDef, only own enumerable properties are read.
+ *
  * @note Does not attempt to load any user data.
  * @note Does not load the shape as this would complicate memory management.
  * Use in conjunction with the shape loading methods.
@@ -253,6 +257,9 @@ loadFixtureDefWithoutShape(
 /**
  * Get the type of a b2Shape from an object on the value stack.
  *
+ * The type is read from the object's `type` property, which may be a name
+ * (`"circle"`, `"edge"`, `"polygon"`, `"chain"`) or a @ref b2Shape::Type.
+ *
  * @param pContext the duktape context.
  * @param shapeIdx the value stack index of the shape JS object.
  * @returns the shape type if valid; otherwise @ref b2Shape::e_typeCount.
@@ -278,10 +285,43 @@ loadCircle(
 ) noexcept;
 
 
+/**
+ * Check polygon vertices as `b2PolygonShape::Set` asserts: after welding
+ * vertices closer than half of `b2_linearSlop`, their hull must have an area.
+ *
+ * @param pVertices the vertices, which must be finite.
+ * @param count the number of vertices.
+ * @returns whether `Set` can be called with the vertices.
+ */
+bool
+validatePolygonVertices(b2Vec2 const* pVertices, std::size_t count) noexcept;
+
+
+/**
+ * Check chain vertices as `b2ChainShape::CreateChain` and `CreateLoop`
+ * assert: at least two vertices for a chain and three for a loop, each
+ * further than `b2_linearSlop` from the next.
+ *
+ * @param pVertices the vertices, which must be finite.
+ * @param count the number of vertices.
+ * @param isLoop whether the last vertex is joined to the first.
+ * @returns whether the chain can be created from the vertices.
+ */
+bool
+validateChainVertices(
+	b2Vec2 const* pVertices,
+	std::size_t count,
+	bool isLoop
+)
+	noexcept;
+
+
 /**
  * Load a polygon shape.
  *
  * @note Required properties are: `vertices`.
+ * @note `vertices` may be an array of coordinate arrays, or a flat
+ * `Float32Array`/`Float64Array` of `x, y` pairs.
  *
  * @param pContext the duktape context.
  * @param idx the value stack index of the shape JS object.
@@ -318,6 +358,9 @@ loadEdge(
  *
  * @note Required properties are: `vertices`.
  * @note Optional properties are: `loop` (default false), `prev`, `next`.
+ * @note `vertices` may be an array of coordinate arrays, or a flat
+ * `Float32Array`/`Float64Array` of `x, y` pairs. A `Float32Array` is read in
+ * place without an intermediate copy.
  *
  * @param pContext the duktape context.
  * @param idx the value stack index of the shape JS object.
@@ -331,6 +374,20 @@ loadChain(
 );
 
 
+/**
+ * Load a shape of any type.
+ *
+ * Dispatches on the `type` property (see @ref getShapeType) to the matching
+ * shape loader.
+ *
+ * @param pContext the duktape context.
+ * @param idx the value stack index of the shape JS object.
+ * @returns the loaded shape, or `nullptr` if the JS object is invalid.
+ */
+std::unique_ptr<b2Shape>
+loadShape(duk_context* pContext, duk_idx_t idx);
+
+
 } // namespace scripting
 } // namespace dukdemo
 #endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SCRIPTING__LOADERS__H
@@ -10,21 +10,35 @@ namespace dukdemo {
 namespace scripting {
 
 
-#define GLOBAL_HIDDEN_SYMBOL(str) ("!G" str)
-#define LOCAL_HIDDEN_SYMBOL(str)  ("!L" str)
+// Duktape treats keys starting with the byte 0xFF as hidden symbols: they are
+// not enumerable and cannot be reached from ECMAScript code.
+#define GLOBAL_HIDDEN_SYMBOL(str) ("\xFF" "G" str)
+#define LOCAL_HIDDEN_SYMBOL(str)  ("\xFF" "L" str)
 
 
-constexpr char const* const g_ownBodyPtrSym = LOCAL_HIDDEN_SYMBOL("mpBody");
 constexpr char const* const g_ownWorldPtrSym = LOCAL_HIDDEN_SYMBOL("mpWrld");
+constexpr char const* const g_worldOwnsBodiesSym =
+	LOCAL_HIDDEN_SYMBOL("bOwnsB");
+constexpr char const* const g_ownPrefabPtrSym = LOCAL_HIDDEN_SYMBOL("mpPfab");
+constexpr char const* const g_worldSerialsSym = LOCAL_HIDDEN_SYMBOL("oSrls");
+constexpr char const* const g_ownSerialsPtrSym = LOCAL_HIDDEN_SYMBOL("mpSrls");
 
 constexpr char const* const g_ownWorldPropSym = "world";
 
 
 constexpr char const* const g_bodyProtoSym = GLOBAL_HIDDEN_SYMBOL("BProto");
 constexpr char const* const g_worldProtoSym = GLOBAL_HIDDEN_SYMBOL("WProto");
+constexpr char const* const g_enumNamesSym = GLOBAL_HIDDEN_SYMBOL("ENames");
+constexpr char const* const g_float32ProtoSym =
+	GLOBAL_HIDDEN_SYMBOL("F32Pro");
+constexpr char const* const g_float64ProtoSym =
+	GLOBAL_HIDDEN_SYMBOL("F64Pro");
 
 constexpr char const* const g_worldCtorSym = "World";
 
+/** The global name of the `profiler` object; see @ref profiler::init. */
+constexpr char const* const g_profilerGlobalName = "profiler";
+
 
 void*
 getPointerFromThis(duk_context* pContext, char const* const pPropName);
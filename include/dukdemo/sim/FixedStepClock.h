@@ -0,0 +1,78 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__FIXEDSTEPCLOCK__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__FIXEDSTEPCLOCK__H
+#include <cstddef>
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/**
+ * Converts elapsed wall-clock time into a number of fixed-size steps.
+ *
+ * Time accumulates between calls to @ref advance, and whole steps are taken
+ * from it. The remainder gives the interpolation factor for rendering. To
+ * avoid a spiral of death when steps take longer than real time, at most
+ * `maxStepsPerAdvance` steps are returned per call; time for any further
+ * steps is dropped, so the simulation slows down rather than falling behind.
+ */
+class FixedStepClock
+{
+public:
+	/**
+	 * @param stepSeconds the duration of each step.
+	 * @param maxStepsPerAdvance the catch-up limit for a single call.
+	 */
+	explicit FixedStepClock(
+		double stepSeconds,
+		unsigned maxStepsPerAdvance = 5u
+	) noexcept;
+
+	/**
+	 * Add elapsed time, and get the number of steps now due.
+	 *
+	 * @param elapsedSeconds the wall-clock time since the last call.
+	 * @returns the number of steps to run, at most `maxStepsPerAdvance`.
+	 */
+	unsigned
+	advance(double elapsedSeconds) noexcept;
+
+	/**
+	 * Get how far the simulation is between its last step and the next.
+	 *
+	 * @returns the interpolation factor, in [0, 1).
+	 */
+	inline double
+	alpha() const noexcept
+	{ return m_accumulator / m_stepSeconds; }
+
+	/** Get the wall-clock time until the next step is due. */
+	inline double
+	secondsUntilNextStep() const noexcept
+	{ return m_stepSeconds - m_accumulator; }
+
+	inline double
+	stepSeconds() const noexcept
+	{ return m_stepSeconds; }
+
+	/** Get the number of steps dropped by the catch-up limit. */
+	inline std::size_t
+	droppedSteps() const noexcept
+	{ return m_droppedSteps; }
+
+	/** Discard any accumulated time, e.g. after pausing. */
+	inline void
+	reset() noexcept
+	{ m_accumulator = 0.0; }
+
+private:
+	double m_stepSeconds;
+	double m_accumulator;
+	unsigned m_maxStepsPerAdvance;
+	std::size_t m_droppedSteps;
+};
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__FIXEDSTEPCLOCK__H
@@ -0,0 +1,100 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__RUNNER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__RUNNER__H
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+class b2World;
+
+
+namespace dukdemo {
+
+
+namespace util {
+class FrameProfiler;
+} // namespace util
+
+
+namespace sim {
+
+
+/** Options for stepping a world at a fixed timestep. */
+struct RunOptions
+{
+	float timeStep = 1.0f / 60.0f;
+	int velocityIterations = 8;
+	int positionIterations = 3;
+
+	/** Stop after this many steps. */
+	std::size_t maxSteps = 600u;
+
+	/** Stop once this much wall-clock time has passed; zero for no limit. */
+	std::chrono::duration<double> deadline{0.0};
+
+	/**
+	 * If set, times each step as a frame, with "script" and "step" phases
+	 * for the function called before stepping and the step itself.
+	 */
+	util::FrameProfiler* pProfiler = nullptr;
+};
+
+
+/** Timings gathered while stepping a world. */
+struct RunStats
+{
+	/** The wall-clock duration of each step, in seconds. */
+	std::vector<double> stepSeconds{};
+
+	/** The total wall-clock time spent running, in seconds. */
+	double elapsedSeconds = 0.0;
+
+	inline std::size_t
+	steps() const noexcept
+	{ return stepSeconds.size(); }
+
+	/** Get the number of steps completed per wall-clock second. */
+	double
+	stepsPerSecond() const noexcept;
+
+	/**
+	 * Get a step latency percentile, using the nearest-rank method.
+	 *
+	 * @param percent the percentile, in [0, 100].
+	 * @returns the latency in seconds, or zero if no steps were run.
+	 */
+	double
+	percentile(double percent) const;
+};
+
+
+/** A function called before or after each step, given the step index. */
+using StepFn = std::function<void(std::size_t)>;
+
+
+/**
+ * Step a world at a fixed timestep, as fast as possible.
+ *
+ * Runs until @ref RunOptions::maxSteps steps have completed, or until @ref
+ * RunOptions::deadline has passed, whichever is sooner.
+ *
+ * @param world the world to step.
+ * @param options the timestep and stopping conditions.
+ * @param beforeStep an optional function to call before each step. Its run
+ * time is included in the step latency.
+ * @param afterStep an optional function to call after each step, e.g. to
+ * collect garbage. Its run time is included in the step latency.
+ */
+RunStats
+runFixedSteps(
+	b2World& world,
+	RunOptions const& options,
+	StepFn const& beforeStep = nullptr,
+	StepFn const& afterStep = nullptr
+);
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__RUNNER__H
@@ -0,0 +1,175 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__SIMULATIONTHREAD__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__SIMULATIONTHREAD__H
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "dukdemo/sim/FixedStepClock.h"
+#include "dukdemo/sim/Snapshot.h"
+#include "dukdemo/sim/TransformHistory.h"
+#include "dukdemo/sim/VisibleBodies.h"
+#include "dukdemo/util/TripleBuffer.h"
+
+
+class b2World;
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/**
+ * Steps a world at a fixed rate on its own thread.
+ *
+ * After each batch of steps the thread captures a @ref Snapshot and
+ * publishes it through a lock-free triple buffer, so a render thread can
+ * draw the latest state without waiting for, or ever blocking, the
+ * simulation. Frame time becomes the longer of stepping and drawing, rather
+ * than their sum.
+ *
+ * Once started, the world belongs to the simulation thread: nothing else
+ * may touch it, or anything it owns, until @ref stop returns.
+ */
+class SimulationThread
+{
+public:
+	/**
+	 * A function stepping the world once, along with any scripts. Called on
+	 * the simulation thread.
+	 */
+	using StepFn = std::function<void()>;
+
+	/**
+	 * A function called on the simulation thread after each snapshot is
+	 * published, e.g. to wake the render thread.
+	 */
+	using PublishFn = std::function<void(Snapshot const&)>;
+
+	/**
+	 * @param world the world to snapshot.
+	 * @param step the function stepping the world.
+	 * @param stepSeconds the wall-clock duration of each step.
+	 * @param maxStepsPerAdvance the catch-up limit after a slow step.
+	 * @param onPublish an optional function called after publishing.
+	 */
+	SimulationThread(
+		b2World& world,
+		StepFn const& step,
+		double stepSeconds,
+		unsigned maxStepsPerAdvance = 5u,
+		PublishFn const& onPublish = nullptr
+	);
+
+	SimulationThread(SimulationThread const&) = delete;
+	SimulationThread& operator=(SimulationThread const&) = delete;
+
+	/** Stop the thread if running, discarding any error it raised. */
+	~SimulationThread() noexcept;
+
+	/** Start stepping. The first snapshot is published immediately. */
+	void
+	start();
+
+	/**
+	 * Stop stepping and wait for the thread to finish.
+	 *
+	 * @throws any exception which ended the thread early.
+	 */
+	void
+	stop();
+
+	/** Whether the thread is stepping; false once an error ends it. */
+	bool
+	running() const;
+
+	void
+	setPaused(bool paused);
+
+	bool
+	paused() const;
+
+	/** Take a single step while paused. */
+	void
+	requestStep();
+
+	/**
+	 * Capture only non-static bodies overlapping a region, e.g. the camera's
+	 * view, from the next snapshot on. While paused, a new snapshot is
+	 * published straight away.
+	 */
+	void
+	setView(b2AABB const& view);
+
+	/** Capture every body again. */
+	void
+	clearView();
+
+	/**
+	 * The version of the world's static geometry, which snapshots only
+	 * recapture when it changes.
+	 *
+	 * Whatever creates or destroys static bodies or their fixtures, or
+	 * changes bodies to or from static, must increment it: on the simulation
+	 * thread, e.g. from the step function, or while stopped. Scripts do so
+	 * when it's their heap's @ref scripting::HeapState::pStaticVersion.
+	 */
+	inline std::uint64_t&
+	staticVersion() noexcept
+	{ return m_staticVersion; }
+
+	/**
+	 * Get the most recently published snapshot. Render thread only; the
+	 * reference is valid until the next call.
+	 */
+	inline Snapshot const&
+	latestSnapshot() noexcept
+	{
+		m_snapshots.update();
+		return m_snapshots.readBuffer();
+	}
+
+private:
+	void
+	run();
+
+	/** Take some steps, then publish a snapshot. */
+	void
+	stepAndPublish(unsigned steps, bool paused);
+
+	b2World& m_world;
+	StepFn m_step;
+	PublishFn m_onPublish;
+
+	// Only used on the simulation thread.
+	FixedStepClock m_clock;
+	TransformHistory m_history;
+	std::uint64_t m_stepCount;
+	std::uint64_t m_staticVersion;
+	std::shared_ptr<Snapshot::StaticGeometry const> m_pStaticGeometry;
+	VisibleBodies m_visibleBodies;
+
+	util::TripleBuffer<Snapshot> m_snapshots;
+
+	// Controls, guarded by m_mutex.
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_running;
+	bool m_stopRequested;
+	bool m_paused;
+	unsigned m_requestedSteps;
+	bool m_hasView;
+	bool m_viewChanged;
+	b2AABB m_view;
+	std::exception_ptr m_pError;
+
+	std::thread m_thread;
+};
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__SIMULATIONTHREAD__H
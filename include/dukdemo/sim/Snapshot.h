@@ -0,0 +1,172 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__SNAPSHOT__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__SNAPSHOT__H
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2Body.h>
+
+#include "dukdemo/sim/TransformHistory.h"
+#include "dukdemo/sim/VisibleBodies.h"
+
+
+class b2World;
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/**
+ * A copy of everything needed to draw a world, taken after a step.
+ *
+ * Snapshots are filled on the simulation thread and then only read on the
+ * render thread, so rendering never touches the live `b2World`. Shapes are
+ * kept in body-local coordinates, along with each body's pose before and
+ * after the latest step, so the renderer can interpolate between them.
+ *
+ * Static bodies are kept apart, in geometry shared by every snapshot until
+ * the world's static geometry version changes. Renderers can compare its
+ * version to upload it only when it changes.
+ */
+struct Snapshot
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class ShapeType : std::uint8_t
+	{
+		circle,
+		edge,
+		chain,
+		polygon
+	};
+
+	struct Shape
+	{
+		ShapeType type;
+
+		/** The radius of a circle; zero for other shapes. */
+		float radius;
+
+		/**
+		 * The shape's vertices in @ref vertices. A circle has one vertex, its
+		 * centre.
+		 */
+		std::uint32_t firstVertex;
+		std::uint32_t vertexCount;
+	};
+
+	struct Body
+	{
+		Pose previous;
+		Pose current;
+
+		b2BodyType type;
+		bool active;
+		bool awake;
+
+		/** The body's shapes in @ref Geometry::shapes. */
+		std::uint32_t firstShape;
+		std::uint32_t shapeCount;
+	};
+
+	/** Some bodies and their shapes. */
+	struct Geometry
+	{
+		std::vector<Body> bodies{};
+		std::vector<Shape> shapes{};
+		std::vector<b2Vec2> vertices{};
+
+		inline Shape const*
+		shapesOf(Body const& body) const noexcept
+		{ return shapes.data() + body.firstShape; }
+
+		inline b2Vec2 const*
+		verticesOf(Shape const& shape) const noexcept
+		{ return vertices.data() + shape.firstVertex; }
+
+		/** Remove everything, keeping the storage. */
+		void
+		clear() noexcept;
+
+		/** Add a body and its fixtures' shapes. */
+		void
+		append(b2Body const& body, Pose const& previous);
+	};
+
+	/** The geometry of a world's static bodies. */
+	struct StaticGeometry
+	{
+		Geometry geometry;
+
+		/** The static geometry version this was captured at. */
+		std::uint64_t version;
+	};
+
+	/** Every body which isn't static. */
+	Geometry dynamicGeometry{};
+
+	/** The static bodies; null until captured. */
+	std::shared_ptr<StaticGeometry const> pStaticGeometry{};
+
+	/**
+	 * Fixtures of non-static bodies captured, and the non-static bodies
+	 * culled. The demo reports them through its @ref util::FrameProfiler.
+	 */
+	std::size_t drawnFixtures = 0u;
+	std::size_t culledBodies = 0u;
+
+	/** The number of steps taken before this snapshot. */
+	std::uint64_t stepCount = 0u;
+
+	/** The wall-clock time at which the latest step fell due. */
+	Clock::time_point stepTime{};
+
+	/** The simulated duration of a step, in seconds. */
+	double stepSeconds = 0.0;
+
+	/** Whether the simulation was paused, so shouldn't be interpolated. */
+	bool paused = false;
+
+	/**
+	 * Replace the contents with a world's bodies and shapes.
+	 *
+	 * Reuses the existing storage for dynamic geometry, so doesn't allocate
+	 * once large enough. Static geometry is only rebuilt if `staticVersion`
+	 * differs from the version of `pPreviousStatic`. It isn't culled, since
+	 * it stays on the GPU.
+	 *
+	 * @param world the world, just after stepping.
+	 * @param history the transforms from before the step.
+	 * @param pPreviousStatic the static geometry of the previous snapshot.
+	 * @param staticVersion the world's static geometry version, incremented
+	 * whenever static bodies or their fixtures are created or destroyed, or
+	 * bodies change to or from static.
+	 * @param pVisible if given, only these non-static bodies are captured,
+	 * without walking the rest of the world's bodies.
+	 */
+	void
+	capture(
+		b2World const& world,
+		TransformHistory const& history,
+		std::shared_ptr<StaticGeometry const> const& pPreviousStatic,
+		std::uint64_t staticVersion,
+		VisibleBodies const* pVisible = nullptr
+	);
+
+	/**
+	 * Get the interpolation factor for drawing at a given time.
+	 *
+	 * @returns the factor in [0, 1]; 1 if paused.
+	 */
+	float
+	alpha(Clock::time_point now) const noexcept;
+};
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__SNAPSHOT__H
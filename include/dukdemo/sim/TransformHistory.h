@@ -0,0 +1,101 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__TRANSFORMHISTORY__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__TRANSFORMHISTORY__H
+#include <cstddef>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+
+
+class b2Body;
+class b2World;
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/** A body's position and unwrapped angle, which interpolate linearly. */
+struct Pose
+{
+	b2Vec2 position;
+	float angle;
+
+	inline b2Transform
+	transform() const noexcept
+	{ return b2Transform{position, b2Rot{angle}}; }
+};
+
+
+/** Interpolate between poses: 0 gives `from`, 1 gives `to`. */
+inline Pose
+lerp(Pose const& from, Pose const& to, float alpha) noexcept
+{
+	return Pose{
+		from.position + alpha * (to.position - from.position),
+		from.angle + alpha * (to.angle - from.angle)
+	};
+}
+
+
+/**
+ * Body transforms from before the latest step, for render interpolation.
+ *
+ * Capture immediately before stepping. Bodies are matched to their previous
+ * transform by address, through an open-addressed table, so looking one up
+ * costs the same however many bodies the world has.
+ */
+class TransformHistory
+{
+public:
+	/** Record the position and angle of every body in a world. */
+	void
+	capture(b2World const& world);
+
+	/**
+	 * Interpolate a body's transform between the capture and now.
+	 *
+	 * Bodies created since the capture use their current transform.
+	 *
+	 * @param body the body.
+	 * @param alpha the interpolation factor: 0 at the capture, 1 for now.
+	 */
+	b2Transform
+	interpolate(b2Body const& body, float alpha) const noexcept;
+
+	/**
+	 * Get a body's pose at the capture.
+	 *
+	 * Bodies created since the capture give their current pose.
+	 */
+	Pose
+	previous(b2Body const& body) const noexcept;
+
+	inline void
+	clear() noexcept
+	{ m_entries.clear(); }
+
+private:
+	struct Entry
+	{
+		b2Body const* pBody;
+		Pose pose;
+	};
+
+	/** The slot to start probing at for a body. */
+	std::size_t
+	slotOf(b2Body const& body) const noexcept;
+
+	/**
+	 * Entries by body address, with linear probing. Empty slots have no
+	 * body; the size is a power of two, at least twice the body count.
+	 */
+	std::vector<Entry> m_entries{};
+
+	/** Shifts a hashed address down to a slot index. */
+	unsigned m_shift = 0u;
+};
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__TRANSFORMHISTORY__H
@@ -0,0 +1,60 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__VISIBLEBODIES__H
+#define DUKDEMO_INCLUDE__DUKDEMO__SIM__VISIBLEBODIES__H
+#include <cstddef>
+#include <vector>
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
+
+
+class b2Body;
+class b2World;
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/**
+ * The non-static bodies with a fixture in a region, found via the
+ * broadphase.
+ *
+ * `b2World::QueryAABB` only visits the broadphase tree nodes overlapping
+ * the region, so finding the visible bodies costs little more than the
+ * number of visible fixtures, however large the world. Inactive bodies have
+ * no broadphase proxies, so are never found.
+ */
+class VisibleBodies: private b2QueryCallback
+{
+public:
+	VisibleBodies() = default;
+
+	/** Replace the set with the bodies overlapping a region. */
+	void
+	query(b2World const& world, b2AABB const& region);
+
+	/** Whether a body was found by the latest query. */
+	bool
+	contains(b2Body const& body) const noexcept;
+
+	/** The bodies found by the latest query, each once. */
+	inline std::vector<b2Body const*> const&
+	bodies() const noexcept
+	{ return m_bodies; }
+
+	inline std::size_t
+	size() const noexcept
+	{ return m_bodies.size(); }
+
+private:
+	bool
+	ReportFixture(b2Fixture* pFixture) override;
+
+	/** The bodies found, sorted by address once the query completes. */
+	std::vector<b2Body const*> m_bodies{};
+};
+
+
+} // namespace sim
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__SIM__VISIBLEBODIES__H
@@ -0,0 +1,157 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__FRAMEPROFILER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__FRAMEPROFILER__H
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dukdemo/util/RollingHistogram.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * Rolling CPU and GPU timings for the phases of a frame.
+ *
+ * Each phase, e.g. stepping the world or swapping buffers, is registered
+ * once by name and then timed every frame, with a @ref ScopedTimer on the
+ * CPU or via `render::GpuTimer` on the GPU. Only the latest frames are kept,
+ * so the timings reflect recent behaviour.
+ *
+ * Recording is thread safe, so phases can be timed on the simulation and
+ * render threads alike.
+ */
+class FrameProfiler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t s_defaultWindow = 600u;
+
+	/** The phase timing whole frames, between calls to @ref endFrame. */
+	static constexpr std::size_t s_framePhase = 0u;
+
+	/** The timings of one phase. */
+	struct Phase
+	{
+		std::string name;
+		RollingHistogram cpu;
+		RollingHistogram gpu;
+	};
+
+	/** A quantity counted once per frame, such as objects drawn. */
+	struct Counter
+	{
+		std::string name;
+		std::uint64_t latest;
+		std::uint64_t total;
+		std::uint64_t samples;
+
+		/** @returns the mean count per sample, or zero if none. */
+		inline double
+		mean() const noexcept
+		{ return samples ? double(total) / double(samples) : 0.0; }
+	};
+
+	/**
+	 * Times a phase on the CPU, from construction until destruction. Does
+	 * nothing without a profiler.
+	 */
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(FrameProfiler* pProfiler, std::size_t phase) noexcept;
+
+		ScopedTimer(ScopedTimer const&) = delete;
+		ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+		~ScopedTimer() noexcept;
+
+	private:
+		FrameProfiler* m_pProfiler;
+		std::size_t m_phase;
+		Clock::time_point m_start;
+	};
+
+	/** @param window the number of samples kept for each phase. */
+	explicit FrameProfiler(std::size_t window = s_defaultWindow);
+
+	FrameProfiler(FrameProfiler const&) = delete;
+	FrameProfiler& operator=(FrameProfiler const&) = delete;
+
+	/**
+	 * Register a phase.
+	 *
+	 * @returns the phase's index, which is the existing one if the name is
+	 * already registered.
+	 */
+	std::size_t
+	addPhase(std::string const& name);
+
+	/**
+	 * Register a counter.
+	 *
+	 * @returns the counter's index, which is the existing one if the name is
+	 * already registered.
+	 */
+	std::size_t
+	addCounter(std::string const& name);
+
+	/** Record a frame's value of a counter. */
+	void
+	recordCount(std::size_t counter, std::uint64_t value) noexcept;
+
+	void
+	recordCpu(std::size_t phase, double seconds) noexcept;
+
+	void
+	recordGpu(std::size_t phase, double seconds) noexcept;
+
+	/** Finish a frame, timing it since the previous call. */
+	void
+	endFrame() noexcept;
+
+	/** The number of frames finished. */
+	std::uint64_t
+	frames() const;
+
+	/** Copy every phase's timings, in registration order. */
+	std::vector<Phase>
+	phases() const;
+
+	/** Copy every counter, in registration order. */
+	std::vector<Counter>
+	counters() const;
+
+	/** Write a summary of each phase's timings and each counter. */
+	void
+	writeReport(std::ostream& out) const;
+
+	/**
+	 * Write the report to a file, replacing it.
+	 *
+	 * @throws std::runtime_error if the file can't be written.
+	 */
+	void
+	dump(std::string const& path) const;
+
+private:
+	mutable std::mutex m_mutex;
+	std::size_t m_window;
+	std::vector<Phase> m_phases;
+	std::vector<Counter> m_counters;
+	std::uint64_t m_frames;
+
+	/** When the previous frame ended; zero before the first. */
+	Clock::time_point m_frameEnd;
+};
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__FRAMEPROFILER__H
@@ -0,0 +1,49 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__MAPPEDFILE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__MAPPEDFILE__H
+#include <cstddef>
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * A read-only memory mapping of a whole file.
+ *
+ * Pages are read in by the OS as they're first touched, so opening a large
+ * file is cheap, and reading it costs little more than a `memcpy`.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * Map a file.
+	 *
+	 * @param pPath the file's path.
+	 * @throws std::runtime_error if the file can't be opened or mapped.
+	 */
+	explicit MappedFile(char const* pPath);
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	~MappedFile();
+
+	/** The file's contents; null if it's empty. Page aligned. */
+	inline void const*
+	data() const noexcept
+	{ return m_pData; }
+
+	inline std::size_t
+	size() const noexcept
+	{ return m_size; }
+
+private:
+	void* m_pData;
+	std::size_t m_size;
+};
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__MAPPEDFILE__H
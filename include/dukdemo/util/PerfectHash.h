@@ -0,0 +1,158 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__PERFECTHASH__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__PERFECTHASH__H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * FNV-1a over a string's bytes, perturbed by a seed. The result is mixed so
+ * that its low bits depend on every bit of the input.
+ */
+constexpr std::uint32_t
+hashName(char const* pName, std::size_t length, std::uint32_t seed) noexcept
+{
+	std::uint32_t hash = 2166136261u ^ seed;
+	for (std::size_t i = 0u; i < length; ++i)
+	{
+		hash ^= std::uint8_t(pName[i]);
+		hash *= 16777619u;
+	}
+	hash ^= hash >> 16u;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13u;
+	return hash;
+}
+
+
+/**
+ * The slots in a @ref PerfectHash: twice the names, rounded up to a power of
+ * two, so that a seed is found quickly.
+ */
+constexpr std::size_t
+perfectHashSlotCount(std::size_t nameCount) noexcept
+{
+	std::size_t count = 1u;
+	while (count < 2u * nameCount)
+	{
+		count *= 2u;
+	}
+	return count;
+}
+
+
+/**
+ * A collision-free hash table from a fixed set of names to their indices.
+ *
+ * The table is built at compile time by searching for a hash seed under which
+ * no two names share a slot, so a lookup is a single hash, one slot read and
+ * one string comparison. Construction fails to compile if the names aren't
+ * distinct.
+ *
+ * @tparam N the number of names.
+ */
+template <std::size_t N>
+class PerfectHash
+{
+public:
+	static_assert(0u < N && N < 255u, "PerfectHash supports 1 to 254 names");
+
+	static constexpr std::size_t s_slotCount = perfectHashSlotCount(N);
+
+	/** @param names the names, which must outlive the table. */
+	constexpr explicit
+	PerfectHash(std::array<char const*, N> const& names)
+		:	m_names{names}
+		,	m_lengths{}
+		,	m_seed{0u}
+		,	m_slots{}
+	{
+		for (std::size_t i = 0u; i < N; ++i)
+		{
+			m_lengths[i] = std::char_traits<char>::length(names[i]);
+		}
+
+		constexpr std::uint32_t maxSeed{1u << 16u};
+		for (; m_seed < maxSeed; ++m_seed)
+		{
+			if (tryFill())
+			{
+				return;
+			}
+		}
+		throw std::logic_error{"No perfect hash found; are names repeated?"};
+	}
+
+	/**
+	 * Find a name.
+	 *
+	 * @param pKey the name's characters, which needn't be null terminated.
+	 * @param length the number of characters.
+	 * @returns the name's index, or `N` if it's not in the table.
+	 */
+	constexpr std::size_t
+	find(char const* pKey, std::size_t length) const noexcept
+	{
+		auto const slot = m_slots[slotOf(pKey, length, m_seed)];
+		if (slot == 0u)
+		{
+			return N;
+		}
+
+		std::size_t const index = slot - 1u;
+		return m_lengths[index] == length
+			&& std::char_traits<char>::compare(
+				m_names[index], pKey, length) == 0
+			? index
+			: N;
+	}
+
+	/** Find a null-terminated name. */
+	constexpr std::size_t
+	find(char const* pKey) const noexcept
+	{ return find(pKey, std::char_traits<char>::length(pKey)); }
+
+	constexpr char const*
+	name(std::size_t index) const noexcept
+	{ return m_names[index]; }
+
+private:
+	static constexpr std::size_t
+	slotOf(char const* pKey, std::size_t length, std::uint32_t seed) noexcept
+	{ return hashName(pKey, length, seed) & (s_slotCount - 1u); }
+
+	/** Place every name under the current seed; false on a collision. */
+	constexpr bool
+	tryFill() noexcept
+	{
+		m_slots = {};
+		for (std::size_t i = 0u; i < N; ++i)
+		{
+			auto& slot = m_slots[slotOf(m_names[i], m_lengths[i], m_seed)];
+			if (slot != 0u)
+			{
+				return false;
+			}
+			slot = std::uint8_t(i + 1u);
+		}
+		return true;
+	}
+
+	std::array<char const*, N> m_names;
+	std::array<std::size_t, N> m_lengths;
+	std::uint32_t m_seed;
+
+	/** One more than the index of the name in each slot; zero if empty. */
+	std::array<std::uint8_t, s_slotCount> m_slots;
+};
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__PERFECTHASH__H
@@ -0,0 +1,96 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__ROLLINGHISTOGRAM__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__ROLLINGHISTOGRAM__H
+#include <array>
+#include <cstddef>
+#include <vector>
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * Durations from a sliding window of the latest samples.
+ *
+ * Samples are kept in a ring, so adding one never allocates once the window
+ * is full. Bucket counts are updated as samples enter and leave the window;
+ * other statistics are computed on demand.
+ */
+class RollingHistogram
+{
+public:
+	/**
+	 * The number of buckets. Bucket 0 holds durations below a microsecond,
+	 * and each following bucket's bound doubles. The last bucket holds
+	 * everything from its lower bound up.
+	 */
+	static constexpr std::size_t s_bucketCount = 18u;
+
+	/** @param window the number of samples kept. */
+	explicit RollingHistogram(std::size_t window);
+
+	/** Add a duration in seconds, replacing the oldest if the window's full. */
+	void
+	add(double seconds);
+
+	/** Remove every sample. */
+	void
+	clear() noexcept;
+
+	/** The number of samples in the window. */
+	inline std::size_t
+	size() const noexcept
+	{ return m_samples.size(); }
+
+	inline std::size_t
+	window() const noexcept
+	{ return m_window; }
+
+	/** @returns the mean duration in seconds, or zero if empty. */
+	double
+	mean() const noexcept;
+
+	/** @returns the longest duration in seconds, or zero if empty. */
+	double
+	max() const noexcept;
+
+	/**
+	 * Get a percentile, using the nearest-rank method.
+	 *
+	 * @param percent the percentile, in [0, 100].
+	 * @returns the duration in seconds, or zero if empty.
+	 */
+	double
+	percentile(double percent) const;
+
+	/** The number of samples in a bucket. */
+	inline std::size_t
+	bucket(std::size_t index) const noexcept
+	{ return m_buckets[index]; }
+
+	/**
+	 * Get the exclusive upper bound of a bucket, in seconds.
+	 *
+	 * @returns the bound; infinity for the last bucket.
+	 */
+	static double
+	bucketUpperBound(std::size_t index) noexcept;
+
+	/** Get the bucket a duration falls in. */
+	static std::size_t
+	bucketOf(double seconds) noexcept;
+
+private:
+	std::size_t m_window;
+	std::vector<double> m_samples;
+
+	/** Where the next sample goes once the window is full. */
+	std::size_t m_next;
+
+	std::array<std::size_t, s_bucketCount> m_buckets;
+};
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__ROLLINGHISTOGRAM__H
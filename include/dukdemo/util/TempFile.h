@@ -0,0 +1,26 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TEMPFILE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__TEMPFILE__H
+#include <string>
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * Create an empty, uniquely named file to be renamed over another.
+ *
+ * The file is made with `mkstemp` in the same directory as @p path, so the
+ * rename is atomic and concurrent writers never share a temporary file. It
+ * is readable by everyone, as files written directly usually are.
+ *
+ * @param path the path the file will be renamed to.
+ * @returns the new file's path, or an empty string if it couldn't be made.
+ */
+std::string
+createTempFileFor(std::string const& path);
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TEMPFILE__H
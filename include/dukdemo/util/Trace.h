@@ -0,0 +1,159 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRACE__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRACE__H
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+
+
+namespace dukdemo {
+namespace util {
+namespace trace {
+
+
+/**
+ * A timeline of scoped events, written as Chrome `trace_event` JSON.
+ *
+ * Each thread records into its own fixed-size ring buffer, created on the
+ * thread's first event, so recording never allocates or locks afterwards.
+ * Once a buffer is full, its oldest events are overwritten. Buffers outlive
+ * their threads, so events from finished threads are still written.
+ *
+ * Use the `DUKDEMO_TRACE_*` macros to record. They compile to nothing unless
+ * `DUKDEMO_TRACE` is defined, which the `DUKDEMO_TRACE` CMake option does.
+ * Event names and categories must be string literals, or otherwise outlive
+ * the trace, since only their addresses are kept.
+ */
+
+
+using Clock = std::chrono::steady_clock;
+
+
+/** The events kept per thread; older events are overwritten. */
+constexpr std::size_t g_eventsPerThread = std::size_t{1u} << 16u;
+
+
+/** Whether the trace macros record anything in this build. */
+constexpr bool
+compiledIn() noexcept
+{
+#ifdef DUKDEMO_TRACE
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/** Whether events are being recorded; true until disabled. */
+bool
+enabled() noexcept;
+
+
+/** Start or stop recording, e.g. to capture only a region of interest. */
+void
+setEnabled(bool enabled) noexcept;
+
+
+/** Name the calling thread in the trace. */
+void
+setThreadName(char const* pName);
+
+
+/** Record an event which ran from `start` until `end`. */
+void
+complete(
+	char const* pCategory,
+	char const* pName,
+	Clock::time_point start,
+	Clock::time_point end
+) noexcept;
+
+
+/** Record an event at a single point in time. */
+void
+instant(char const* pCategory, char const* pName) noexcept;
+
+
+/**
+ * Write every thread's events as a Chrome trace.
+ *
+ * Events recorded while writing may be torn, so call this once the recording
+ * threads are idle.
+ */
+void
+writeChromeTrace(std::ostream& out);
+
+
+/**
+ * Write a Chrome trace to a file, replacing it.
+ *
+ * @throws std::runtime_error if the file can't be written.
+ */
+void
+dump(char const* pPath);
+
+
+/** Discard every recorded event. Recording threads must be idle. */
+void
+clear() noexcept;
+
+
+/** Records an event lasting from construction until destruction. */
+class Scope
+{
+public:
+	inline
+	Scope(char const* pCategory, char const* pName) noexcept
+		:	m_pCategory{pCategory}
+		,	m_pName{pName}
+		,	m_start{enabled() ? Clock::now() : Clock::time_point{}}
+	{}
+
+	Scope(Scope const&) = delete;
+	Scope& operator=(Scope const&) = delete;
+
+	inline
+	~Scope() noexcept
+	{
+		if (m_start != Clock::time_point{})
+		{
+			complete(m_pCategory, m_pName, m_start, Clock::now());
+		}
+	}
+
+private:
+	char const* m_pCategory;
+	char const* m_pName;
+	Clock::time_point m_start;
+};
+
+
+} // namespace trace
+} // namespace util
+} // namespace dukdemo
+
+
+#define DUKDEMO_TRACE_CONCAT_IMPL(a, b) a##b
+#define DUKDEMO_TRACE_CONCAT(a, b) DUKDEMO_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef DUKDEMO_TRACE
+/** Record the rest of the enclosing scope as an event. */
+#define DUKDEMO_TRACE_SCOPE(category, name) \
+	::dukdemo::util::trace::Scope DUKDEMO_TRACE_CONCAT( \
+		dukdemoTraceScope, __LINE__){category, name}
+
+/** Record a point in time. */
+#define DUKDEMO_TRACE_INSTANT(category, name) \
+	::dukdemo::util::trace::instant(category, name)
+
+/** Name the calling thread. */
+#define DUKDEMO_TRACE_THREAD_NAME(name) \
+	::dukdemo::util::trace::setThreadName(name)
+#else
+#define DUKDEMO_TRACE_SCOPE(category, name) ((void) 0)
+#define DUKDEMO_TRACE_INSTANT(category, name) ((void) 0)
+#define DUKDEMO_TRACE_THREAD_NAME(name) ((void) 0)
+#endif
+
+
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRACE__H
@@ -0,0 +1,94 @@
+#ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRIPLEBUFFER__H
+#define DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRIPLEBUFFER__H
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * A lock-free triple buffer, passing values from one writer thread to one
+ * reader thread.
+ *
+ * The writer fills @ref writeBuffer and then calls @ref publish; the reader
+ * calls @ref update and then uses @ref readBuffer. Neither side ever waits
+ * for the other: the writer always has a free buffer to fill, and the reader
+ * always sees the most recently published value, skipping any it missed.
+ *
+ * The buffers are reused rather than reconstructed, so values which own
+ * memory (e.g. vectors) stop allocating once they reach a steady size.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(TripleBuffer const&) = delete;
+	TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+	/** Get the buffer to fill before publishing. Writer thread only. */
+	inline T&
+	writeBuffer() noexcept
+	{ return m_buffers[m_writeIndex]; }
+
+	/** Make the write buffer the latest value. Writer thread only. */
+	inline void
+	publish() noexcept
+	{
+		auto const previous = m_shared.exchange(
+			m_writeIndex | s_freshFlag, std::memory_order_acq_rel);
+		m_writeIndex = previous & s_indexMask;
+	}
+
+	/**
+	 * Switch the read buffer to the latest value, if one has been published
+	 * since the last update. Reader thread only.
+	 *
+	 * @returns whether the read buffer changed.
+	 */
+	inline bool
+	update() noexcept
+	{
+		if ((m_shared.load(std::memory_order_relaxed) & s_freshFlag) == 0u)
+		{
+			return false;
+		}
+		auto const previous =
+			m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+		m_readIndex = previous & s_indexMask;
+		return true;
+	}
+
+	/**
+	 * Get the value current as of the last @ref update. Reader thread only.
+	 *
+	 * Before anything is published, this is a default-constructed value.
+	 */
+	inline T const&
+	readBuffer() const noexcept
+	{ return m_buffers[m_readIndex]; }
+
+private:
+	static constexpr unsigned s_indexMask = 0x3u;
+	static constexpr unsigned s_freshFlag = 0x4u;
+
+	/** Each side's index is kept on its own cache line. */
+	static constexpr std::size_t s_cacheLineSize = 64u;
+
+	std::array<T, 3> m_buffers{};
+
+	/** The index of the buffer between the two sides, and the fresh flag. */
+	alignas(s_cacheLineSize) std::atomic<unsigned> m_shared{0u};
+
+	alignas(s_cacheLineSize) unsigned m_writeIndex{1u};
+	alignas(s_cacheLineSize) unsigned m_readIndex{2u};
+};
+
+
+} // namespace util
+} // namespace dukdemo
+#endif // #ifndef DUKDEMO_INCLUDE__DUKDEMO__UTIL__TRIPLEBUFFER__H
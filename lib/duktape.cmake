@@ -3,20 +3,94 @@ if(NOT DUKTAPE_PATH)
 endif()
 
 
+option(
+	DUKTAPE_EXEC_TIMEOUT
+	"Reconfigure Duktape so script execution budgets are enforced"
+	OFF
+)
+option(
+	DUKTAPE_MANUAL_GC
+	"Reconfigure Duktape so mark-and-sweep only runs when scheduled"
+	OFF
+)
+
+
 set(DUKTAPE_VERSION "2.2.0")
 set(DUKTAPE_LIBRARY "duktape")
+set(DUKTAPE_SOURCE_DIR "${DUKTAPE_PATH}/src")
+
+
+# The prebuilt sources in the distributable have no execution timeout hook,
+# and collect garbage whenever enough has been allocated. Generate a configured
+# copy when either needs changing. Requires Python 2 and PyYAML.
+set(DUKTAPE_CONFIG_INPUTS)
+set(DUKTAPE_CONFIGURE_ARGS)
+if(DUKTAPE_EXEC_TIMEOUT)
+	list(
+		APPEND
+		DUKTAPE_CONFIG_INPUTS
+		"${CMAKE_CURRENT_LIST_DIR}/duktape/exec_timeout.yaml"
+		"${CMAKE_CURRENT_LIST_DIR}/duktape/exec_timeout_fixup.h"
+	)
+	list(
+		APPEND
+		DUKTAPE_CONFIGURE_ARGS
+		--option-file "${CMAKE_CURRENT_LIST_DIR}/duktape/exec_timeout.yaml"
+		--fixup-file "${CMAKE_CURRENT_LIST_DIR}/duktape/exec_timeout_fixup.h"
+	)
+	list(
+		APPEND
+		DUKTAPE_EXTRA_C_SOURCES
+		"${CMAKE_CURRENT_LIST_DIR}/duktape/exec_timeout.c"
+	)
+endif()
+if(DUKTAPE_MANUAL_GC)
+	list(
+		APPEND
+		DUKTAPE_CONFIG_INPUTS
+		"${CMAKE_CURRENT_LIST_DIR}/duktape/manual_gc.yaml"
+	)
+	list(
+		APPEND
+		DUKTAPE_CONFIGURE_ARGS
+		--option-file "${CMAKE_CURRENT_LIST_DIR}/duktape/manual_gc.yaml"
+	)
+endif()
+
+if(DUKTAPE_CONFIG_INPUTS)
+	find_package(PythonInterp 2 REQUIRED)
+	set(DUKTAPE_SOURCE_DIR "${CMAKE_BINARY_DIR}/duktape-src")
+	execute_process(
+		COMMAND
+			"${PYTHON_EXECUTABLE}" "${DUKTAPE_PATH}/tools/configure.py"
+			--output-directory "${DUKTAPE_SOURCE_DIR}"
+			${DUKTAPE_CONFIGURE_ARGS}
+		RESULT_VARIABLE DUKTAPE_CONFIGURE_RESULT
+	)
+	if(NOT DUKTAPE_CONFIGURE_RESULT EQUAL 0)
+		message(SEND_ERROR "Failed to configure Duktape")
+	endif()
+	set_property(
+		DIRECTORY
+		APPEND
+		PROPERTY CMAKE_CONFIGURE_DEPENDS ${DUKTAPE_CONFIG_INPUTS}
+	)
+endif()
+
+
 set(
 	DUKTAPE_INCLUDE_DIRS
-	"${DUKTAPE_PATH}/src"
+	"${DUKTAPE_SOURCE_DIR}"
 	# "${DUKTAPE_PATH}/extras/logging"
 	# "${DUKTAPE_PATH}/extras/console"
 	"${DUKTAPE_PATH}/extras/print-alert"
 )
 set(DUKTAPE_C_SOURCES
-	"${DUKTAPE_PATH}/src/duktape.c"
+	"${DUKTAPE_SOURCE_DIR}/duktape.c"
 	# "${DUKTAPE_PATH}/extras/logging/duk_logging.c"
 	# "${DUKTAPE_PATH}/extras/console/duk_console.c"
 	"${DUKTAPE_PATH}/extras/print-alert/duk_print_alert.c"
+	${DUKTAPE_EXTRA_C_SOURCES}
 )
 
 
@@ -28,3 +102,17 @@ set_target_properties(
 	LINKER_LANGAUGE "C"
 )
 target_include_directories(${DUKTAPE_LIBRARY} PUBLIC ${DUKTAPE_INCLUDE_DIRS})
+if(DUKTAPE_EXEC_TIMEOUT)
+	target_compile_definitions(
+		${DUKTAPE_LIBRARY}
+		PUBLIC
+		DUKDEMO_EXEC_TIMEOUT=1
+	)
+endif()
+if(DUKTAPE_MANUAL_GC)
+	target_compile_definitions(
+		${DUKTAPE_LIBRARY}
+		PUBLIC
+		DUKDEMO_MANUAL_GC=1
+	)
+endif()
@@ -0,0 +1,17 @@
+#include "duktape.h"
+
+
+static dukdemo_exec_timeout_fn dukdemo_exec_timeout_impl = NULL;
+
+
+duk_bool_t dukdemo_exec_timeout_check(void *udata)
+{
+	dukdemo_exec_timeout_fn const fn = dukdemo_exec_timeout_impl;
+	return fn != NULL ? fn(udata) : 0;
+}
+
+
+void dukdemo_set_exec_timeout_check(dukdemo_exec_timeout_fn fn)
+{
+	dukdemo_exec_timeout_impl = fn;
+}
@@ -0,0 +1,13 @@
+/*
+ * Declare the execution timeout check used by DUK_USE_EXEC_TIMEOUT_CHECK.
+ * It forwards to a function registered by native code; see exec_timeout.c.
+ */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+typedef duk_bool_t (*dukdemo_exec_timeout_fn)(void *udata);
+duk_bool_t dukdemo_exec_timeout_check(void *udata);
+void dukdemo_set_exec_timeout_check(dukdemo_exec_timeout_fn fn);
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <easylogging++.h>
+
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/util/TempFile.h"
+
+
+constexpr char const* const pUsage =
+	"Usage: dukdemo-convert-scene SCENE.json SCENE.dkscene\n"
+	"\n"
+	"Converts a JSON scene to a binary scene, which loads without parsing.\n"
+	"Pass either to dukdemo-headless with --level.\n";
+
+
+INITIALIZE_EASYLOGGINGPP
+
+
+void
+convertScene(char const* const pJsonPath, char const* const pBinaryPath)
+{
+	std::ifstream json{pJsonPath, std::ios::in | std::ios::binary};
+	if (!json)
+	{
+		throw std::runtime_error{std::string{"Unable to open "} + pJsonPath};
+	}
+
+	// Write to a temporary file and rename it, so that a failed conversion
+	// never leaves a partial scene behind.
+	auto const tmpPath = dukdemo::util::createTempFileFor(pBinaryPath);
+	if (tmpPath.empty())
+	{
+		throw std::runtime_error{
+			std::string{"Unable to create a file beside "} + pBinaryPath};
+	}
+	bool valid = false;
+	{
+		std::ofstream out{tmpPath, std::ios::out | std::ios::binary};
+		if (!out)
+		{
+			std::remove(tmpPath.c_str());
+			throw std::runtime_error{"Unable to create " + tmpPath};
+		}
+		try
+		{
+			valid = dukdemo::scene::convertJsonScene(json, out);
+			out.close();
+			valid = valid && bool(out);
+		}
+		catch (...)
+		{
+			std::remove(tmpPath.c_str());
+			throw;
+		}
+	}
+
+	if (!valid)
+	{
+		std::remove(tmpPath.c_str());
+		throw std::runtime_error{std::string{"Invalid scene in "} + pJsonPath};
+	}
+	if (std::rename(tmpPath.c_str(), pBinaryPath) != 0)
+	{
+		std::remove(tmpPath.c_str());
+		throw std::runtime_error{
+			std::string{"Unable to write "} + pBinaryPath};
+	}
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	try
+	{
+		if (argc != 3)
+		{
+			throw std::invalid_argument{pUsage};
+		}
+		convertScene(argv[1], argv[2]);
+	}
+	catch (std::invalid_argument const& err)
+	{
+		std::cerr << err.what();
+		return 2;
+	}
+	catch (std::exception const& err)
+	{
+		LOG(ERROR) << err.what();
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,588 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <Box2D/Dynamics/b2World.h>
+
+#include <easylogging++.h>
+
+#include <duktape.h>
+
+#include "dukdemo/util/deleters.h"
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/JsonScene.h"
+#include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/GcScheduler.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+#include "dukdemo/scripting/JsSampler.h"
+#include "dukdemo/scripting/Profiler.h"
+#include "dukdemo/scripting/ScriptCache.h"
+#include "dukdemo/scripting/util.h"
+#include "dukdemo/scripting/World.h"
+#include "dukdemo/sim/Runner.h"
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/util/Trace.h"
+
+
+constexpr char const* const pUsage =
+	"Usage: dukdemo-headless SCENE.js "
+	"[--steps N] [--seconds S] [--timestep T]\n"
+	"                        [--cache-dir DIR] [--call-budget-ms MS]\n"
+	"                        [--frame-budget-ms MS] [--memory-limit-mb MB]\n"
+	"                        [--profile FILE] [--trace FILE]\n"
+	"                        [--js-profile FILE] [--js-sample-us US]\n"
+	"                        [--scheduled-gc] [--level FILE]\n"
+	"\n"
+	"Runs SCENE.js with a global `world`, then steps the world at a fixed\n"
+	"timestep for N steps (default 600) or until S seconds have passed. If\n"
+	"the scene defines a global `onStep(stepIndex)` function, it is called\n"
+	"before every step. With --cache-dir, compiled scripts are cached in DIR\n"
+	"and reused while the source is unchanged. With a budget, an `onStep`\n"
+	"call which runs too long is abandoned and the run continues. The JS\n"
+	"heap's memory can be capped with --memory-limit-mb. Script and step\n"
+	"timings are readable from `profiler.stats()`, and with --profile are\n"
+	"written to FILE on exit. In builds with DUKDEMO_TRACE, --trace writes\n"
+	"a Chrome trace of the run to FILE. With --js-profile, the JS call stack\n"
+	"is sampled every US microseconds (default 1000) while scripts run, and\n"
+	"the samples are written to FILE as folded stacks for flame graphs.\n"
+	"With --scheduled-gc, garbage is collected after a step when the rest of\n"
+	"its timestep allows, or once overdue. With --level, the bodies of a\n"
+	"JSON or binary scene are created natively before SCENE.js runs.\n";
+
+constexpr char const* const pStepHookName = "onStep";
+
+
+INITIALIZE_EASYLOGGINGPP
+
+
+using duk_context_ptr =
+	std::unique_ptr<duk_context, dukdemo::util::DukContextDeleter>;
+
+
+struct Arguments
+{
+	char const* pScenePath = nullptr;
+	char const* pCacheDir = nullptr;
+	char const* pProfilePath = nullptr;
+	char const* pTracePath = nullptr;
+	char const* pJsProfilePath = nullptr;
+	char const* pLevelPath = nullptr;
+	double jsSampleUs = 1000.0;
+	bool scheduledGc = false;
+	dukdemo::sim::RunOptions options{};
+	double callBudgetMs = 0.0;
+	double frameBudgetMs = 0.0;
+	double memoryLimitMb = 0.0;
+};
+
+
+/**
+ * Parse an option's value as a real number. Malformed and out of range
+ * values, or trailing characters, are usage errors.
+ */
+static double
+parseDouble(char const* pValue)
+{
+	std::size_t length = 0u;
+	try
+	{
+		double const value = std::stod(pValue, &length);
+		if (pValue[length] == '\0')
+		{
+			return value;
+		}
+	}
+	catch (std::logic_error const&)
+	{
+	}
+	throw std::invalid_argument{pUsage};
+}
+
+
+/** Parse an option's value as a float, like @ref parseDouble. */
+static float
+parseFloat(char const* pValue)
+{
+	std::size_t length = 0u;
+	try
+	{
+		float const value = std::stof(pValue, &length);
+		if (pValue[length] == '\0')
+		{
+			return value;
+		}
+	}
+	catch (std::logic_error const&)
+	{
+	}
+	throw std::invalid_argument{pUsage};
+}
+
+
+/**
+ * Parse an option's value as a count, like @ref parseDouble. `std::stoul`
+ * negates values with a minus sign, so those are rejected too.
+ */
+static unsigned long
+parseCount(char const* pValue)
+{
+	std::size_t length = 0u;
+	try
+	{
+		unsigned long const value = std::stoul(pValue, &length);
+		if (pValue[length] == '\0' && !std::strchr(pValue, '-'))
+		{
+			return value;
+		}
+	}
+	catch (std::logic_error const&)
+	{
+	}
+	throw std::invalid_argument{pUsage};
+}
+
+
+Arguments
+parseArguments(int argc, char const* const argv[])
+{
+	Arguments args;
+	bool hasSteps = false;
+	bool hasSeconds = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		char const* const pArg = argv[i];
+		bool const hasValue = i + 1 < argc;
+		if (std::strcmp(pArg, "--steps") == 0 && hasValue)
+		{
+			args.options.maxSteps = parseCount(argv[++i]);
+			hasSteps = true;
+		}
+		else if (std::strcmp(pArg, "--seconds") == 0 && hasValue)
+		{
+			args.options.deadline =
+				std::chrono::duration<double>{parseDouble(argv[++i])};
+			hasSeconds = true;
+		}
+		else if (std::strcmp(pArg, "--timestep") == 0 && hasValue)
+		{
+			args.options.timeStep = parseFloat(argv[++i]);
+		}
+		else if (std::strcmp(pArg, "--cache-dir") == 0 && hasValue)
+		{
+			args.pCacheDir = argv[++i];
+		}
+		else if (std::strcmp(pArg, "--call-budget-ms") == 0 && hasValue)
+		{
+			args.callBudgetMs = parseDouble(argv[++i]);
+		}
+		else if (std::strcmp(pArg, "--frame-budget-ms") == 0 && hasValue)
+		{
+			args.frameBudgetMs = parseDouble(argv[++i]);
+		}
+		else if (std::strcmp(pArg, "--memory-limit-mb") == 0 && hasValue)
+		{
+			args.memoryLimitMb = parseDouble(argv[++i]);
+		}
+		else if (std::strcmp(pArg, "--profile") == 0 && hasValue)
+		{
+			args.pProfilePath = argv[++i];
+		}
+		else if (std::strcmp(pArg, "--trace") == 0 && hasValue)
+		{
+			args.pTracePath = argv[++i];
+		}
+		else if (std::strcmp(pArg, "--js-profile") == 0 && hasValue)
+		{
+			args.pJsProfilePath = argv[++i];
+		}
+		else if (std::strcmp(pArg, "--js-sample-us") == 0 && hasValue)
+		{
+			args.jsSampleUs = parseDouble(argv[++i]);
+		}
+		else if (std::strcmp(pArg, "--level") == 0 && hasValue)
+		{
+			args.pLevelPath = argv[++i];
+		}
+		else if (std::strcmp(pArg, "--scheduled-gc") == 0)
+		{
+			args.scheduledGc = true;
+		}
+		else if (pArg[0] != '-' && !args.pScenePath)
+		{
+			args.pScenePath = pArg;
+		}
+		else
+		{
+			throw std::invalid_argument{pUsage};
+		}
+	}
+
+	if (!args.pScenePath)
+	{
+		throw std::invalid_argument{pUsage};
+	}
+
+	// Without the interrupt hook, an overrunning call would never be
+	// abandoned, so don't pretend to enforce a budget.
+	bool const hasBudget = args.callBudgetMs > 0.0 || args.frameBudgetMs > 0.0;
+	if (hasBudget && !dukdemo::scripting::ExecBudget::isEnforced())
+	{
+		throw std::invalid_argument{
+			"--call-budget-ms and --frame-budget-ms need Duktape configured "
+			"with -DDUKTAPE_EXEC_TIMEOUT=ON\n"};
+	}
+
+	// With only a deadline, run until it passes.
+	if (hasSeconds && !hasSteps)
+	{
+		args.options.maxSteps = std::numeric_limits<std::size_t>::max();
+	}
+	return args;
+}
+
+
+std::string
+readFile(char const* const pPath)
+{
+	std::ifstream file{pPath, std::ios::in | std::ios::binary};
+	if (!file)
+	{
+		throw std::runtime_error{std::string{"Unable to open "} + pPath};
+	}
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+
+/** Pop an error from the value stack and throw it as an exception. */
+[[noreturn]] void
+throwScriptError(duk_context* pContext)
+{
+	std::string const message{duk_safe_to_string(pContext, -1)};
+	duk_pop(pContext);
+	throw std::runtime_error{message};
+}
+
+
+void
+evalScript(
+	duk_context* pContext,
+	std::string const& source,
+	char const* const pFileName,
+	dukdemo::scripting::ScriptCache* pCache
+)
+{
+	bool compiled = false;
+	if (pCache)
+	{
+		compiled = pCache->pushFunction(pContext, source, pFileName);
+	}
+	else
+	{
+		duk_push_string(pContext, pFileName);
+		compiled = duk_pcompile_lstring_filename(
+			pContext, 0, source.data(), source.size()) == 0;
+	}
+
+	bool const ran = compiled && duk_pcall(pContext, 0) == 0;
+	dukdemo::scripting::takeDueSamples(pContext, pFileName);
+	if (!ran)
+	{
+		throwScriptError(pContext);
+	}
+	duk_pop(pContext);
+}
+
+
+/** Whether a file starts as a binary scene does. */
+bool
+isBinaryScene(char const* const pPath)
+{
+	std::ifstream file{pPath, std::ios::in | std::ios::binary};
+	char magic[sizeof(dukdemo::scene::g_binarySceneMagic)] = {};
+	file.read(&magic[0], sizeof(magic));
+	return file && std::memcmp(
+		magic, dukdemo::scene::g_binarySceneMagic, sizeof(magic)) == 0;
+}
+
+
+/** Create the bodies of a JSON or binary scene, reporting the time taken. */
+void
+loadLevel(char const* const pPath, b2World& world)
+{
+	bool const isBinary = isBinaryScene(pPath);
+	std::ifstream file;
+	if (!isBinary)
+	{
+		file.open(pPath, std::ios::in | std::ios::binary);
+		if (!file)
+		{
+			throw std::runtime_error{std::string{"Unable to open "} + pPath};
+		}
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	bool const valid = isBinary
+		? dukdemo::scene::loadBinarySceneFile(pPath, world)
+		: dukdemo::scene::loadJsonScene(file, world);
+	if (!valid)
+	{
+		throw std::runtime_error{std::string{"Invalid scene in "} + pPath};
+	}
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	Milliseconds const elapsed = std::chrono::steady_clock::now() - start;
+	std::cout
+		<< "level_format: " << (isBinary ? "binary" : "json") << '\n'
+		<< "level_bodies: " << world.GetBodyCount() << '\n'
+		<< "level_load_ms: " << elapsed.count() << '\n';
+}
+
+
+void
+report(dukdemo::sim::RunStats const& stats, b2World const& world)
+{
+	constexpr double msPerSecond = 1000.0;
+	std::cout
+		<< "bodies: " << world.GetBodyCount() << '\n'
+		<< "steps: " << stats.steps() << '\n'
+		<< "elapsed_s: " << stats.elapsedSeconds << '\n'
+		<< "steps_per_s: " << stats.stepsPerSecond() << '\n'
+		<< "step_p50_ms: " << stats.percentile(50.0) * msPerSecond << '\n'
+		<< "step_p90_ms: " << stats.percentile(90.0) * msPerSecond << '\n'
+		<< "step_p99_ms: " << stats.percentile(99.0) * msPerSecond << '\n'
+		<< "step_max_ms: " << stats.percentile(100.0) * msPerSecond << '\n';
+}
+
+
+void
+reportHeap(dukdemo::scripting::HeapAllocator const& allocator)
+{
+	auto const& stats = allocator.stats();
+	std::cout
+		<< "heap_bytes_live: " << stats.bytesLive << '\n'
+		<< "heap_bytes_peak: " << stats.peakBytes << '\n'
+		<< "heap_allocations: " << stats.allocations << '\n'
+		<< "heap_system_allocations: " << stats.systemAllocations << '\n'
+		<< "heap_limit_failures: " << stats.limitFailures << '\n';
+	for (std::size_t i = 0u; i < stats.classes.size(); ++i)
+	{
+		std::cout << "heap_class_hit_rate["
+			<< dukdemo::scripting::HeapAllocator::s_classSizes[i] << "]: "
+			<< stats.classes[i].hitRate() << '\n';
+	}
+}
+
+
+void
+reportBudget(dukdemo::scripting::ExecBudget const& budget)
+{
+	auto const& stats = budget.stats();
+	std::cout
+		<< "budget_enforced: " << budget.isEnforced() << '\n'
+		<< "budget_calls: " << stats.calls << '\n'
+		<< "budget_call_overruns: " << stats.callOverruns << '\n'
+		<< "budget_frame_overruns: " << stats.frameOverruns << '\n'
+		<< "budget_skipped_calls: " << stats.skippedCalls << '\n';
+	for (auto const& site: stats.sites)
+	{
+		std::cout << "budget_overruns[" << site.first << "]: "
+			<< site.second.callOverruns + site.second.frameOverruns << '\n';
+	}
+}
+
+
+void
+reportGc(dukdemo::scripting::GcScheduler const& scheduler)
+{
+	constexpr double msPerSecond = 1000.0;
+	auto const& stats = scheduler.stats();
+	std::cout
+		<< "gc_automatic_suppressed: "
+		<< scheduler.isAutomaticGcSuppressed() << '\n'
+		<< "gc_collections: " << stats.collections << '\n'
+		<< "gc_forced_collections: " << stats.forcedCollections << '\n'
+		<< "gc_compactions: " << stats.compactions << '\n'
+		<< "gc_total_ms: " << stats.totalSeconds * msPerSecond << '\n'
+		<< "gc_ms_per_frame_p99: "
+		<< stats.secondsPerFrame.percentile(99.0) * msPerSecond << '\n'
+		<< "gc_ms_per_frame_max: "
+		<< stats.secondsPerFrame.max() * msPerSecond << '\n';
+}
+
+
+void
+runScene(Arguments const& args)
+{
+	DUKDEMO_TRACE_THREAD_NAME("main");
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	dukdemo::scripting::ExecBudget budget;
+	budget.setCallBudget(Milliseconds{args.callBudgetMs});
+	budget.setFrameBudget(Milliseconds{args.frameBudgetMs});
+	bool const hasBudget = args.callBudgetMs > 0.0 || args.frameBudgetMs > 0.0;
+
+	constexpr double bytesPerMb = 1024.0 * 1024.0;
+	dukdemo::scripting::HeapAllocator allocator{
+		std::size_t(args.memoryLimitMb * bytesPerMb)};
+
+	dukdemo::util::FrameProfiler profiler;
+	auto options = args.options;
+	options.pProfiler = &profiler;
+
+	using Microseconds = std::chrono::duration<double, std::micro>;
+	dukdemo::scripting::JsSampler sampler{Microseconds{args.jsSampleUs}};
+
+	dukdemo::scripting::EnumNameCache enumNameCache;
+	dukdemo::scripting::BodyTable bodyTable;
+	dukdemo::scripting::HeapState heapState;
+	heapState.pBodyTable = &bodyTable;
+	heapState.pExecBudget = &budget;
+	heapState.pAllocator = &allocator;
+	heapState.pProfiler = &profiler;
+	heapState.pEnumNameCache = &enumNameCache;
+	if (args.pJsProfilePath)
+	{
+		LOG_IF(not sampler.isAutomatic(), WARNING)
+			<< "Built without DUKTAPE_EXEC_TIMEOUT; scripts won't be sampled";
+		heapState.pSampler = &sampler;
+	}
+	duk_context_ptr pContext{dukdemo::scripting::createHeap(&heapState)};
+	if (!pContext)
+	{
+		throw std::runtime_error{"Failed to create duktape context"};
+	}
+	auto* const pCtx = pContext.get();
+	dukdemo::scripting::world::init(pCtx);
+	dukdemo::scripting::body::init(pCtx);
+	dukdemo::scripting::profiler::init(pCtx);
+
+	// The JS world owns the b2World, and with it every body.
+	auto pWorld = std::make_unique<b2World>(b2Vec2{0.0f, -9.8f});
+	auto& world = *pWorld;
+	dukdemo::scripting::world::pushWorldWithFinalizer(pCtx, std::move(pWorld));
+	duk_put_global_string(pCtx, "world");
+
+	if (args.pLevelPath)
+	{
+		loadLevel(args.pLevelPath, world);
+	}
+
+	std::unique_ptr<dukdemo::scripting::ScriptCache> pCache;
+	if (args.pCacheDir)
+	{
+		pCache = std::make_unique<dukdemo::scripting::ScriptCache>(
+			args.pCacheDir);
+	}
+	evalScript(
+		pCtx, readFile(args.pScenePath), args.pScenePath, pCache.get());
+	if (pCache && pCache->stats().writeFailures > 0u)
+	{
+		LOG(WARNING) << "Unable to write to script cache " << args.pCacheDir;
+	}
+
+	// Keep the step hook, if any, at a fixed value stack index.
+	duk_get_global_string(pCtx, pStepHookName);
+	auto const hookIdx = duk_normalize_index(pCtx, -1);
+	dukdemo::sim::StepFn onStep;
+	if (duk_is_function(pCtx, hookIdx))
+	{
+		onStep = [pCtx, hookIdx, &budget](std::size_t stepIndex) {
+			budget.beginFrame();
+			auto const overruns =
+				budget.stats().callOverruns + budget.stats().frameOverruns;
+			duk_dup(pCtx, hookIdx);
+			duk_push_number(pCtx, double(stepIndex));
+			if (budget.pcall(pCtx, 1, pStepHookName) != DUK_EXEC_SUCCESS)
+			{
+				// Only errors due to the budget are tolerated.
+				auto const newOverruns =
+					budget.stats().callOverruns + budget.stats().frameOverruns;
+				if (newOverruns == overruns)
+				{
+					throwScriptError(pCtx);
+				}
+			}
+			duk_pop(pCtx);
+		};
+	}
+
+	// Collect garbage in whatever is left of each timestep.
+	dukdemo::scripting::GcScheduler gcScheduler;
+	dukdemo::sim::StepFn afterStep;
+	std::chrono::steady_clock::time_point frameStart{};
+	if (args.scheduledGc)
+	{
+		LOG_IF(not gcScheduler.isAutomaticGcSuppressed(), WARNING)
+			<< "Built without DUKTAPE_MANUAL_GC; Duktape may still collect "
+			"garbage mid-step";
+		gcScheduler.addLongLived(dukdemo::scripting::g_bodyProtoSym);
+		gcScheduler.addLongLived(dukdemo::scripting::g_worldProtoSym);
+		afterStep = [pCtx, &gcScheduler, &frameStart, &options](std::size_t) {
+			using Seconds = std::chrono::duration<double>;
+			auto const now = std::chrono::steady_clock::now();
+			auto const idle = Seconds{options.timeStep} - (now - frameStart);
+			gcScheduler.endFrame(pCtx, idle);
+			frameStart = std::chrono::steady_clock::now();
+		};
+	}
+
+	frameStart = std::chrono::steady_clock::now();
+	auto const stats =
+		dukdemo::sim::runFixedSteps(world, options, onStep, afterStep);
+	report(stats, world);
+	reportHeap(allocator);
+	if (hasBudget)
+	{
+		reportBudget(budget);
+	}
+	if (args.pProfilePath)
+	{
+		profiler.dump(args.pProfilePath);
+	}
+	if (args.scheduledGc)
+	{
+		reportGc(gcScheduler);
+	}
+	if (args.pJsProfilePath)
+	{
+		sampler.dump(args.pJsProfilePath);
+		std::cout << "js_samples: " << sampler.samples() << '\n';
+	}
+	if (args.pTracePath)
+	{
+		if (!dukdemo::util::trace::compiledIn())
+		{
+			LOG(WARNING) << "Built without DUKDEMO_TRACE; the trace is empty";
+		}
+		dukdemo::util::trace::dump(args.pTracePath);
+	}
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	try
+	{
+		runScene(parseArguments(argc, argv));
+	}
+	catch (std::invalid_argument const& err)
+	{
+		std::cerr << err.what();
+		return 2;
+	}
+	catch (std::exception const& err)
+	{
+		LOG(ERROR) << err.what();
+		return 1;
+	}
+	return 0;
+}
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <cstring>
 #include <memory>
 
 #include <SDL2/SDL.h>
@@ -5,10 +7,6 @@
 #include <SDL2/SDL_opengl.h>
 #include <GL/glu.h>
 
-#include <glm/vec3.hpp>
-#include <glm/vec4.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
@@ -22,9 +20,22 @@
 #include "b2draw/DebugDraw.h"
 
 #include "dukdemo/util/deleters.h"
+#include "dukdemo/render/BatchRenderer.h"
+#include "dukdemo/render/Camera.h"
 #include "dukdemo/render/Context.h"
+#include "dukdemo/render/GpuTimer.h"
 #include "dukdemo/render/util.h"
+#include "dukdemo/render/draw.h"
 #include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+#include "dukdemo/scripting/JsSampler.h"
+#include "dukdemo/sim/SimulationThread.h"
+#include "dukdemo/sim/Snapshot.h"
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/util/Trace.h"
 
 
 constexpr int screenWidth{640};
@@ -35,6 +46,21 @@ constexpr float worldTimeStep{1.0f / 60.0f};
 constexpr unsigned velocityIterations{8};
 constexpr unsigned positionIterations{3};
 
+/** The most steps to run per frame when catching up after a slow frame. */
+constexpr unsigned maxCatchUpSteps{5};
+
+/** The minimum frame duration, for when VSync isn't available. */
+constexpr double minFrameSeconds{1.0 / 60.0};
+
+/** The time allowed for each of the demo's script calls. */
+constexpr std::chrono::duration<double, std::milli> scriptBudget{100.0};
+
+/** Where frame phase timings are written on exit. */
+constexpr char const* const pProfilePath = "dukdemo-profile.txt";
+
+/** Where the trace is written on exit, when built with tracing. */
+constexpr char const* const pTracePath = "dukdemo-trace.json";
+
 
 constexpr char const* const pPositionAttribName = "position";
 constexpr char const* const pColourAttribName = "colour";
@@ -68,28 +94,39 @@ void addBody(duk_context* pContext)
 }
 
 
-void runScripts()
+void logHeapStats(dukdemo::scripting::HeapAllocator const& allocator)
 {
-	// Create Duktape heap and context.
-	duk_context_ptr pContext{duk_create_heap_default()};
-	if (!pContext)
+	auto const& stats = allocator.stats();
+	LOG(INFO) << "JS heap: " << stats.bytesLive << " bytes live, "
+		<< stats.peakBytes << " peak, " << stats.allocations << " allocations, "
+		<< stats.systemAllocations << " system allocations";
+	for (std::size_t i = 0u; i < stats.classes.size(); ++i)
 	{
-		throw std::runtime_error{"Failed to create duktype context"};
+		auto const& classStats = stats.classes[i];
+		LOG(INFO) << "JS heap class "
+			<< dukdemo::scripting::HeapAllocator::s_classSizes[i] << ": "
+			<< classStats.allocations << " allocations, "
+			<< classStats.hitRate() * 100.0 << "% pooled";
 	}
+}
+
 
-	duk_push_string(pContext.get(), R"JSON({
+/** Load the demo's definitions; run through the script budget. */
+duk_ret_t loadDemoDefs(duk_context* pContext)
+{
+	duk_push_string(pContext, R"JSON({
 		"type": 1,
 		"position": [1, 2],
 		"angularVelocity": 1.2345,
 		"bullet": true
 	})JSON");
-	duk_json_decode(pContext.get(), -1);
+	duk_json_decode(pContext, -1);
 
 	b2BodyDef bodyDef;
 	dukdemo::scripting::loadBodyDef(
-		pContext.get(), duk_normalize_index(pContext.get(), -1), &bodyDef);
+		pContext, duk_normalize_index(pContext, -1), &bodyDef);
 
-	duk_push_string(pContext.get(), R"JSON({
+	duk_push_string(pContext, R"JSON({
 		"friction": 1,
 		"restitution": 0.03,
 		"density": 4,
@@ -98,24 +135,75 @@ void runScripts()
 		"maskBits": 7,
 		"groupIndex": 1
 	})JSON");
-	duk_json_decode(pContext.get(), -1);
+	duk_json_decode(pContext, -1);
 	b2FixtureDef fixtureDef;
 	dukdemo::scripting::loadFixtureDefWithoutShape(
-		pContext.get(), duk_normalize_index(pContext.get(), -1), &fixtureDef);
+		pContext, duk_normalize_index(pContext, -1), &fixtureDef);
 
-	duk_push_string(pContext.get(), R"JSON({
+	duk_push_string(pContext, R"JSON({
 		"type": "circle",
 		"radius": 1
 	})JSON");
 	b2CircleShape circle;
-	dukdemo::scripting::loadCircle(pContext.get(), -1, &circle);
+	dukdemo::scripting::loadCircle(pContext, -1, &circle);
 
-	duk_push_string(pContext.get(), R"JSON({
+	duk_push_string(pContext, R"JSON({
 		"type": "polygon",
 		"vertices": [[-1, -1], [1, -1], [1, 1], [-1, 1]]
 	})JSON");
 	b2PolygonShape polygon;
-	dukdemo::scripting::loadPolygon(pContext.get(), -1, &polygon);
+	dukdemo::scripting::loadPolygon(pContext, -1, &polygon);
+	return 0;
+}
+
+
+/**
+ * Run the demo scripts.
+ *
+ * @param pJsProfilePath if set, where to write folded JS stack samples.
+ */
+void runScripts(char const* pJsProfilePath)
+{
+	// Create Duktape heap and context.
+	dukdemo::scripting::HeapAllocator allocator;
+	dukdemo::scripting::JsSampler sampler;
+	dukdemo::scripting::EnumNameCache enumNameCache;
+	dukdemo::scripting::ExecBudget budget;
+	budget.setCallBudget(scriptBudget);
+	dukdemo::scripting::HeapState heapState;
+	heapState.pExecBudget = &budget;
+	heapState.pAllocator = &allocator;
+	heapState.pEnumNameCache = &enumNameCache;
+	if (pJsProfilePath)
+	{
+		LOG_IF(not sampler.isAutomatic(), WARNING)
+			<< "Built without DUKTAPE_EXEC_TIMEOUT; scripts won't be sampled";
+		heapState.pSampler = &sampler;
+	}
+	duk_context_ptr pContext{dukdemo::scripting::createHeap(&heapState)};
+	if (!pContext)
+	{
+		throw std::runtime_error{"Failed to create duktype context"};
+	}
+
+	// Budget the scripts, so a runaway one can't stall startup.
+	auto* const pCtx = pContext.get();
+	duk_push_c_function(pCtx, loadDemoDefs, 0);
+	if (budget.pcall(pCtx, 0, "loadDemoDefs") != DUK_EXEC_SUCCESS)
+	{
+		LOG(WARNING) << "Demo scripts failed: " << duk_safe_to_string(pCtx, -1);
+	}
+	duk_pop(pCtx);
+	LOG_IF(budget.stats().callOverruns > 0u, WARNING)
+		<< "Demo scripts overran their " << scriptBudget.count() << "ms budget";
+
+	logHeapStats(allocator);
+	if (pJsProfilePath)
+	{
+		sampler.dump(pJsProfilePath);
+		LOG(INFO) << sampler.samples() << " JS samples written to "
+			<< pJsProfilePath;
+	}
 }
 
 
@@ -133,10 +221,25 @@ void runSimulation()
 		pColourAttribName
 	};
 	debugDraw.SetFlags(0xff);
+	dukdemo::render::BatchRenderer batchRenderer;
+
+	dukdemo::util::FrameProfiler profiler;
+	dukdemo::render::GpuTimer gpuTimer{profiler};
+	LOG_IF(not gpuTimer.supported(), INFO) << "No GPU timer queries";
+	renderContext.setProfiler(&profiler);
+	auto const stepPhase = profiler.addPhase("step");
+	auto const tessellatePhase = profiler.addPhase("tessellate");
+	auto const uploadPhase = profiler.addPhase("upload");
+	auto const batchPhase = profiler.addPhase("batch");
+	auto const drawPhase = profiler.addPhase("draw");
+	auto const drawnCounter = profiler.addCounter("drawn_fixtures");
+	auto const culledCounter = profiler.addCounter("culled_bodies");
+
+	// Press 'd' to compare against b2draw's per-vertex debug drawing.
+	bool useDebugDraw{false};
 
 	b2Vec2 const gravity{0.0f, -9.8f};
 	b2World world{gravity};
-	world.SetDebugDraw(&debugDraw);
 
 	{
 		b2BodyDef bodyDef;
@@ -166,22 +269,20 @@ void runSimulation()
 	}
 
 
-	constexpr float fieldOfView{45.0f};
-	auto const projMat = glm::perspective(
-		fieldOfView,
-		4.0f / 3.0f,
-		0.1f,
-		100.0f
-	);
-
-	constexpr glm::vec3 eye{0.0f, 0.0f, 40.0f};
-	constexpr glm::vec3 focus{0.0f, 0.0f, 0.0f};
-	constexpr glm::vec3 up{0.0f, 1.0f, 0.0f};
-	auto const viewMat = glm::lookAt(eye, focus, up);
-
-	glm::mat4 const modelMat{1.0f};
+	// Bodies just outside the view are still captured, so they don't pop in
+	// while the next snapshot is on its way.
+	constexpr float cullMargin{2.0f};
+	constexpr float panFraction{0.1f};
+	constexpr float zoomFactor{1.25f};
+	dukdemo::render::Camera camera{
+		b2Vec2{0.0f, 0.0f},
+		16.0f,
+		float(screenWidth) / float(screenHeight)
+	};
+	bool cullBodies{true};
+	bool cameraMoved{true};
 
-	auto const mvpMat{projMat * viewMat * modelMat};
+	auto mvpMat = camera.viewProjection();
 	auto const pMvpMatStart{&mvpMat[0][0]};
 	auto const mvpAttribLoc{glGetUniformLocation(programID, "MVP")};
 	if (mvpAttribLoc < 0)
@@ -190,79 +291,263 @@ void runSimulation()
 	}
 
 
-	auto const update = [&debugDraw, &world] {
-		world.Step(worldTimeStep, velocityIterations, positionIterations);
-		debugDraw.Clear();
-		world.DrawDebugData();
-		debugDraw.BufferData();
+	// The world belongs to the simulation thread once it starts. Wake the
+	// render loop when a snapshot arrives while it's idling.
+	dukdemo::sim::SimulationThread simulation{
+		world,
+		[&world, &profiler, stepPhase] {
+			dukdemo::util::FrameProfiler::ScopedTimer timer{
+				&profiler, stepPhase};
+			world.Step(worldTimeStep, velocityIterations, positionIterations);
+		},
+		worldTimeStep,
+		maxCatchUpSteps,
+		[](dukdemo::sim::Snapshot const& snapshot) {
+			if (snapshot.paused)
+			{
+				SDL_Event wake{};
+				wake.type = SDL_USEREVENT;
+				SDL_PushEvent(&wake);
+			}
+		}
+	};
+
+	using ScopedTimer = dukdemo::util::FrameProfiler::ScopedTimer;
+	auto const update = [&](
+		dukdemo::sim::Snapshot const& snapshot,
+		float const alpha
+	) {
+		profiler.recordCount(drawnCounter, snapshot.drawnFixtures);
+		profiler.recordCount(culledCounter, snapshot.culledBodies);
+		if (useDebugDraw)
+		{
+			{
+				ScopedTimer timer{&profiler, tessellatePhase};
+				debugDraw.Clear();
+				dukdemo::render::drawSnapshot(snapshot, debugDraw, alpha);
+			}
+			ScopedTimer timer{&profiler, uploadPhase};
+			debugDraw.BufferData();
+		}
+		else
+		{
+			// Collects and uploads instances together.
+			ScopedTimer timer{&profiler, batchPhase};
+			batchRenderer.update(snapshot, alpha);
+		}
 	};
 
 	auto const render = [
 		&debugDraw,
+		&batchRenderer,
+		&useDebugDraw,
 		programID,
 		pSDLWindow = renderContext.window(),
 		mvpAttribLoc,
-		pMvpMatStart
+		pMvpMatStart,
+		&profiler,
+		&gpuTimer,
+		drawPhase
 	] {
+		ScopedTimer cpuTimer{&profiler, drawPhase};
+		dukdemo::render::ScopedGpuTimer drawTimer{gpuTimer, drawPhase};
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glUniformMatrix4fv(mvpAttribLoc, 1, GL_FALSE, pMvpMatStart);
-		debugDraw.Render();
+		if (useDebugDraw)
+		{
+			glUseProgram(programID);
+			glUniformMatrix4fv(mvpAttribLoc, 1, GL_FALSE, pMvpMatStart);
+			debugDraw.Render();
+		}
+		else
+		{
+			batchRenderer.render(pMvpMatStart);
+		}
 	};
 	renderContext.setOnRender(render);
 
 	// Ensure no GL errors.
 	dukdemo::render::checkGLErrors("Ready to render");
 
-	update();
-	renderContext.render();
-	renderContext.render();  // TODO: Why is this second render required?
-
-	SDL_Event event;
 	bool userQuit{false};
+	auto const handleEvent = [&](SDL_Event const& event) {
+		switch (event.type)
+		{
+			case SDL_QUIT:
+				userQuit = true;
+				break;
+
+			case SDL_KEYDOWN:
+				switch (event.key.keysym.sym)
+				{
+					case SDLK_ESCAPE:
+						userQuit = true;
+						break;
+
+					case SDLK_SPACE:
+						simulation.setPaused(not simulation.paused());
+						break;
+
+					case SDLK_s:
+						if (simulation.paused())
+						{
+							simulation.requestStep();
+						}
+						break;
+
+					case SDLK_d:
+						useDebugDraw = not useDebugDraw;
+						break;
+
+					case SDLK_c:
+						cullBodies = not cullBodies;
+						cameraMoved = true;
+						break;
+
+					case SDLK_LEFT:
+						camera.pan(b2Vec2{-panFraction, 0.0f});
+						cameraMoved = true;
+						break;
+
+					case SDLK_RIGHT:
+						camera.pan(b2Vec2{panFraction, 0.0f});
+						cameraMoved = true;
+						break;
+
+					case SDLK_UP:
+						camera.pan(b2Vec2{0.0f, panFraction});
+						cameraMoved = true;
+						break;
+
+					case SDLK_DOWN:
+						camera.pan(b2Vec2{0.0f, -panFraction});
+						cameraMoved = true;
+						break;
+
+					case SDLK_EQUALS:
+						camera.zoom(1.0f / zoomFactor);
+						cameraMoved = true;
+						break;
+
+					case SDLK_MINUS:
+						camera.zoom(zoomFactor);
+						cameraMoved = true;
+						break;
+
+					default:
+						break;
+				}
+				break;
+
+			case SDL_MOUSEWHEEL:
+				if (event.wheel.y != 0)
+				{
+					camera.zoom(
+						event.wheel.y > 0 ? 1.0f / zoomFactor : zoomFactor);
+					cameraMoved = true;
+				}
+				break;
+
+			default:
+				break;
+		}
+	};
 
-	while (not userQuit)
+	using Clock = std::chrono::steady_clock;
+	using Seconds = std::chrono::duration<double>;
+	simulation.start();
+	SDL_Event event;
+	DUKDEMO_TRACE_THREAD_NAME("main");
+	while (not userQuit && simulation.running())
 	{
-		while (SDL_PollEvent(&event) != 0)
+		DUKDEMO_TRACE_SCOPE("main", "frame");
+		auto const frameStart = Clock::now();
+		{
+			DUKDEMO_TRACE_SCOPE("main", "events");
+			while (SDL_PollEvent(&event) != 0)
+			{
+				handleEvent(event);
+			}
+		}
+
+		// Only tell the simulation about changes, since while paused each one
+		// publishes a snapshot, which wakes this loop again.
+		if (cameraMoved)
 		{
-			switch (event.type)
+			mvpMat = camera.viewProjection();
+			if (cullBodies)
 			{
-				case SDL_QUIT:
-					userQuit = true;
-					break;
-
-				case SDL_KEYDOWN:
-					switch (event.key.keysym.sym)
-					{
-						case SDLK_ESCAPE:
-							userQuit = true;
-							break;
-
-						case SDLK_s:
-							update();
-							renderContext.render();
-							break;
-
-						default:
-							break;
-					}
-					break;
-
-				default:
-					break;
+				simulation.setView(camera.visibleAABB(cullMargin));
+			}
+			else
+			{
+				simulation.clearView();
+			}
+			cameraMoved = false;
+		}
+
+		auto const& snapshot = simulation.latestSnapshot();
+		update(snapshot, snapshot.alpha(frameStart));
+		renderContext.render();
+		gpuTimer.endFrame();
+		profiler.endFrame();
+
+		// With VSync, rendering blocks until the next frame. Otherwise, or when
+		// paused, sleep until input or a snapshot arrives, or the next frame is
+		// due.
+		auto const remaining =
+			minFrameSeconds - Seconds{Clock::now() - frameStart}.count();
+		DUKDEMO_TRACE_SCOPE("main", "wait");
+		if (simulation.paused())
+		{
+			if (SDL_WaitEvent(&event) != 0)
+			{
+				handleEvent(event);
+			}
+		}
+		else if (remaining > 0.001)
+		{
+			if (SDL_WaitEventTimeout(&event, int(remaining * 1000.0)) != 0)
+			{
+				handleEvent(event);
 			}
 		}
 	}
 
+	// Rethrows any error from the simulation thread.
+	simulation.stop();
+	renderContext.setProfiler(nullptr);
+	try
+	{
+		profiler.dump(pProfilePath);
+		if (dukdemo::util::trace::compiledIn())
+		{
+			dukdemo::util::trace::dump(pTracePath);
+		}
+	}
+	catch (std::runtime_error const& err)
+	{
+		LOG(WARNING) << err.what();
+	}
 	renderContext.reset();
 }
 
 
 int main(int argc, char const* const argv[])
 {
+	// Pass --js-profile FILE to sample the scripts' call stacks.
+	char const* pJsProfilePath = nullptr;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--js-profile") == 0)
+		{
+			pJsProfilePath = argv[++i];
+		}
+	}
+
 #ifdef NDEBUG
 	try
 	{
-		runScripts();
+		runScripts(pJsProfilePath);
 	}
 	catch (std::exception const& err)
 	{
@@ -271,7 +556,7 @@ int main(int argc, char const* const argv[])
 	}
 #else
 	// Run without intercepting exceptions so we get a stack trace.
-	runScripts();
+	runScripts(pJsProfilePath);
 #endif
 	return 0;
 }
@@ -0,0 +1,540 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include <Box2D/Common/b2Draw.h>
+
+#include "dukdemo/sim/Snapshot.h"
+#include "dukdemo/render/draw.h"
+#include "dukdemo/render/util.h"
+#include "dukdemo/render/BatchRenderer.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace render {
+
+
+using Snapshot = sim::Snapshot;
+
+
+/** The number of segments approximating a circle. */
+constexpr int circleSegments{24};
+
+/** The relative tolerance when checking whether a polygon is a rectangle. */
+constexpr float boxTolerance{1e-4f};
+
+/** The most vertices a polygon instance holds. */
+constexpr std::uint32_t maxPolygonVertices{8u};
+
+/** Colour multipliers for fills and outlines, as used by b2Draw. */
+constexpr GLfloat fillColourScale[4]{0.5f, 0.5f, 0.5f, 0.5f};
+constexpr GLfloat outlineColourScale[4]{1.0f, 1.0f, 1.0f, 1.0f};
+
+
+/** Get the address of a vertex attribute, as an offset into a buffer. */
+inline void const*
+attribOffset(std::size_t offset) noexcept
+{
+	return reinterpret_cast<void const*>(offset);
+}
+
+
+/** Set up a per-instance float attribute of the bound array buffer. */
+template <typename Instance>
+void
+setInstanceAttrib(GLuint index, GLint size, std::size_t offset)
+{
+	glEnableVertexAttribArray(index);
+	glVertexAttribPointer(
+		index,
+		size,
+		GL_FLOAT,
+		GL_FALSE,
+		GLsizei(sizeof(Instance)),
+		attribOffset(offset));
+	glVertexAttribDivisor(index, 1);
+}
+
+
+/** Append a line segment to mesh vertex data. */
+void
+appendSegment(std::vector<GLfloat>& data, b2Vec2 const& a, b2Vec2 const& b)
+{
+	data.insert(data.end(), {a.x, a.y, b.x, b.y});
+}
+
+
+/** Append a triangle to mesh vertex data. */
+void
+appendTriangle(
+	std::vector<GLfloat>& data,
+	b2Vec2 const& a,
+	b2Vec2 const& b,
+	b2Vec2 const& c
+)
+{
+	data.insert(data.end(), {a.x, a.y, b.x, b.y, c.x, c.y});
+}
+
+
+/** Get the index of the next vertex to be added to mesh data. */
+inline GLint
+nextVertex(std::vector<GLfloat> const& data) noexcept
+{
+	return GLint(data.size() / 2u);
+}
+
+
+/**
+ * Get the centre, half-extents and angle of a polygon, if it's a rectangle.
+ *
+ * @returns whether the polygon is a rectangle.
+ */
+bool
+getBox(
+	b2Vec2 const* pVertices,
+	std::uint32_t count,
+	b2Vec2& centre,
+	b2Vec2& halfExtents,
+	float& angle
+) noexcept
+{
+	if (count != 4u)
+	{
+		return false;
+	}
+
+	auto const edge0 = pVertices[1] - pVertices[0];
+	auto const edge1 = pVertices[2] - pVertices[1];
+	auto const edge3 = pVertices[3] - pVertices[0];
+	auto const tolerance =
+		boxTolerance * (edge0.LengthSquared() + edge1.LengthSquared());
+	if (std::abs(b2Dot(edge0, edge1)) > tolerance ||
+		(edge3 - edge1).LengthSquared() > tolerance)
+	{
+		return false;
+	}
+
+	// Box2D polygons wind anticlockwise, so edge1 is edge0 turned left.
+	centre = 0.5f * (pVertices[0] + pVertices[2]);
+	halfExtents.Set(0.5f * edge0.Length(), 0.5f * edge1.Length());
+	angle = std::atan2(edge0.y, edge0.x);
+	return true;
+}
+
+
+BatchRenderer::BatchRenderer()
+	:	m_instancedProgram(getProgram(createInstancedProgram()))
+	,	m_polygonProgram(getProgram(createPolygonProgram()))
+	,	m_meshBuffer{0u}
+	,	m_circles{}
+	,	m_boxes{}
+	,	m_segments{}
+	,	m_polygons{}
+	,	m_staticPolygons{}
+	,	m_dynamicPolygons{}
+	,	m_staticVersion{0u}
+	,	m_stats{}
+{
+	std::vector<GLfloat> data;
+	b2Vec2 const origin{0.0f, 0.0f};
+
+	// A unit circle, with a line showing its rotation.
+	Mesh circle{nextVertex(data), 0, 0, 0};
+	auto const circlePoint = [](int i) {
+		auto const theta = 2.0f * b2_pi * float(i) / float(circleSegments);
+		return b2Vec2{std::cos(theta), std::sin(theta)};
+	};
+	for (int i = 0; i < circleSegments; ++i)
+	{
+		appendTriangle(data, origin, circlePoint(i), circlePoint(i + 1));
+	}
+	circle.fillCount = nextVertex(data) - circle.fillFirst;
+	circle.outlineFirst = nextVertex(data);
+	for (int i = 0; i < circleSegments; ++i)
+	{
+		appendSegment(data, circlePoint(i), circlePoint(i + 1));
+	}
+	appendSegment(data, origin, b2Vec2{1.0f, 0.0f});
+	circle.outlineCount = nextVertex(data) - circle.outlineFirst;
+
+	// A box with half-extents of one.
+	b2Vec2 const corners[4]{{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f},
+		{-1.0f, 1.0f}};
+	Mesh box{nextVertex(data), 0, 0, 0};
+	appendTriangle(data, corners[0], corners[1], corners[2]);
+	appendTriangle(data, corners[0], corners[2], corners[3]);
+	box.fillCount = nextVertex(data) - box.fillFirst;
+	box.outlineFirst = nextVertex(data);
+	for (int i = 0; i < 4; ++i)
+	{
+		appendSegment(data, corners[i], corners[(i + 1) % 4]);
+	}
+	box.outlineCount = nextVertex(data) - box.outlineFirst;
+
+	// A unit segment along the x axis.
+	Mesh segment{0, 0, nextVertex(data), 2};
+	appendSegment(data, origin, b2Vec2{1.0f, 0.0f});
+
+	glGenBuffers(1, &m_meshBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		GLsizeiptr(data.size() * sizeof(GLfloat)),
+		data.data(),
+		GL_STATIC_DRAW);
+
+	initBatch(m_circles, circle);
+	initBatch(m_boxes, box);
+	initBatch(m_segments, segment);
+
+	initPolygonBuffer(m_staticPolygons);
+	initPolygonBuffer(m_dynamicPolygons);
+
+	glBindVertexArray(0u);
+	checkGLErrors("BatchRenderer created");
+}
+
+
+BatchRenderer::~BatchRenderer() noexcept
+{
+	for (auto const* pBuffer: {
+		&m_circles.staticInstances, &m_circles.dynamicInstances,
+		&m_boxes.staticInstances, &m_boxes.dynamicInstances,
+		&m_segments.staticInstances, &m_segments.dynamicInstances,
+		&m_staticPolygons, &m_dynamicPolygons})
+	{
+		glDeleteBuffers(1, &pBuffer->buffer);
+		glDeleteVertexArrays(1, &pBuffer->vertexArray);
+	}
+	glDeleteBuffers(1, &m_meshBuffer);
+	glDeleteProgram(m_polygonProgram.id);
+	glDeleteProgram(m_instancedProgram.id);
+}
+
+
+BatchRenderer::Program
+BatchRenderer::getProgram(GLuint programID)
+{
+	return Program{
+		programID,
+		glGetUniformLocation(programID, "MVP"),
+		glGetUniformLocation(programID, "colourScale"),
+		glGetUniformLocation(programID, "outline")
+	};
+}
+
+
+void
+BatchRenderer::initBatch(Batch& batch, Mesh const& mesh)
+{
+	batch.mesh = mesh;
+	for (auto* const pBuffer: {&batch.staticInstances, &batch.dynamicInstances})
+	{
+		glGenVertexArrays(1, &pBuffer->vertexArray);
+		glBindVertexArray(pBuffer->vertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+		glEnableVertexAttribArray(0u);
+		glVertexAttribPointer(0u, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+		glGenBuffers(1, &pBuffer->buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, pBuffer->buffer);
+		setInstanceAttrib<Instance>(1u, 4, offsetof(Instance, colour));
+		setInstanceAttrib<Instance>(2u, 4, offsetof(Instance, placement));
+		setInstanceAttrib<Instance>(3u, 2, offsetof(Instance, scale));
+		pBuffer->count = 0;
+	}
+}
+
+
+void
+BatchRenderer::initPolygonBuffer(InstanceBuffer& buffer)
+{
+	// Polygons have no mesh: the vertex shader reads the instance data.
+	glGenVertexArrays(1, &buffer.vertexArray);
+	glBindVertexArray(buffer.vertexArray);
+	glGenBuffers(1, &buffer.buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer);
+
+	using P = PolygonInstance;
+	setInstanceAttrib<P>(1u, 4, offsetof(P, colour));
+	setInstanceAttrib<P>(2u, 4, offsetof(P, placement));
+	for (GLuint i = 0u; i < 4u; ++i)
+	{
+		auto const offset = offsetof(P, vertices) + i * 4u * sizeof(GLfloat);
+		setInstanceAttrib<P>(4u + i, 4, offset);
+	}
+	setInstanceAttrib<P>(8u, 1, offsetof(P, vertexCount));
+	buffer.count = 0;
+}
+
+
+void
+BatchRenderer::addShape(
+	Snapshot::Geometry const& geometry,
+	std::size_t shapeIndex,
+	b2Transform const& xf,
+	b2Color const& colour
+)
+{
+	auto const& shape = geometry.shapes[shapeIndex];
+	auto const* const pVertices = geometry.verticesOf(shape);
+
+	auto const addSegment = [this, &colour](b2Vec2 const& a, b2Vec2 const& b) {
+		auto const delta = b - a;
+		auto const length = delta.Length();
+		if (length > b2_epsilon)
+		{
+			m_segments.instances.push_back(Instance{
+				{a.x, a.y, delta.x / length, delta.y / length},
+				{length, 1.0f},
+				{colour.r, colour.g, colour.b, 1.0f}
+			});
+		}
+	};
+
+	switch (shape.type)
+	{
+		case Snapshot::ShapeType::circle:
+		{
+			auto const centre = b2Mul(xf, pVertices[0]);
+			m_circles.instances.push_back(Instance{
+				{centre.x, centre.y, xf.q.c, xf.q.s},
+				{shape.radius, shape.radius},
+				{colour.r, colour.g, colour.b, 1.0f}
+			});
+			break;
+		}
+
+		case Snapshot::ShapeType::edge:
+			addSegment(b2Mul(xf, pVertices[0]), b2Mul(xf, pVertices[1]));
+			break;
+
+		case Snapshot::ShapeType::chain:
+			for (std::uint32_t i = 1u; i < shape.vertexCount; ++i)
+			{
+				addSegment(
+					b2Mul(xf, pVertices[i - 1u]), b2Mul(xf, pVertices[i]));
+			}
+			break;
+
+		case Snapshot::ShapeType::polygon:
+		{
+			b2Vec2 centre;
+			b2Vec2 halfExtents;
+			float angle{0.0f};
+			bool const isBox = getBox(
+				pVertices, shape.vertexCount, centre, halfExtents, angle);
+			if (isBox)
+			{
+				auto const position = b2Mul(xf, centre);
+				auto const rotation = b2Mul(xf.q, b2Rot{angle});
+				m_boxes.instances.push_back(Instance{
+					{position.x, position.y, rotation.c, rotation.s},
+					{halfExtents.x, halfExtents.y},
+					{colour.r, colour.g, colour.b, 1.0f}
+				});
+				break;
+			}
+
+			m_polygons.push_back(PolygonInstance{
+				{xf.p.x, xf.p.y, xf.q.c, xf.q.s},
+				{colour.r, colour.g, colour.b, 1.0f},
+				{},
+				0.0f
+			});
+			auto& polygon = m_polygons.back();
+			auto const count = std::min(shape.vertexCount, maxPolygonVertices);
+			for (std::uint32_t i = 0u; i < count; ++i)
+			{
+				polygon.vertices[2u * i] = pVertices[i].x;
+				polygon.vertices[2u * i + 1u] = pVertices[i].y;
+			}
+			polygon.vertexCount = GLfloat(count);
+			break;
+		}
+	}
+}
+
+
+void
+BatchRenderer::collect(Snapshot::Geometry const& geometry, float alpha)
+{
+	m_circles.instances.clear();
+	m_boxes.instances.clear();
+	m_segments.instances.clear();
+	m_polygons.clear();
+
+	for (auto const& body: geometry.bodies)
+	{
+		auto const xf =
+			sim::lerp(body.previous, body.current, alpha).transform();
+		auto const colour = getBodyColour(body);
+		for (std::uint32_t i = 0u; i < body.shapeCount; ++i)
+		{
+			addShape(geometry, body.firstShape + i, xf, colour);
+		}
+	}
+}
+
+
+void
+BatchRenderer::upload(
+	InstanceBuffer& target,
+	void const* pInstances,
+	std::size_t count,
+	std::size_t instanceSize,
+	GLenum usage
+)
+{
+	target.count = GLsizei(count);
+	if (count == 0u)
+	{
+		return;
+	}
+
+	// Respecifying the whole buffer lets the driver orphan the old one.
+	auto const bytes = count * instanceSize;
+	glBindBuffer(GL_ARRAY_BUFFER, target.buffer);
+	glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bytes), pInstances, usage);
+	m_stats.uploadedBytes += bytes;
+}
+
+
+void
+BatchRenderer::uploadAll(bool isStatic)
+{
+	auto const usage = GLenum(isStatic ? GL_STATIC_DRAW : GL_STREAM_DRAW);
+	for (auto* const pBatch: {&m_circles, &m_boxes, &m_segments})
+	{
+		upload(
+			isStatic ? pBatch->staticInstances : pBatch->dynamicInstances,
+			pBatch->instances.data(),
+			pBatch->instances.size(),
+			sizeof(Instance),
+			usage);
+	}
+	upload(
+		isStatic ? m_staticPolygons : m_dynamicPolygons,
+		m_polygons.data(),
+		m_polygons.size(),
+		sizeof(PolygonInstance),
+		usage);
+}
+
+
+void
+BatchRenderer::update(Snapshot const& snapshot, float alpha)
+{
+	DUKDEMO_TRACE_SCOPE("render", "BatchRenderer.update");
+	m_stats.uploadedBytes = 0u;
+
+	// Static geometry is only uploaded when it changes.
+	auto const* const pStatic = snapshot.pStaticGeometry.get();
+	auto const staticVersion = pStatic ? pStatic->version : 0u;
+	if (staticVersion != m_staticVersion)
+	{
+		collect(pStatic ? pStatic->geometry : Snapshot::Geometry{}, 1.0f);
+		uploadAll(true);
+		m_staticVersion = staticVersion;
+		++m_stats.staticUploads;
+	}
+
+	collect(snapshot.dynamicGeometry, alpha);
+	uploadAll(false);
+
+	auto const total = [](Batch const& batch) {
+		return std::size_t(
+			batch.staticInstances.count + batch.dynamicInstances.count);
+	};
+	m_stats.circles = total(m_circles);
+	m_stats.boxes = total(m_boxes);
+	m_stats.segments = total(m_segments);
+	m_stats.polygons =
+		std::size_t(m_staticPolygons.count + m_dynamicPolygons.count);
+}
+
+
+void
+BatchRenderer::drawBatch(Batch const& batch)
+{
+	for (auto const* pBuffer: {&batch.staticInstances, &batch.dynamicInstances})
+	{
+		if (pBuffer->count == 0)
+		{
+			continue;
+		}
+
+		glBindVertexArray(pBuffer->vertexArray);
+		if (batch.mesh.fillCount > 0)
+		{
+			glUniform4fv(m_instancedProgram.colourScaleLoc, 1, fillColourScale);
+			glDrawArraysInstanced(
+				GL_TRIANGLES,
+				batch.mesh.fillFirst,
+				batch.mesh.fillCount,
+				pBuffer->count);
+			++m_stats.drawCalls;
+		}
+		glUniform4fv(m_instancedProgram.colourScaleLoc, 1, outlineColourScale);
+		glDrawArraysInstanced(
+			GL_LINES,
+			batch.mesh.outlineFirst,
+			batch.mesh.outlineCount,
+			pBuffer->count);
+		++m_stats.drawCalls;
+	}
+}
+
+
+void
+BatchRenderer::render(GLfloat const* pMVP)
+{
+	DUKDEMO_TRACE_SCOPE("render", "BatchRenderer.render");
+	m_stats.drawCalls = 0u;
+
+	// Everything lies in one plane, so outlines would fail the depth test.
+	GLboolean const depthTest{glIsEnabled(GL_DEPTH_TEST)};
+	glDisable(GL_DEPTH_TEST);
+
+	glUseProgram(m_instancedProgram.id);
+	glUniformMatrix4fv(m_instancedProgram.mvpLoc, 1, GL_FALSE, pMVP);
+	drawBatch(m_circles);
+	drawBatch(m_boxes);
+	drawBatch(m_segments);
+
+	glUseProgram(m_polygonProgram.id);
+	glUniformMatrix4fv(m_polygonProgram.mvpLoc, 1, GL_FALSE, pMVP);
+	for (auto const* pBuffer: {&m_staticPolygons, &m_dynamicPolygons})
+	{
+		if (pBuffer->count == 0)
+		{
+			continue;
+		}
+
+		// Fill as a fan of six triangles, then outline with eight lines.
+		glBindVertexArray(pBuffer->vertexArray);
+		glUniform4fv(m_polygonProgram.colourScaleLoc, 1, fillColourScale);
+		glUniform1i(m_polygonProgram.outlineLoc, GL_FALSE);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 18, pBuffer->count);
+		glUniform4fv(m_polygonProgram.colourScaleLoc, 1, outlineColourScale);
+		glUniform1i(m_polygonProgram.outlineLoc, GL_TRUE);
+		glDrawArraysInstanced(GL_LINES, 0, 16, pBuffer->count);
+		m_stats.drawCalls += 2u;
+	}
+
+	glBindVertexArray(0u);
+	if (depthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+}
+
+
+} // namespace render
+} // namespace dukdemo
@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "dukdemo/render/Camera.h"
+
+
+namespace dukdemo {
+namespace render {
+
+
+Camera::Camera(
+	b2Vec2 const& centre,
+	float halfHeight,
+	float aspectRatio
+) noexcept
+	:	m_centre{centre}
+	,	m_halfHeight{halfHeight}
+	,	m_aspectRatio{aspectRatio}
+{
+}
+
+
+void
+Camera::zoom(float factor) noexcept
+{
+	m_halfHeight = std::min(
+		std::max(m_halfHeight * factor, s_minHalfHeight),
+		s_maxHalfHeight);
+}
+
+
+b2AABB
+Camera::visibleAABB(float margin) const noexcept
+{
+	b2Vec2 const extents{
+		m_halfHeight * m_aspectRatio + margin,
+		m_halfHeight + margin
+	};
+	b2AABB aabb;
+	aabb.lowerBound = m_centre - extents;
+	aabb.upperBound = m_centre + extents;
+	return aabb;
+}
+
+
+glm::mat4
+Camera::viewProjection() const
+{
+	auto const aabb = visibleAABB();
+	return glm::ortho(
+		aabb.lowerBound.x,
+		aabb.upperBound.x,
+		aabb.lowerBound.y,
+		aabb.upperBound.y,
+		-1.0f,
+		1.0f);
+}
+
+
+} // namespace render
+} // namespace dukdemo
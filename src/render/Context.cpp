@@ -6,6 +6,7 @@
 
 #include "dukdemo/render/util.h"
 #include "dukdemo/render/Context.h"
+#include "dukdemo/util/Trace.h"
 
 
 namespace dukdemo {
@@ -22,6 +23,8 @@ Context::Context(
 	Uint32 windowType
 )
 	:	m_onRender{onRender}
+	,	m_pProfiler{nullptr}
+	,	m_swapPhase{0u}
 	,	m_pWindow{SDL_CreateWindow(
 			pWindowName,
 			windowX, windowY,
@@ -71,11 +74,26 @@ Context::~Context() noexcept
 }
 
 
+void
+Context::setProfiler(util::FrameProfiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+	if (m_pProfiler)
+	{
+		m_swapPhase = m_pProfiler->addPhase("swap");
+	}
+}
+
+
 void
 Context::render()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	m_onRender();
+
+	// With VSync, this includes waiting for the display.
+	DUKDEMO_TRACE_SCOPE("render", "swap");
+	util::FrameProfiler::ScopedTimer timer{m_pProfiler, m_swapPhase};
 	SDL_GL_SwapWindow(m_pWindow.get());
 }
 
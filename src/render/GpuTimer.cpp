@@ -0,0 +1,96 @@
+#include "dukdemo/render/GpuTimer.h"
+
+
+namespace dukdemo {
+namespace render {
+
+
+constexpr double secondsPerNanosecond{1e-9};
+
+
+GpuTimer::GpuTimer(util::FrameProfiler& profiler)
+	:	m_profiler(profiler)
+	,	m_supported{GLEW_VERSION_3_3 || GLEW_ARB_timer_query}
+	,	m_sets()
+	,	m_current{0u}
+	,	m_dropped{0u}
+{
+}
+
+
+GpuTimer::~GpuTimer() noexcept
+{
+	for (auto const& set: m_sets)
+	{
+		for (auto const& query: set.queries)
+		{
+			glDeleteQueries(1, &query.id);
+		}
+	}
+}
+
+
+void
+GpuTimer::begin(std::size_t phase)
+{
+	if (!m_supported)
+	{
+		return;
+	}
+
+	auto& set = m_sets[m_current];
+	if (set.used == set.queries.size())
+	{
+		Query query{0u, phase};
+		glGenQueries(1, &query.id);
+		set.queries.push_back(query);
+	}
+	auto& query = set.queries[set.used++];
+	query.phase = phase;
+	glBeginQuery(GL_TIME_ELAPSED, query.id);
+}
+
+
+void
+GpuTimer::end() noexcept
+{
+	if (m_supported)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+}
+
+
+void
+GpuTimer::endFrame()
+{
+	if (!m_supported)
+	{
+		return;
+	}
+
+	// The other set holds the previous frame's queries.
+	m_current = 1u - m_current;
+	auto& set = m_sets[m_current];
+	for (std::size_t i = 0u; i < set.used; ++i)
+	{
+		auto const& query = set.queries[i];
+		GLint available{GL_FALSE};
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+		{
+			++m_dropped;
+			continue;
+		}
+
+		GLuint64 nanoseconds{0u};
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+		m_profiler.recordGpu(
+			query.phase, double(nanoseconds) * secondsPerNanosecond);
+	}
+	set.used = 0u;
+}
+
+
+} // namespace render
+} // namespace dukdemo
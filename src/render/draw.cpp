@@ -0,0 +1,120 @@
+#include <Box2D/Common/b2Draw.h>
+
+#include "dukdemo/sim/Snapshot.h"
+#include "dukdemo/render/draw.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace render {
+
+
+using Snapshot = sim::Snapshot;
+
+
+b2Color
+getBodyColour(Snapshot::Body const& body)
+{
+	if (!body.active)
+	{
+		return b2Color{0.5f, 0.5f, 0.3f};
+	}
+	switch (body.type)
+	{
+		case b2_staticBody:
+			return b2Color{0.5f, 0.9f, 0.5f};
+		case b2_kinematicBody:
+			return b2Color{0.5f, 0.5f, 0.9f};
+		default:
+			return body.awake
+				? b2Color{0.9f, 0.7f, 0.7f}
+				: b2Color{0.6f, 0.6f, 0.6f};
+	}
+}
+
+
+/** Draw a snapshot shape, as b2World::DrawShape does. */
+void
+drawShape(
+	b2Draw& draw,
+	Snapshot::Geometry const& geometry,
+	Snapshot::Shape const& shape,
+	b2Transform const& xf,
+	b2Color const& colour
+)
+{
+	auto const* const pVertices = geometry.verticesOf(shape);
+	switch (shape.type)
+	{
+		case Snapshot::ShapeType::circle:
+			draw.DrawSolidCircle(
+				b2Mul(xf, pVertices[0]),
+				shape.radius,
+				b2Mul(xf.q, b2Vec2{1.0f, 0.0f}),
+				colour);
+			break;
+
+		case Snapshot::ShapeType::edge:
+			draw.DrawSegment(
+				b2Mul(xf, pVertices[0]), b2Mul(xf, pVertices[1]), colour);
+			break;
+
+		case Snapshot::ShapeType::chain:
+		{
+			auto v1 = b2Mul(xf, pVertices[0]);
+			for (std::uint32_t i = 1u; i < shape.vertexCount; ++i)
+			{
+				auto const v2 = b2Mul(xf, pVertices[i]);
+				draw.DrawSegment(v1, v2, colour);
+				draw.DrawCircle(v1, 0.05f, colour);
+				v1 = v2;
+			}
+			break;
+		}
+
+		case Snapshot::ShapeType::polygon:
+		{
+			b2Vec2 vertices[b2_maxPolygonVertices];
+			for (std::uint32_t i = 0u; i < shape.vertexCount; ++i)
+			{
+				vertices[i] = b2Mul(xf, pVertices[i]);
+			}
+			draw.DrawSolidPolygon(vertices, int32(shape.vertexCount), colour);
+			break;
+		}
+	}
+}
+
+
+/** Draw some of a snapshot's bodies. */
+void
+drawGeometry(Snapshot::Geometry const& geometry, b2Draw& draw, float alpha)
+{
+	for (auto const& body: geometry.bodies)
+	{
+		auto const xf =
+			sim::lerp(body.previous, body.current, alpha).transform();
+		auto const colour = getBodyColour(body);
+		auto const* const pShapes = geometry.shapesOf(body);
+		for (std::uint32_t i = 0u; i < body.shapeCount; ++i)
+		{
+			drawShape(draw, geometry, pShapes[i], xf, colour);
+		}
+	}
+}
+
+
+void
+drawSnapshot(Snapshot const& snapshot, b2Draw& draw, float alpha)
+{
+	DUKDEMO_TRACE_SCOPE("render", "drawSnapshot");
+	if (snapshot.pStaticGeometry)
+	{
+		drawGeometry(snapshot.pStaticGeometry->geometry, draw, alpha);
+	}
+	drawGeometry(snapshot.dynamicGeometry, draw, alpha);
+}
+
+
+} // namespace render
+} // namespace dukdemo
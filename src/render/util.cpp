@@ -11,6 +11,19 @@ namespace dukdemo {
 namespace render {
 
 
+/** A fragment shader passing through the vertex colour. */
+constexpr GLchar const* const pColourFragmentSource = R"GLS(\
+#version 330 core
+
+in vec4 fsColour;
+out vec4 fragColour;
+
+void main() {
+	fragColour = fsColour;
+}
+	)GLS";
+
+
 /**
  * Create a GL program and add compiled shaders.
  *
@@ -36,17 +49,97 @@ void main() {
 
 	)GLS")};
 
-	GLuint const fragShaderID{compileShader(GL_FRAGMENT_SHADER, R"GLS(\
+	GLuint const fragShaderID{
+		compileShader(GL_FRAGMENT_SHADER, pColourFragmentSource)};
+	return linkProgram(vertShaderID, fragShaderID);
+}
+
+
+GLuint const createInstancedProgram()
+{
+	GLuint const vertShaderID{compileShader(GL_VERTEX_SHADER, R"GLS(\
 #version 330 core
 
-in vec4 fsColour;
-out vec4 fragColour;
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 colour;
+layout(location = 2) in vec4 placement;
+layout(location = 3) in vec2 scale;
+
+out vec4 fsColour;
+uniform mat4 MVP;
+uniform vec4 colourScale;
+
 
 void main() {
-	fragColour = fsColour;
+	vec2 local = position * scale;
+	vec2 rotated = vec2(
+		placement.z * local.x - placement.w * local.y,
+		placement.w * local.x + placement.z * local.y
+	);
+	gl_Position = MVP * vec4(placement.xy + rotated, 0, 1);
+	fsColour = colour * colourScale;
+}
+
+	)GLS")};
+
+	GLuint const fragShaderID{
+		compileShader(GL_FRAGMENT_SHADER, pColourFragmentSource)};
+	return linkProgram(vertShaderID, fragShaderID);
 }
+
+
+GLuint const createPolygonProgram()
+{
+	GLuint const vertShaderID{compileShader(GL_VERTEX_SHADER, R"GLS(\
+#version 330 core
+
+layout(location = 1) in vec4 colour;
+layout(location = 2) in vec4 placement;
+layout(location = 4) in mat4 vertices;
+layout(location = 8) in float vertexCount;
+
+out vec4 fsColour;
+uniform mat4 MVP;
+uniform vec4 colourScale;
+uniform bool outline;
+
+
+void main() {
+	int count = int(vertexCount);
+	int index;
+	if (outline) {
+		// Lines: segment i joins vertices i and i + 1, or is degenerate.
+		int segment = gl_VertexID / 2;
+		index = segment < count ? (segment + gl_VertexID % 2) % count : 0;
+	}
+	else {
+		// Triangles: a fan around vertex 0, degenerate beyond the count.
+		int corner = gl_VertexID % 3;
+		index = corner == 0 ? 0 : min(gl_VertexID / 3 + corner, count - 1);
+	}
+
+	// Each column of the matrix holds two vertices.
+	vec4 pair = vertices[index / 2];
+	vec2 local = index % 2 == 0 ? pair.xy : pair.zw;
+	vec2 rotated = vec2(
+		placement.z * local.x - placement.w * local.y,
+		placement.w * local.x + placement.z * local.y
+	);
+	gl_Position = MVP * vec4(placement.xy + rotated, 0, 1);
+	fsColour = colour * colourScale;
+}
+
 	)GLS")};
 
+	GLuint const fragShaderID{
+		compileShader(GL_FRAGMENT_SHADER, pColourFragmentSource)};
+	return linkProgram(vertShaderID, fragShaderID);
+}
+
+
+/** Link a vertex and fragment shader into a program. */
+GLuint const linkProgram(GLuint const vertShaderID, GLuint const fragShaderID)
+{
 	GLuint const programID{glCreateProgram()};
 	glAttachShader(programID, vertShaderID);
 	glAttachShader(programID, fragShaderID);
@@ -0,0 +1,702 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/JsonScene.h"
+#include "dukdemo/scripting/Prefab.h"
+#include "dukdemo/util/MappedFile.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scene {
+
+
+// Records are written and read in the host's layout, which must therefore
+// match the file's.
+static_assert(
+	__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+	"Binary scenes need a little-endian host"
+);
+static_assert(
+	std::numeric_limits<float>::is_iec559,
+	"Binary scenes need IEEE 754 floats"
+);
+static_assert(sizeof(BinarySceneHeader) == 24u, "Unexpected header padding");
+static_assert(sizeof(BinaryBody) == 52u, "Unexpected body padding");
+static_assert(sizeof(BinaryFixture) == 28u, "Unexpected fixture padding");
+static_assert(
+	std::is_trivially_copyable<BinaryBody>::value &&
+	std::is_trivially_copyable<BinaryFixture>::value,
+	"Records must be readable in place"
+);
+static_assert(
+	sizeof(b2Vec2) == 2 * sizeof(float),
+	"b2Vec2 must be two packed floats"
+);
+
+
+/** The number of floats in a vertex. */
+constexpr std::size_t coordsPerVertex = 2u;
+
+
+/** Vertices before a polygon's hull, or a chain's vertices. */
+constexpr std::uint32_t polygonPrefix = 1u;
+constexpr std::uint32_t chainPrefix = 2u;
+
+
+/** The arrays of a scene whose header has been checked. */
+struct SceneArrays
+{
+	BinaryBody const* pBodies;
+	std::size_t bodyCount;
+	BinaryFixture const* pFixtures;
+	std::size_t fixtureCount;
+	float const* pCoords;
+	std::size_t vertexCount;
+};
+
+
+bool
+getArrays(void const* pData, std::size_t size, SceneArrays* pArrays) noexcept
+{
+	if (
+		size < sizeof(BinarySceneHeader) ||
+		reinterpret_cast<std::uintptr_t>(pData) % alignof(BinaryBody) != 0u
+	)
+	{
+		return false;
+	}
+
+	auto const* const pBytes = static_cast<unsigned char const*>(pData);
+	auto const& header = *reinterpret_cast<BinarySceneHeader const*>(pBytes);
+	bool const hasMagic = std::memcmp(
+		header.magic, g_binarySceneMagic, sizeof(g_binarySceneMagic)) == 0;
+	if (!hasMagic || header.version != g_binarySceneVersion)
+	{
+		return false;
+	}
+
+	// Counts are 32-bit, so the sizes can't overflow.
+	auto const bodyBytes = std::uint64_t(header.bodyCount) * sizeof(BinaryBody);
+	auto const fixtureBytes =
+		std::uint64_t(header.fixtureCount) * sizeof(BinaryFixture);
+	auto const vertexBytes = std::uint64_t(header.vertexCount) * sizeof(b2Vec2);
+	if (
+		std::uint64_t(size) != sizeof(BinarySceneHeader) + bodyBytes +
+			fixtureBytes + vertexBytes
+	)
+	{
+		return false;
+	}
+
+	auto const* pNext = pBytes + sizeof(BinarySceneHeader);
+	pArrays->pBodies = reinterpret_cast<BinaryBody const*>(pNext);
+	pArrays->bodyCount = header.bodyCount;
+	pNext += bodyBytes;
+	pArrays->pFixtures = reinterpret_cast<BinaryFixture const*>(pNext);
+	pArrays->fixtureCount = header.fixtureCount;
+	pNext += fixtureBytes;
+	pArrays->pCoords = reinterpret_cast<float const*>(pNext);
+	pArrays->vertexCount = header.vertexCount;
+	return true;
+}
+
+
+bool
+allFinite(float const* pValues, std::size_t count) noexcept
+{
+	for (std::size_t i = 0u; i < count; ++i)
+	{
+		if (!std::isfinite(pValues[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+isBool(std::uint8_t value) noexcept
+{
+	return value <= 1u;
+}
+
+
+bool
+validateBody(BinaryBody const& body) noexcept
+{
+	float const floats[] = {
+		body.position[0], body.position[1], body.angle,
+		body.linearVelocity[0], body.linearVelocity[1], body.angularVelocity,
+		body.linearDamping, body.angularDamping, body.gravityScale,
+	};
+	return
+		body.type <= b2_dynamicBody &&
+		allFinite(&floats[0], sizeof(floats) / sizeof(floats[0])) &&
+		isBool(body.allowSleep) &&
+		isBool(body.awake) &&
+		isBool(body.fixedRotation) &&
+		isBool(body.bullet) &&
+		isBool(body.active);
+}
+
+
+b2Vec2
+vertexAt(float const* pCoords, std::size_t index) noexcept
+{
+	return b2Vec2{
+		pCoords[coordsPerVertex * index],
+		pCoords[coordsPerVertex * index + 1u]};
+}
+
+
+/** Copy a stored polygon, whose vertex count has been checked. */
+void
+setPolygon(
+	BinaryFixture const& fixture,
+	float const* pCoords,
+	b2PolygonShape* pShape
+) noexcept
+{
+	auto const count = (fixture.vertexCount - polygonPrefix) / 2u;
+	pShape->m_radius = fixture.radius;
+	pShape->m_centroid = vertexAt(pCoords, 0u);
+	pShape->m_count = int32(count);
+	for (std::uint32_t i = 0u; i < count; ++i)
+	{
+		pShape->m_vertices[i] = vertexAt(pCoords, polygonPrefix + i);
+		pShape->m_normals[i] = vertexAt(pCoords, polygonPrefix + count + i);
+	}
+}
+
+
+/**
+ * Check that a polygon's normals are the outward unit normals of its edges,
+ * as `b2PolygonShape::Set` computes them, since collision trusts them.
+ */
+bool
+validateNormals(b2PolygonShape const& shape) noexcept
+{
+	// Allows for rounding where the writer computed them differently.
+	constexpr float tolerance = 1e-4f;
+	for (int32 i = 0; i < shape.m_count; ++i)
+	{
+		auto const next = i + 1 < shape.m_count ? i + 1 : 0;
+		auto normal =
+			b2Cross(shape.m_vertices[next] - shape.m_vertices[i], 1.0f);
+		normal.Normalize();
+		if (
+			b2DistanceSquared(normal, shape.m_normals[i]) >
+				tolerance * tolerance
+		)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/** Check a chain's vertices as `b2ChainShape::CreateChain` asserts. */
+bool
+validateChain(float const* pCoords, std::uint32_t count) noexcept
+{
+	constexpr float minDistanceSquared = b2_linearSlop * b2_linearSlop;
+	if (count < 2u)
+	{
+		return false;
+	}
+	for (std::uint32_t i = 1u; i < count; ++i)
+	{
+		if (
+			b2DistanceSquared(
+				vertexAt(pCoords, chainPrefix + i - 1u),
+				vertexAt(pCoords, chainPrefix + i)) <= minDistanceSquared
+		)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+validateBinaryFixture(
+	BinaryFixture const& fixture,
+	float const* pCoords
+) noexcept
+{
+	float const floats[] = {
+		fixture.friction, fixture.restitution, fixture.density, fixture.radius,
+	};
+	if (
+		!allFinite(&floats[0], sizeof(floats) / sizeof(floats[0])) ||
+		!allFinite(pCoords, coordsPerVertex * fixture.vertexCount)
+	)
+	{
+		return false;
+	}
+
+	std::uint8_t allowedFlags = BinaryFixture::IsSensor;
+	bool valid = false;
+	switch (fixture.shapeType)
+	{
+		case b2Shape::e_circle:
+			valid = fixture.vertexCount == 1u;
+			break;
+
+		case b2Shape::e_edge:
+			allowedFlags |= BinaryFixture::HasPrev | BinaryFixture::HasNext;
+			valid = fixture.vertexCount == 4u;
+			break;
+
+		case b2Shape::e_polygon:
+		{
+			auto const hullCount = (fixture.vertexCount - polygonPrefix) / 2u;
+			valid =
+				fixture.vertexCount == polygonPrefix + 2u * hullCount &&
+				3u <= hullCount && hullCount <= b2_maxPolygonVertices;
+			if (valid)
+			{
+				b2PolygonShape shape;
+				setPolygon(fixture, pCoords, &shape);
+				valid = shape.Validate() && validateNormals(shape);
+			}
+			break;
+		}
+
+		case b2Shape::e_chain:
+			allowedFlags |= BinaryFixture::HasPrev | BinaryFixture::HasNext;
+			valid =
+				fixture.vertexCount >= chainPrefix &&
+				validateChain(pCoords, fixture.vertexCount - chainPrefix);
+			break;
+
+		default:
+			break;
+	}
+	return valid && (fixture.flags & ~allowedFlags) == 0u;
+}
+
+
+bool
+validateScene(SceneArrays const& scene) noexcept
+{
+	std::size_t fixtureIdx = 0u;
+	std::size_t vertexIdx = 0u;
+	for (std::size_t i = 0u; i < scene.bodyCount; ++i)
+	{
+		auto const& body = scene.pBodies[i];
+		if (
+			!validateBody(body) ||
+			body.fixtureCount > scene.fixtureCount - fixtureIdx
+		)
+		{
+			return false;
+		}
+
+		auto const fixtureEnd = fixtureIdx + body.fixtureCount;
+		for (; fixtureIdx < fixtureEnd; ++fixtureIdx)
+		{
+			auto const& fixture = scene.pFixtures[fixtureIdx];
+			if (
+				fixture.vertexCount > scene.vertexCount - vertexIdx ||
+				!validateBinaryFixture(
+					fixture, scene.pCoords + coordsPerVertex * vertexIdx)
+			)
+			{
+				return false;
+			}
+			vertexIdx += fixture.vertexCount;
+		}
+	}
+	return fixtureIdx == scene.fixtureCount && vertexIdx == scene.vertexCount;
+}
+
+
+b2Fixture*
+createBinaryFixture(
+	b2Body* pBody,
+	BinaryFixture const& fixture,
+	float const* pCoords
+)
+{
+	b2FixtureDef def;
+	def.friction = fixture.friction;
+	def.restitution = fixture.restitution;
+	def.density = fixture.density;
+	def.isSensor = (fixture.flags & BinaryFixture::IsSensor) != 0u;
+	def.filter.categoryBits = fixture.categoryBits;
+	def.filter.maskBits = fixture.maskBits;
+	def.filter.groupIndex = fixture.groupIndex;
+	bool const hasPrev = (fixture.flags & BinaryFixture::HasPrev) != 0u;
+	bool const hasNext = (fixture.flags & BinaryFixture::HasNext) != 0u;
+
+	b2Fixture* pFixture = nullptr;
+	switch (fixture.shapeType)
+	{
+		case b2Shape::e_circle:
+		{
+			b2CircleShape shape;
+			shape.m_radius = fixture.radius;
+			shape.m_p = vertexAt(pCoords, 0u);
+			def.shape = &shape;
+			pFixture = pBody->CreateFixture(&def);
+			break;
+		}
+
+		case b2Shape::e_edge:
+		{
+			b2EdgeShape shape;
+			shape.m_radius = fixture.radius;
+			shape.m_vertex0 = vertexAt(pCoords, 0u);
+			shape.m_vertex1 = vertexAt(pCoords, 1u);
+			shape.m_vertex2 = vertexAt(pCoords, 2u);
+			shape.m_vertex3 = vertexAt(pCoords, 3u);
+			shape.m_hasVertex0 = hasPrev;
+			shape.m_hasVertex3 = hasNext;
+			def.shape = &shape;
+			pFixture = pBody->CreateFixture(&def);
+			break;
+		}
+
+		case b2Shape::e_polygon:
+		{
+			b2PolygonShape shape;
+			setPolygon(fixture, pCoords, &shape);
+			def.shape = &shape;
+			pFixture = pBody->CreateFixture(&def);
+			break;
+		}
+
+		case b2Shape::e_chain:
+		{
+			// The fixture clones the shape, copying its vertices, so lend it
+			// the mapped vertices rather than copying them twice.
+			b2ChainShape shape;
+			shape.m_radius = fixture.radius;
+			shape.m_prevVertex = vertexAt(pCoords, 0u);
+			shape.m_nextVertex = vertexAt(pCoords, 1u);
+			shape.m_hasPrevVertex = hasPrev;
+			shape.m_hasNextVertex = hasNext;
+			shape.m_vertices = const_cast<b2Vec2*>(
+				reinterpret_cast<b2Vec2 const*>(
+					pCoords + coordsPerVertex * chainPrefix));
+			shape.m_count = int32(fixture.vertexCount - chainPrefix);
+			def.shape = &shape;
+			pFixture = pBody->CreateFixture(&def);
+			shape.m_vertices = nullptr;
+			shape.m_count = 0;
+			break;
+		}
+	}
+	return pFixture;
+}
+
+
+void
+createBodies(SceneArrays const& scene, b2World& world)
+{
+	std::size_t fixtureIdx = 0u;
+	std::size_t vertexIdx = 0u;
+	for (std::size_t i = 0u; i < scene.bodyCount; ++i)
+	{
+		auto const& body = scene.pBodies[i];
+		b2BodyDef def;
+		def.type = b2BodyType(body.type);
+		def.position.Set(body.position[0], body.position[1]);
+		def.angle = body.angle;
+		def.linearVelocity.Set(body.linearVelocity[0], body.linearVelocity[1]);
+		def.angularVelocity = body.angularVelocity;
+		def.linearDamping = body.linearDamping;
+		def.angularDamping = body.angularDamping;
+		def.gravityScale = body.gravityScale;
+		def.allowSleep = body.allowSleep != 0u;
+		def.awake = body.awake != 0u;
+		def.fixedRotation = body.fixedRotation != 0u;
+		def.bullet = body.bullet != 0u;
+		def.active = body.active != 0u;
+
+		auto* const pBody = world.CreateBody(&def);
+		auto const fixtureEnd = fixtureIdx + body.fixtureCount;
+		for (; fixtureIdx < fixtureEnd; ++fixtureIdx)
+		{
+			auto const& fixture = scene.pFixtures[fixtureIdx];
+			createBinaryFixture(
+				pBody, fixture, scene.pCoords + coordsPerVertex * vertexIdx);
+			vertexIdx += fixture.vertexCount;
+		}
+	}
+}
+
+
+std::uint32_t
+binaryVertexCount(b2Shape const& shape) noexcept
+{
+	switch (shape.GetType())
+	{
+		case b2Shape::e_circle:
+			return 1u;
+
+		case b2Shape::e_edge:
+			return 4u;
+
+		case b2Shape::e_polygon:
+			return polygonPrefix + 2u * std::uint32_t(
+				static_cast<b2PolygonShape const&>(shape).m_count);
+
+		case b2Shape::e_chain:
+			return chainPrefix + std::uint32_t(
+				static_cast<b2ChainShape const&>(shape).m_count);
+
+		default:
+			return 0u;
+	}
+}
+
+
+/**
+ * Call a function with each of a shape's vertices, in the order they're
+ * stored.
+ *
+ * @returns the shape's @ref BinaryFixture::Flag "neighbour flags".
+ */
+template<typename Fn>
+std::uint8_t
+forEachBinaryVertex(b2Shape const& shape, Fn fn)
+{
+	auto const neighbours = [](bool prev, bool next) {
+		return std::uint8_t(
+			(prev ? BinaryFixture::HasPrev : 0u) |
+			(next ? BinaryFixture::HasNext : 0u));
+	};
+	switch (shape.GetType())
+	{
+		case b2Shape::e_circle:
+			fn(static_cast<b2CircleShape const&>(shape).m_p);
+			return 0u;
+
+		case b2Shape::e_edge:
+		{
+			auto const& edge = static_cast<b2EdgeShape const&>(shape);
+			fn(edge.m_vertex0);
+			fn(edge.m_vertex1);
+			fn(edge.m_vertex2);
+			fn(edge.m_vertex3);
+			return neighbours(edge.m_hasVertex0, edge.m_hasVertex3);
+		}
+
+		case b2Shape::e_polygon:
+		{
+			auto const& polygon = static_cast<b2PolygonShape const&>(shape);
+			fn(polygon.m_centroid);
+			for (int32 i = 0; i < polygon.m_count; ++i)
+			{
+				fn(polygon.m_vertices[i]);
+			}
+			for (int32 i = 0; i < polygon.m_count; ++i)
+			{
+				fn(polygon.m_normals[i]);
+			}
+			return 0u;
+		}
+
+		case b2Shape::e_chain:
+		{
+			auto const& chain = static_cast<b2ChainShape const&>(shape);
+			fn(chain.m_prevVertex);
+			fn(chain.m_nextVertex);
+			for (int32 i = 0; i < chain.m_count; ++i)
+			{
+				fn(chain.m_vertices[i]);
+			}
+			return neighbours(chain.m_hasPrevVertex, chain.m_hasNextVertex);
+		}
+
+		default:
+			return 0u;
+	}
+}
+
+
+BinaryFixture
+storeBinaryFixture(b2FixtureDef const& def, float* pCoords) noexcept
+{
+	auto const& shape = *def.shape;
+	BinaryFixture record{};
+	record.friction = def.friction;
+	record.restitution = def.restitution;
+	record.density = def.density;
+	record.categoryBits = def.filter.categoryBits;
+	record.maskBits = def.filter.maskBits;
+	record.groupIndex = def.filter.groupIndex;
+	record.shapeType = std::uint8_t(shape.GetType());
+	record.radius = shape.m_radius;
+	record.vertexCount = binaryVertexCount(shape);
+	record.flags = forEachBinaryVertex(
+		shape,
+		[&pCoords](b2Vec2 const& vertex) {
+			*pCoords++ = vertex.x;
+			*pCoords++ = vertex.y;
+		});
+	if (def.isSensor)
+	{
+		record.flags |= BinaryFixture::IsSensor;
+	}
+	return record;
+}
+
+
+bool
+matchesBinaryShape(
+	b2Shape const& shape,
+	BinaryFixture const& fixture,
+	float const* pCoords
+) noexcept
+{
+	if (
+		shape.GetType() != fixture.shapeType ||
+		shape.m_radius != fixture.radius ||
+		binaryVertexCount(shape) != fixture.vertexCount
+	)
+	{
+		return false;
+	}
+
+	bool same = true;
+	auto const neighbours = forEachBinaryVertex(
+		shape,
+		[&same, &pCoords](b2Vec2 const& vertex) {
+			same = same && vertex.x == pCoords[0] && vertex.y == pCoords[1];
+			pCoords += coordsPerVertex;
+		});
+	auto const neighbourMask = BinaryFixture::HasPrev | BinaryFixture::HasNext;
+	return same && neighbours == (fixture.flags & neighbourMask);
+}
+
+
+BinarySceneWriter::BinarySceneWriter()
+	:	m_bodies{}
+	,	m_fixtures{}
+	,	m_coords{}
+{
+}
+
+
+void
+BinarySceneWriter::add(scripting::Prefab const& body)
+{
+	auto const& bodyDef = body.bodyDef;
+	BinaryBody record{};
+	record.type = std::uint32_t(bodyDef.type);
+	record.position[0] = bodyDef.position.x;
+	record.position[1] = bodyDef.position.y;
+	record.angle = bodyDef.angle;
+	record.linearVelocity[0] = bodyDef.linearVelocity.x;
+	record.linearVelocity[1] = bodyDef.linearVelocity.y;
+	record.angularVelocity = bodyDef.angularVelocity;
+	record.linearDamping = bodyDef.linearDamping;
+	record.angularDamping = bodyDef.angularDamping;
+	record.gravityScale = bodyDef.gravityScale;
+	record.allowSleep = bodyDef.allowSleep;
+	record.awake = bodyDef.awake;
+	record.fixedRotation = bodyDef.fixedRotation;
+	record.bullet = bodyDef.bullet;
+	record.active = bodyDef.active;
+	record.fixtureCount = std::uint32_t(body.fixtures.size());
+	m_bodies.push_back(record);
+
+	for (auto const& fixture: body.fixtures)
+	{
+		auto const firstCoord = m_coords.size();
+		m_coords.resize(
+			firstCoord + coordsPerVertex * binaryVertexCount(*fixture.pShape));
+		m_fixtures.push_back(
+			storeBinaryFixture(fixture.def, &m_coords[firstCoord]));
+	}
+}
+
+
+bool
+BinarySceneWriter::write(std::ostream& out) const
+{
+	BinarySceneHeader header{};
+	std::memcpy(header.magic, g_binarySceneMagic, sizeof(g_binarySceneMagic));
+	header.version = g_binarySceneVersion;
+	header.bodyCount = std::uint32_t(m_bodies.size());
+	header.fixtureCount = std::uint32_t(m_fixtures.size());
+	header.vertexCount = std::uint32_t(m_coords.size() / coordsPerVertex);
+
+	out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	out.write(
+		reinterpret_cast<char const*>(m_bodies.data()),
+		std::streamsize(m_bodies.size() * sizeof(BinaryBody)));
+	out.write(
+		reinterpret_cast<char const*>(m_fixtures.data()),
+		std::streamsize(m_fixtures.size() * sizeof(BinaryFixture)));
+	out.write(
+		reinterpret_cast<char const*>(m_coords.data()),
+		std::streamsize(m_coords.size() * sizeof(float)));
+	return bool(out);
+}
+
+
+bool
+convertJsonScene(std::istream& json, std::ostream& out)
+{
+	BinarySceneWriter writer;
+	bool const valid = parseJsonScene(
+		json,
+		[&writer](scripting::Prefab const& body) { writer.add(body); });
+	if (!valid)
+	{
+		return false;
+	}
+	if (!writer.write(out))
+	{
+		throw std::runtime_error{"Unable to write binary scene"};
+	}
+	return true;
+}
+
+
+bool
+loadBinaryScene(void const* pData, std::size_t size, b2World& world)
+{
+	DUKDEMO_TRACE_SCOPE("scene", "loadBinaryScene");
+	SceneArrays scene;
+	if (!getArrays(pData, size, &scene) || !validateScene(scene))
+	{
+		return false;
+	}
+	createBodies(scene, world);
+	return true;
+}
+
+
+bool
+loadBinarySceneFile(char const* pPath, b2World& world)
+{
+	util::MappedFile const file{pPath};
+	return loadBinaryScene(file.data(), file.size(), world);
+}
+
+
+} // namespace scene
+} // namespace dukdemo
@@ -0,0 +1,454 @@
+#include <istream>
+#include <new>
+#include <stdexcept>
+
+#include <locale.h>
+#include <stdlib.h>
+
+#include "dukdemo/scene/JsonReader.h"
+
+
+namespace dukdemo {
+namespace scene {
+
+
+bool
+isWhitespace(int c) noexcept
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+bool
+isDigit(int c) noexcept
+{
+	return '0' <= c && c <= '9';
+}
+
+
+/** Append a code point as UTF-8. */
+void
+appendUtf8(std::string& out, unsigned codePoint)
+{
+	if (codePoint < 0x80u)
+	{
+		out += char(codePoint);
+	}
+	else if (codePoint < 0x800u)
+	{
+		out += char(0xc0u | (codePoint >> 6u));
+		out += char(0x80u | (codePoint & 0x3fu));
+	}
+	else if (codePoint < 0x10000u)
+	{
+		out += char(0xe0u | (codePoint >> 12u));
+		out += char(0x80u | ((codePoint >> 6u) & 0x3fu));
+		out += char(0x80u | (codePoint & 0x3fu));
+	}
+	else
+	{
+		out += char(0xf0u | (codePoint >> 18u));
+		out += char(0x80u | ((codePoint >> 12u) & 0x3fu));
+		out += char(0x80u | ((codePoint >> 6u) & 0x3fu));
+		out += char(0x80u | (codePoint & 0x3fu));
+	}
+}
+
+
+JsonReader::JsonReader(std::istream& in)
+	:	m_pBuffer{in.rdbuf()}
+	,	m_offset{0u}
+	,	m_hasItem{}
+	,	m_scratch{}
+{
+}
+
+
+void
+JsonReader::fail(char const* pMessage) const
+{
+	throw std::runtime_error{
+		"Invalid JSON at byte " + std::to_string(m_offset) + ": " + pMessage};
+}
+
+
+int
+JsonReader::get()
+{
+	auto const c = m_pBuffer->sbumpc();
+	if (c != std::char_traits<char>::eof())
+	{
+		++m_offset;
+	}
+	return c;
+}
+
+
+int
+JsonReader::peekToken()
+{
+	auto c = m_pBuffer->sgetc();
+	while (isWhitespace(c))
+	{
+		m_pBuffer->sbumpc();
+		++m_offset;
+		c = m_pBuffer->sgetc();
+	}
+	return c;
+}
+
+
+void
+JsonReader::expect(char c)
+{
+	if (peekToken() != c)
+	{
+		fail((std::string{"expected '"} + c + "'").c_str());
+	}
+	get();
+}
+
+
+JsonReader::Type
+JsonReader::peek()
+{
+	switch (peekToken())
+	{
+		case '{':
+			return Type::Object;
+		case '[':
+			return Type::Array;
+		case '"':
+			return Type::String;
+		case 't':
+		case 'f':
+			return Type::Boolean;
+		case 'n':
+			return Type::Null;
+		case '-':
+			return Type::Number;
+		case std::char_traits<char>::eof():
+			fail("unexpected end of input");
+		default:
+			if (isDigit(m_pBuffer->sgetc()))
+			{
+				return Type::Number;
+			}
+			fail("expected a value");
+	}
+}
+
+
+void
+JsonReader::beginObject()
+{
+	if (m_hasItem.size() >= s_maxDepth)
+	{
+		fail("nested too deeply");
+	}
+	expect('{');
+	m_hasItem.push_back(false);
+}
+
+
+bool
+JsonReader::nextItem(char end)
+{
+	auto const c = peekToken();
+	if (c == end && !m_hasItem.empty())
+	{
+		get();
+		m_hasItem.pop_back();
+		return false;
+	}
+	if (m_hasItem.back())
+	{
+		expect(',');
+	}
+	m_hasItem.back() = true;
+	return true;
+}
+
+
+bool
+JsonReader::nextKey(std::string& key)
+{
+	if (!nextItem('}'))
+	{
+		return false;
+	}
+	if (peekToken() != '"')
+	{
+		fail("expected a key");
+	}
+	readString(key);
+	expect(':');
+	return true;
+}
+
+
+void
+JsonReader::beginArray()
+{
+	if (m_hasItem.size() >= s_maxDepth)
+	{
+		fail("nested too deeply");
+	}
+	expect('[');
+	m_hasItem.push_back(false);
+}
+
+
+bool
+JsonReader::nextElement()
+{
+	return nextItem(']');
+}
+
+
+unsigned
+JsonReader::readHex()
+{
+	unsigned value = 0u;
+	for (int i = 0; i < 4; ++i)
+	{
+		auto const c = get();
+		value <<= 4u;
+		if (isDigit(c))
+		{
+			value |= unsigned(c - '0');
+		}
+		else if ('a' <= c && c <= 'f')
+		{
+			value |= unsigned(c - 'a' + 10);
+		}
+		else if ('A' <= c && c <= 'F')
+		{
+			value |= unsigned(c - 'A' + 10);
+		}
+		else
+		{
+			fail("invalid \\u escape");
+		}
+	}
+	return value;
+}
+
+
+void
+JsonReader::readString(std::string& value)
+{
+	expect('"');
+	value.clear();
+	while (true)
+	{
+		auto const c = get();
+		if (c == '"')
+		{
+			return;
+		}
+		if (c == std::char_traits<char>::eof())
+		{
+			fail("unterminated string");
+		}
+		if (c < 0x20)
+		{
+			fail("control character in string");
+		}
+		if (c != '\\')
+		{
+			value += char(c);
+			continue;
+		}
+
+		switch (get())
+		{
+			case '"': value += '"'; break;
+			case '\\': value += '\\'; break;
+			case '/': value += '/'; break;
+			case 'b': value += '\b'; break;
+			case 'f': value += '\f'; break;
+			case 'n': value += '\n'; break;
+			case 'r': value += '\r'; break;
+			case 't': value += '\t'; break;
+			case 'u':
+			{
+				auto codePoint = readHex();
+				// Combine surrogate pairs; lone surrogates are kept as is.
+				bool const isHigh = 0xd800u <= codePoint && codePoint < 0xdc00u;
+				if (isHigh && m_pBuffer->sgetc() == '\\')
+				{
+					get();
+					if (get() != 'u')
+					{
+						fail("invalid escape");
+					}
+					auto const low = readHex();
+					if (0xdc00u <= low && low < 0xe000u)
+					{
+						codePoint =
+							0x10000u + ((codePoint - 0xd800u) << 10u)
+							+ (low - 0xdc00u);
+					}
+					else
+					{
+						appendUtf8(value, codePoint);
+						codePoint = low;
+					}
+				}
+				appendUtf8(value, codePoint);
+				break;
+			}
+			default:
+				fail("invalid escape");
+		}
+	}
+}
+
+
+/**
+ * The "C" locale, so that numbers are read the same whatever the global
+ * locale's decimal separator.
+ */
+locale_t
+getCLocale()
+{
+	static locale_t const locale = newlocale(LC_ALL_MASK, "C", nullptr);
+	if (!locale)
+	{
+		throw std::bad_alloc{};
+	}
+	return locale;
+}
+
+
+double
+JsonReader::readNumber()
+{
+	peekToken();
+	m_scratch.clear();
+	auto const take = [this]() { m_scratch += char(get()); };
+	auto const takeDigits = [this, &take]() {
+		if (!isDigit(m_pBuffer->sgetc()))
+		{
+			fail("expected a digit");
+		}
+		while (isDigit(m_pBuffer->sgetc()))
+		{
+			take();
+		}
+	};
+
+	if (m_pBuffer->sgetc() == '-')
+	{
+		take();
+	}
+	if (m_pBuffer->sgetc() == '0')
+	{
+		take();
+	}
+	else
+	{
+		takeDigits();
+	}
+	if (m_pBuffer->sgetc() == '.')
+	{
+		take();
+		takeDigits();
+	}
+	if (m_pBuffer->sgetc() == 'e' || m_pBuffer->sgetc() == 'E')
+	{
+		take();
+		if (m_pBuffer->sgetc() == '+' || m_pBuffer->sgetc() == '-')
+		{
+			take();
+		}
+		takeDigits();
+	}
+	// Out of range numbers become infinities or zeros, as in `JSON.parse`.
+	return strtod_l(m_scratch.c_str(), nullptr, getCLocale());
+}
+
+
+bool
+JsonReader::readBoolean()
+{
+	auto const c = peekToken();
+	char const* const pRest = c == 't' ? "true" : "false";
+	for (auto const* pChar = pRest; *pChar != '\0'; ++pChar)
+	{
+		if (get() != *pChar)
+		{
+			fail("expected a boolean");
+		}
+	}
+	return c == 't';
+}
+
+
+void
+JsonReader::readNull()
+{
+	peekToken();
+	for (auto const* pChar = "null"; *pChar != '\0'; ++pChar)
+	{
+		if (get() != *pChar)
+		{
+			fail("expected null");
+		}
+	}
+}
+
+
+void
+JsonReader::skipValue()
+{
+	switch (peek())
+	{
+		case Type::Object:
+			beginObject();
+			while (nextKey(m_scratch))
+			{
+				skipValue();
+			}
+			break;
+
+		case Type::Array:
+			beginArray();
+			while (nextElement())
+			{
+				skipValue();
+			}
+			break;
+
+		case Type::String:
+			readString(m_scratch);
+			break;
+
+		case Type::Number:
+			readNumber();
+			break;
+
+		case Type::Boolean:
+			readBoolean();
+			break;
+
+		case Type::Null:
+			readNull();
+			break;
+	}
+}
+
+
+void
+JsonReader::finish()
+{
+	if (peekToken() != std::char_traits<char>::eof())
+	{
+		fail("unexpected data after the document");
+	}
+}
+
+
+} // namespace scene
+} // namespace dukdemo
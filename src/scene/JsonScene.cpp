@@ -0,0 +1,672 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/scene/JsonReader.h"
+#include "dukdemo/scene/JsonScene.h"
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/Prefab.h"
+#include "dukdemo/scripting/Schema.h"
+#include "dukdemo/scripting/loaders.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scene {
+
+
+using scripting::FieldType;
+using scripting::Prefab;
+using scripting::PrefabFixture;
+using scripting::SchemaField;
+using Type = JsonReader::Type;
+
+
+/** Convert a number to an integer as `duk_get_int` does. */
+int
+toInt(double value) noexcept
+{
+	constexpr double min = std::numeric_limits<int>::min();
+	constexpr double max = std::numeric_limits<int>::max();
+	return std::isnan(value) ? 0 : int(std::trunc(std::fmin(
+		std::fmax(value, min), max)));
+}
+
+
+/** Convert a number to an unsigned integer as `duk_get_uint` does. */
+unsigned
+toUint(double value) noexcept
+{
+	constexpr double max = std::numeric_limits<unsigned>::max();
+	return std::isnan(value) ? 0u : unsigned(std::trunc(std::fmin(
+		std::fmax(value, 0.0), max)));
+}
+
+
+/** Decode an enumerated value as @ref scripting::getEnum does. */
+unsigned
+readEnum(
+	JsonReader& reader,
+	scripting::EnumNames const& names,
+	std::string& scratch
+)
+{
+	switch (reader.peek())
+	{
+		case Type::Number:
+		{
+			auto const value = toUint(reader.readNumber());
+			return value < names.count ? value : names.count;
+		}
+
+		case Type::String:
+		{
+			reader.readString(scratch);
+			auto const value = names.pFind(scratch.data(), scratch.size());
+			return value < names.count ? unsigned(value) : names.count;
+		}
+
+		default:
+			reader.skipValue();
+			return names.count;
+	}
+}
+
+
+/** Read a coordinate array as @ref scripting::loadVec2 does. */
+bool
+readVec2(JsonReader& reader, b2Vec2* pVec)
+{
+	if (reader.peek() != Type::Array)
+	{
+		reader.skipValue();
+		return false;
+	}
+
+	double coords[2] = {0.0, 0.0};
+	std::size_t count = 0u;
+	bool valid = true;
+	reader.beginArray();
+	while (reader.nextElement())
+	{
+		if (count < 2u && reader.peek() == Type::Number)
+		{
+			coords[count] = reader.readNumber();
+		}
+		else
+		{
+			valid &= count >= 2u;
+			reader.skipValue();
+		}
+		++count;
+	}
+
+	if (!valid || count < 2u)
+	{
+		return false;
+	}
+	pVec->Set(float(coords[0]), float(coords[1]));
+	return true;
+}
+
+
+/** Read an array of coordinate arrays; false if any is invalid. */
+bool
+readVertices(JsonReader& reader, std::vector<b2Vec2>& vertices)
+{
+	vertices.clear();
+	if (reader.peek() != Type::Array)
+	{
+		reader.skipValue();
+		return false;
+	}
+
+	bool valid = true;
+	reader.beginArray();
+	while (reader.nextElement())
+	{
+		b2Vec2 vertex;
+		valid &= readVec2(reader, &vertex);
+		vertices.push_back(vertex);
+	}
+	return valid;
+}
+
+
+/** Copy a value into a field, which may be unaligned. */
+template <typename Value>
+void
+storeField(void* pObject, std::size_t offset, Value const& value) noexcept
+{
+	std::memcpy(static_cast<char*>(pObject) + offset, &value, sizeof(Value));
+}
+
+
+/**
+ * Read a value into a field as @ref scripting::loadField does.
+ *
+ * @returns false iff the value is invalid, leaving the field unchanged.
+ */
+bool
+readField(
+	JsonReader& reader,
+	SchemaField const& field,
+	void* pObject,
+	std::string& scratch
+)
+{
+	switch (field.type)
+	{
+		case FieldType::Float:
+		case FieldType::Int16:
+		case FieldType::Uint16:
+		{
+			if (reader.peek() != Type::Number)
+			{
+				reader.skipValue();
+				return false;
+			}
+			auto const value = reader.readNumber();
+			if (field.type == FieldType::Float)
+			{
+				storeField(pObject, field.offset, float(value));
+			}
+			else if (field.type == FieldType::Int16)
+			{
+				storeField(pObject, field.offset, int16(toInt(value)));
+			}
+			else
+			{
+				auto const bits = toUint(value);
+				if (bits >= std::numeric_limits<uint16>::max())
+				{
+					return false;
+				}
+				storeField(pObject, field.offset, uint16(bits));
+			}
+			return true;
+		}
+
+		case FieldType::Bool:
+		{
+			if (reader.peek() != Type::Boolean)
+			{
+				reader.skipValue();
+				return false;
+			}
+			storeField(pObject, field.offset, reader.readBoolean());
+			return true;
+		}
+
+		case FieldType::Vec2:
+		{
+			b2Vec2 value;
+			if (!readVec2(reader, &value))
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, value);
+			return true;
+		}
+
+		case FieldType::Enum:
+		{
+			auto const value = readEnum(reader, *field.pEnum, scratch);
+			if (value == field.pEnum->count)
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, int(value));
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/** A property which is only checked if the shape's type reads it. */
+template <typename Value>
+struct ShapeProperty
+{
+	bool present = false;
+	bool valid = false;
+	Value value{};
+
+	inline bool
+	isValid() const noexcept
+	{ return present && valid; }
+
+	/** Optional properties only need to be valid if present. */
+	inline bool
+	isValidIfPresent() const noexcept
+	{ return !present || valid; }
+};
+
+
+/**
+ * A shape's properties. Its type may come after the rest, so they're all
+ * read before any are checked.
+ */
+struct ShapeFields
+{
+	unsigned type = b2Shape::e_typeCount;
+	ShapeProperty<float> radius{};
+	ShapeProperty<b2Vec2> position{};
+	ShapeProperty<b2Vec2> v1{};
+	ShapeProperty<b2Vec2> v2{};
+	ShapeProperty<b2Vec2> prev{};
+	ShapeProperty<b2Vec2> next{};
+	ShapeProperty<std::vector<b2Vec2>> vertices{};
+	bool loop = false;
+};
+
+
+/** Build a shape as @ref scripting::loadShape does. */
+std::unique_ptr<b2Shape>
+buildShape(ShapeFields const& fields)
+{
+	auto const& vertices = fields.vertices.value;
+	auto const count = int(vertices.size());
+	switch (fields.type)
+	{
+		case b2Shape::e_circle:
+		{
+			if (!fields.radius.isValid() || !fields.position.isValid())
+			{
+				return nullptr;
+			}
+			auto pShape = std::make_unique<b2CircleShape>();
+			pShape->m_radius = fields.radius.value;
+			pShape->m_p = fields.position.value;
+			return std::move(pShape);
+		}
+
+		case b2Shape::e_edge:
+		{
+			if (
+				!fields.v1.isValid() || !fields.v2.isValid() ||
+				!fields.prev.isValidIfPresent() ||
+				!fields.next.isValidIfPresent()
+			)
+			{
+				return nullptr;
+			}
+			auto pShape = std::make_unique<b2EdgeShape>();
+			pShape->m_vertex1 = fields.v1.value;
+			pShape->m_vertex2 = fields.v2.value;
+			if (fields.prev.present)
+			{
+				pShape->m_vertex0 = fields.prev.value;
+			}
+			if (fields.next.present)
+			{
+				pShape->m_vertex3 = fields.next.value;
+			}
+			return std::move(pShape);
+		}
+
+		case b2Shape::e_polygon:
+		{
+			if (
+				!fields.vertices.isValid() ||
+				!scripting::validatePolygonVertices(
+					vertices.data(), vertices.size())
+			)
+			{
+				return nullptr;
+			}
+			auto pShape = std::make_unique<b2PolygonShape>();
+			pShape->Set(vertices.data(), count);
+			if (!pShape->Validate())
+			{
+				return nullptr;
+			}
+			return std::move(pShape);
+		}
+
+		case b2Shape::e_chain:
+		{
+			if (
+				!fields.vertices.isValid() ||
+				!scripting::validateChainVertices(
+					vertices.data(), vertices.size(), fields.loop)
+			)
+			{
+				return nullptr;
+			}
+			auto pShape = std::make_unique<b2ChainShape>();
+			if (fields.loop)
+			{
+				pShape->CreateLoop(vertices.data(), count);
+				return std::move(pShape);
+			}
+			if (
+				!fields.prev.isValidIfPresent() ||
+				!fields.next.isValidIfPresent()
+			)
+			{
+				return nullptr;
+			}
+			pShape->CreateChain(vertices.data(), count);
+			if (fields.prev.present)
+			{
+				pShape->SetPrevVertex(fields.prev.value);
+			}
+			if (fields.next.present)
+			{
+				pShape->SetNextVertex(fields.next.value);
+			}
+			return std::move(pShape);
+		}
+
+		default:
+			return nullptr;
+	}
+}
+
+
+/** Parses a scene's bodies, reusing its buffers from one body to the next. */
+class SceneParser
+{
+public:
+	explicit SceneParser(std::istream& in)
+		:	m_reader{in}
+		,	m_key{}
+		,	m_scratch{}
+		,	m_shape{}
+	{}
+
+	bool
+	parse(BodyCallback const& onBody);
+
+private:
+	bool
+	parseBody(Prefab& body);
+
+	bool
+	parseFixture(PrefabFixture& fixture);
+
+	std::unique_ptr<b2Shape>
+	parseShape();
+
+	void
+	readVec2Property(ShapeProperty<b2Vec2>& property);
+
+	JsonReader m_reader;
+	std::string m_key;
+	std::string m_scratch;
+	ShapeFields m_shape;
+};
+
+
+bool
+SceneParser::parse(BodyCallback const& onBody)
+{
+	if (m_reader.peek() != Type::Object)
+	{
+		return false;
+	}
+
+	Prefab body;
+	m_reader.beginObject();
+	while (m_reader.nextKey(m_key))
+	{
+		if (m_key != "bodies")
+		{
+			m_reader.skipValue();
+			continue;
+		}
+
+		if (m_reader.peek() != Type::Array)
+		{
+			return false;
+		}
+		m_reader.beginArray();
+		while (m_reader.nextElement())
+		{
+			if (!parseBody(body))
+			{
+				return false;
+			}
+			onBody(body);
+			body.bodyDef = b2BodyDef{};
+			body.fixtures.clear();
+		}
+	}
+	m_reader.finish();
+	return true;
+}
+
+
+bool
+SceneParser::parseBody(Prefab& body)
+{
+	if (m_reader.peek() != Type::Object)
+	{
+		return false;
+	}
+
+	m_reader.beginObject();
+	while (m_reader.nextKey(m_key))
+	{
+		if (m_key == "fixtures")
+		{
+			if (m_reader.peek() != Type::Array)
+			{
+				return false;
+			}
+			body.fixtures.clear();
+			m_reader.beginArray();
+			while (m_reader.nextElement())
+			{
+				body.fixtures.emplace_back();
+				if (!parseFixture(body.fixtures.back()))
+				{
+					return false;
+				}
+			}
+			continue;
+		}
+
+		auto const* const pField =
+			scripting::findBodyDefField(m_key.data(), m_key.size());
+		if (!pField)
+		{
+			m_reader.skipValue();
+		}
+		else if (!readField(m_reader, *pField, &body.bodyDef, m_scratch))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+SceneParser::parseFixture(PrefabFixture& fixture)
+{
+	if (m_reader.peek() != Type::Object)
+	{
+		return false;
+	}
+
+	m_reader.beginObject();
+	while (m_reader.nextKey(m_key))
+	{
+		if (m_key == "shape")
+		{
+			fixture.pShape = parseShape();
+			if (!fixture.pShape)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		auto const* const pField =
+			scripting::findFixtureDefField(m_key.data(), m_key.size());
+		if (!pField)
+		{
+			m_reader.skipValue();
+		}
+		else if (!readField(m_reader, *pField, &fixture.def, m_scratch))
+		{
+			return false;
+		}
+	}
+
+	fixture.def.shape = fixture.pShape.get();
+	return bool(fixture.pShape);
+}
+
+
+void
+SceneParser::readVec2Property(ShapeProperty<b2Vec2>& property)
+{
+	property.present = true;
+	property.valid = readVec2(m_reader, &property.value);
+}
+
+
+std::unique_ptr<b2Shape>
+SceneParser::parseShape()
+{
+	if (m_reader.peek() != Type::Object)
+	{
+		return nullptr;
+	}
+
+	// Keep the vertex buffer's storage for the next shape.
+	auto vertices = std::move(m_shape.vertices.value);
+	m_shape = ShapeFields{};
+	m_shape.vertices.value = std::move(vertices);
+	m_shape.vertices.value.clear();
+
+	m_reader.beginObject();
+	while (m_reader.nextKey(m_key))
+	{
+		if (m_key == "type")
+		{
+			m_shape.type = readEnum(
+				m_reader, scripting::getShapeTypeNames(), m_scratch);
+		}
+		else if (m_key == "radius")
+		{
+			m_shape.radius.present = true;
+			m_shape.radius.valid = m_reader.peek() == Type::Number;
+			if (m_shape.radius.valid)
+			{
+				m_shape.radius.value = float(m_reader.readNumber());
+			}
+			else
+			{
+				m_reader.skipValue();
+			}
+		}
+		else if (m_key == "position")
+		{
+			readVec2Property(m_shape.position);
+		}
+		else if (m_key == "v1")
+		{
+			readVec2Property(m_shape.v1);
+		}
+		else if (m_key == "v2")
+		{
+			readVec2Property(m_shape.v2);
+		}
+		else if (m_key == "prev")
+		{
+			readVec2Property(m_shape.prev);
+		}
+		else if (m_key == "next")
+		{
+			readVec2Property(m_shape.next);
+		}
+		else if (m_key == "vertices")
+		{
+			m_shape.vertices.present = true;
+			m_shape.vertices.valid =
+				readVertices(m_reader, m_shape.vertices.value);
+		}
+		else if (m_key == "loop")
+		{
+			// As in loadChain, anything but `true` is no loop.
+			if (m_reader.peek() == Type::Boolean)
+			{
+				m_shape.loop = m_reader.readBoolean();
+			}
+			else
+			{
+				m_shape.loop = false;
+				m_reader.skipValue();
+			}
+		}
+		else
+		{
+			m_reader.skipValue();
+		}
+	}
+	return buildShape(m_shape);
+}
+
+
+bool
+parseJsonScene(std::istream& in, BodyCallback const& onBody)
+{
+	DUKDEMO_TRACE_SCOPE("scene", "parseJsonScene");
+	SceneParser parser{in};
+	return parser.parse(onBody);
+}
+
+
+bool
+loadJsonScene(std::istream& in, b2World& world)
+{
+	std::vector<b2Body*> bodies;
+	auto const destroyBodies = [&world, &bodies]() {
+		for (auto* const pBody: bodies)
+		{
+			if (pBody)
+			{
+				world.DestroyBody(pBody);
+			}
+		}
+	};
+
+	try
+	{
+		bool const valid = parseJsonScene(
+			in,
+			[&world, &bodies](Prefab const& body) {
+				bodies.push_back(nullptr);
+				bodies.back() = scripting::createBodyFromPrefab(
+					world, body, body.bodyDef.position, body.bodyDef.angle);
+			});
+		if (valid)
+		{
+			return true;
+		}
+	}
+	catch (...)
+	{
+		destroyBodies();
+		throw;
+	}
+	destroyBodies();
+	return false;
+}
+
+
+} // namespace scene
+} // namespace dukdemo
@@ -0,0 +1,910 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/WorldState.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scene {
+
+
+static_assert(sizeof(WorldStateHeader) == 32u, "Unexpected header padding");
+static_assert(sizeof(BodyState) == 80u, "Unexpected body padding");
+static_assert(sizeof(ContactState) == 72u, "Unexpected contact padding");
+static_assert(
+	std::is_trivially_copyable<BodyState>::value &&
+	std::is_trivially_copyable<ContactState>::value,
+	"Records must be readable in place"
+);
+static_assert(
+	b2_maxManifoldPoints == 2,
+	"Contact states hold two manifold points"
+);
+
+
+/** The number of floats in a vertex. */
+constexpr std::size_t coordsPerVertex = 2u;
+
+
+BodySerials::BodySerials()
+	:	m_serials{}
+	,	m_nextSerial{1u}
+{
+}
+
+
+std::uint64_t
+BodySerials::issue(b2Body const& body)
+{
+	m_serials[&body] = m_nextSerial;
+	return m_nextSerial++;
+}
+
+
+std::uint64_t
+BodySerials::idOf(b2Body const& body)
+{
+	// Look up first, as emplacing allocates a node even if the key exists.
+	auto const found = m_serials.find(&body);
+	if (found != m_serials.end())
+	{
+		return found->second;
+	}
+	m_serials.emplace(&body, m_nextSerial);
+	return m_nextSerial++;
+}
+
+
+void
+BodySerials::assign(b2Body const& body, std::uint64_t id)
+{
+	m_serials[&body] = id;
+	m_nextSerial = std::max(m_nextSerial, id + 1u);
+}
+
+
+void
+BodySerials::forget(b2Body const& body)
+{
+	m_serials.erase(&body);
+}
+
+
+/** The arrays of a state whose header has been checked. */
+struct StateArrays
+{
+	WorldStateHeader const* pHeader;
+	BodyState const* pBodies;
+	std::size_t bodyCount;
+	ContactState const* pContacts;
+	std::size_t contactCount;
+	BinaryFixture const* pFixtures;
+	std::size_t fixtureCount;
+	float const* pCoords;
+	std::size_t vertexCount;
+};
+
+
+std::uint64_t
+stateSize(
+	std::uint64_t bodyCount,
+	std::uint64_t contactCount,
+	std::uint64_t fixtureCount,
+	std::uint64_t vertexCount
+) noexcept
+{
+	return sizeof(WorldStateHeader) +
+		bodyCount * sizeof(BodyState) +
+		contactCount * sizeof(ContactState) +
+		fixtureCount * sizeof(BinaryFixture) +
+		vertexCount * coordsPerVertex * sizeof(float);
+}
+
+
+bool
+getArrays(void const* pData, std::size_t size, StateArrays* pArrays) noexcept
+{
+	if (
+		size < sizeof(WorldStateHeader) ||
+		reinterpret_cast<std::uintptr_t>(pData) % alignof(BodyState) != 0u
+	)
+	{
+		return false;
+	}
+
+	auto const* const pBytes = static_cast<unsigned char const*>(pData);
+	auto const& header = *reinterpret_cast<WorldStateHeader const*>(pBytes);
+	bool const hasMagic = std::memcmp(
+		header.magic, g_worldStateMagic, sizeof(g_worldStateMagic)) == 0;
+	if (
+		!hasMagic ||
+		header.version != g_worldStateVersion ||
+		std::uint64_t(size) != stateSize(
+			header.bodyCount, header.contactCount, header.fixtureCount,
+			header.vertexCount)
+	)
+	{
+		return false;
+	}
+
+	auto const* pNext = pBytes + sizeof(WorldStateHeader);
+	pArrays->pHeader = &header;
+	pArrays->pBodies = reinterpret_cast<BodyState const*>(pNext);
+	pArrays->bodyCount = header.bodyCount;
+	pNext += pArrays->bodyCount * sizeof(BodyState);
+	pArrays->pContacts = reinterpret_cast<ContactState const*>(pNext);
+	pArrays->contactCount = header.contactCount;
+	pNext += pArrays->contactCount * sizeof(ContactState);
+	pArrays->pFixtures = reinterpret_cast<BinaryFixture const*>(pNext);
+	pArrays->fixtureCount = header.fixtureCount;
+	pNext += pArrays->fixtureCount * sizeof(BinaryFixture);
+	pArrays->pCoords = reinterpret_cast<float const*>(pNext);
+	pArrays->vertexCount = header.vertexCount;
+	return true;
+}
+
+
+bool
+allFinite(float const* pValues, std::size_t count) noexcept
+{
+	for (std::size_t i = 0u; i < count; ++i)
+	{
+		if (!std::isfinite(pValues[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+isBool(std::uint8_t value) noexcept
+{
+	return value <= 1u;
+}
+
+
+/** Check a body as `b2Body::SetMassData` and the JSON loaders would. */
+bool
+validateBody(BodyState const& body) noexcept
+{
+	float const floats[] = {
+		body.position[0], body.position[1], body.angle,
+		body.linearVelocity[0], body.linearVelocity[1], body.angularVelocity,
+		body.linearDamping, body.angularDamping, body.gravityScale,
+		body.mass, body.center[0], body.center[1], body.inertia,
+	};
+	if (
+		body.type > b2_dynamicBody ||
+		!allFinite(&floats[0], sizeof(floats) / sizeof(floats[0])) ||
+		!isBool(body.awake) ||
+		!isBool(body.sleepingAllowed) ||
+		!isBool(body.bullet) ||
+		!isBool(body.fixedRotation) ||
+		!isBool(body.active) ||
+		body.mass < 0.0f ||
+		body.inertia < 0.0f
+	)
+	{
+		return false;
+	}
+
+	// The rotational inertia about the centre of mass must be positive.
+	auto const centerInertia = body.inertia - body.mass *
+		(body.center[0] * body.center[0] + body.center[1] * body.center[1]);
+	return
+		body.type != b2_dynamicBody ||
+		body.fixedRotation != 0u ||
+		body.inertia == 0.0f ||
+		centerInertia > 0.0f;
+}
+
+
+/** Order contacts by their bodies, then fixtures, then children. */
+auto
+contactKey(ContactState const& contact) noexcept
+{
+	return std::make_tuple(
+		contact.bodyA, contact.bodyB, contact.fixtureA, contact.fixtureB,
+		contact.childA, contact.childB);
+}
+
+
+bool
+validateContact(ContactState const& contact) noexcept
+{
+	float const floats[] = {
+		contact.friction, contact.restitution, contact.tangentSpeed,
+		contact.normalImpulses[0], contact.normalImpulses[1],
+		contact.tangentImpulses[0], contact.tangentImpulses[1],
+	};
+	return
+		allFinite(&floats[0], sizeof(floats) / sizeof(floats[0])) &&
+		contact.pointCount <= b2_maxManifoldPoints;
+}
+
+
+bool
+validateState(StateArrays const& state) noexcept
+{
+	if (!allFinite(&state.pHeader->gravity[0], 2u))
+	{
+		return false;
+	}
+
+	std::size_t fixtureIdx = 0u;
+	std::size_t vertexIdx = 0u;
+	for (std::size_t i = 0u; i < state.bodyCount; ++i)
+	{
+		auto const& body = state.pBodies[i];
+		if (
+			!validateBody(body) ||
+			body.fixtureCount > state.fixtureCount - fixtureIdx
+		)
+		{
+			return false;
+		}
+
+		auto const fixtureEnd = fixtureIdx + body.fixtureCount;
+		for (; fixtureIdx < fixtureEnd; ++fixtureIdx)
+		{
+			auto const& fixture = state.pFixtures[fixtureIdx];
+			if (
+				fixture.vertexCount > state.vertexCount - vertexIdx ||
+				!validateBinaryFixture(
+					fixture, state.pCoords + coordsPerVertex * vertexIdx)
+			)
+			{
+				return false;
+			}
+			vertexIdx += fixture.vertexCount;
+		}
+	}
+	if (fixtureIdx != state.fixtureCount || vertexIdx != state.vertexCount)
+	{
+		return false;
+	}
+
+	// Contacts must be strictly ordered to be found by a binary search.
+	for (std::size_t i = 0u; i < state.contactCount; ++i)
+	{
+		auto const& contact = state.pContacts[i];
+		if (
+			!validateContact(contact) ||
+			(i > 0u && !(contactKey(state.pContacts[i - 1u]) <
+				contactKey(contact)))
+		)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/** Find a fixture's position in its body's fixture list. */
+std::uint32_t
+indexOf(b2Fixture const& fixture) noexcept
+{
+	std::uint32_t index = 0u;
+	for (auto const* pFixture = fixture.GetBody()->GetFixtureList();
+		pFixture != &fixture; pFixture = pFixture->GetNext())
+	{
+		++index;
+	}
+	return index;
+}
+
+
+BodyState
+storeBody(
+	b2Body const& body,
+	std::uint64_t id,
+	std::uint32_t fixtureCount
+)
+	noexcept
+{
+	b2MassData massData;
+	body.GetMassData(&massData);
+
+	BodyState record{};
+	record.id = id;
+	record.type = std::uint32_t(body.GetType());
+	record.position[0] = body.GetPosition().x;
+	record.position[1] = body.GetPosition().y;
+	record.angle = body.GetAngle();
+	record.linearVelocity[0] = body.GetLinearVelocity().x;
+	record.linearVelocity[1] = body.GetLinearVelocity().y;
+	record.angularVelocity = body.GetAngularVelocity();
+	record.linearDamping = body.GetLinearDamping();
+	record.angularDamping = body.GetAngularDamping();
+	record.gravityScale = body.GetGravityScale();
+	record.mass = massData.mass;
+	record.center[0] = massData.center.x;
+	record.center[1] = massData.center.y;
+	record.inertia = massData.I;
+	record.awake = body.IsAwake();
+	record.sleepingAllowed = body.IsSleepingAllowed();
+	record.bullet = body.IsBullet();
+	record.fixedRotation = body.IsFixedRotation();
+	record.active = body.IsActive();
+	record.fixtureCount = fixtureCount;
+	return record;
+}
+
+
+ContactState
+storeContact(b2Contact const& contact, BodyIds& ids)
+{
+	auto const& fixtureA = *contact.GetFixtureA();
+	auto const& fixtureB = *contact.GetFixtureB();
+	ContactState record{};
+	record.bodyA = ids.idOf(*fixtureA.GetBody());
+	record.bodyB = ids.idOf(*fixtureB.GetBody());
+	record.fixtureA = indexOf(fixtureA);
+	record.fixtureB = indexOf(fixtureB);
+	record.childA = contact.GetChildIndexA();
+	record.childB = contact.GetChildIndexB();
+	record.friction = contact.GetFriction();
+	record.restitution = contact.GetRestitution();
+	record.tangentSpeed = contact.GetTangentSpeed();
+
+	auto const& manifold = *contact.GetManifold();
+	record.pointCount = std::uint8_t(manifold.pointCount);
+	for (int32 i = 0; i < manifold.pointCount; ++i)
+	{
+		auto const& point = manifold.points[i];
+		record.pointIds[i] = point.id.key;
+		record.normalImpulses[i] = point.normalImpulse;
+		record.tangentImpulses[i] = point.tangentImpulse;
+	}
+	return record;
+}
+
+
+b2FixtureDef
+fixtureDefOf(b2Fixture const& fixture) noexcept
+{
+	b2FixtureDef def;
+	def.shape = fixture.GetShape();
+	def.friction = fixture.GetFriction();
+	def.restitution = fixture.GetRestitution();
+	def.density = fixture.GetDensity();
+	def.isSensor = fixture.IsSensor();
+	def.filter = fixture.GetFilterData();
+	return def;
+}
+
+
+/** The number of each record in a world's state. */
+struct StateCounts
+{
+	std::uint64_t bodies;
+	std::uint64_t contacts;
+	std::uint64_t fixtures;
+	std::uint64_t vertices;
+};
+
+
+StateCounts
+countState(b2World const& world) noexcept
+{
+	StateCounts counts{
+		std::uint64_t(world.GetBodyCount()),
+		std::uint64_t(world.GetContactCount()),
+		0u,
+		0u};
+	for (auto const* pBody = world.GetBodyList(); pBody;
+		pBody = pBody->GetNext())
+	{
+		for (auto const* pFixture = pBody->GetFixtureList(); pFixture;
+			pFixture = pFixture->GetNext())
+		{
+			++counts.fixtures;
+			counts.vertices += binaryVertexCount(*pFixture->GetShape());
+		}
+	}
+	return counts;
+}
+
+
+std::size_t
+worldStateSize(b2World const& world) noexcept
+{
+	auto const counts = countState(world);
+	return std::size_t(stateSize(
+		counts.bodies, counts.contacts, counts.fixtures, counts.vertices));
+}
+
+
+/** Write a world's state into a buffer sized for its counts. */
+void
+writeState(
+	b2World const& world,
+	BodyIds& ids,
+	StateCounts const& counts,
+	unsigned char* pNext
+)
+{
+	WorldStateHeader header{};
+	std::memcpy(header.magic, g_worldStateMagic, sizeof(g_worldStateMagic));
+	header.version = g_worldStateVersion;
+	header.bodyCount = std::uint32_t(counts.bodies);
+	header.contactCount = std::uint32_t(counts.contacts);
+	header.fixtureCount = std::uint32_t(counts.fixtures);
+	header.vertexCount = std::uint32_t(counts.vertices);
+	header.gravity[0] = world.GetGravity().x;
+	header.gravity[1] = world.GetGravity().y;
+	std::memcpy(pNext, &header, sizeof(header));
+	pNext += sizeof(header);
+
+	auto* pBodyRecord = reinterpret_cast<BodyState*>(pNext);
+	pNext += counts.bodies * sizeof(BodyState);
+	auto* const pContacts = reinterpret_cast<ContactState*>(pNext);
+	pNext += counts.contacts * sizeof(ContactState);
+	auto* pFixtureRecord = reinterpret_cast<BinaryFixture*>(pNext);
+	pNext += counts.fixtures * sizeof(BinaryFixture);
+	auto* pCoords = reinterpret_cast<float*>(pNext);
+
+	for (auto const* pBody = world.GetBodyList(); pBody;
+		pBody = pBody->GetNext())
+	{
+		std::uint32_t bodyFixtures = 0u;
+		for (auto const* pFixture = pBody->GetFixtureList(); pFixture;
+			pFixture = pFixture->GetNext(), ++bodyFixtures)
+		{
+			*pFixtureRecord = storeBinaryFixture(
+				fixtureDefOf(*pFixture), pCoords);
+			pCoords += coordsPerVertex * pFixtureRecord->vertexCount;
+			++pFixtureRecord;
+		}
+		*pBodyRecord++ = storeBody(*pBody, ids.idOf(*pBody), bodyFixtures);
+	}
+
+	auto* pContact = pContacts;
+	for (auto const* pLive = world.GetContactList(); pLive;
+		pLive = pLive->GetNext())
+	{
+		*pContact++ = storeContact(*pLive, ids);
+	}
+	std::sort(
+		pContacts, pContacts + counts.contacts,
+		[](ContactState const& lhs, ContactState const& rhs) {
+			return contactKey(lhs) < contactKey(rhs);
+		});
+}
+
+
+void
+saveWorldState(
+	b2World const& world,
+	BodyIds& ids,
+	std::vector<unsigned char>& state
+)
+{
+	DUKDEMO_TRACE_SCOPE("scene", "saveWorldState");
+	auto const counts = countState(world);
+	state.resize(stateSize(
+		counts.bodies, counts.contacts, counts.fixtures, counts.vertices));
+	writeState(world, ids, counts, state.data());
+}
+
+
+void
+saveWorldState(
+	b2World const& world,
+	BodyIds& ids,
+	void* pData,
+	std::size_t size
+)
+{
+	DUKDEMO_TRACE_SCOPE("scene", "saveWorldState");
+	auto const counts = countState(world);
+	if (
+		std::uint64_t(size) != stateSize(
+			counts.bodies, counts.contacts, counts.fixtures, counts.vertices)
+	)
+	{
+		throw std::invalid_argument{"World state buffer has the wrong size"};
+	}
+	writeState(world, ids, counts, static_cast<unsigned char*>(pData));
+}
+
+
+/** A body's records, and where they are in the state. */
+struct BodyRecords
+{
+	BodyState const& body;
+	BinaryFixture const* pFixtures;
+	float const* pCoords;
+};
+
+
+/** Check whether a body's fixtures have exactly the recorded shapes. */
+bool
+sameShapes(b2Body const& body, BodyRecords const& records) noexcept
+{
+	auto const* pCoords = records.pCoords;
+	std::uint32_t count = 0u;
+	for (auto const* pFixture = body.GetFixtureList(); pFixture;
+		pFixture = pFixture->GetNext(), ++count)
+	{
+		if (count == records.body.fixtureCount)
+		{
+			return false;
+		}
+		auto const& fixture = records.pFixtures[count];
+		if (!matchesBinaryShape(*pFixture->GetShape(), fixture, pCoords))
+		{
+			return false;
+		}
+		pCoords += coordsPerVertex * fixture.vertexCount;
+	}
+	return count == records.body.fixtureCount;
+}
+
+
+/** Update the properties of fixtures whose shapes are unchanged. */
+void
+updateFixtures(b2Body* pBody, BodyRecords const& records)
+{
+	auto const* pRecord = records.pFixtures;
+	for (auto* pFixture = pBody->GetFixtureList(); pFixture;
+		pFixture = pFixture->GetNext(), ++pRecord)
+	{
+		auto const& record = *pRecord;
+		if (pFixture->GetFriction() != record.friction)
+		{
+			pFixture->SetFriction(record.friction);
+		}
+		if (pFixture->GetRestitution() != record.restitution)
+		{
+			pFixture->SetRestitution(record.restitution);
+		}
+		if (pFixture->GetDensity() != record.density)
+		{
+			pFixture->SetDensity(record.density);
+		}
+
+		bool const isSensor = (record.flags & BinaryFixture::IsSensor) != 0u;
+		if (pFixture->IsSensor() != isSensor)
+		{
+			pFixture->SetSensor(isSensor);
+		}
+
+		// Setting the filter flags the fixture's contacts for filtering.
+		auto const& filter = pFixture->GetFilterData();
+		if (
+			filter.categoryBits != record.categoryBits ||
+			filter.maskBits != record.maskBits ||
+			filter.groupIndex != record.groupIndex
+		)
+		{
+			b2Filter changed;
+			changed.categoryBits = record.categoryBits;
+			changed.maskBits = record.maskBits;
+			changed.groupIndex = record.groupIndex;
+			pFixture->SetFilterData(changed);
+		}
+	}
+}
+
+
+/** Replace a body's fixtures with the recorded ones. */
+void
+replaceFixtures(b2Body* pBody, BodyRecords const& records)
+{
+	while (auto* const pFixture = pBody->GetFixtureList())
+	{
+		pBody->DestroyFixture(pFixture);
+	}
+
+	// Box2D prepends new fixtures, so create them last to first to keep
+	// their recorded order.
+	auto const* pCoords = records.pCoords;
+	for (std::uint32_t i = 0u; i < records.body.fixtureCount; ++i)
+	{
+		pCoords += coordsPerVertex * records.pFixtures[i].vertexCount;
+	}
+	for (auto i = records.body.fixtureCount; i-- > 0u;)
+	{
+		auto const& fixture = records.pFixtures[i];
+		pCoords -= coordsPerVertex * fixture.vertexCount;
+		createBinaryFixture(pBody, fixture, pCoords);
+	}
+}
+
+
+/** Bring a live body to its recorded state. */
+void
+applyBody(b2Body* pBody, BodyRecords const& records)
+{
+	auto const& record = records.body;
+	auto const type = b2BodyType(record.type);
+	if (pBody->GetType() != type)
+	{
+		pBody->SetType(type);
+	}
+
+	if (sameShapes(*pBody, records))
+	{
+		updateFixtures(pBody, records);
+	}
+	else
+	{
+		replaceFixtures(pBody, records);
+	}
+
+	bool const fixedRotation = record.fixedRotation != 0u;
+	if (pBody->IsFixedRotation() != fixedRotation)
+	{
+		pBody->SetFixedRotation(fixedRotation);
+	}
+	bool const active = record.active != 0u;
+	if (pBody->IsActive() != active)
+	{
+		pBody->SetActive(active);
+	}
+
+	// Changing the type, fixtures or rotation resets the mass, so set it
+	// after them.
+	if (type == b2_dynamicBody)
+	{
+		b2MassData massData;
+		pBody->GetMassData(&massData);
+		if (
+			massData.mass != record.mass ||
+			massData.center.x != record.center[0] ||
+			massData.center.y != record.center[1] ||
+			massData.I != record.inertia
+		)
+		{
+			massData.mass = record.mass;
+			massData.center.Set(record.center[0], record.center[1]);
+			massData.I = record.inertia;
+			pBody->SetMassData(&massData);
+		}
+	}
+
+	pBody->SetTransform(
+		b2Vec2{record.position[0], record.position[1]}, record.angle);
+	pBody->SetLinearDamping(record.linearDamping);
+	pBody->SetAngularDamping(record.angularDamping);
+	pBody->SetGravityScale(record.gravityScale);
+	pBody->SetBullet(record.bullet != 0u);
+	pBody->SetSleepingAllowed(record.sleepingAllowed != 0u);
+	pBody->SetLinearVelocity(
+		b2Vec2{record.linearVelocity[0], record.linearVelocity[1]});
+	pBody->SetAngularVelocity(record.angularVelocity);
+
+	// Last, as putting a body to sleep clears its velocities, and setting
+	// them wakes it.
+	pBody->SetAwake(record.awake != 0u);
+}
+
+
+b2BodyDef
+bodyDefOf(BodyState const& record) noexcept
+{
+	b2BodyDef def;
+	def.type = b2BodyType(record.type);
+	def.position.Set(record.position[0], record.position[1]);
+	def.angle = record.angle;
+	def.active = record.active != 0u;
+	return def;
+}
+
+
+/**
+ * Match the recorded bodies to live ones, by id.
+ *
+ * @param state the state.
+ * @param world the world.
+ * @param pBodies set to the live body of each record, or `nullptr`.
+ * @param pUnmatched set to the live bodies matching no record.
+ * @returns false iff the state records a body twice.
+ */
+bool
+matchBodies(
+	StateArrays const& state,
+	b2World& world,
+	BodyIds& ids,
+	std::vector<b2Body*>* pBodies,
+	std::vector<b2Body*>* pUnmatched
+)
+{
+	std::vector<std::pair<std::uint64_t, std::size_t>> recorded;
+	recorded.reserve(state.bodyCount);
+	for (std::size_t i = 0u; i < state.bodyCount; ++i)
+	{
+		recorded.emplace_back(state.pBodies[i].id, i);
+	}
+	std::sort(recorded.begin(), recorded.end());
+	auto const sameId = [](auto const& lhs, auto const& rhs) {
+		return lhs.first == rhs.first;
+	};
+	if (
+		std::adjacent_find(recorded.begin(), recorded.end(), sameId) !=
+		recorded.end()
+	)
+	{
+		return false;
+	}
+
+	pBodies->assign(state.bodyCount, nullptr);
+	for (auto* pBody = world.GetBodyList(); pBody; pBody = pBody->GetNext())
+	{
+		auto const id = ids.idOf(*pBody);
+		auto const found = std::lower_bound(
+			recorded.begin(), recorded.end(),
+			std::make_pair(id, std::size_t(0u)));
+		if (found != recorded.end() && found->first == id)
+		{
+			(*pBodies)[found->second] = pBody;
+		}
+		else
+		{
+			pUnmatched->push_back(pBody);
+		}
+	}
+	return true;
+}
+
+
+/** Check whether the world's bodies are the recorded ones, in order. */
+bool
+sameBodies(StateArrays const& state, b2World const& world, BodyIds& ids)
+{
+	if (std::size_t(world.GetBodyCount()) != state.bodyCount)
+	{
+		return false;
+	}
+	auto const* pBody = world.GetBodyList();
+	for (std::size_t i = 0u; i < state.bodyCount; ++i)
+	{
+		if (ids.idOf(*pBody) != state.pBodies[i].id)
+		{
+			return false;
+		}
+		pBody = pBody->GetNext();
+	}
+	return true;
+}
+
+
+void
+restoreContacts(StateArrays const& state, b2World& world, BodyIds& ids)
+{
+	auto const* const pBegin = state.pContacts;
+	auto const* const pEnd = pBegin + state.contactCount;
+	for (auto* pContact = world.GetContactList(); pContact;
+		pContact = pContact->GetNext())
+	{
+		auto const& fixtureA = *pContact->GetFixtureA();
+		auto const& fixtureB = *pContact->GetFixtureB();
+		auto const key = std::make_tuple(
+			ids.idOf(*fixtureA.GetBody()), ids.idOf(*fixtureB.GetBody()),
+			indexOf(fixtureA), indexOf(fixtureB),
+			pContact->GetChildIndexA(), pContact->GetChildIndexB());
+		auto const* const pFound = std::lower_bound(
+			pBegin, pEnd, key,
+			[](ContactState const& contact, decltype(key) const& other) {
+				return contactKey(contact) < other;
+			});
+		if (pFound == pEnd || contactKey(*pFound) != key)
+		{
+			continue;
+		}
+
+		pContact->SetFriction(pFound->friction);
+		pContact->SetRestitution(pFound->restitution);
+		pContact->SetTangentSpeed(pFound->tangentSpeed);
+
+		// The next step matches its manifold points to these by their IDs
+		// to warm start.
+		auto& manifold = *pContact->GetManifold();
+		manifold.pointCount = pFound->pointCount;
+		for (int32 i = 0; i < manifold.pointCount; ++i)
+		{
+			auto& point = manifold.points[i];
+			point.id.key = pFound->pointIds[i];
+			point.normalImpulse = pFound->normalImpulses[i];
+			point.tangentImpulse = pFound->tangentImpulses[i];
+		}
+	}
+}
+
+
+bool
+restoreWorldState(
+	b2World& world,
+	void const* pData,
+	std::size_t size,
+	BodyIds& ids
+)
+{
+	DUKDEMO_TRACE_SCOPE("scene", "restoreWorldState");
+	StateArrays state;
+	if (
+		world.IsLocked() ||
+		!getArrays(pData, size, &state) ||
+		!validateState(state)
+	)
+	{
+		return false;
+	}
+
+	// Usually the world still holds exactly the recorded bodies, which can
+	// be walked in step with their records without allocating.
+	bool const same = sameBodies(state, world, ids);
+	std::vector<b2Body*> bodies;
+	if (!same)
+	{
+		std::vector<b2Body*> unmatched;
+		if (!matchBodies(state, world, ids, &bodies, &unmatched))
+		{
+			return false;
+		}
+		for (auto* const pBody: unmatched)
+		{
+			ids.forget(*pBody);
+			world.DestroyBody(pBody);
+		}
+	}
+
+	auto const& gravity = state.pHeader->gravity;
+	world.SetGravity(b2Vec2{gravity[0], gravity[1]});
+	auto* pLive = world.GetBodyList();
+	auto const* pFixtures = state.pFixtures;
+	auto const* pCoords = state.pCoords;
+	for (std::size_t i = 0u; i < state.bodyCount; ++i)
+	{
+		auto const& record = state.pBodies[i];
+		b2Body* pBody = nullptr;
+		if (same)
+		{
+			pBody = pLive;
+			pLive = pLive->GetNext();
+		}
+		else
+		{
+			pBody = bodies[i];
+			if (!pBody)
+			{
+				auto const def = bodyDefOf(record);
+				pBody = world.CreateBody(&def);
+				ids.assign(*pBody, record.id);
+			}
+		}
+
+		BodyRecords const records{record, pFixtures, pCoords};
+		applyBody(pBody, records);
+		for (std::uint32_t j = 0u; j < record.fixtureCount; ++j)
+		{
+			pCoords += coordsPerVertex * pFixtures[j].vertexCount;
+		}
+		pFixtures += record.fixtureCount;
+	}
+
+	restoreContacts(state, world, ids);
+	return true;
+}
+
+
+} // namespace scene
+} // namespace dukdemo
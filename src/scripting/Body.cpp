@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2Body.h>
 
@@ -5,6 +7,9 @@
 
 #include "dukdemo/scripting/util.h"
 #include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/World.h"
 
 
 namespace dukdemo {
@@ -31,14 +36,25 @@ init(duk_context* pContext)
 duk_idx_t
 pushBodyWithoutFinalizer(duk_context* pContext, b2Body* pBody)
 {
-	auto const bodyIdx = duk_push_object(pContext);
+	auto* const pTable = getBodyTable(pContext);
+	if (!pTable)
+	{
+		duk_error(pContext, DUK_ERR_ERROR, "Heap has no body table");
+	}
+
+	// The wrapper is a DataView over the body's handle, which methods read
+	// straight from the buffer rather than through a property.
+	auto const handle = pTable->insert(pBody);
+	auto* const pData = duk_push_fixed_buffer(pContext, sizeof(handle));
+	std::memcpy(pData, &handle, sizeof(handle));
+	duk_push_buffer_object(
+		pContext, -1, 0u, sizeof(handle), DUK_BUFOBJ_DATAVIEW);
+	duk_remove(pContext, -2);
+	auto const bodyIdx = duk_get_top_index(pContext);
+
 	// Set internal prototype to Body.prototype.
 	duk_get_global_string(pContext, g_bodyProtoSym);
 	duk_set_prototype(pContext, bodyIdx);
-
-	// Set the body pointer on the JS object.
-	duk_push_pointer(pContext, pBody);
-	duk_put_prop_string(pContext, bodyIdx, g_ownBodyPtrSym);
 	return bodyIdx;
 }
 
@@ -53,34 +69,64 @@ pushBodyWithFinalizer(duk_context* pContext, b2Body* pBody)
 }
 
 
+/** Read the @ref BodyTable handle held by a body object. */
+BodyTable::Handle
+getBodyHandleAt(duk_context* pContext, duk_idx_t bodyIdx)
+{
+	auto handle = BodyTable::s_invalidHandle;
+	duk_size_t size = 0u;
+	auto const* const pData = duk_get_buffer_data(pContext, bodyIdx, &size);
+	if (pData && size == sizeof(handle))
+	{
+		std::memcpy(&handle, pData, sizeof(handle));
+	}
+	return handle;
+}
+
+
+b2Body*
+getBodyPtrAt(duk_context* pContext, duk_idx_t bodyIdx)
+{
+	auto const* const pTable = getBodyTable(pContext);
+	return pTable ? pTable->get(getBodyHandleAt(pContext, bodyIdx)) : nullptr;
+}
+
+
 void
 destroyBodyAt(duk_context* pContext, duk_idx_t bodyIdx)
 {
-	duk_get_prop_string(pContext, bodyIdx, g_ownBodyPtrSym);
-	auto* const pBody = static_cast<b2Body*>(duk_get_pointer(pContext, 1));
-	duk_pop_2(pContext);
-
+	auto* const pTable = getBodyTable(pContext);
+	auto const handle = getBodyHandleAt(pContext, bodyIdx);
+	auto* const pBody = pTable ? pTable->get(handle) : nullptr;
 	if (!pBody)
 	{
 		// Nothing to do: body was already destroyed.
 		return;
 	}
 
+	// Forgotten while still reachable, in case looking up the world throws.
+	world::forgetBody(pContext, bodyIdx, *pBody);
+	pTable->remove(handle);
+
+	if (pBody->GetType() == b2_staticBody)
+	{
+		bumpStaticVersion(pContext);
+	}
 	auto* const pWorld = pBody->GetWorld();
 	if (pWorld)
 	{
 		pWorld->DestroyBody(pBody);
 	}
-
-	duk_push_pointer(pContext, nullptr);
-	duk_put_prop_string(pContext, -1, g_ownBodyPtrSym);
 }
 
 
 b2Body*
 getOwnBodyPtr(duk_context* pContext)
 {
-	return static_cast<b2Body*>(getPointerFromThis(pContext, g_ownBodyPtrSym));
+	duk_push_this(pContext);
+	auto* const pBody = getBodyPtrAt(pContext, -1);
+	duk_pop(pContext);
+	return pBody;
 }
 
 
@@ -100,6 +146,10 @@ methods::setLinearVelocity(duk_context* pContext)
 		float(duk_get_number(pContext, 1))
 	};
 	auto* const pBody = getOwnBodyPtr(pContext);
+	if (!pBody)
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
 	pBody->SetLinearVelocity(vec);
 	return 0;
 }
@@ -109,6 +159,10 @@ duk_ret_t
 methods::getLinearVelocity(duk_context* pContext)
 {
 	auto const* const pBody = getOwnBodyPtr(pContext);
+	if (!pBody)
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
 	writeVec2ToArray(pContext, 0, pBody->GetLinearVelocity());
 	return 1;
 }
@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <limits>
+
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/Heap.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+namespace {
+
+
+constexpr unsigned generationShift = 32u;
+
+// Keep handles within the 53 bits a double can represent exactly.
+constexpr std::uint32_t generationMask = (1u << 21u) - 1u;
+
+constexpr std::uint32_t noFreeSlot = std::numeric_limits<std::uint32_t>::max();
+
+
+inline BodyTable::Handle
+makeHandle(std::uint32_t index, std::uint32_t generation) noexcept
+{
+	return (BodyTable::Handle(generation) << generationShift) | index;
+}
+
+
+inline std::uint32_t
+getIndex(BodyTable::Handle handle) noexcept
+{
+	return std::uint32_t(handle);
+}
+
+
+inline std::uint32_t
+getGeneration(BodyTable::Handle handle) noexcept
+{
+	return std::uint32_t(handle >> generationShift);
+}
+
+
+} // namespace
+
+
+BodyTable::BodyTable()
+	:	m_slots{}
+	,	m_indices{}
+	,	m_freeHead{noFreeSlot}
+	,	m_size{0u}
+{
+}
+
+
+BodyTable::Handle
+BodyTable::insert(b2Body* pBody)
+{
+	auto const existing = find(pBody);
+	if (existing != s_invalidHandle)
+	{
+		return existing;
+	}
+
+	std::uint32_t index = 0u;
+	if (m_freeHead != noFreeSlot)
+	{
+		index = m_freeHead;
+		m_freeHead = m_slots[index].nextFree;
+		m_slots[index].pBody = pBody;
+	}
+	else
+	{
+		index = std::uint32_t(m_slots.size());
+		m_slots.push_back(Slot{pBody, 1u, noFreeSlot});
+	}
+
+	m_indices.emplace(pBody, index);
+	++m_size;
+	return makeHandle(index, m_slots[index].generation);
+}
+
+
+b2Body*
+BodyTable::get(Handle handle) const noexcept
+{
+	auto const index = getIndex(handle);
+	if (index >= m_slots.size())
+	{
+		return nullptr;
+	}
+
+	Slot const& slot = m_slots[index];
+	return slot.generation == getGeneration(handle) ? slot.pBody : nullptr;
+}
+
+
+BodyTable::Handle
+BodyTable::find(b2Body const* pBody) const noexcept
+{
+	auto const found = m_indices.find(pBody);
+	if (found == m_indices.end())
+	{
+		return s_invalidHandle;
+	}
+	auto const index = found->second;
+	return makeHandle(index, m_slots[index].generation);
+}
+
+
+b2Body*
+BodyTable::remove(Handle handle) noexcept
+{
+	auto* const pBody = get(handle);
+	if (pBody == nullptr)
+	{
+		return nullptr;
+	}
+
+	auto const index = getIndex(handle);
+	Slot& slot = m_slots[index];
+	slot.pBody = nullptr;
+	slot.generation =
+		slot.generation < generationMask ? slot.generation + 1u : 1u;
+	slot.nextFree = m_freeHead;
+	m_freeHead = index;
+	--m_size;
+
+	m_indices.erase(pBody);
+	return pBody;
+}
+
+
+BodyTable*
+getBodyTable(duk_context* pContext)
+{
+	auto const* const pState = getHeapState(pContext);
+	return pState ? pState->pBodyTable : nullptr;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
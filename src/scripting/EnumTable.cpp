@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/util.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+EnumNameCache::EnumNameCache()
+	:	m_tables{}
+{
+}
+
+
+duk_uint_t
+EnumNameCache::find(
+	duk_context* pContext,
+	EnumNames const& names,
+	char const* pString,
+	std::size_t length
+)
+{
+	auto pTable = std::find_if(
+		m_tables.begin(),
+		m_tables.end(),
+		[&names](Table const& table) {
+			return table.pNames == names.pNames;
+		});
+	if (pTable == m_tables.end())
+	{
+		// Record the table before pinning it, so that a failed pin leaves
+		// nothing half built.
+		m_tables.push_back(Table{
+			names.pNames,
+			std::vector<char const*>(names.count, nullptr),
+			false});
+		pTable = std::prev(m_tables.end());
+	}
+	auto& table = *pTable;
+	if (!table.pinned)
+	{
+		InternCall call{&names, &table};
+		duk_safe_call(pContext, intern, &call, 0, 1);
+		duk_pop(pContext);
+		if (!table.pinned)
+		{
+			// Names pinned so far are usable, but a missing one would be
+			// mistaken for an invalid name.
+			return duk_uint_t(std::min<std::size_t>(
+				names.pFind(pString, length), names.count));
+		}
+	}
+
+	for (duk_uint_t i = 0u; i < names.count; ++i)
+	{
+		if (table.interned[i] == pString)
+		{
+			return i;
+		}
+	}
+	return names.count;
+}
+
+
+void
+EnumNameCache::clear() noexcept
+{
+	m_tables.clear();
+}
+
+
+duk_ret_t
+EnumNameCache::intern(duk_context* pContext, void* udata)
+{
+	auto const& call = *static_cast<InternCall*>(udata);
+	auto const& names = *call.pNames;
+	auto& table = *call.pTable;
+
+	// The names are pinned as the keys of an object in the heap stash.
+	duk_push_heap_stash(pContext);
+	if (!duk_get_prop_string(pContext, -1, g_enumNamesSym))
+	{
+		duk_pop(pContext);
+		duk_push_object(pContext);
+		duk_dup_top(pContext);
+		duk_put_prop_string(pContext, -3, g_enumNamesSym);
+	}
+	for (duk_uint_t i = 0u; i < names.count; ++i)
+	{
+		duk_push_true(pContext);
+		duk_put_prop_string(pContext, -2, names.pNames[i]);
+		table.interned[i] = duk_push_string(pContext, names.pNames[i]);
+		duk_pop(pContext);
+	}
+	duk_pop_2(pContext); // Pop the names object and the stash.
+
+	table.pinned = true;
+	return 0;
+}
+
+
+duk_uint_t
+getEnum(duk_context* pContext, duk_idx_t idx, EnumNames const& names) noexcept
+{
+	if (duk_is_number(pContext, idx))
+	{
+		auto const value = duk_get_uint_default(pContext, idx, names.count);
+		return value < names.count ? value : names.count;
+	}
+
+	if (!duk_is_string(pContext, idx))
+	{
+		return names.count;
+	}
+
+	duk_size_t length = 0u;
+	auto const* const pName = duk_get_lstring(pContext, idx, &length);
+	auto* const pState = getHeapState(pContext);
+	if (pState && pState->pEnumNameCache)
+	{
+		try
+		{
+			return pState->pEnumNameCache->find(
+				pContext, names, pName, length);
+		}
+		catch (std::bad_alloc const&)
+		{
+			// Without memory to intern the names, fall back to hashing.
+		}
+	}
+	return duk_uint_t(std::min<std::size_t>(
+		names.pFind(pName, length), names.count));
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+constexpr auto noDeadline = ExecBudget::Clock::time_point::max();
+
+
+static ExecBudget::Clock::time_point
+deadlineAfter(ExecBudget::Clock::time_point start, ExecBudget::Duration budget)
+{
+	using ClockDuration = ExecBudget::Clock::duration;
+	return budget.count() > 0.0
+		? start + std::chrono::duration_cast<ClockDuration>(budget)
+		: noDeadline;
+}
+
+
+static void
+recordOverrun(ExecBudget::Stats& stats, char const* pSite, bool frame)
+{
+	auto& site = stats.sites[pSite];
+	if (frame)
+	{
+		++stats.frameOverruns;
+		++site.frameOverruns;
+	}
+	else
+	{
+		++stats.callOverruns;
+		++site.callOverruns;
+	}
+}
+
+
+ExecBudget::ExecBudget()
+	:	m_callBudget{0.0}
+	,	m_frameBudget{0.0}
+	,	m_frameDeadline{noDeadline}
+	,	m_deadline{noDeadline}
+	,	m_timedOut{false}
+	,	m_depth{0u}
+	,	m_stats{}
+{
+}
+
+
+void
+ExecBudget::beginFrame() noexcept
+{
+	m_frameDeadline = deadlineAfter(Clock::now(), m_frameBudget);
+}
+
+
+void
+ExecBudget::endFrame() noexcept
+{
+	m_frameDeadline = noDeadline;
+}
+
+
+duk_int_t
+ExecBudget::pcall(duk_context* pContext, duk_idx_t nargs, char const* pSite)
+{
+	DUKDEMO_TRACE_SCOPE("script", "pcall");
+	++m_stats.calls;
+	auto const start = Clock::now();
+	if (start >= m_frameDeadline)
+	{
+		duk_pop_n(pContext, nargs + 1);
+		duk_push_error_object(
+			pContext, DUK_ERR_RANGE_ERROR, "frame budget exhausted");
+		++m_stats.skippedCalls;
+		recordOverrun(m_stats, pSite, true);
+		return DUK_EXEC_ERROR;
+	}
+
+	// Save the enclosing call's state, in case of nested budgeted calls.
+	auto const outerDeadline = m_deadline;
+	auto const outerTimedOut = m_timedOut;
+
+	auto const callDeadline = deadlineAfter(start, m_callBudget);
+	m_deadline = std::min({outerDeadline, m_frameDeadline, callDeadline});
+	m_timedOut = false;
+
+	++m_depth;
+	auto const result = duk_pcall(pContext, nargs);
+	--m_depth;
+	bool const overran = m_timedOut || Clock::now() >= m_deadline;
+	if (overran)
+	{
+		recordOverrun(m_stats, pSite, m_frameDeadline < callDeadline);
+	}
+	if (m_depth == 0u)
+	{
+		takeDueSamples(pContext, pSite);
+	}
+
+	m_deadline = outerDeadline;
+	m_timedOut = outerTimedOut;
+	return result;
+}
+
+
+bool
+ExecBudget::expired() noexcept
+{
+	if (m_timedOut)
+	{
+		return true;
+	}
+	if (m_deadline == noDeadline || Clock::now() < m_deadline)
+	{
+		return false;
+	}
+	m_timedOut = true;
+	return true;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
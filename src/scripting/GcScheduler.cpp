@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/GcScheduler.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** How much the cost estimate shrinks with each collection. */
+constexpr double costDecay{0.9};
+
+
+GcScheduler::GcScheduler(GcOptions const& options)
+	:	m_options(options)
+	,	m_longLived{}
+	,	m_compactionPending{false}
+	,	m_framesSinceCollection{0u}
+	,	m_bytesAfterCollection{0u}
+	,	m_estimatedCost{0.0}
+	,	m_frameSeconds{0.0}
+	,	m_stats{}
+{
+}
+
+
+void
+GcScheduler::addLongLived(char const* pGlobalKey)
+{
+	m_longLived.emplace_back(pGlobalKey);
+	m_compactionPending = true;
+}
+
+
+/** Get the live bytes of a heap, or zero if it has no allocator. */
+std::size_t
+getBytesLive(duk_context* pContext)
+{
+	auto const* const pState = getHeapState(pContext);
+	return pState && pState->pAllocator
+		? pState->pAllocator->stats().bytesLive
+		: 0u;
+}
+
+
+bool
+GcScheduler::endFrame(duk_context* pContext, Duration idle)
+{
+	++m_stats.frames;
+	++m_framesSinceCollection;
+
+	auto const bytesLive = getBytesLive(pContext);
+	auto const growth = bytesLive > m_bytesAfterCollection
+		? bytesLive - m_bytesAfterCollection
+		: 0u;
+	bool const overdue =
+		m_framesSinceCollection >= m_options.maxFramesBetween
+		|| (m_options.maxGrowthBytes > 0u
+			&& growth >= m_options.maxGrowthBytes);
+	bool const worthwhile =
+		m_framesSinceCollection >= m_options.minFramesBetween
+		|| (m_options.minGrowthBytes > 0u
+			&& growth >= m_options.minGrowthBytes);
+	bool const hasTime = m_estimatedCost <= idle;
+
+	if ((hasTime && worthwhile) || overdue)
+	{
+		if (!hasTime)
+		{
+			++m_stats.forcedCollections;
+		}
+		collect(pContext);
+	}
+
+	m_stats.secondsPerFrame.add(m_frameSeconds);
+	bool const collected = m_frameSeconds > 0.0;
+	m_frameSeconds = 0.0;
+	return collected;
+}
+
+
+void
+GcScheduler::collect(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "gc");
+	auto const start = Clock::now();
+
+	duk_gc(pContext, 0);
+	if (m_compactionPending)
+	{
+		for (auto const& key: m_longLived)
+		{
+			duk_get_global_string(pContext, key.c_str());
+			if (duk_is_object(pContext, -1))
+			{
+				duk_compact(pContext, -1);
+				++m_stats.compactions;
+			}
+			duk_pop(pContext);
+		}
+		m_compactionPending = false;
+	}
+
+	Duration const cost{Clock::now() - start};
+	m_estimatedCost = std::max(cost, m_estimatedCost * costDecay);
+	m_frameSeconds += cost.count();
+	m_stats.totalSeconds += cost.count();
+	++m_stats.collections;
+	m_framesSinceCollection = 0u;
+	m_bytesAfterCollection = getBytesLive(pContext);
+
+	auto* const pState = getHeapState(pContext);
+	if (pState && pState->pProfiler)
+	{
+		auto& profiler = *pState->pProfiler;
+		profiler.recordCpu(profiler.addPhase("gc"), cost.count());
+	}
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
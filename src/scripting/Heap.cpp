@@ -0,0 +1,156 @@
+#include <duktape.h>
+
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+#include "dukdemo/scripting/JsSampler.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/util.h"
+
+
+#ifdef DUKDEMO_EXEC_TIMEOUT
+extern "C" {
+
+
+/**
+ * Forwarded to from DUK_USE_EXEC_TIMEOUT_CHECK, with the heap udata. Doubles
+ * as the sampling profiler's tick, since it's called periodically while
+ * scripts run.
+ */
+static duk_bool_t
+checkExecTimeout(void* udata)
+{
+	auto* const pState = static_cast<dukdemo::scripting::HeapState*>(udata);
+	if (!pState)
+	{
+		return 0;
+	}
+	if (pState->pSampler)
+	{
+		pState->pSampler->poll();
+	}
+	return pState->pExecBudget && pState->pExecBudget->expired();
+}
+
+
+} // extern "C"
+#endif
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+inline HeapAllocator&
+getAllocator(void* udata) noexcept
+{
+	return *static_cast<HeapState*>(udata)->pAllocator;
+}
+
+
+void*
+allocate(void* udata, duk_size_t size)
+{
+	return getAllocator(udata).allocate(size);
+}
+
+
+void*
+reallocate(void* udata, void* pMemory, duk_size_t size)
+{
+	return getAllocator(udata).reallocate(pMemory, size);
+}
+
+
+void
+deallocate(void* udata, void* pMemory)
+{
+	getAllocator(udata).deallocate(pMemory);
+}
+
+
+/**
+ * Keep the typed array prototypes the loaders check coordinates against,
+ * before any script can replace the global constructors.
+ */
+static void
+stashCoordArrayPrototypes(duk_context* pContext)
+{
+	duk_push_heap_stash(pContext);
+	duk_get_global_string(pContext, "Float32Array");
+	duk_get_prop_string(pContext, -1, "prototype");
+	duk_put_prop_string(pContext, -3, g_float32ProtoSym);
+	duk_pop(pContext);
+	duk_get_global_string(pContext, "Float64Array");
+	duk_get_prop_string(pContext, -1, "prototype");
+	duk_put_prop_string(pContext, -3, g_float64ProtoSym);
+	duk_pop_2(pContext);
+}
+
+
+duk_context*
+createHeap(HeapState* pState)
+{
+#ifdef DUKDEMO_EXEC_TIMEOUT
+	dukdemo_set_exec_timeout_check(checkExecTimeout);
+#endif
+	duk_context* pContext{nullptr};
+	if (pState && pState->pAllocator)
+	{
+		pContext = duk_create_heap(
+			allocate, reallocate, deallocate, pState, nullptr);
+	}
+	else
+	{
+		pContext = duk_create_heap(nullptr, nullptr, nullptr, pState, nullptr);
+	}
+
+	if (pContext)
+	{
+		stashCoordArrayPrototypes(pContext);
+	}
+	if (pContext && pState && pState->pSampler)
+	{
+		pState->pSampler->attach(pContext);
+	}
+	if (pContext && pState && pState->pEnumNameCache)
+	{
+		pState->pEnumNameCache->clear();
+	}
+	return pContext;
+}
+
+
+HeapState*
+getHeapState(duk_context* pContext)
+{
+	duk_memory_functions functions;
+	duk_get_memory_functions(pContext, &functions);
+	return static_cast<HeapState*>(functions.udata);
+}
+
+
+void
+bumpStaticVersion(duk_context* pContext) noexcept
+{
+	auto* const pState = getHeapState(pContext);
+	if (pState && pState->pStaticVersion)
+	{
+		++*pState->pStaticVersion;
+	}
+}
+
+
+void
+takeDueSamples(duk_context* pContext, char const* pSite) noexcept
+{
+	auto* const pState = getHeapState(pContext);
+	if (pState && pState->pSampler)
+	{
+		pState->pSampler->takePending(pContext, pSite);
+	}
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
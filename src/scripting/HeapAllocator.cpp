@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "dukdemo/scripting/HeapAllocator.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** Precedes every large allocation, keeping the payload maximally aligned. */
+struct alignas(std::max_align_t) LargeHeader
+{
+	/** The size requested for the payload. */
+	std::size_t size;
+};
+
+
+/** Get the smallest class fitting `size` bytes, or the class count. */
+std::size_t
+getSizeClass(std::size_t size) noexcept
+{
+	auto const& sizes = HeapAllocator::s_classSizes;
+	return std::size_t(
+		std::lower_bound(sizes.begin(), sizes.end(), size) - sizes.begin());
+}
+
+
+inline LargeHeader*
+getLargeHeader(void* pMemory) noexcept
+{
+	return static_cast<LargeHeader*>(pMemory) - 1;
+}
+
+
+/** Round up to a power of two, so chunks can be found by masking. */
+std::size_t
+roundUpToPowerOfTwo(std::size_t size) noexcept
+{
+	std::size_t rounded = 1u;
+	while (rounded < size)
+	{
+		rounded <<= 1u;
+	}
+	return rounded;
+}
+
+
+HeapAllocator::HeapAllocator(std::size_t memoryLimit, std::size_t chunkSize)
+	:	m_memoryLimit{memoryLimit}
+	,	m_chunkSize{roundUpToPowerOfTwo(
+			std::max(chunkSize, s_classSizes.back()))}
+	,	m_pools{}
+	,	m_chunks{}
+	,	m_stats{}
+{
+}
+
+
+HeapAllocator::~HeapAllocator() noexcept
+{
+	for (auto const& chunk: m_chunks)
+	{
+		std::free(chunk.pBase);
+	}
+}
+
+
+bool
+HeapAllocator::reserve(std::size_t size) noexcept
+{
+	if (m_memoryLimit != 0u && m_stats.bytesLive + size > m_memoryLimit)
+	{
+		++m_stats.limitFailures;
+		return false;
+	}
+	m_stats.bytesLive += size;
+	m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.bytesLive);
+	return true;
+}
+
+
+std::size_t
+HeapAllocator::getBlockClass(void* pMemory) const noexcept
+{
+	auto* const pBase = reinterpret_cast<char*>(
+		reinterpret_cast<std::uintptr_t>(pMemory) & ~(m_chunkSize - 1u));
+	auto const it = std::lower_bound(
+		m_chunks.begin(), m_chunks.end(), pBase,
+		[](Chunk const& chunk, char* pKey) { return chunk.pBase < pKey; });
+	return it != m_chunks.end() && it->pBase == pBase
+		? it->sizeClass
+		: s_classCount;
+}
+
+
+void*
+HeapAllocator::allocateBlock(std::size_t sizeClass) noexcept
+{
+	auto& pool = m_pools[sizeClass];
+	auto& classStats = m_stats.classes[sizeClass];
+	auto const blockSize = s_classSizes[sizeClass];
+
+	void* pBlock = nullptr;
+	if (pool.pFree)
+	{
+		pBlock = pool.pFree;
+		pool.pFree = pool.pFree->pNext;
+		++classStats.hits;
+	}
+	else if (std::size_t(pool.pEnd - pool.pCursor) >= blockSize)
+	{
+		pBlock = pool.pCursor;
+		pool.pCursor += blockSize;
+		++classStats.hits;
+	}
+	else
+	{
+		auto* const pChunk =
+			static_cast<char*>(std::aligned_alloc(m_chunkSize, m_chunkSize));
+		if (!pChunk)
+		{
+			return nullptr;
+		}
+		try
+		{
+			Chunk const chunk{pChunk, sizeClass};
+			m_chunks.insert(
+				std::upper_bound(
+					m_chunks.begin(), m_chunks.end(), chunk,
+					[](Chunk const& lhs, Chunk const& rhs) {
+						return lhs.pBase < rhs.pBase;
+					}),
+				chunk);
+		}
+		catch (std::bad_alloc const&)
+		{
+			std::free(pChunk);
+			return nullptr;
+		}
+		++m_stats.systemAllocations;
+		pBlock = pChunk;
+		pool.pCursor = pChunk + blockSize;
+		pool.pEnd = pChunk + m_chunkSize;
+	}
+
+	++classStats.allocations;
+	++classStats.liveBlocks;
+	return pBlock;
+}
+
+
+void*
+HeapAllocator::allocateLarge(std::size_t size) noexcept
+{
+	auto* const pHeader = static_cast<LargeHeader*>(
+		std::malloc(sizeof(LargeHeader) + size));
+	if (!pHeader)
+	{
+		return nullptr;
+	}
+	++m_stats.systemAllocations;
+	++m_stats.largeAllocations;
+	pHeader->size = size;
+	return pHeader + 1;
+}
+
+
+void*
+HeapAllocator::allocate(std::size_t size) noexcept
+{
+	if (size == 0u)
+	{
+		return nullptr;
+	}
+
+	auto const sizeClass = getSizeClass(size);
+	bool const isLarge = sizeClass == s_classCount;
+	auto const reserved = isLarge ? size : s_classSizes[sizeClass];
+	if (!reserve(reserved))
+	{
+		return nullptr;
+	}
+
+	auto* const pMemory = isLarge
+		? allocateLarge(size)
+		: allocateBlock(sizeClass);
+	if (!pMemory)
+	{
+		m_stats.bytesLive -= reserved;
+		return nullptr;
+	}
+
+	++m_stats.allocations;
+	return pMemory;
+}
+
+
+void*
+HeapAllocator::reallocate(void* pMemory, std::size_t size) noexcept
+{
+	if (!pMemory)
+	{
+		return allocate(size);
+	}
+	if (size == 0u)
+	{
+		deallocate(pMemory);
+		return nullptr;
+	}
+
+	auto const oldClass = getBlockClass(pMemory);
+	auto const newClass = getSizeClass(size);
+	bool const wasLarge = oldClass == s_classCount;
+	bool const isLarge = newClass == s_classCount;
+	auto const oldSize = wasLarge
+		? getLargeHeader(pMemory)->size
+		: s_classSizes[oldClass];
+
+	// Keep a pooled block while staying in the same class.
+	if (!wasLarge && newClass == oldClass)
+	{
+		++m_stats.reallocations;
+		return pMemory;
+	}
+
+	// Resize large blocks in place.
+	if (wasLarge && isLarge)
+	{
+		if (size > oldSize && !reserve(size - oldSize))
+		{
+			return nullptr;
+		}
+
+		auto* const pResized = static_cast<LargeHeader*>(std::realloc(
+			getLargeHeader(pMemory), sizeof(LargeHeader) + size));
+		if (!pResized)
+		{
+			m_stats.bytesLive -= size > oldSize ? size - oldSize : 0u;
+			return nullptr;
+		}
+		++m_stats.systemAllocations;
+		m_stats.bytesLive -= size < oldSize ? oldSize - size : 0u;
+		++m_stats.reallocations;
+		pResized->size = size;
+		return pResized + 1;
+	}
+
+	// Otherwise move to a block of the new class.
+	auto* const pMoved = allocate(size);
+	if (!pMoved)
+	{
+		return nullptr;
+	}
+	std::memcpy(pMoved, pMemory, std::min(oldSize, size));
+	deallocate(pMemory);
+	++m_stats.reallocations;
+	return pMoved;
+}
+
+
+void
+HeapAllocator::deallocate(void* pMemory) noexcept
+{
+	if (!pMemory)
+	{
+		return;
+	}
+
+	++m_stats.frees;
+	auto const sizeClass = getBlockClass(pMemory);
+	if (sizeClass == s_classCount)
+	{
+		auto* const pHeader = getLargeHeader(pMemory);
+		m_stats.bytesLive -= pHeader->size;
+		std::free(pHeader);
+		return;
+	}
+
+	m_stats.bytesLive -= s_classSizes[sizeClass];
+	auto& pool = m_pools[sizeClass];
+	--m_stats.classes[sizeClass].liveBlocks;
+	auto* const pBlock = static_cast<FreeBlock*>(pMemory);
+	pBlock->pNext = pool.pFree;
+	pool.pFree = pBlock;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/JsSampler.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+JsSampler::JsSampler(Duration interval)
+	:	m_pContext{nullptr}
+	,	m_interval{interval}
+	,	m_nextSample{}
+	,	m_pending{0u}
+	,	m_count{0u}
+	,	m_pSite{nullptr}
+	,	m_stacks{}
+	,	m_samples{0u}
+	,	m_stack{}
+{
+}
+
+
+void
+JsSampler::poll() noexcept
+{
+	if (!m_pContext)
+	{
+		return;
+	}
+
+	auto const now = Clock::now();
+	if (now < m_nextSample)
+	{
+		return;
+	}
+	m_nextSample =
+		now + std::chrono::duration_cast<Clock::duration>(m_interval);
+	++m_pending;
+}
+
+
+void
+JsSampler::takePending(duk_context* pContext, char const* pSite) noexcept
+{
+	if (m_pending == 0u)
+	{
+		return;
+	}
+	auto const count = m_pending;
+	m_pending = 0u;
+	m_pSite = pSite;
+	sample(pContext, count);
+	m_pSite = nullptr;
+}
+
+
+/** Get a string property of the value stack top, or a fallback. */
+static char const*
+getStringProp(duk_context* pContext, char const* pKey, char const* pFallback)
+{
+	duk_get_prop_string(pContext, -1, pKey);
+	auto const* const pValue = duk_get_string(pContext, -1);
+	duk_pop(pContext);
+	return pValue && *pValue != '\0' ? pValue : pFallback;
+}
+
+
+/** Append a frame's label, keeping the folded format's separators out. */
+static void
+appendLabel(std::string& stack, char const* pLabel)
+{
+	for (auto const* pChar = pLabel; *pChar != '\0'; ++pChar)
+	{
+		stack += *pChar == ';' ? ',' : *pChar;
+	}
+}
+
+
+duk_ret_t
+JsSampler::captureStack(duk_context* pContext, void* udata)
+{
+	auto& sampler = *static_cast<JsSampler*>(udata);
+	try
+	{
+		// Frames are found innermost first, but folded outermost first.
+		std::vector<std::string> frames;
+		if (sampler.m_pSite)
+		{
+			frames.emplace_back();
+			appendLabel(frames.back(), sampler.m_pSite);
+		}
+		for (int level = -1; level >= -s_maxDepth; --level)
+		{
+			duk_inspect_callstack_entry(pContext, level);
+			if (duk_is_undefined(pContext, -1))
+			{
+				duk_pop(pContext);
+				break;
+			}
+
+			duk_get_prop_string(pContext, -1, "lineNumber");
+			auto const line = duk_get_int(pContext, -1);
+			duk_pop(pContext);
+			duk_get_prop_string(pContext, -1, "function");
+
+			std::string frame;
+			if (duk_is_c_function(pContext, -1))
+			{
+				frame = "[native]";
+			}
+			else
+			{
+				appendLabel(
+					frame, getStringProp(pContext, "name", "(anonymous)"));
+				frame += " (";
+				appendLabel(
+					frame, getStringProp(pContext, "fileName", "?"));
+				frame += ':';
+				frame += std::to_string(line);
+				frame += ')';
+			}
+			frames.push_back(std::move(frame));
+			duk_pop_2(pContext);
+		}
+
+		if (frames.empty())
+		{
+			return 0;
+		}
+
+		auto& stack = sampler.m_stack;
+		stack.clear();
+		for (auto pFrame = frames.rbegin(); pFrame != frames.rend(); ++pFrame)
+		{
+			if (!stack.empty())
+			{
+				stack += ';';
+			}
+			stack += *pFrame;
+		}
+		sampler.m_stacks[stack] += sampler.m_count;
+		sampler.m_samples += sampler.m_count;
+	}
+	catch (...)
+	{
+		return DUK_RET_ERROR;
+	}
+
+	duk_push_true(pContext);
+	return 1;
+}
+
+
+bool
+JsSampler::sample(duk_context* pContext, std::size_t count) noexcept
+{
+	m_count = count;
+	auto const result =
+		duk_safe_call(pContext, captureStack, this, 0, 1) == DUK_EXEC_SUCCESS
+		&& duk_get_boolean(pContext, -1);
+	duk_pop(pContext);
+	return result;
+}
+
+
+void
+JsSampler::writeFolded(std::ostream& out) const
+{
+	// Sort for stable output.
+	std::vector<std::pair<std::string, std::size_t>> stacks{
+		m_stacks.begin(), m_stacks.end()};
+	std::sort(stacks.begin(), stacks.end());
+	for (auto const& stack: stacks)
+	{
+		out << stack.first << ' ' << stack.second << '\n';
+	}
+}
+
+
+void
+JsSampler::dump(std::string const& path) const
+{
+	std::ofstream file{path, std::ios::trunc};
+	writeFolded(file);
+	file.close();
+	if (!file)
+	{
+		throw std::runtime_error{"Unable to write JS profile to " + path};
+	}
+}
+
+
+void
+JsSampler::clear() noexcept
+{
+	m_stacks.clear();
+	m_samples = 0u;
+	m_pending = 0u;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
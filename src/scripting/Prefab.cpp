@@ -0,0 +1,152 @@
+#include <memory>
+#include <utility>
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/util.h"
+#include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/Prefab.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** Load a fixture definition and its shape. */
+bool
+loadPrefabFixture(
+	duk_context* pContext,
+	duk_idx_t fixtureIdx,
+	PrefabFixture* pFixture
+)
+{
+	if (!loadFixtureDefWithoutShape(pContext, fixtureIdx, &pFixture->def))
+	{
+		return false;
+	}
+
+	duk_get_prop_string(pContext, fixtureIdx, "shape");
+	pFixture->pShape = loadShape(pContext, -1);
+	duk_pop(pContext);
+	pFixture->def.shape = pFixture->pShape.get();
+	return bool(pFixture->pShape);
+}
+
+
+bool
+loadPrefab(duk_context* pContext, duk_idx_t defIdx, Prefab* pPrefab)
+{
+	defIdx = duk_normalize_index(pContext, defIdx);
+	Prefab tmp;
+	if (!loadBodyDef(pContext, defIdx, &tmp.bodyDef))
+	{
+		return false;
+	}
+
+	bool valid = true;
+	if (duk_get_prop_string(pContext, defIdx, "fixtures"))
+	{
+		valid = duk_is_array(pContext, -1);
+		auto const count = valid ? duk_get_length(pContext, -1) : 0u;
+		tmp.fixtures.resize(count);
+		for (duk_size_t i = 0u; valid && i < count; ++i)
+		{
+			duk_get_prop_index(pContext, -1, duk_uarridx_t(i));
+			valid = loadPrefabFixture(
+				pContext, duk_normalize_index(pContext, -1), &tmp.fixtures[i]);
+			duk_pop(pContext);
+		}
+	}
+	duk_pop(pContext); // Pop `fixtures`.
+
+	if (valid)
+	{
+		*pPrefab = std::move(tmp);
+	}
+	return valid;
+}
+
+
+b2Body*
+createBodyFromPrefab(
+	b2World& world,
+	Prefab const& prefab,
+	b2Vec2 const& position,
+	float angle
+)
+{
+	b2BodyDef bodyDef{prefab.bodyDef};
+	bodyDef.position = position;
+	bodyDef.angle = angle;
+
+	auto* const pBody = world.CreateBody(&bodyDef);
+	if (!pBody)
+	{
+		// The world is locked, mid-step.
+		return nullptr;
+	}
+	for (auto const& fixture: prefab.fixtures)
+	{
+		pBody->CreateFixture(&fixture.def);
+	}
+	return pBody;
+}
+
+
+namespace prefab {
+
+
+duk_idx_t
+pushPrefab(duk_context* pContext, std::unique_ptr<Prefab> pPrefab)
+{
+	auto const prefabIdx = duk_push_bare_object(pContext);
+	duk_push_pointer(pContext, pPrefab.get());
+	duk_put_prop_string(pContext, prefabIdx, g_ownPrefabPtrSym);
+	duk_push_c_function(pContext, finalizer, 1);
+	duk_set_finalizer(pContext, prefabIdx);
+	pPrefab.release();
+	return prefabIdx;
+}
+
+
+Prefab const*
+getPrefabPtrAt(duk_context* pContext, duk_idx_t prefabIdx)
+{
+	if (!duk_is_object(pContext, prefabIdx))
+	{
+		return nullptr;
+	}
+
+	duk_get_prop_string(pContext, prefabIdx, g_ownPrefabPtrSym);
+	auto const* const pPrefab =
+		static_cast<Prefab const*>(duk_get_pointer(pContext, -1));
+	duk_pop(pContext);
+	return pPrefab;
+}
+
+
+duk_ret_t
+finalizer(duk_context* pContext)
+{
+	duk_get_prop_string(pContext, 0, g_ownPrefabPtrSym);
+	auto* const pPrefab = static_cast<Prefab*>(duk_get_pointer(pContext, -1));
+	duk_pop(pContext);
+	if (pPrefab == nullptr)
+	{
+		return 0;
+	}
+
+	duk_push_pointer(pContext, nullptr);
+	duk_put_prop_string(pContext, 0, g_ownPrefabPtrSym);
+	delete pPrefab;
+	return 0;
+}
+
+
+} // namespace prefab
+} // namespace scripting
+} // namespace dukdemo
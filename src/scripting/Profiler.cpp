@@ -0,0 +1,105 @@
+#include <duktape.h>
+
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/scripting/util.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/Profiler.h"
+
+
+namespace dukdemo {
+namespace scripting {
+namespace profiler {
+
+
+constexpr double msPerSecond{1000.0};
+
+
+void
+init(duk_context* pContext)
+{
+	auto const profilerIdx = duk_push_object(pContext);
+
+#define PUSH_METHOD(method, nargs) \
+	duk_push_c_function(pContext, methods::method, nargs); \
+	duk_put_prop_string(pContext, profilerIdx, #method)
+
+	PUSH_METHOD(stats, 0);
+#undef PUSH_METHOD
+
+	duk_put_global_string(pContext, g_profilerGlobalName);
+}
+
+
+/** Push an object summarising some timings. */
+void
+pushTimings(duk_context* pContext, util::RollingHistogram const& timings)
+{
+	auto const objIdx = duk_push_object(pContext);
+	duk_push_number(pContext, timings.mean() * msPerSecond);
+	duk_put_prop_string(pContext, objIdx, "mean");
+	duk_push_number(pContext, timings.percentile(50.0) * msPerSecond);
+	duk_put_prop_string(pContext, objIdx, "p50");
+	duk_push_number(pContext, timings.percentile(95.0) * msPerSecond);
+	duk_put_prop_string(pContext, objIdx, "p95");
+	duk_push_number(pContext, timings.percentile(99.0) * msPerSecond);
+	duk_put_prop_string(pContext, objIdx, "p99");
+	duk_push_number(pContext, timings.max() * msPerSecond);
+	duk_put_prop_string(pContext, objIdx, "max");
+	duk_push_number(pContext, duk_double_t(timings.size()));
+	duk_put_prop_string(pContext, objIdx, "samples");
+}
+
+
+namespace methods {
+
+
+duk_ret_t
+stats(duk_context* pContext)
+{
+	auto const* const pState = getHeapState(pContext);
+	if (!pState || !pState->pProfiler)
+	{
+		return 0;
+	}
+
+	auto const& profiler = *pState->pProfiler;
+	auto const statsIdx = duk_push_object(pContext);
+	duk_push_number(pContext, duk_double_t(profiler.frames()));
+	duk_put_prop_string(pContext, statsIdx, "frames");
+
+	auto const phasesIdx = duk_push_object(pContext);
+	for (auto const& phase: profiler.phases())
+	{
+		auto const phaseIdx = duk_push_object(pContext);
+		pushTimings(pContext, phase.cpu);
+		duk_put_prop_string(pContext, phaseIdx, "cpu");
+		if (phase.gpu.size() > 0u)
+		{
+			pushTimings(pContext, phase.gpu);
+			duk_put_prop_string(pContext, phaseIdx, "gpu");
+		}
+		duk_put_prop_string(pContext, phasesIdx, phase.name.c_str());
+	}
+	duk_put_prop_string(pContext, statsIdx, "phases");
+
+	auto const countersIdx = duk_push_object(pContext);
+	for (auto const& counter: profiler.counters())
+	{
+		auto const counterIdx = duk_push_object(pContext);
+		duk_push_number(pContext, duk_double_t(counter.latest));
+		duk_put_prop_string(pContext, counterIdx, "latest");
+		duk_push_number(pContext, counter.mean());
+		duk_put_prop_string(pContext, counterIdx, "mean");
+		duk_push_number(pContext, duk_double_t(counter.samples));
+		duk_put_prop_string(pContext, counterIdx, "samples");
+		duk_put_prop_string(pContext, countersIdx, counter.name.c_str());
+	}
+	duk_put_prop_string(pContext, statsIdx, "counters");
+	return 1;
+}
+
+
+} // namespace methods
+} // namespace profiler
+} // namespace scripting
+} // namespace dukdemo
@@ -0,0 +1,140 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <Box2D/Common/b2Math.h>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/Schema.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+/** Copy a loaded value into its field, which may be unaligned. */
+template <typename Value>
+void
+storeField(void* pObject, std::size_t offset, Value const& value) noexcept
+{
+	std::memcpy(static_cast<char*>(pObject) + offset, &value, sizeof(Value));
+}
+
+
+bool
+loadField(
+	duk_context* pContext,
+	duk_idx_t valueIdx,
+	SchemaField const& field,
+	void* pObject
+)
+	noexcept
+{
+	switch (field.type)
+	{
+		case FieldType::Float:
+		{
+			auto const value = float(duk_get_number(pContext, valueIdx));
+			if (std::isnan(value))
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, value);
+			return true;
+		}
+
+		case FieldType::Bool:
+		{
+			if (!duk_is_boolean(pContext, valueIdx))
+			{
+				return false;
+			}
+			bool const value = duk_get_boolean(pContext, valueIdx);
+			storeField(pObject, field.offset, value);
+			return true;
+		}
+
+		case FieldType::Int16:
+		{
+			if (!duk_is_number(pContext, valueIdx))
+			{
+				return false;
+			}
+			auto const value = int16(duk_get_int(pContext, valueIdx));
+			storeField(pObject, field.offset, value);
+			return true;
+		}
+
+		case FieldType::Uint16:
+		{
+			if (!duk_is_number(pContext, valueIdx))
+			{
+				return false;
+			}
+			auto const value = duk_get_uint(pContext, valueIdx);
+			if (value >= std::numeric_limits<uint16>::max())
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, uint16(value));
+			return true;
+		}
+
+		case FieldType::Vec2:
+		{
+			b2Vec2 value;
+			if (!loadVec2(pContext, valueIdx, &value))
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, value);
+			return true;
+		}
+
+		case FieldType::Enum:
+		{
+			auto const value = getEnum(pContext, valueIdx, *field.pEnum);
+			if (value == field.pEnum->count)
+			{
+				return false;
+			}
+			storeField(pObject, field.offset, int(value));
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool
+loadSchemaFields(
+	duk_context* pContext,
+	duk_idx_t objectIdx,
+	FieldLookup lookup,
+	void* pObject
+)
+	noexcept
+{
+	duk_enum(pContext, objectIdx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+	bool valid = true;
+	while (valid && duk_next(pContext, -1, 1))
+	{
+		duk_size_t length = 0u;
+		auto const* const pName = duk_get_lstring(pContext, -2, &length);
+		auto const* const pField = pName ? lookup(pName, length) : nullptr;
+		if (pField && !duk_is_undefined(pContext, -1))
+		{
+			valid = loadField(pContext, -1, *pField, pObject);
+		}
+		duk_pop_2(pContext); // Pop the key and value.
+	}
+	duk_pop(pContext); // Pop the enumerator.
+	return valid;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
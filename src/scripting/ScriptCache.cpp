@@ -0,0 +1,224 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/ScriptCache.h"
+#include "dukdemo/util/TempFile.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace scripting {
+
+
+constexpr char const cacheMagic[8] = {'D', 'U', 'K', 'B', 'C', '0', '0', '2'};
+
+
+/**
+ * The Duktape build options that entries depend on. Bytecode is only loaded
+ * by the build configuration that compiled it.
+ */
+constexpr std::uint64_t dukConfig = 0u
+#ifdef DUKDEMO_EXEC_TIMEOUT
+	| 1u
+#endif
+#ifdef DUKDEMO_MANUAL_GC
+	| 2u
+#endif
+	;
+
+
+/** The fixed-size header preceding the bytecode in each cache file. */
+struct CacheHeader
+{
+	char magic[8];
+	std::uint64_t dukVersion;
+	std::uint64_t dukConfig;
+	std::uint64_t key;
+	std::uint64_t sourceSize;
+	std::uint64_t bytecodeSize;
+};
+
+
+static duk_ret_t
+loadFunction(duk_context* pContext, void*)
+{
+	duk_load_function(pContext);
+	return 1;
+}
+
+
+ScriptCache::ScriptCache(std::string directory)
+	:	m_directory{std::move(directory)}
+	,	m_stats{}
+{
+}
+
+
+ScriptCache::Key
+ScriptCache::hash(std::string const& source, char const* pFileName) noexcept
+{
+	// 64-bit FNV-1a.
+	constexpr Key offsetBasis = 14695981039346656037ull;
+	constexpr Key prime = 1099511628211ull;
+	Key key = offsetBasis;
+	for (auto const* pChar = pFileName; *pChar != '\0'; ++pChar)
+	{
+		key = (key ^ Key(static_cast<unsigned char>(*pChar))) * prime;
+	}
+	key = (key ^ 0u) * prime; // Separate the file name from the source.
+	for (char const c: source)
+	{
+		key = (key ^ Key(static_cast<unsigned char>(c))) * prime;
+	}
+	return key;
+}
+
+
+std::string
+ScriptCache::pathFor(std::string const& source, char const* pFileName) const
+{
+	char name[64];
+	std::snprintf(
+		name, sizeof(name), "%016llx-%ld-%llx.dukbc",
+		static_cast<unsigned long long>(hash(source, pFileName)),
+		long(DUK_VERSION), static_cast<unsigned long long>(dukConfig));
+	return m_directory + '/' + name;
+}
+
+
+bool
+ScriptCache::pushFunction(
+	duk_context* pContext,
+	std::string const& source,
+	char const* pFileName
+)
+{
+	DUKDEMO_TRACE_SCOPE("script", "ScriptCache.pushFunction");
+	auto const key = hash(source, pFileName);
+	auto const path = pathFor(source, pFileName);
+	if (load(pContext, path, key, source.size()))
+	{
+		++m_stats.hits;
+		return true;
+	}
+
+	++m_stats.misses;
+	duk_push_string(pContext, pFileName);
+	if (duk_pcompile_lstring_filename(
+			pContext, 0, source.data(), source.size()) != 0)
+	{
+		return false;
+	}
+
+	if (!store(pContext, path, key, source.size()))
+	{
+		++m_stats.writeFailures;
+	}
+	return true;
+}
+
+
+bool
+ScriptCache::load(
+	duk_context* pContext,
+	std::string const& path,
+	Key key,
+	std::size_t sourceSize
+) const
+{
+	std::ifstream file{path, std::ios::in | std::ios::binary};
+	CacheHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		return false;
+	}
+
+	bool const valid =
+		std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 &&
+		header.dukVersion == std::uint64_t(DUK_VERSION) &&
+		header.dukConfig == dukConfig &&
+		header.key == key &&
+		header.sourceSize == sourceSize &&
+		header.bytecodeSize > 0u;
+	if (!valid)
+	{
+		return false;
+	}
+
+	// Read straight into the buffer which duk_load_function consumes.
+	auto* const pBytecode =
+		duk_push_fixed_buffer(pContext, duk_size_t(header.bytecodeSize));
+	file.read(
+		static_cast<char*>(pBytecode), std::streamsize(header.bytecodeSize));
+	if (!file || file.peek() != std::ifstream::traits_type::eof())
+	{
+		duk_pop(pContext);
+		return false;
+	}
+
+	if (duk_safe_call(pContext, loadFunction, nullptr, 1, 1) !=
+			DUK_EXEC_SUCCESS)
+	{
+		duk_pop(pContext);
+		return false;
+	}
+	return true;
+}
+
+
+bool
+ScriptCache::store(
+	duk_context* pContext,
+	std::string const& path,
+	Key key,
+	std::size_t sourceSize
+) const
+{
+	duk_dup(pContext, -1);
+	duk_dump_function(pContext);
+	duk_size_t bytecodeSize = 0u;
+	auto const* const pBytecode = duk_get_buffer(pContext, -1, &bytecodeSize);
+
+	CacheHeader header;
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.dukVersion = std::uint64_t(DUK_VERSION);
+	header.dukConfig = dukConfig;
+	header.key = key;
+	header.sourceSize = sourceSize;
+	header.bytecodeSize = bytecodeSize;
+
+	// Write to a temporary file and rename it, so that readers never see a
+	// partially written entry.
+	auto const tmpPath = util::createTempFileFor(path);
+	if (tmpPath.empty())
+	{
+		duk_pop(pContext);
+		return false;
+	}
+	bool written = false;
+	{
+		std::ofstream file{tmpPath, std::ios::out | std::ios::binary};
+		written = bool(file) &&
+			file.write(
+				reinterpret_cast<char const*>(&header), sizeof(header)) &&
+			file.write(
+				static_cast<char const*>(pBytecode),
+				std::streamsize(bytecodeSize));
+	}
+	duk_pop(pContext);
+
+	if (!written || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tmpPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+} // namespace scripting
+} // namespace dukdemo
@@ -1,15 +1,23 @@
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2Body.h>
 
 #include <duktape.h>
 
+#include "dukdemo/scene/WorldState.h"
 #include "dukdemo/util/deleters.h"
 #include "dukdemo/scripting/util.h"
 #include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/Heap.h"
 #include "dukdemo/scripting/World.h"
 #include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/Prefab.h"
+#include "dukdemo/util/Trace.h"
 
 
 namespace dukdemo {
@@ -31,7 +39,12 @@ init(duk_context* pContext)
 	PUSH_METHOD(setGravity, 2);
 	PUSH_METHOD(getGravity, 1);
 	PUSH_METHOD(createBody, 1);
+	PUSH_METHOD(createBodies, 1);
+	PUSH_METHOD(spawn, 4);
 	PUSH_METHOD(destroyBody, 1);
+	PUSH_METHOD(readTransforms, 2);
+	PUSH_METHOD(snapshot, 0);
+	PUSH_METHOD(restore, 1);
 #undef PUSH_METHOD
 
 	duk_dup(pContext, prototypeIdx); // [ctor, proto, proto].
@@ -42,26 +55,137 @@ init(duk_context* pContext)
 	// Store the prototype on the constructor.
 	duk_put_prop_string(pContext, -2, "prototype"); // [ctor].
 
+	// Add static functions to the constructor.
+	duk_push_c_function(pContext, compilePrefab, 1);
+	duk_put_prop_string(pContext, -2, "compilePrefab"); // [ctor].
+
 	// Put the constructor on the global object.
 	duk_put_global_string(pContext, g_worldCtorSym); // [].
 }
 
 
+/**
+ * Get the @ref b2World of a `World` object.
+ *
+ * Throws a `TypeError` if the world has been detached.
+ */
+static b2World*
+getWorldPtrAt(duk_context* pContext, duk_idx_t worldIdx)
+{
+	duk_get_prop_string(pContext, worldIdx, g_ownWorldPtrSym);
+	auto* const pWorld = static_cast<b2World*>(duk_get_pointer(pContext, -1));
+	duk_pop(pContext);
+	if (!pWorld)
+	{
+		duk_type_error(pContext, "World has been destroyed");
+	}
+	return pWorld;
+}
+
+
 b2World*
 getOwnWorldPtr(duk_context* pContext)
 {
-	return static_cast<b2World*>(
-		getPointerFromThis(pContext, g_ownWorldPtrSym));
+	duk_push_this(pContext);
+	auto* const pWorld = getWorldPtrAt(pContext, -1);
+	duk_pop(pContext);
+	return pWorld;
+}
+
+
+/**
+ * Finalize the object holding a world's @ref scene::BodySerials.
+ *
+ * Clears the pointer, as bodies finalized with the world may still look for
+ * their serials.
+ */
+static duk_ret_t
+serialsFinalizer(duk_context* pContext)
+{
+	duk_get_prop_string(pContext, 0, g_ownSerialsPtrSym);
+	delete static_cast<scene::BodySerials*>(duk_get_pointer(pContext, -1));
+	duk_pop(pContext);
+	duk_push_pointer(pContext, nullptr);
+	duk_put_prop_string(pContext, 0, g_ownSerialsPtrSym);
+	return 0;
+}
+
+
+/**
+ * Get the @ref scene::BodySerials of a `World` object.
+ *
+ * @returns the serials, or `nullptr` if the value isn't a `World` object or
+ * its serials have been finalized.
+ */
+static scene::BodySerials*
+getSerialsAt(duk_context* pContext, duk_idx_t worldIdx)
+{
+	if (!duk_is_object(pContext, worldIdx))
+	{
+		return nullptr;
+	}
+	duk_get_prop_string(pContext, worldIdx, g_worldSerialsSym);
+	void* pSerials = nullptr;
+	if (duk_is_object(pContext, -1))
+	{
+		duk_get_prop_string(pContext, -1, g_ownSerialsPtrSym);
+		pSerials = duk_get_pointer(pContext, -1);
+		duk_pop(pContext);
+	}
+	duk_pop(pContext);
+	return static_cast<scene::BodySerials*>(pSerials);
+}
+
+
+/** Get the serials of a `World` object, throwing if it has none. */
+static scene::BodySerials&
+requireSerialsAt(duk_context* pContext, duk_idx_t worldIdx)
+{
+	auto* const pSerials = getSerialsAt(pContext, worldIdx);
+	if (!pSerials)
+	{
+		duk_error(pContext, DUK_ERR_ERROR, "World has no body serials");
+	}
+	return *pSerials;
 }
 
 
 void
-initWorldObject(duk_context* pContext, duk_idx_t objIdx, b2World* pWorld)
+initWorldObject(
+	duk_context* pContext,
+	duk_idx_t objIdx,
+	b2World* pWorld,
+	BodyLifetime lifetime
+)
 {
 	duk_get_global_string(pContext, g_worldProtoSym);
 	duk_set_prototype(pContext, objIdx);
 	duk_push_pointer(pContext, pWorld);
 	duk_put_prop_string(pContext, objIdx, g_ownWorldPtrSym);
+	duk_push_boolean(pContext, lifetime == BodyLifetime::worldOwned);
+	duk_put_prop_string(pContext, objIdx, g_worldOwnsBodiesSym);
+
+	// The serials are held by an object of their own, whose finalizer frees
+	// them, so worlds without a finalizer free them too.
+	duk_push_object(pContext);
+	duk_push_c_function(pContext, serialsFinalizer, 1);
+	duk_set_finalizer(pContext, -2);
+	auto pSerials = std::make_unique<scene::BodySerials>();
+	duk_push_pointer(pContext, pSerials.get());
+	duk_put_prop_string(pContext, -2, g_ownSerialsPtrSym);
+	pSerials.release();
+	duk_put_prop_string(pContext, objIdx, g_worldSerialsSym);
+}
+
+
+/** Get the lifetime of bodies created by a `World` object. */
+BodyLifetime
+getBodyLifetime(duk_context* pContext, duk_idx_t worldIdx)
+{
+	duk_get_prop_string(pContext, worldIdx, g_worldOwnsBodiesSym);
+	bool const ownsBodies = duk_get_boolean(pContext, -1);
+	duk_pop(pContext);
+	return ownsBodies ? BodyLifetime::worldOwned : BodyLifetime::finalized;
 }
 
 
@@ -69,7 +193,7 @@ duk_idx_t
 pushWorldWithoutFinalizer(duk_context* pContext, b2World* pWorld)
 {
 	auto const worldIdx = duk_push_object(pContext);
-	initWorldObject(pContext, worldIdx, pWorld);
+	initWorldObject(pContext, worldIdx, pWorld, BodyLifetime::finalized);
 	return worldIdx;
 }
 
@@ -77,7 +201,9 @@ pushWorldWithoutFinalizer(duk_context* pContext, b2World* pWorld)
 duk_idx_t
 pushWorldWithFinalizer(duk_context* pContext, std::unique_ptr<b2World> pWorld)
 {
-	auto const objIdx = pushWorldWithoutFinalizer(pContext, pWorld.get());
+	auto const objIdx = duk_push_object(pContext);
+	initWorldObject(
+		pContext, objIdx, pWorld.get(), BodyLifetime::worldOwned);
 	duk_push_c_function(pContext, finalizer, 1);
 	duk_set_finalizer(pContext, -2);
 	pWorld.release();
@@ -101,7 +227,7 @@ constructor(duk_context* pContext)
 
 	auto pWorld = std::make_unique<b2World>(gravity);
 	duk_push_this(pContext);
-	initWorldObject(pContext, 1, pWorld.get());
+	initWorldObject(pContext, 1, pWorld.get(), BodyLifetime::worldOwned);
 	duk_push_c_function(pContext, finalizer, 1);
 	duk_set_finalizer(pContext, -2);
 	pWorld.release();
@@ -109,24 +235,65 @@ constructor(duk_context* pContext)
 }
 
 
-duk_ret_t
-finalizer(duk_context* pContext)
+void
+detach(duk_context* pContext, duk_idx_t worldIdx)
 {
-	duk_get_prop_string(pContext, 0, g_ownWorldPtrSym);
-	auto* const pWorld = static_cast<b2World*>(duk_get_pointer(pContext, 1));
+	worldIdx = duk_normalize_index(pContext, worldIdx);
+	duk_get_prop_string(pContext, worldIdx, g_ownWorldPtrSym);
+	auto* const pWorld = static_cast<b2World*>(duk_get_pointer(pContext, -1));
 	duk_pop(pContext);
 
-	// If the world pointer is null, we're finalising something which has
-	// already been destroyed, or the prototype itself, so can bail out.
+	// If the world pointer is null, the world has already been detached, or
+	// this is the prototype itself, so can bail out.
 	if (pWorld == nullptr)
 	{
-		return 0;
+		return;
 	}
 
 	// Replace the world's internal pointer with a nullptr.
 	duk_push_pointer(pContext, nullptr);
-	duk_put_prop_string(pContext, 0, g_ownWorldPtrSym);
-	pWorld->~b2World();
+	duk_put_prop_string(pContext, worldIdx, g_ownWorldPtrSym);
+
+	// Invalidate every body handle in one sweep.
+	auto* const pTable = getBodyTable(pContext);
+	if (pTable == nullptr)
+	{
+		return;
+	}
+	for (
+		b2Body* pBody = pWorld->GetBodyList();
+		pBody != nullptr;
+		pBody = pBody->GetNext()
+	)
+	{
+		pTable->remove(pTable->find(pBody));
+	}
+}
+
+
+void
+forgetBody(duk_context* pContext, duk_idx_t bodyIdx, b2Body const& body)
+{
+	duk_get_prop_string(pContext, bodyIdx, g_ownWorldPropSym);
+	auto* const pSerials = getSerialsAt(pContext, -1);
+	duk_pop(pContext);
+	if (pSerials)
+	{
+		pSerials->forget(body);
+	}
+}
+
+
+duk_ret_t
+finalizer(duk_context* pContext)
+{
+	duk_get_prop_string(pContext, 0, g_ownWorldPtrSym);
+	auto* const pWorld = static_cast<b2World*>(duk_get_pointer(pContext, 1));
+	duk_pop(pContext);
+
+	// Destroying the world frees the bodies, so detach it first.
+	detach(pContext, 0);
+	delete pWorld;
 	return 0;
 }
 
@@ -158,9 +325,76 @@ methods::getGravity(duk_context* pContext)
 }
 
 
+/**
+ * Push a `Body` object for a body newly created in a world.
+ *
+ * @param pContext the duktape context.
+ * @param worldIdx the value stack index of the owning `World` object.
+ * @param lifetime how the body should be destroyed.
+ * @param pBody the new body, or `nullptr` if the world was locked, which
+ * throws an `Error`.
+ * @returns the value stack index of the new `Body` object.
+ */
+static duk_idx_t
+pushBodyOfWorld(
+	duk_context* pContext,
+	duk_idx_t worldIdx,
+	BodyLifetime lifetime,
+	std::unique_ptr<b2Body, util::B2Deleter> pBody
+)
+{
+	if (!pBody)
+	{
+		duk_error(pContext, DUK_ERR_ERROR, "World is locked");
+	}
+
+	// Numbered while still owned here, so that a failure destroys it.
+	requireSerialsAt(pContext, worldIdx).issue(*pBody);
+
+	auto const bodyIdx = lifetime == BodyLifetime::worldOwned
+		?	body::pushBodyWithoutFinalizer(pContext, pBody.get())
+		:	body::pushBodyWithFinalizer(pContext, pBody.get());
+	pBody.release();
+
+	duk_dup(pContext, worldIdx);
+	duk_put_prop_string(pContext, bodyIdx, g_ownWorldPropSym);
+	return bodyIdx;
+}
+
+
+/**
+ * Create a body in a world and push its `Body` object.
+ *
+ * @param pContext the duktape context.
+ * @param pWorld the world to create the body in.
+ * @param worldIdx the value stack index of the owning `World` object.
+ * @param lifetime how the body should be destroyed.
+ * @param bodyDef the body definition.
+ * @returns the value stack index of the new `Body` object.
+ */
+static duk_idx_t
+pushNewBody(
+	duk_context* pContext,
+	b2World* pWorld,
+	duk_idx_t worldIdx,
+	BodyLifetime lifetime,
+	b2BodyDef const& bodyDef
+)
+{
+	std::unique_ptr<b2Body, util::B2Deleter> pBody{
+		pWorld->CreateBody(&bodyDef)};
+	if (pBody && bodyDef.type == b2_staticBody)
+	{
+		bumpStaticVersion(pContext);
+	}
+	return pushBodyOfWorld(pContext, worldIdx, lifetime, std::move(pBody));
+}
+
+
 duk_ret_t
 methods::createBody(duk_context* pContext)
 {
+	DUKDEMO_TRACE_SCOPE("script", "World.createBody");
 	// Stack: [bodyDef].
 	b2BodyDef bodyDef;
 	if (!loadBodyDef(pContext, 0, &bodyDef))
@@ -169,30 +403,262 @@ methods::createBody(duk_context* pContext)
 	}
 	duk_pop(pContext); // [].
 
-	duk_push_this(pContext);
-	duk_get_prop_string(pContext, -1, g_ownWorldPtrSym);
-	auto* const pWorld = static_cast<b2World*>(duk_get_pointer(pContext, -1));
-	duk_pop(pContext); // Stack: [world].
+	duk_push_this(pContext); // Stack: [world].
+	auto* const pWorld = getWorldPtrAt(pContext, 0);
+
+	auto const lifetime = getBodyLifetime(pContext, 0);
+	pushNewBody(pContext, pWorld, 0, lifetime, bodyDef); // [world, body].
+	return 1;
+}
+
+
+/** The most bodies `createBodies` creates at once. */
+constexpr duk_size_t maxBodiesPerBatch{1u << 16u};
 
-	std::unique_ptr<b2Body, util::B2Deleter> pBody{
-		pWorld->CreateBody(&bodyDef)};
-	body::pushBodyWithFinalizer(pContext, pBody.get());
-	pBody.release(); // Stack: [world, body].
 
-	duk_swap_top(pContext, -2); // Stack: [body, world].
-	duk_put_prop_string(pContext, -2, "world");
-	return 1; // Stack: [body].
+duk_ret_t
+methods::createBodies(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "World.createBodies");
+	// Stack: [bodyDefs].
+	if (!duk_is_array(pContext, 0))
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+
+	// The length is the script's to choose, so check it before sizing
+	// anything by it.
+	auto const length = duk_get_length(pContext, 0);
+	if (length > maxBodiesPerBatch)
+	{
+		return DUK_RET_RANGE_ERROR;
+	}
+
+	// Load every definition before creating anything, so that an invalid
+	// definition leaves the world untouched.
+	auto const count = duk_idx_t(length);
+	b2BodyDef const defaultDef;
+	std::vector<b2BodyDef> bodyDefs(count, defaultDef);
+	for (duk_idx_t i = 0; i < count; ++i)
+	{
+		duk_get_prop_index(pContext, 0, duk_uarridx_t(i));
+		bool const valid = loadBodyDef(pContext, -1, &bodyDefs[i]);
+		duk_pop(pContext);
+		if (!valid)
+		{
+			return DUK_RET_TYPE_ERROR;
+		}
+	}
+	duk_pop(pContext); // [].
+
+	duk_push_this(pContext); // Stack: [world].
+	auto* const pWorld = getWorldPtrAt(pContext, 0);
+
+	// Reserve room for every body, then pack them into the result array.
+	auto const lifetime = getBodyLifetime(pContext, 0);
+	duk_require_stack(pContext, count);
+	for (auto const& bodyDef: bodyDefs)
+	{
+		pushNewBody(pContext, pWorld, 0, lifetime, bodyDef);
+	}
+	duk_pack(pContext, count); // Stack: [world, bodies].
+	return 1;
+}
+
+
+duk_ret_t
+compilePrefab(duk_context* pContext)
+{
+	// Stack: [prefabDef].
+	auto pPrefab = std::make_unique<Prefab>();
+	if (!loadPrefab(pContext, 0, pPrefab.get()))
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+	prefab::pushPrefab(pContext, std::move(pPrefab));
+	return 1;
+}
+
+
+duk_ret_t
+methods::spawn(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "World.spawn");
+	// Stack: [prefab, x, y, angle].
+	auto const* const pPrefab = prefab::getPrefabPtrAt(pContext, 0);
+	if (!pPrefab)
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+	auto const& bodyDef = pPrefab->bodyDef;
+	b2Vec2 const position{
+		float(duk_get_number_default(pContext, 1, bodyDef.position.x)),
+		float(duk_get_number_default(pContext, 2, bodyDef.position.y))
+	};
+	auto const angle =
+		float(duk_get_number_default(pContext, 3, bodyDef.angle));
+	duk_pop_n(pContext, 4); // [].
+
+	duk_push_this(pContext); // Stack: [world].
+	auto* const pWorld = getWorldPtrAt(pContext, 0);
+
+	std::unique_ptr<b2Body, util::B2Deleter> pBody{
+		createBodyFromPrefab(*pWorld, *pPrefab, position, angle)};
+	if (pBody && bodyDef.type == b2_staticBody)
+	{
+		bumpStaticVersion(pContext);
+	}
+	auto const lifetime = getBodyLifetime(pContext, 0);
+	pushBodyOfWorld(pContext, 0, lifetime, std::move(pBody)); // [world, body].
+	return 1;
 }
 
 
 duk_ret_t
 methods::destroyBody(duk_context* pContext)
 {
+	DUKDEMO_TRACE_SCOPE("script", "World.destroyBody");
 	body::destroyBodyAt(pContext, 0);
 	return 0;
 }
 
 
+duk_ret_t
+methods::readTransforms(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "World.readTransforms");
+	// Stack: [array, withVelocities].
+	duk_get_global_string(pContext, "Float32Array");
+	if (!duk_instanceof(pContext, 0, -1))
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+	duk_pop(pContext);
+
+	duk_size_t byteLength = 0u;
+	auto* const pData = static_cast<float*>(
+		duk_get_buffer_data(pContext, 0, &byteLength));
+	bool const withVelocities = duk_get_boolean(pContext, 1);
+
+	duk_size_t const stride = withVelocities ? 6u : 3u;
+	duk_size_t const capacity = byteLength / (stride * sizeof(float));
+
+	auto* const pWorld = getOwnWorldPtr(pContext);
+	float* pOut = pData;
+	duk_size_t written = 0u;
+	for (
+		b2Body const* pBody = pWorld->GetBodyList();
+		pBody != nullptr && written < capacity;
+		pBody = pBody->GetNext(), ++written
+	)
+	{
+		b2Vec2 const& position = pBody->GetPosition();
+		pOut[0] = position.x;
+		pOut[1] = position.y;
+		pOut[2] = pBody->GetAngle();
+		if (withVelocities)
+		{
+			b2Vec2 const& velocity = pBody->GetLinearVelocity();
+			pOut[3] = velocity.x;
+			pOut[4] = velocity.y;
+			pOut[5] = pBody->GetAngularVelocity();
+		}
+		pOut += stride;
+	}
+
+	duk_push_int(pContext, pWorld->GetBodyCount());
+	return 1;
+}
+
+
+/**
+ * Identifies a world's bodies in its states by their serials, and
+ * invalidates the handles of bodies a restore destroys.
+ */
+class WorldIds: public scene::BodyIds
+{
+public:
+	WorldIds(scene::BodySerials& serials, BodyTable& table)
+		:	m_serials(serials)
+		,	m_table(table)
+	{
+	}
+
+	std::uint64_t
+	idOf(b2Body const& body) override
+	{ return m_serials.idOf(body); }
+
+	void
+	assign(b2Body const& body, std::uint64_t id) override
+	{ m_serials.assign(body, id); }
+
+	void
+	forget(b2Body const& body) override
+	{
+		m_serials.forget(body);
+		m_table.remove(m_table.find(&body));
+	}
+
+private:
+	scene::BodySerials& m_serials;
+	BodyTable& m_table;
+};
+
+
+/** Get a heap's body table, throwing if it has none. */
+static BodyTable&
+requireBodyTable(duk_context* pContext)
+{
+	auto* const pTable = getBodyTable(pContext);
+	if (!pTable)
+	{
+		duk_error(pContext, DUK_ERR_ERROR, "Heap has no body table");
+	}
+	return *pTable;
+}
+
+
+duk_ret_t
+methods::snapshot(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "World.snapshot");
+	duk_push_this(pContext); // Stack: [world].
+	auto const* const pWorld = getWorldPtrAt(pContext, 0);
+	WorldIds ids{requireSerialsAt(pContext, 0), requireBodyTable(pContext)};
+
+	// Written in place, so capturing allocates nothing but the buffer.
+	auto const size = scene::worldStateSize(*pWorld);
+	auto* const pData = duk_push_fixed_buffer(pContext, size);
+	scene::saveWorldState(*pWorld, ids, pData, size);
+	return 1;
+}
+
+
+duk_ret_t
+methods::restore(duk_context* pContext)
+{
+	DUKDEMO_TRACE_SCOPE("script", "World.restore");
+	// Stack: [state].
+	if (!duk_is_buffer_data(pContext, 0))
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+	duk_size_t size = 0u;
+	auto const* const pData = duk_get_buffer_data(pContext, 0, &size);
+
+	duk_push_this(pContext); // Stack: [state, world].
+	auto* const pWorld = getWorldPtrAt(pContext, 1);
+	WorldIds ids{requireSerialsAt(pContext, 1), requireBodyTable(pContext)};
+	if (!scene::restoreWorldState(*pWorld, pData, size, ids))
+	{
+		return DUK_RET_TYPE_ERROR;
+	}
+	// Static bodies may have been moved, replaced or changed type.
+	bumpStaticVersion(pContext);
+	return 0;
+}
+
+
 duk_ret_t
 methods::toString(duk_context* pContext)
 {
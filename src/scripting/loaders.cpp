@@ -1,6 +1,9 @@
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <limits>
+#include <memory>
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
@@ -13,28 +16,211 @@
 
 #include <duktape.h>
 
+#include "dukdemo/scripting/EnumTable.h"
 #include "dukdemo/scripting/loaders.h"
+#include "dukdemo/scripting/Schema.h"
+#include "dukdemo/scripting/util.h"
 
 
 namespace dukdemo {
 namespace scripting {
 
 
-constexpr char const* const shapeTypeNames[] = {
+constexpr auto shapeTypeTable = makeEnumTable({
 	"circle",
 	"edge",
 	"polygon",
 	"chain",
-};
-constexpr duk_uint_t shapeTypeCount = 4u;
+});
+constexpr EnumNames shapeTypes = enumNames<shapeTypeTable>();
 
 
-constexpr char const* const bodyTypeNames[] = {
+constexpr auto bodyTypeTable = makeEnumTable({
 	"static",
 	"kinematic",
 	"dynamic",
+});
+constexpr EnumNames bodyTypes = enumNames<bodyTypeTable>();
+
+
+// Shape types are decoded straight into b2Shape::Type.
+static_assert(
+	shapeTypeTable.names.size() == b2Shape::e_typeCount,
+	"Every shape type must be named"
+);
+
+
+// Enumerated fields are stored as an `int`.
+static_assert(
+	sizeof(b2BodyType) == sizeof(int),
+	"b2BodyType must be the size of an int"
+);
+
+
+constexpr auto bodyDefSchema = makeSchema({
+	{"type", offsetof(b2BodyDef, type), FieldType::Enum, &bodyTypes},
+	{"position", offsetof(b2BodyDef, position), FieldType::Vec2},
+	{"linearVelocity", offsetof(b2BodyDef, linearVelocity), FieldType::Vec2},
+	{"angle", offsetof(b2BodyDef, angle), FieldType::Float},
+	{
+		"angularVelocity", offsetof(b2BodyDef, angularVelocity),
+		FieldType::Float,
+	},
+	{"linearDamping", offsetof(b2BodyDef, linearDamping), FieldType::Float},
+	{"angularDamping", offsetof(b2BodyDef, angularDamping), FieldType::Float},
+	{"allowSleep", offsetof(b2BodyDef, allowSleep), FieldType::Bool},
+	{"awake", offsetof(b2BodyDef, awake), FieldType::Bool},
+	{"fixedRotation", offsetof(b2BodyDef, fixedRotation), FieldType::Bool},
+	{"bullet", offsetof(b2BodyDef, bullet), FieldType::Bool},
+	{"active", offsetof(b2BodyDef, active), FieldType::Bool},
+	{"gravityScale", offsetof(b2BodyDef, gravityScale), FieldType::Float},
+});
+
+
+constexpr auto filterSchema = makeSchema({
+	{"categoryBits", offsetof(b2Filter, categoryBits), FieldType::Uint16},
+	{"maskBits", offsetof(b2Filter, maskBits), FieldType::Uint16},
+	{"groupIndex", offsetof(b2Filter, groupIndex), FieldType::Int16},
+});
+
+
+/** The filter's properties sit on the fixture def itself. */
+constexpr auto fixtureDefSchema = makeSchema({
+	{
+		"categoryBits", offsetof(b2FixtureDef, filter.categoryBits),
+		FieldType::Uint16,
+	},
+	{
+		"maskBits", offsetof(b2FixtureDef, filter.maskBits),
+		FieldType::Uint16,
+	},
+	{
+		"groupIndex", offsetof(b2FixtureDef, filter.groupIndex),
+		FieldType::Int16,
+	},
+	{"friction", offsetof(b2FixtureDef, friction), FieldType::Float},
+	{"restitution", offsetof(b2FixtureDef, restitution), FieldType::Float},
+	{"density", offsetof(b2FixtureDef, density), FieldType::Float},
+	{"isSensor", offsetof(b2FixtureDef, isSensor), FieldType::Bool},
+});
+
+
+// Vertices read from a Float32Array are handed to Box2D in place.
+static_assert(
+	sizeof(b2Vec2) == 2 * sizeof(float),
+	"b2Vec2 must be two packed floats"
+);
+
+
+/** Coordinates held in a `Float32Array` or `Float64Array`. */
+struct CoordBuffer
+{
+	float const* pFloats;
+	double const* pDoubles;
+	duk_size_t count;
 };
-constexpr duk_uint_t bodyTypeCount = 3u;
+
+
+/**
+ * Get the backing data of a `Float32Array` or `Float64Array`.
+ *
+ * The element type is taken from the object's own prototype, compared with
+ * the prototypes stashed by @ref createHeap, so replacing the global
+ * constructors has no effect. A script can still give another buffer one of
+ * those prototypes; its bytes are then read as floats, which is harmless as
+ * long as they are aligned and in bounds.
+ *
+ * @returns false if the value is not one of those typed arrays.
+ */
+bool
+getCoordBuffer(duk_context* pContext, duk_idx_t idx, CoordBuffer* pCoords)
+	noexcept
+{
+	if (!duk_is_buffer_data(pContext, idx) || !duk_is_object(pContext, idx))
+	{
+		return false;
+	}
+	idx = duk_normalize_index(pContext, idx);
+
+	duk_size_t byteLength = 0u;
+	void const* const pData = duk_get_buffer_data(pContext, idx, &byteLength);
+	auto const address = reinterpret_cast<std::uintptr_t>(pData);
+
+	duk_get_prototype(pContext, idx);
+	duk_push_heap_stash(pContext);
+	duk_get_prop_string(pContext, -1, g_float32ProtoSym);
+	bool const isFloat32 = duk_strict_equals(pContext, -1, -3);
+	duk_get_prop_string(pContext, -2, g_float64ProtoSym);
+	bool const isFloat64 = duk_strict_equals(pContext, -1, -4);
+	duk_pop_n(pContext, 4);
+
+	if (isFloat32 && address % alignof(float) == 0u)
+	{
+		pCoords->pFloats = static_cast<float const*>(pData);
+		pCoords->pDoubles = nullptr;
+		pCoords->count = byteLength / sizeof(float);
+		return true;
+	}
+	if (isFloat64 && address % alignof(double) == 0u)
+	{
+		pCoords->pFloats = nullptr;
+		pCoords->pDoubles = static_cast<double const*>(pData);
+		pCoords->count = byteLength / sizeof(double);
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * Check that every value is finite.
+ *
+ * `x - x` is zero for finite values and NaN otherwise. Accumulating without
+ * branching lets the compiler vectorise the loop.
+ */
+template <typename Float>
+bool
+allFinite(Float const* pValues, duk_size_t count) noexcept
+{
+	bool finite = true;
+	for (duk_size_t i = 0u; i < count; ++i)
+	{
+		finite &= (pValues[i] - pValues[i] == Float(0));
+	}
+	return finite;
+}
+
+
+/** Check that the first `count` coordinates are finite. */
+bool
+allFinite(CoordBuffer const& coords, duk_size_t count) noexcept
+{
+	return coords.pFloats
+		?	allFinite(coords.pFloats, count)
+		:	allFinite(coords.pDoubles, count);
+}
+
+
+/** Copy the first `count` vertices out of a coordinate buffer. */
+void
+copyVertices(CoordBuffer const& coords, b2Vec2* pVertices, duk_size_t count)
+	noexcept
+{
+	if (coords.pFloats)
+	{
+		std::memcpy(
+			static_cast<void*>(pVertices),
+			coords.pFloats,
+			count * sizeof(b2Vec2));
+		return;
+	}
+	for (duk_size_t i = 0u; i < count; ++i)
+	{
+		pVertices[i].Set(
+			float(coords.pDoubles[2 * i]),
+			float(coords.pDoubles[2 * i + 1]));
+	}
+}
 
 
 bool
@@ -42,7 +228,16 @@ loadVec2(duk_context* pContext, duk_idx_t vecIdx, b2Vec2* pVec) noexcept
 {
 	if (!duk_is_array(pContext, vecIdx))
 	{
-		return false;
+		CoordBuffer coords{nullptr, nullptr, 0u};
+		bool const valid =
+			getCoordBuffer(pContext, vecIdx, &coords) &&
+			coords.count >= 2u &&
+			allFinite(coords, 2u);
+		if (valid)
+		{
+			copyVertices(coords, pVec, 1u);
+		}
+		return valid;
 	}
 
 	duk_get_prop_index(pContext, vecIdx, 0);
@@ -214,47 +409,24 @@ loadOptionalBoolProp(
 }
 
 
-duk_uint_t
-lookupName(
-	char const* const pCandidate,
-	char const* const* const pNameTable,
-	duk_uint_t const tableSize
-)
-	noexcept
+SchemaField const*
+findBodyDefField(char const* pName, std::size_t length) noexcept
 {
-	for (duk_uint_t i = 0u; i < tableSize; ++i)
-	{
-		if (std::strcmp(pCandidate, pNameTable[i]) == 0)
-		{
-			return i;
-		}
-	}
-	return tableSize;
+	return findField<bodyDefSchema>(pName, length);
 }
 
 
-duk_uint_t
-getEnum(
-	duk_context* pContext,
-	duk_idx_t idx,
-	char const* const* const pNameTable,
-	duk_uint_t tableSize
-)
-	noexcept
+SchemaField const*
+findFixtureDefField(char const* pName, std::size_t length) noexcept
 {
-	if (duk_is_number(pContext, idx))
-	{
-		auto const type = duk_get_uint_default(pContext, idx, tableSize);
-		return (0 <= type && type < tableSize) ? type : tableSize;
-	}
+	return findField<fixtureDefSchema>(pName, length);
+}
 
-	if (duk_is_string(pContext, idx))
-	{
-		char const* const pType = duk_get_string(pContext, idx);
-		return std::min(lookupName(pType, pNameTable, tableSize), tableSize);
-	}
 
-	return bodyTypeCount;
+EnumNames const&
+getShapeTypeNames() noexcept
+{
+	return shapeTypes;
 }
 
 
@@ -269,40 +441,7 @@ loadBodyDef(duk_context* pContext, duk_idx_t defIdx, b2BodyDef* pDef)
 
 	b2BodyDef tmp;
 	std::memcpy(&tmp, pDef, sizeof(b2BodyDef));
-
-	if (duk_get_prop_string(pContext, defIdx, "type"))
-	{
-		auto const type = getEnum(pContext, -1, bodyTypeNames, bodyTypeCount);
-		if (type == bodyTypeCount)
-		{
-			duk_pop(pContext);
-			return false;
-		}
-		tmp.type = static_cast<b2BodyType>(type);
-	}
-	duk_pop(pContext);
-
-	if (
-		loadOptionalVec2Prop(pContext, defIdx, "position", &tmp.position) &&
-		loadOptionalVec2Prop(
-			pContext, defIdx, "linearVelocity", &tmp.linearVelocity) &&
-		loadOptionalFloatProp(pContext, defIdx, "angle", &tmp.angle) &&
-		loadOptionalFloatProp(
-			pContext, defIdx, "angularVelocity", &tmp.angularVelocity) &&
-		loadOptionalFloatProp(
-			pContext, defIdx, "linearDamping", &tmp.linearDamping) &&
-		loadOptionalFloatProp(
-			pContext, defIdx, "angularDamping", &tmp.angularDamping) &&
-		loadOptionalBoolProp(
-			pContext, defIdx, "allowSleep", &tmp.allowSleep) &&
-		loadOptionalBoolProp(pContext, defIdx, "awake", &tmp.awake) &&
-		loadOptionalBoolProp(
-			pContext, defIdx, "fixedRotation", &tmp.fixedRotation) &&
-		loadOptionalBoolProp(pContext, defIdx, "bullet", &tmp.bullet) &&
-		loadOptionalBoolProp(pContext, defIdx, "active", &tmp.active) &&
-		loadOptionalFloatProp(
-			pContext, defIdx, "gravityScale", &tmp.gravityScale)
-	)
+	if (loadSchemaFields(pContext, defIdx, findField<bodyDefSchema>, &tmp))
 	{
 		std::memcpy(pDef, &tmp, sizeof(b2BodyDef));
 		return true;
@@ -319,15 +458,10 @@ loadFilter(duk_context* pContext, duk_idx_t index, b2Filter* pFilter)
 	{
 		return false;
 	}
+
 	b2Filter tmp;
 	std::memcpy(&tmp, pFilter, sizeof(b2Filter));
-
-	if (
-		loadOptionalUint16Prop(
-			pContext, index, "categoryBits", &tmp.categoryBits) &&
-		loadOptionalUint16Prop(pContext, index, "maskBits", &tmp.maskBits) &&
-		loadOptionalInt16Prop(pContext, index, "groupIndex", &tmp.groupIndex)
-	)
+	if (loadSchemaFields(pContext, index, findField<filterSchema>, &tmp))
 	{
 		std::memcpy(pFilter, &tmp, sizeof(b2Filter));
 		return true;
@@ -351,14 +485,7 @@ loadFixtureDefWithoutShape(
 
 	b2FixtureDef tmp;
 	std::memcpy(&tmp, pDef, sizeof(b2FixtureDef));
-	if (
-		loadFilter(pContext, index, &tmp.filter) &&
-		loadOptionalFloatProp(pContext, index, "friction", &tmp.friction) &&
-		loadOptionalFloatProp(
-			pContext, index, "restitution", &tmp.restitution) &&
-		loadOptionalFloatProp(pContext, index, "density", &tmp.density) &&
-		loadOptionalBoolProp(pContext, index, "isSensor", &tmp.isSensor)
-	)
+	if (loadSchemaFields(pContext, index, findField<fixtureDefSchema>, &tmp))
 	{
 		std::memcpy(pDef, &tmp, sizeof(b2FixtureDef));
 		return true;
@@ -367,6 +494,21 @@ loadFixtureDefWithoutShape(
 }
 
 
+b2Shape::Type
+getShapeType(duk_context* pContext, duk_idx_t shapeIdx) noexcept
+{
+	if (!duk_is_object(pContext, shapeIdx))
+	{
+		return b2Shape::e_typeCount;
+	}
+
+	duk_get_prop_string(pContext, shapeIdx, "type");
+	auto const type = getEnum(pContext, -1, shapeTypes);
+	duk_pop(pContext);
+	return static_cast<b2Shape::Type>(type);
+}
+
+
 bool
 loadCircle(
 	duk_context* pContext,
@@ -404,7 +546,7 @@ loadVertexArray(
 	for (duk_idx_t i = 0ul; i < count; ++i)
 	{
 		duk_get_prop_index(pContext, arrayIdx, i);
-		bool valid = loadVec2(pContext, arrayIdx, pVertices + i);
+		bool valid = loadVec2(pContext, -1, pVertices + i);
 		duk_pop(pContext);
 		if (!valid)
 		{
@@ -415,6 +557,79 @@ loadVertexArray(
 }
 
 
+bool
+validatePolygonVertices(b2Vec2 const* pVertices, std::size_t count) noexcept
+{
+	if (count < 3u || count > std::size_t(b2_maxPolygonVertices))
+	{
+		return false;
+	}
+
+	// Weld close vertices as `Set` does.
+	constexpr float weldDistanceSquared =
+		0.25f * b2_linearSlop * b2_linearSlop;
+	b2Vec2 welded[b2_maxPolygonVertices];
+	std::size_t weldedCount = 0u;
+	for (std::size_t i = 0u; i < count; ++i)
+	{
+		bool unique = true;
+		for (std::size_t j = 0u; unique && j < weldedCount; ++j)
+		{
+			unique = b2DistanceSquared(pVertices[i], welded[j]) >=
+				weldDistanceSquared;
+		}
+		if (unique)
+		{
+			welded[weldedCount++] = pVertices[i];
+		}
+	}
+
+	// The hull's area is at least that of any triangle of its vertices.
+	for (std::size_t i = 1u; i < weldedCount; ++i)
+	{
+		for (std::size_t j = i + 1u; j < weldedCount; ++j)
+		{
+			auto const doubleArea = b2Cross(
+				welded[i] - welded[0], welded[j] - welded[0]);
+			if (std::fabs(doubleArea) > 2.0f * b2_epsilon)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+bool
+validateChainVertices(
+	b2Vec2 const* pVertices,
+	std::size_t count,
+	bool isLoop
+)
+	noexcept
+{
+	constexpr float minDistanceSquared = b2_linearSlop * b2_linearSlop;
+	if (count < (isLoop ? 3u : 2u))
+	{
+		return false;
+	}
+	for (std::size_t i = 1u; i < count; ++i)
+	{
+		if (
+			b2DistanceSquared(pVertices[i - 1u], pVertices[i]) <=
+			minDistanceSquared
+		)
+		{
+			return false;
+		}
+	}
+	return !isLoop ||
+		b2DistanceSquared(pVertices[count - 1u], pVertices[0]) >
+		minDistanceSquared;
+}
+
+
 bool
 loadPolygon(
 	duk_context* pContext,
@@ -431,18 +646,39 @@ loadPolygon(
 	bool valid = duk_get_prop_string(pContext, polygonIdx, "vertices");
 	if (valid)
 	{
-		valid = duk_is_array(pContext, -1);
+		b2Vec2 vertices[b2_maxPolygonVertices];
+		duk_size_t len = 0u;
+		CoordBuffer coords{nullptr, nullptr, 0u};
+		if (getCoordBuffer(pContext, -1, &coords))
+		{
+			len = coords.count / 2u;
+			valid =
+				coords.count % 2u == 0u &&
+				(3 <= len && len <= b2_maxPolygonVertices) &&
+				allFinite(coords, coords.count);
+			if (valid)
+			{
+				copyVertices(coords, &vertices[0], len);
+			}
+		}
+		else
+		{
+			valid = duk_is_array(pContext, -1);
+			len = valid ? duk_get_length(pContext, -1) : 0u;
+			valid = valid &&
+				(3 <= len && len <= b2_maxPolygonVertices) &&
+				loadVertexArray(pContext, -1, &vertices[0], len);
+		}
 
+		valid = valid && validatePolygonVertices(&vertices[0], len);
 		if (valid)
 		{
-			b2Vec2 vertices[b2_maxPolygonVertices];
-			duk_size_t const len = duk_get_length(pContext, -1);
-			valid = (0 < len && len < b2_maxPolygonVertices);
-
-			valid &= loadVertexArray(pContext, polygonIdx, &vertices[0], len);
+			b2PolygonShape tmp;
+			tmp.Set(vertices, len);
+			valid = tmp.Validate();
 			if (valid)
 			{
-				pShape->Set(vertices, len);
+				*pShape = tmp;
 			}
 		}
 	}
@@ -484,26 +720,50 @@ loadEdge(
 bool
 loadChain(duk_context* pContext, duk_idx_t idx, b2ChainShape* pShape)
 {
-	// Get vertices property.
-	bool valid =
-		duk_get_prop_string(pContext, idx, "vertices") &&
-		duk_is_array(pContext, -1);
+	// Get vertices property. It stays on the stack until the chain has been
+	// created, as vertices from a Float32Array are read in place.
+	bool valid = duk_get_prop_string(pContext, idx, "vertices");
 
-	std::unique_ptr<b2Vec2[]> pVertices;
+	std::unique_ptr<b2Vec2[]> pOwnedVertices;
+	b2Vec2 const* pVertices = nullptr;
 	duk_size_t len = 0ul;
-	if (valid)
+	CoordBuffer coords{nullptr, nullptr, 0u};
+	if (valid && getCoordBuffer(pContext, -1, &coords))
+	{
+		len = coords.count / 2u;
+		valid = len > 0 &&
+			coords.count % 2u == 0u &&
+			allFinite(coords, coords.count);
+		if (valid && coords.pFloats)
+		{
+			pVertices = reinterpret_cast<b2Vec2 const*>(coords.pFloats);
+		}
+		else if (valid)
+		{
+			pOwnedVertices = std::make_unique<b2Vec2[]>(len);
+			copyVertices(coords, &pOwnedVertices[0], len);
+			pVertices = pOwnedVertices.get();
+		}
+	}
+	else if (valid && duk_is_array(pContext, -1))
 	{
 		len = duk_get_length(pContext, -1);
 		valid = (len > 0);
 		if (valid)
 		{
-			pVertices = std::make_unique<b2Vec2[]>(len);
-			valid = loadVertexArray(pContext, -1, &pVertices[0], len);
+			pOwnedVertices = std::make_unique<b2Vec2[]>(len);
+			valid = loadVertexArray(pContext, -1, &pOwnedVertices[0], len);
+			pVertices = pOwnedVertices.get();
 		}
 	}
-	duk_pop(pContext); // Pop `vertices`.
+	else
+	{
+		valid = false;
+	}
+
 	if (!valid)
 	{
+		duk_pop(pContext); // Pop `vertices`.
 		return false;
 	}
 
@@ -512,15 +772,21 @@ loadChain(duk_context* pContext, duk_idx_t idx, b2ChainShape* pShape)
 		duk_get_prop_string(pContext, idx, "loop") &&
 		duk_get_boolean(pContext, -1);
 	duk_pop(pContext); // Pop `loop`.
+	if (!validateChainVertices(pVertices, len, isLoop))
+	{
+		duk_pop(pContext); // Pop `vertices`.
+		return false;
+	}
 	if (isLoop)
 	{
-		pShape->CreateLoop(pVertices.get(), len);
+		pShape->CreateLoop(pVertices, len);
+		duk_pop(pContext); // Pop `vertices`.
 		return true;
 	}
 
 	// Load previous vertex.
 	b2Vec2 prev;
-	auto const hasPrev = duk_get_prop_string(pContext, -1, "prev");
+	auto const hasPrev = duk_get_prop_string(pContext, idx, "prev");
 	if (hasPrev)
 	{
 		valid = loadVec2(pContext, -1, &prev);
@@ -528,7 +794,7 @@ loadChain(duk_context* pContext, duk_idx_t idx, b2ChainShape* pShape)
 	duk_pop(pContext);
 
 	// Load next vertex.
-	auto const hasNext = duk_get_prop_string(pContext, -1, "next");
+	auto const hasNext = duk_get_prop_string(pContext, idx, "next");
 	b2Vec2 next;
 	if (hasNext)
 	{
@@ -538,7 +804,7 @@ loadChain(duk_context* pContext, duk_idx_t idx, b2ChainShape* pShape)
 
 	if (valid)
 	{
-		pShape->CreateChain(pVertices.get(), len);
+		pShape->CreateChain(pVertices, len);
 		if (hasPrev)
 		{
 			pShape->SetPrevVertex(prev);
@@ -548,10 +814,64 @@ loadChain(duk_context* pContext, duk_idx_t idx, b2ChainShape* pShape)
 			pShape->SetNextVertex(next);
 		}
 	}
+	duk_pop(pContext); // Pop `vertices`.
 
 	return valid;
 }
 
 
+std::unique_ptr<b2Shape>
+loadShape(duk_context* pContext, duk_idx_t idx)
+{
+	idx = duk_normalize_index(pContext, idx);
+	switch (getShapeType(pContext, idx))
+	{
+		case b2Shape::e_circle:
+		{
+			auto pShape = std::make_unique<b2CircleShape>();
+			if (loadCircle(pContext, idx, pShape.get()))
+			{
+				return std::move(pShape);
+			}
+			break;
+		}
+
+		case b2Shape::e_edge:
+		{
+			auto pShape = std::make_unique<b2EdgeShape>();
+			if (loadEdge(pContext, idx, pShape.get()))
+			{
+				return std::move(pShape);
+			}
+			break;
+		}
+
+		case b2Shape::e_polygon:
+		{
+			auto pShape = std::make_unique<b2PolygonShape>();
+			if (loadPolygon(pContext, idx, pShape.get()))
+			{
+				return std::move(pShape);
+			}
+			break;
+		}
+
+		case b2Shape::e_chain:
+		{
+			auto pShape = std::make_unique<b2ChainShape>();
+			if (loadChain(pContext, idx, pShape.get()))
+			{
+				return std::move(pShape);
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+	return nullptr;
+}
+
+
 } // namespace scripting
 } // namespace dukdemo
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <cmath>
+
+#include "dukdemo/sim/FixedStepClock.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+FixedStepClock::FixedStepClock(
+	double stepSeconds,
+	unsigned maxStepsPerAdvance
+) noexcept
+	:	m_stepSeconds{stepSeconds}
+	,	m_accumulator{0.0}
+	,	m_maxStepsPerAdvance{maxStepsPerAdvance}
+	,	m_droppedSteps{0u}
+{
+}
+
+
+unsigned
+FixedStepClock::advance(double elapsedSeconds) noexcept
+{
+	m_accumulator += std::max(elapsedSeconds, 0.0);
+	auto const due = std::floor(m_accumulator / m_stepSeconds);
+	m_accumulator = std::max(m_accumulator - due * m_stepSeconds, 0.0);
+
+	auto const steps = std::min(due, double(m_maxStepsPerAdvance));
+	m_droppedSteps += std::size_t(due - steps);
+	return unsigned(steps);
+}
+
+
+} // namespace sim
+} // namespace dukdemo
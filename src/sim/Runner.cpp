@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/Runner.h"
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+using Clock = std::chrono::steady_clock;
+
+
+double
+RunStats::stepsPerSecond() const noexcept
+{
+	return elapsedSeconds > 0.0 ? double(steps()) / elapsedSeconds : 0.0;
+}
+
+
+double
+RunStats::percentile(double percent) const
+{
+	if (stepSeconds.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector<double> sorted{stepSeconds};
+	std::sort(sorted.begin(), sorted.end());
+	auto const rank = std::ceil(percent / 100.0 * double(sorted.size()));
+	auto const index = std::size_t(std::max(rank, 1.0)) - 1u;
+	return sorted[std::min(index, sorted.size() - 1u)];
+}
+
+
+RunStats
+runFixedSteps(
+	b2World& world,
+	RunOptions const& options,
+	StepFn const& beforeStep,
+	StepFn const& afterStep
+)
+{
+	// Don't reserve unbounded memory when running until a deadline.
+	constexpr std::size_t maxReserve = 1u << 20u;
+	RunStats stats;
+	stats.stepSeconds.reserve(std::min(options.maxSteps, maxReserve));
+
+	bool const hasDeadline = options.deadline.count() > 0.0;
+	auto const start = Clock::now();
+	auto const deadline =
+		start + std::chrono::duration_cast<Clock::duration>(options.deadline);
+
+	auto* const pProfiler = options.pProfiler;
+	std::size_t scriptPhase{0u};
+	std::size_t stepPhase{0u};
+	if (pProfiler)
+	{
+		scriptPhase = pProfiler->addPhase("script");
+		stepPhase = pProfiler->addPhase("step");
+	}
+
+	auto stepStart = start;
+	for (std::size_t i = 0u; i < options.maxSteps; ++i)
+	{
+		if (beforeStep)
+		{
+			DUKDEMO_TRACE_SCOPE("sim", "beforeStep");
+			util::FrameProfiler::ScopedTimer timer{pProfiler, scriptPhase};
+			beforeStep(i);
+		}
+		{
+			DUKDEMO_TRACE_SCOPE("sim", "step");
+			util::FrameProfiler::ScopedTimer timer{pProfiler, stepPhase};
+			world.Step(
+				options.timeStep,
+				options.velocityIterations,
+				options.positionIterations
+			);
+		}
+		if (afterStep)
+		{
+			afterStep(i);
+		}
+
+		auto const stepEnd = Clock::now();
+		stats.stepSeconds.push_back(
+			std::chrono::duration<double>(stepEnd - stepStart).count());
+		stepStart = stepEnd;
+		if (pProfiler)
+		{
+			pProfiler->endFrame();
+		}
+
+		if (hasDeadline && stepEnd >= deadline)
+		{
+			break;
+		}
+	}
+
+	stats.elapsedSeconds =
+		std::chrono::duration<double>(stepStart - start).count();
+	return stats;
+}
+
+
+} // namespace sim
+} // namespace dukdemo
@@ -0,0 +1,299 @@
+#include <chrono>
+#include <stdexcept>
+
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/SimulationThread.h"
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+using Clock = Snapshot::Clock;
+using Seconds = std::chrono::duration<double>;
+
+
+SimulationThread::SimulationThread(
+	b2World& world,
+	StepFn const& step,
+	double stepSeconds,
+	unsigned maxStepsPerAdvance,
+	PublishFn const& onPublish
+)
+	:	m_world(world)
+	,	m_step{step}
+	,	m_onPublish{onPublish}
+	,	m_clock{stepSeconds, maxStepsPerAdvance}
+	,	m_history{}
+	,	m_stepCount{0u}
+	,	m_staticVersion{1u}
+	,	m_pStaticGeometry{}
+	,	m_visibleBodies{}
+	,	m_snapshots{}
+	,	m_mutex{}
+	,	m_wake{}
+	,	m_running{false}
+	,	m_stopRequested{false}
+	,	m_paused{false}
+	,	m_requestedSteps{0u}
+	,	m_hasView{false}
+	,	m_viewChanged{false}
+	,	m_view()
+	,	m_pError{}
+	,	m_thread{}
+{
+}
+
+
+SimulationThread::~SimulationThread() noexcept
+{
+	try
+	{
+		stop();
+	}
+	catch (...)
+	{
+	}
+}
+
+
+void
+SimulationThread::start()
+{
+	if (m_thread.joinable())
+	{
+		throw std::logic_error{"Simulation thread already started"};
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_running = true;
+		m_stopRequested = false;
+		m_pError = nullptr;
+	}
+	m_thread = std::thread{&SimulationThread::run, this};
+}
+
+
+void
+SimulationThread::stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_stopRequested = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+
+	if (m_pError)
+	{
+		auto const pError = m_pError;
+		m_pError = nullptr;
+		std::rethrow_exception(pError);
+	}
+}
+
+
+bool
+SimulationThread::running() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_running;
+}
+
+
+void
+SimulationThread::setPaused(bool paused)
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_paused = paused;
+	}
+	m_wake.notify_one();
+}
+
+
+bool
+SimulationThread::paused() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_paused;
+}
+
+
+void
+SimulationThread::requestStep()
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		++m_requestedSteps;
+	}
+	m_wake.notify_one();
+}
+
+
+void
+SimulationThread::setView(b2AABB const& view)
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_hasView = true;
+		m_viewChanged = true;
+		m_view = view;
+	}
+	m_wake.notify_one();
+}
+
+
+void
+SimulationThread::clearView()
+{
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_hasView = false;
+		m_viewChanged = true;
+	}
+	m_wake.notify_one();
+}
+
+
+void
+SimulationThread::stepAndPublish(unsigned steps, bool paused)
+{
+	if (steps == 0u)
+	{
+		// Nothing moved, so nothing should be interpolated.
+		m_history.capture(m_world);
+	}
+	for (unsigned i = 0u; i < steps; ++i)
+	{
+		// Rendering interpolates from the state before the final step.
+		if (i + 1u == steps)
+		{
+			m_history.capture(m_world);
+		}
+		DUKDEMO_TRACE_SCOPE("sim", "step");
+		m_step();
+		++m_stepCount;
+	}
+
+	bool hasView{false};
+	b2AABB view;
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		hasView = m_hasView;
+		view = m_view;
+	}
+	if (hasView)
+	{
+		m_visibleBodies.query(m_world, view);
+	}
+
+	DUKDEMO_TRACE_SCOPE("sim", "capture");
+	auto& snapshot = m_snapshots.writeBuffer();
+	snapshot.capture(
+		m_world,
+		m_history,
+		m_pStaticGeometry,
+		m_staticVersion,
+		hasView ? &m_visibleBodies : nullptr);
+	m_pStaticGeometry = snapshot.pStaticGeometry;
+	snapshot.stepCount = m_stepCount;
+	snapshot.stepSeconds = m_clock.stepSeconds();
+	snapshot.paused = paused;
+
+	// Time left in the accumulator has passed since the latest step fell due.
+	auto const sinceStep =
+		paused ? 0.0 : m_clock.alpha() * m_clock.stepSeconds();
+	snapshot.stepTime =
+		Clock::now() - std::chrono::duration_cast<Clock::duration>(
+			Seconds{sinceStep});
+
+	m_snapshots.publish();
+	if (m_onPublish)
+	{
+		m_onPublish(snapshot);
+	}
+}
+
+
+void
+SimulationThread::run()
+{
+	DUKDEMO_TRACE_THREAD_NAME("simulation");
+	try
+	{
+		bool wasPaused = paused();
+		stepAndPublish(0u, wasPaused);
+
+		auto previous = Clock::now();
+		std::unique_lock<std::mutex> lock{m_mutex};
+		while (not m_stopRequested)
+		{
+			bool const isPaused = m_paused;
+			auto steps = isPaused ? m_requestedSteps : 0u;
+			bool const viewChanged = m_viewChanged;
+			m_requestedSteps = 0u;
+			m_viewChanged = false;
+			lock.unlock();
+
+			// Time spent paused isn't caught up on.
+			auto const now = Clock::now();
+			if (isPaused)
+			{
+				m_clock.reset();
+			}
+			else
+			{
+				auto const elapsed = Seconds{now - previous}.count();
+				steps = m_clock.advance(wasPaused ? 0.0 : elapsed);
+			}
+			previous = now;
+
+			if (steps > 0u
+				|| isPaused != wasPaused
+				|| (isPaused && viewChanged))
+			{
+				stepAndPublish(steps, isPaused);
+			}
+			wasPaused = isPaused;
+
+			lock.lock();
+			if (m_paused)
+			{
+				m_wake.wait(lock, [this] {
+					return m_stopRequested
+						|| !m_paused
+						|| m_requestedSteps > 0u
+						|| m_viewChanged;
+				});
+			}
+			else
+			{
+				m_wake.wait_for(
+					lock,
+					Seconds{m_clock.secondsUntilNextStep()},
+					[this] { return m_stopRequested || m_paused; });
+			}
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_pError = std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> lock{m_mutex};
+	m_running = false;
+}
+
+
+} // namespace sim
+} // namespace dukdemo
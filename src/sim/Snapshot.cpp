@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <utility>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/Snapshot.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+/** Append a shape's local geometry. */
+void
+appendShape(Snapshot::Geometry& geometry, b2Shape const& shape)
+{
+	Snapshot::Shape entry{
+		Snapshot::ShapeType::circle,
+		0.0f,
+		std::uint32_t(geometry.vertices.size()),
+		0u
+	};
+	auto& vertices = geometry.vertices;
+
+	switch (shape.GetType())
+	{
+		case b2Shape::e_circle:
+		{
+			auto const& circle = static_cast<b2CircleShape const&>(shape);
+			entry.radius = circle.m_radius;
+			vertices.push_back(circle.m_p);
+			break;
+		}
+
+		case b2Shape::e_edge:
+		{
+			auto const& edge = static_cast<b2EdgeShape const&>(shape);
+			entry.type = Snapshot::ShapeType::edge;
+			vertices.push_back(edge.m_vertex1);
+			vertices.push_back(edge.m_vertex2);
+			break;
+		}
+
+		case b2Shape::e_chain:
+		{
+			auto const& chain = static_cast<b2ChainShape const&>(shape);
+			entry.type = Snapshot::ShapeType::chain;
+			vertices.insert(
+				vertices.end(),
+				chain.m_vertices,
+				chain.m_vertices + chain.m_count);
+			break;
+		}
+
+		case b2Shape::e_polygon:
+		{
+			auto const& polygon = static_cast<b2PolygonShape const&>(shape);
+			entry.type = Snapshot::ShapeType::polygon;
+			vertices.insert(
+				vertices.end(),
+				polygon.m_vertices,
+				polygon.m_vertices + polygon.m_count);
+			break;
+		}
+
+		default:
+			return;
+	}
+
+	entry.vertexCount = std::uint32_t(vertices.size()) - entry.firstVertex;
+	geometry.shapes.push_back(entry);
+}
+
+
+void
+Snapshot::Geometry::clear() noexcept
+{
+	bodies.clear();
+	shapes.clear();
+	vertices.clear();
+}
+
+
+void
+Snapshot::Geometry::append(b2Body const& body, Pose const& previous)
+{
+	Body entry{
+		previous,
+		Pose{body.GetPosition(), body.GetAngle()},
+		body.GetType(),
+		body.IsActive(),
+		body.IsAwake(),
+		std::uint32_t(shapes.size()),
+		0u
+	};
+
+	auto const* pFixture = body.GetFixtureList();
+	for (; pFixture != nullptr; pFixture = pFixture->GetNext())
+	{
+		appendShape(*this, *pFixture->GetShape());
+	}
+	entry.shapeCount = std::uint32_t(shapes.size()) - entry.firstShape;
+	bodies.push_back(entry);
+}
+
+
+void
+Snapshot::capture(
+	b2World const& world,
+	TransformHistory const& history,
+	std::shared_ptr<StaticGeometry const> const& pPreviousStatic,
+	std::uint64_t staticVersion,
+	VisibleBodies const* pVisible
+)
+{
+	bool const staticChanged =
+		!pPreviousStatic || pPreviousStatic->version != staticVersion;
+	std::shared_ptr<StaticGeometry> pNewStatic;
+	if (staticChanged)
+	{
+		pNewStatic = std::make_shared<StaticGeometry>(
+			StaticGeometry{Geometry{}, staticVersion});
+	}
+
+	dynamicGeometry.clear();
+	culledBodies = 0u;
+	if (pVisible)
+	{
+		for (auto const* pBody: pVisible->bodies())
+		{
+			dynamicGeometry.append(*pBody, history.previous(*pBody));
+		}
+	}
+
+	// The static bodies, and without a view the others too, are only found
+	// by walking the body list.
+	auto const* pBody = world.GetBodyList();
+	bool const walkAll = !pVisible || pNewStatic;
+	for (; walkAll && pBody != nullptr; pBody = pBody->GetNext())
+	{
+		if (pBody->GetType() != b2_staticBody && !pVisible)
+		{
+			dynamicGeometry.append(*pBody, history.previous(*pBody));
+		}
+		else if (pBody->GetType() == b2_staticBody && pNewStatic)
+		{
+			// Static bodies don't move, so aren't interpolated.
+			pNewStatic->geometry.append(
+				*pBody, Pose{pBody->GetPosition(), pBody->GetAngle()});
+		}
+	}
+	drawnFixtures = dynamicGeometry.shapes.size();
+
+	if (pNewStatic)
+	{
+		pStaticGeometry = std::move(pNewStatic);
+	}
+	else
+	{
+		pStaticGeometry = pPreviousStatic;
+	}
+
+	if (pVisible)
+	{
+		// Every body is either static, captured or culled.
+		auto const staticBodies = pStaticGeometry->geometry.bodies.size();
+		auto const bodies = std::size_t(world.GetBodyCount());
+		auto const captured = dynamicGeometry.bodies.size();
+		culledBodies = bodies - std::min(bodies, staticBodies + captured);
+	}
+}
+
+
+float
+Snapshot::alpha(Clock::time_point now) const noexcept
+{
+	if (paused || stepSeconds <= 0.0)
+	{
+		return 1.0f;
+	}
+	auto const elapsed = std::chrono::duration<double>(now - stepTime);
+	return float(std::min(std::max(elapsed.count() / stepSeconds, 0.0), 1.0));
+}
+
+
+} // namespace sim
+} // namespace dukdemo
@@ -0,0 +1,86 @@
+#include <cstdint>
+
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/TransformHistory.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+void
+TransformHistory::capture(b2World const& world)
+{
+	// Keep at most half the slots full, so probes stay short.
+	auto const minSlots = 2u * std::size_t(world.GetBodyCount());
+	m_shift = 64u;
+	std::size_t slots = 1u;
+	while (slots < minSlots)
+	{
+		slots <<= 1u;
+		--m_shift;
+	}
+	m_entries.assign(slots, Entry{nullptr, Pose{b2Vec2{0.0f, 0.0f}, 0.0f}});
+
+	auto const* pBody = world.GetBodyList();
+	for (; pBody != nullptr; pBody = pBody->GetNext())
+	{
+		auto slot = slotOf(*pBody);
+		while (m_entries[slot].pBody)
+		{
+			slot = (slot + 1u) & (slots - 1u);
+		}
+		m_entries[slot] =
+			Entry{pBody, Pose{pBody->GetPosition(), pBody->GetAngle()}};
+	}
+}
+
+
+b2Transform
+TransformHistory::interpolate(b2Body const& body, float alpha) const noexcept
+{
+	// Box2D doesn't wrap angles, so they can be interpolated directly.
+	Pose const current{body.GetPosition(), body.GetAngle()};
+	return lerp(previous(body), current, alpha).transform();
+}
+
+
+Pose
+TransformHistory::previous(b2Body const& body) const noexcept
+{
+	if (m_entries.empty())
+	{
+		return Pose{body.GetPosition(), body.GetAngle()};
+	}
+
+	auto const mask = m_entries.size() - 1u;
+	auto slot = slotOf(body);
+	while (m_entries[slot].pBody && m_entries[slot].pBody != &body)
+	{
+		slot = (slot + 1u) & mask;
+	}
+	return m_entries[slot].pBody
+		?	m_entries[slot].pose
+		:	Pose{body.GetPosition(), body.GetAngle()};
+}
+
+
+std::size_t
+TransformHistory::slotOf(b2Body const& body) const noexcept
+{
+	// Fibonacci hashing spreads the aligned addresses over the top bits.
+	constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+	if (m_shift >= 64u)
+	{
+		return 0u;
+	}
+	auto const address =
+		std::uint64_t(reinterpret_cast<std::uintptr_t>(&body));
+	return std::size_t((address * multiplier) >> m_shift);
+}
+
+
+} // namespace sim
+} // namespace dukdemo
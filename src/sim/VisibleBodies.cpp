@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/VisibleBodies.h"
+
+
+namespace dukdemo {
+namespace sim {
+
+
+void
+VisibleBodies::query(b2World const& world, b2AABB const& region)
+{
+	m_bodies.clear();
+	world.QueryAABB(this, region);
+
+	// Bodies with several fixtures in the region are reported repeatedly.
+	std::sort(m_bodies.begin(), m_bodies.end());
+	m_bodies.erase(
+		std::unique(m_bodies.begin(), m_bodies.end()), m_bodies.end());
+}
+
+
+bool
+VisibleBodies::contains(b2Body const& body) const noexcept
+{
+	return std::binary_search(m_bodies.begin(), m_bodies.end(), &body);
+}
+
+
+bool
+VisibleBodies::ReportFixture(b2Fixture* pFixture)
+{
+	auto const* const pBody = pFixture->GetBody();
+	if (pBody->GetType() != b2_staticBody)
+	{
+		m_bodies.push_back(pBody);
+	}
+	return true;
+}
+
+
+} // namespace sim
+} // namespace dukdemo
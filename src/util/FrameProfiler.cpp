@@ -0,0 +1,229 @@
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+#include "dukdemo/util/FrameProfiler.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+constexpr double msPerSecond{1000.0};
+constexpr double usPerSecond{1000000.0};
+
+
+FrameProfiler::ScopedTimer::ScopedTimer(
+	FrameProfiler* pProfiler,
+	std::size_t phase
+) noexcept
+	:	m_pProfiler{pProfiler}
+	,	m_phase{phase}
+	,	m_start{pProfiler ? Clock::now() : Clock::time_point{}}
+{
+}
+
+
+FrameProfiler::ScopedTimer::~ScopedTimer() noexcept
+{
+	if (m_pProfiler)
+	{
+		m_pProfiler->recordCpu(
+			m_phase,
+			std::chrono::duration<double>(Clock::now() - m_start).count());
+	}
+}
+
+
+FrameProfiler::FrameProfiler(std::size_t window)
+	:	m_mutex{}
+	,	m_window{window}
+	,	m_phases{}
+	,	m_counters{}
+	,	m_frames{0u}
+	,	m_frameEnd{}
+{
+	addPhase("frame");
+}
+
+
+std::size_t
+FrameProfiler::addPhase(std::string const& name)
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (std::size_t i = 0u; i < m_phases.size(); ++i)
+	{
+		if (m_phases[i].name == name)
+		{
+			return i;
+		}
+	}
+	m_phases.push_back(
+		Phase{name, RollingHistogram{m_window}, RollingHistogram{m_window}});
+	return m_phases.size() - 1u;
+}
+
+
+std::size_t
+FrameProfiler::addCounter(std::string const& name)
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (std::size_t i = 0u; i < m_counters.size(); ++i)
+	{
+		if (m_counters[i].name == name)
+		{
+			return i;
+		}
+	}
+	m_counters.push_back(Counter{name, 0u, 0u, 0u});
+	return m_counters.size() - 1u;
+}
+
+
+void
+FrameProfiler::recordCount(std::size_t counter, std::uint64_t value) noexcept
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	auto& entry = m_counters[counter];
+	entry.latest = value;
+	entry.total += value;
+	++entry.samples;
+}
+
+
+void
+FrameProfiler::recordCpu(std::size_t phase, double seconds) noexcept
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	m_phases[phase].cpu.add(seconds);
+}
+
+
+void
+FrameProfiler::recordGpu(std::size_t phase, double seconds) noexcept
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	m_phases[phase].gpu.add(seconds);
+}
+
+
+void
+FrameProfiler::endFrame() noexcept
+{
+	auto const now = Clock::now();
+	std::lock_guard<std::mutex> lock{m_mutex};
+	if (m_frameEnd != Clock::time_point{})
+	{
+		m_phases[s_framePhase].cpu.add(
+			std::chrono::duration<double>(now - m_frameEnd).count());
+	}
+	m_frameEnd = now;
+	++m_frames;
+}
+
+
+std::uint64_t
+FrameProfiler::frames() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_frames;
+}
+
+
+std::vector<FrameProfiler::Phase>
+FrameProfiler::phases() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_phases;
+}
+
+
+std::vector<FrameProfiler::Counter>
+FrameProfiler::counters() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_counters;
+}
+
+
+void
+writeTimings(
+	std::ostream& out,
+	char const* pKind,
+	std::string const& name,
+	RollingHistogram const& timings
+)
+{
+	out << "profile_" << pKind << "_ms[" << name << "]:"
+		<< " mean " << timings.mean() * msPerSecond
+		<< " p50 " << timings.percentile(50.0) * msPerSecond
+		<< " p95 " << timings.percentile(95.0) * msPerSecond
+		<< " p99 " << timings.percentile(99.0) * msPerSecond
+		<< " max " << timings.max() * msPerSecond
+		<< " samples " << timings.size() << '\n';
+
+	// Buckets are labelled by their upper bounds, skipping empty ones.
+	out << "profile_" << pKind << "_histogram[" << name << "]:";
+	for (std::size_t i = 0u; i < RollingHistogram::s_bucketCount; ++i)
+	{
+		if (timings.bucket(i) == 0u)
+		{
+			continue;
+		}
+		if (i + 1u < RollingHistogram::s_bucketCount)
+		{
+			out << " <" << RollingHistogram::bucketUpperBound(i) * usPerSecond
+				<< "us " << timings.bucket(i);
+		}
+		else
+		{
+			out << " >="
+				<< RollingHistogram::bucketUpperBound(i - 1u) * usPerSecond
+				<< "us " << timings.bucket(i);
+		}
+	}
+	out << '\n';
+}
+
+
+void
+FrameProfiler::writeReport(std::ostream& out) const
+{
+	auto const phases = this->phases();
+	out << "profile_frames: " << frames() << '\n';
+	for (auto const& phase: phases)
+	{
+		if (phase.cpu.size() > 0u)
+		{
+			writeTimings(out, "cpu", phase.name, phase.cpu);
+		}
+		if (phase.gpu.size() > 0u)
+		{
+			writeTimings(out, "gpu", phase.name, phase.gpu);
+		}
+	}
+	for (auto const& counter: counters())
+	{
+		out << "profile_count[" << counter.name << "]:"
+			<< " mean " << counter.mean()
+			<< " latest " << counter.latest
+			<< " samples " << counter.samples << '\n';
+	}
+}
+
+
+void
+FrameProfiler::dump(std::string const& path) const
+{
+	std::ofstream file{path, std::ios::trunc};
+	writeReport(file);
+	file.close();
+	if (!file)
+	{
+		throw std::runtime_error{"Unable to write profile to " + path};
+	}
+}
+
+
+} // namespace util
+} // namespace dukdemo
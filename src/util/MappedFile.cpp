@@ -0,0 +1,78 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dukdemo/util/MappedFile.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+/**
+ * Throw for a failed call, closing the file first if it's open. The error is
+ * saved beforehand, since closing may change errno.
+ */
+[[noreturn]] static void
+throwMapError(char const* pAction, char const* pPath, int fd = -1)
+{
+	auto const error = errno;
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+	throw std::runtime_error{
+		std::string{"Unable to "} + pAction + " " + pPath + ": " +
+		std::strerror(error)};
+}
+
+
+MappedFile::MappedFile(char const* pPath)
+	:	m_pData{nullptr}
+	,	m_size{0u}
+{
+	auto const fd = ::open(pPath, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		throwMapError("open", pPath);
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0)
+	{
+		throwMapError("stat", pPath, fd);
+	}
+
+	// Mapping zero bytes fails, so leave empty files unmapped.
+	m_size = std::size_t(status.st_size);
+	if (m_size > 0u)
+	{
+		m_pData = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (m_pData == MAP_FAILED)
+		{
+			throwMapError("map", pPath, fd);
+		}
+	}
+
+	// The mapping stays valid once the file is closed.
+	::close(fd);
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (m_pData)
+	{
+		::munmap(m_pData, m_size);
+	}
+}
+
+
+} // namespace util
+} // namespace dukdemo
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "dukdemo/util/RollingHistogram.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+constexpr double firstBucketSeconds{1e-6};
+
+
+RollingHistogram::RollingHistogram(std::size_t window)
+	:	m_window{window}
+	,	m_samples{}
+	,	m_next{0u}
+	,	m_buckets()
+{
+	if (window == 0u)
+	{
+		throw std::invalid_argument{"Histogram window must not be empty"};
+	}
+	m_samples.reserve(window);
+}
+
+
+void
+RollingHistogram::add(double seconds)
+{
+	if (m_samples.size() < m_window)
+	{
+		m_samples.push_back(seconds);
+	}
+	else
+	{
+		auto& oldest = m_samples[m_next];
+		--m_buckets[bucketOf(oldest)];
+		oldest = seconds;
+		m_next = (m_next + 1u) % m_window;
+	}
+	++m_buckets[bucketOf(seconds)];
+}
+
+
+void
+RollingHistogram::clear() noexcept
+{
+	m_samples.clear();
+	m_next = 0u;
+	m_buckets.fill(0u);
+}
+
+
+double
+RollingHistogram::mean() const noexcept
+{
+	if (m_samples.empty())
+	{
+		return 0.0;
+	}
+	double sum{0.0};
+	for (auto const sample: m_samples)
+	{
+		sum += sample;
+	}
+	return sum / double(m_samples.size());
+}
+
+
+double
+RollingHistogram::max() const noexcept
+{
+	if (m_samples.empty())
+	{
+		return 0.0;
+	}
+	return *std::max_element(m_samples.begin(), m_samples.end());
+}
+
+
+double
+RollingHistogram::percentile(double percent) const
+{
+	if (m_samples.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector<double> samples{m_samples};
+	auto const rank = std::ceil(percent / 100.0 * double(samples.size()));
+	auto const index = std::min(
+		std::size_t(std::max(rank, 1.0)) - 1u, samples.size() - 1u);
+	auto const nth = samples.begin() + std::ptrdiff_t(index);
+	std::nth_element(samples.begin(), nth, samples.end());
+	return samples[index];
+}
+
+
+double
+RollingHistogram::bucketUpperBound(std::size_t index) noexcept
+{
+	if (index + 1u >= s_bucketCount)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	return std::ldexp(firstBucketSeconds, int(index));
+}
+
+
+std::size_t
+RollingHistogram::bucketOf(double seconds) noexcept
+{
+	std::size_t index{0u};
+	while (index + 1u < s_bucketCount && seconds >= bucketUpperBound(index))
+	{
+		++index;
+	}
+	return index;
+}
+
+
+} // namespace util
+} // namespace dukdemo
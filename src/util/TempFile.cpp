@@ -0,0 +1,35 @@
+#include <cstdlib>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dukdemo/util/TempFile.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+std::string
+createTempFileFor(std::string const& path)
+{
+	auto const pattern = path + ".XXXXXX";
+	std::vector<char> name(pattern.begin(), pattern.end());
+	name.push_back('\0');
+
+	auto const fd = ::mkstemp(name.data());
+	if (fd < 0)
+	{
+		return std::string{};
+	}
+
+	// mkstemp only lets the owner read the file.
+	::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	::close(fd);
+	return std::string{name.data()};
+}
+
+
+} // namespace util
+} // namespace dukdemo
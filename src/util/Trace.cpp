@@ -0,0 +1,298 @@
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dukdemo/util/Trace.h"
+
+
+namespace dukdemo {
+namespace util {
+namespace trace {
+
+
+using Nanoseconds = std::chrono::duration<std::int64_t, std::nano>;
+
+
+struct Event
+{
+	char const* pCategory;
+	char const* pName;
+	std::int64_t startNs;
+
+	/** Negative for an instant event. */
+	std::int64_t durationNs;
+};
+
+
+/** One thread's events. Only that thread writes to it. */
+struct ThreadBuffer
+{
+	explicit ThreadBuffer(unsigned id)
+		:	id{id}
+		,	name{}
+		,	events(g_eventsPerThread)
+		,	count{0u}
+	{}
+
+	unsigned id;
+
+	/** Guarded by the registry's mutex. */
+	std::string name;
+
+	std::vector<Event> events;
+
+	/** Events recorded since the last clear; may exceed the capacity. */
+	std::atomic<std::uint64_t> count;
+};
+
+
+struct Registry
+{
+	Registry()
+		:	mutex{}
+		,	buffers{}
+		,	origin{Clock::now()}
+	{}
+
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+	/** Event times are relative to this. */
+	Clock::time_point origin;
+};
+
+
+std::atomic<bool> g_enabled{true};
+
+thread_local ThreadBuffer* t_pBuffer = nullptr;
+
+
+Registry&
+getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+
+/** Get the calling thread's buffer, creating it if need be. */
+ThreadBuffer*
+getThreadBuffer() noexcept
+{
+	if (t_pBuffer)
+	{
+		return t_pBuffer;
+	}
+
+	try
+	{
+		auto& registry = getRegistry();
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		auto const id = unsigned(registry.buffers.size() + 1u);
+		registry.buffers.push_back(std::make_unique<ThreadBuffer>(id));
+		t_pBuffer = registry.buffers.back().get();
+	}
+	catch (...)
+	{
+		// Without memory for a buffer, the thread's events are dropped.
+	}
+	return t_pBuffer;
+}
+
+
+void
+record(
+	char const* pCategory,
+	char const* pName,
+	Clock::time_point start,
+	std::int64_t durationNs
+) noexcept
+{
+	auto* const pBuffer = getThreadBuffer();
+	if (!pBuffer)
+	{
+		return;
+	}
+
+	auto const startNs = std::chrono::duration_cast<Nanoseconds>(
+		start - getRegistry().origin).count();
+	auto const index = pBuffer->count.load(std::memory_order_relaxed);
+	pBuffer->events[index % g_eventsPerThread] =
+		Event{pCategory, pName, startNs, durationNs};
+	pBuffer->count.store(index + 1u, std::memory_order_release);
+}
+
+
+bool
+enabled() noexcept
+{
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+
+void
+setEnabled(bool enabled) noexcept
+{
+	g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+void
+setThreadName(char const* pName)
+{
+	auto* const pBuffer = getThreadBuffer();
+	if (pBuffer)
+	{
+		std::lock_guard<std::mutex> lock{getRegistry().mutex};
+		pBuffer->name = pName;
+	}
+}
+
+
+void
+complete(
+	char const* pCategory,
+	char const* pName,
+	Clock::time_point start,
+	Clock::time_point end
+) noexcept
+{
+	if (enabled())
+	{
+		auto const durationNs =
+			std::chrono::duration_cast<Nanoseconds>(end - start).count();
+		record(pCategory, pName, start, durationNs);
+	}
+}
+
+
+void
+instant(char const* pCategory, char const* pName) noexcept
+{
+	if (enabled())
+	{
+		record(pCategory, pName, Clock::now(), -1);
+	}
+}
+
+
+/** Write a JSON string, escaping as needed. */
+void
+writeString(std::ostream& out, char const* pString)
+{
+	out << '"';
+	for (auto const* pChar = pString; *pChar != '\0'; ++pChar)
+	{
+		auto const c = *pChar;
+		if (c == '"' || c == '\\')
+		{
+			out << '\\' << c;
+		}
+		else if (std::uint8_t(c) < 0x20u)
+		{
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+				<< unsigned(c) << std::dec << std::setfill(' ');
+		}
+		else
+		{
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+
+void
+writeChromeTrace(std::ostream& out)
+{
+	constexpr double nsPerUs{1000.0};
+	auto const flags = out.flags();
+	auto const precision = out.precision();
+	out << std::fixed << std::setprecision(3);
+
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first{true};
+	auto const beginEvent = [&out, &first](unsigned threadID) {
+		out << (first ? "\n" : ",\n") << "{\"pid\":1,\"tid\":" << threadID;
+		first = false;
+	};
+
+	for (auto const& pBuffer: registry.buffers)
+	{
+		if (!pBuffer->name.empty())
+		{
+			beginEvent(pBuffer->id);
+			out << ",\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":";
+			writeString(out, pBuffer->name.c_str());
+			out << "}}";
+		}
+
+		// Only the latest events are left once the buffer has wrapped.
+		auto const count = pBuffer->count.load(std::memory_order_acquire);
+		auto const begin =
+			count > g_eventsPerThread ? count - g_eventsPerThread : 0u;
+		for (auto i = begin; i < count; ++i)
+		{
+			auto const& event = pBuffer->events[i % g_eventsPerThread];
+			beginEvent(pBuffer->id);
+			out << ",\"cat\":";
+			writeString(out, event.pCategory);
+			out << ",\"name\":";
+			writeString(out, event.pName);
+			out << ",\"ts\":" << double(event.startNs) / nsPerUs;
+			if (event.durationNs < 0)
+			{
+				out << ",\"ph\":\"i\",\"s\":\"t\"}";
+			}
+			else
+			{
+				out << ",\"ph\":\"X\",\"dur\":"
+					<< double(event.durationNs) / nsPerUs << '}';
+			}
+		}
+	}
+	out << "\n]}\n";
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+
+void
+dump(char const* pPath)
+{
+	std::ofstream file{pPath, std::ios::trunc};
+	writeChromeTrace(file);
+	file.close();
+	if (!file)
+	{
+		throw std::runtime_error{
+			std::string{"Unable to write trace to "} + pPath};
+	}
+}
+
+
+void
+clear() noexcept
+{
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	for (auto const& pBuffer: registry.buffers)
+	{
+		pBuffer->count.store(0u, std::memory_order_relaxed);
+	}
+}
+
+
+} // namespace trace
+} // namespace util
+} // namespace dukdemo
@@ -1,5 +1,3 @@
-#include <SDL2/SDL_video.h>
-
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2World.h>
 
@@ -20,22 +18,6 @@ DukContextDeleter::operator()(duk_context* pContext)
 }
 
 
-void
-SDLWindowDeleter::operator()(SDL_Window* pWindow)
-	noexcept
-{
-	SDL_DestroyWindow(pWindow);
-}
-
-
-void
-GLContextDeleter::operator()(SDL_GLContext pGLContext)
-	noexcept
-{
-	SDL_GL_DeleteContext(pGLContext);
-}
-
-
 void
 B2Deleter::operator()(b2Body* pBody)
 	noexcept
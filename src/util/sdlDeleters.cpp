@@ -0,0 +1,27 @@
+#include <SDL2/SDL_video.h>
+
+#include "dukdemo/util/deleters.h"
+
+
+namespace dukdemo {
+namespace util {
+
+
+void
+SDLWindowDeleter::operator()(SDL_Window* pWindow)
+	noexcept
+{
+	SDL_DestroyWindow(pWindow);
+}
+
+
+void
+GLContextDeleter::operator()(SDL_GLContext pGLContext)
+	noexcept
+{
+	SDL_GL_DeleteContext(pGLContext);
+}
+
+
+} // namespace util
+} // namespace dukdemo
@@ -0,0 +1,390 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/JsonScene.h"
+
+
+namespace scene = dukdemo::scene;
+
+
+namespace {
+
+
+constexpr char const* const pSceneJson = R"JSON({"bodies": [
+	{"type": "static", "fixtures": [
+		{"friction": 0.75, "shape": {"type": "chain", "loop": true,
+			"vertices": [[-5, 0], [5, 0], [5, 5], [-5, 5]]}},
+		{"isSensor": true,
+			"shape": {"type": "edge", "v1": [0, 0], "v2": [1, 0]}}
+	]},
+	{"type": "dynamic", "position": [1, 2], "angle": 0.5, "bullet": true,
+		"fixtures": [
+			{"density": 2, "categoryBits": 4, "groupIndex": -3, "shape":
+				{"type": "circle", "radius": 0.5, "position": [0.25, 0]}},
+			{"shape": {"type": "polygon",
+				"vertices": [[0, 0], [1, 1], [1, 0], [0, 1], [0.5, 0.5]]}}
+		]},
+	{"type": "kinematic", "linearVelocity": [3, 0]}
+]})JSON";
+
+
+/** A binary scene, stored with the alignment the loader needs. */
+class Buffer
+{
+public:
+	explicit Buffer(std::string const& bytes)
+		:	m_words((bytes.size() + 3u) / 4u)
+		,	m_size{bytes.size()}
+	{
+		std::memcpy(m_words.data(), bytes.data(), bytes.size());
+	}
+
+	void*
+	data() noexcept
+	{ return m_words.data(); }
+
+	std::size_t
+	size() const noexcept
+	{ return m_size; }
+
+	/** The start of the records, after the header. */
+	unsigned char*
+	records() noexcept
+	{
+		return static_cast<unsigned char*>(data()) +
+			sizeof(scene::BinarySceneHeader);
+	}
+
+private:
+	std::vector<std::uint32_t> m_words;
+	std::size_t m_size;
+};
+
+
+std::string
+convert(char const* pJson)
+{
+	std::istringstream json{pJson};
+	std::ostringstream out;
+	REQUIRE(scene::convertJsonScene(json, out));
+	return out.str();
+}
+
+
+std::vector<b2Body const*>
+bodiesOf(b2World const& world)
+{
+	std::vector<b2Body const*> bodies;
+	for (auto const* pBody = world.GetBodyList(); pBody;
+		pBody = pBody->GetNext())
+	{
+		bodies.push_back(pBody);
+	}
+	return bodies;
+}
+
+
+void
+checkSameShape(b2Shape const& expected, b2Shape const& actual)
+{
+	REQUIRE(actual.GetType() == expected.GetType());
+	CHECK(actual.m_radius == expected.m_radius);
+	switch (expected.GetType())
+	{
+		case b2Shape::e_circle:
+		{
+			auto const& circle = static_cast<b2CircleShape const&>(actual);
+			auto const& other = static_cast<b2CircleShape const&>(expected);
+			CHECK(circle.m_p == other.m_p);
+			break;
+		}
+
+		case b2Shape::e_polygon:
+		{
+			auto const& polygon = static_cast<b2PolygonShape const&>(actual);
+			auto const& other = static_cast<b2PolygonShape const&>(expected);
+			REQUIRE(polygon.m_count == other.m_count);
+			CHECK(polygon.m_centroid == other.m_centroid);
+			for (int32 i = 0; i < polygon.m_count; ++i)
+			{
+				CHECK(polygon.m_vertices[i] == other.m_vertices[i]);
+				CHECK(polygon.m_normals[i] == other.m_normals[i]);
+			}
+			break;
+		}
+
+		case b2Shape::e_chain:
+		{
+			auto const& chain = static_cast<b2ChainShape const&>(actual);
+			auto const& other = static_cast<b2ChainShape const&>(expected);
+			REQUIRE(chain.m_count == other.m_count);
+			for (int32 i = 0; i < chain.m_count; ++i)
+			{
+				CHECK(chain.m_vertices[i] == other.m_vertices[i]);
+			}
+			CHECK(chain.m_hasPrevVertex == other.m_hasPrevVertex);
+			CHECK(chain.m_hasNextVertex == other.m_hasNextVertex);
+			CHECK(chain.m_prevVertex == other.m_prevVertex);
+			CHECK(chain.m_nextVertex == other.m_nextVertex);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+/** Check that two worlds hold the same bodies, fixtures and shapes. */
+void
+checkSameWorld(b2World const& expected, b2World const& actual)
+{
+	auto const expectedBodies = bodiesOf(expected);
+	auto const actualBodies = bodiesOf(actual);
+	REQUIRE(actualBodies.size() == expectedBodies.size());
+	for (std::size_t i = 0u; i < actualBodies.size(); ++i)
+	{
+		auto const& body = *actualBodies[i];
+		auto const& other = *expectedBodies[i];
+		CHECK(body.GetType() == other.GetType());
+		CHECK(body.GetPosition() == other.GetPosition());
+		CHECK(body.GetAngle() == other.GetAngle());
+		CHECK(body.GetLinearVelocity() == other.GetLinearVelocity());
+		CHECK(body.GetMass() == other.GetMass());
+		CHECK(body.IsBullet() == other.IsBullet());
+
+		auto const* pFixture = body.GetFixtureList();
+		auto const* pOther = other.GetFixtureList();
+		for (; pFixture && pOther;
+			pFixture = pFixture->GetNext(), pOther = pOther->GetNext())
+		{
+			CHECK(pFixture->GetFriction() == pOther->GetFriction());
+			CHECK(pFixture->GetDensity() == pOther->GetDensity());
+			CHECK(pFixture->IsSensor() == pOther->IsSensor());
+			auto const& filter = pFixture->GetFilterData();
+			CHECK(filter.categoryBits == pOther->GetFilterData().categoryBits);
+			CHECK(filter.groupIndex == pOther->GetFilterData().groupIndex);
+			checkSameShape(*pOther->GetShape(), *pFixture->GetShape());
+		}
+		CHECK(pFixture == nullptr);
+		CHECK(pOther == nullptr);
+	}
+}
+
+
+} // namespace
+
+
+SCENARIO("Loading binary scenes", "[BinaryScene]")
+{
+	GIVEN("a JSON scene converted to a binary scene")
+	{
+		Buffer buffer{convert(pSceneJson)};
+		b2World world{b2Vec2{0.0f, -9.8f}};
+
+		THEN("it holds each body, fixture and vertex")
+		{
+			scene::BinarySceneHeader header;
+			std::memcpy(&header, buffer.data(), sizeof(header));
+			CHECK(header.version == scene::g_binarySceneVersion);
+			CHECK(header.bodyCount == 3u);
+			CHECK(header.fixtureCount == 4u);
+			// 2 + 5 for the loop, 4 for the edge, 1 for the circle, and
+			// 1 + 4 + 4 for the hull of the polygon.
+			CHECK(header.vertexCount == 21u);
+		}
+
+		WHEN("it is loaded")
+		{
+			bool const loaded =
+				scene::loadBinaryScene(buffer.data(), buffer.size(), world);
+
+			THEN("the world matches one loaded from the JSON")
+			{
+				REQUIRE(loaded);
+				b2World expected{b2Vec2{0.0f, -9.8f}};
+				std::istringstream json{pSceneJson};
+				REQUIRE(scene::loadJsonScene(json, expected));
+				checkSameWorld(expected, world);
+			}
+		}
+
+		WHEN("it is written to a file and mapped")
+		{
+			std::string const path{P_tmpdir "/dukdemo-test.dkscene"};
+			{
+				std::ofstream file{path, std::ios::out | std::ios::binary};
+				file.write(
+					static_cast<char const*>(buffer.data()),
+					std::streamsize(buffer.size()));
+			}
+			bool const loaded = scene::loadBinarySceneFile(path.c_str(), world);
+			std::remove(path.c_str());
+
+			THEN("its bodies are created")
+			{
+				CHECK(loaded);
+				CHECK(world.GetBodyCount() == 3);
+			}
+		}
+
+		WHEN("it is truncated")
+		{
+			THEN("it is rejected")
+			{
+				CHECK_FALSE(
+					scene::loadBinaryScene(
+						buffer.data(), buffer.size() - 4u, world));
+				CHECK_FALSE(scene::loadBinaryScene(buffer.data(), 8u, world));
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+
+		WHEN("its header is changed")
+		{
+			auto* const pHeader =
+				static_cast<scene::BinarySceneHeader*>(buffer.data());
+			auto const original = *pHeader;
+			auto const load = [&buffer, &world]() {
+				return scene::loadBinaryScene(
+					buffer.data(), buffer.size(), world);
+			};
+
+			THEN("a different magic, version or count is rejected")
+			{
+				pHeader->magic[0] = 'X';
+				CHECK_FALSE(load());
+				*pHeader = original;
+
+				pHeader->version = scene::g_binarySceneVersion + 1u;
+				CHECK_FALSE(load());
+				*pHeader = original;
+
+				pHeader->vertexCount = 0xffffffffu;
+				CHECK_FALSE(load());
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+
+		WHEN("a record is corrupted")
+		{
+			auto* const pBodies =
+				reinterpret_cast<scene::BinaryBody*>(buffer.records());
+			auto* const pFixtures =
+				reinterpret_cast<scene::BinaryFixture*>(pBodies + 3);
+			auto* const pCoords = reinterpret_cast<float*>(pFixtures + 4);
+			auto const rejected = [&buffer, &world]() {
+				return
+					!scene::loadBinaryScene(
+						buffer.data(), buffer.size(), world) &&
+					world.GetBodyCount() == 0;
+			};
+
+			SECTION("a body type is unknown")
+			{
+				pBodies[2].type = 3u;
+				CHECK(rejected());
+			}
+			SECTION("a later body's angle is NaN")
+			{
+				pBodies[2].angle = std::numeric_limits<float>::quiet_NaN();
+				CHECK(rejected());
+			}
+			SECTION("a boolean isn't 0 or 1")
+			{
+				pBodies[1].bullet = 2u;
+				CHECK(rejected());
+			}
+			SECTION("fixtures are miscounted")
+			{
+				pBodies[0].fixtureCount = 3u;
+				CHECK(rejected());
+			}
+			SECTION("a shape type is unknown")
+			{
+				pFixtures[2].shapeType = 4u;
+				CHECK(rejected());
+			}
+			SECTION("a circle has flags only edges and chains may have")
+			{
+				pFixtures[2].flags |= scene::BinaryFixture::HasPrev;
+				CHECK(rejected());
+			}
+			SECTION("a polygon's hull is out of order")
+			{
+				// The hull follows the loop, edge, circle and centroid.
+				auto* const pHull = pCoords + 2u * (7u + 4u + 1u + 1u);
+				std::swap(pHull[0], pHull[2]);
+				std::swap(pHull[1], pHull[3]);
+				CHECK(rejected());
+			}
+			SECTION("a polygon's normal isn't a unit vector")
+			{
+				// The normals follow the hull's four vertices.
+				auto* const pNormals = pCoords + 2u * (7u + 4u + 1u + 1u + 4u);
+				pNormals[0] *= 2.0f;
+				pNormals[1] *= 2.0f;
+				CHECK(rejected());
+			}
+			SECTION("a polygon's normal points inwards")
+			{
+				auto* const pNormals = pCoords + 2u * (7u + 4u + 1u + 1u + 4u);
+				pNormals[2] = -pNormals[2];
+				pNormals[3] = -pNormals[3];
+				CHECK(rejected());
+			}
+			SECTION("chain vertices coincide")
+			{
+				// The loop's vertices follow its neighbours.
+				pCoords[2u * 3u] = pCoords[2u * 2u];
+				pCoords[2u * 3u + 1u] = pCoords[2u * 2u + 1u];
+				CHECK(rejected());
+			}
+		}
+	}
+
+
+	GIVEN("an invalid JSON scene")
+	{
+		std::istringstream json{R"({"bodies": [{}, {"type": "flying"}]})"};
+		std::ostringstream out;
+
+		THEN("it isn't converted")
+		{
+			CHECK_FALSE(scene::convertJsonScene(json, out));
+			CHECK(out.str().empty());
+		}
+	}
+
+	GIVEN("a missing file")
+	{
+		b2World world{b2Vec2{0.0f, -9.8f}};
+
+		THEN("mapping it throws")
+		{
+			CHECK_THROWS_AS(
+				scene::loadBinarySceneFile(
+					P_tmpdir "/dukdemo-missing.dkscene", world),
+				std::runtime_error);
+		}
+	}
+}
@@ -0,0 +1,275 @@
+#include <clocale>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <catch.hpp>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include <duktape.h>
+
+#include "dukdemo/scene/JsonScene.h"
+#include "dukdemo/scripting/Prefab.h"
+
+#include "../scripting/physics/test_utils.h"
+
+
+namespace ds = dukdemo::scripting;
+namespace scene = dukdemo::scene;
+
+
+/** Whether `loadPrefab` accepts every body of a scene, via `JSON.parse`. */
+bool
+duktapeAccepts(std::string const& json)
+{
+	testutils::Heap pContext;
+	auto* const pCtx = pContext.get();
+	testutils::pushJSONObject(pCtx, json.c_str());
+	if (!duk_is_object(pCtx, -1))
+	{
+		return false;
+	}
+	if (!duk_get_prop_string(pCtx, -1, "bodies"))
+	{
+		return true;
+	}
+	if (!duk_is_array(pCtx, -1))
+	{
+		return false;
+	}
+
+	auto const count = duk_get_length(pCtx, -1);
+	for (duk_size_t i = 0u; i < count; ++i)
+	{
+		duk_get_prop_index(pCtx, -1, duk_uarridx_t(i));
+		ds::Prefab prefab;
+		bool const valid = ds::loadPrefab(pCtx, -1, &prefab);
+		duk_pop(pCtx);
+		if (!valid)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+nativeAccepts(std::string const& json)
+{
+	std::istringstream in{json};
+	return scene::parseJsonScene(in, [](ds::Prefab const&) {});
+}
+
+
+std::string
+sceneWithBody(std::string const& body)
+{
+	return "{\"bodies\": [" + body + "]}";
+}
+
+
+std::string
+sceneWithShape(std::string const& shape)
+{
+	return sceneWithBody("{\"fixtures\": [{\"shape\": " + shape + "}]}");
+}
+
+
+SCENARIO("Parsing JSON scenes natively", "[JsonScene]")
+{
+	GIVEN("scenes which the Duktape loaders accept or reject")
+	{
+		std::string const scenes[] = {
+			"{}",
+			"[]",
+			"{\"bodies\": {}}",
+			"{\"bodies\": [], \"name\": \"empty\"}",
+			sceneWithBody("{}"),
+			sceneWithBody("1"),
+			sceneWithBody("{\"type\": \"dynamic\", \"position\": [1, 2]}"),
+			sceneWithBody("{\"type\": \"flying\"}"),
+			sceneWithBody("{\"type\": 2.5}"),
+			sceneWithBody("{\"type\": 3}"),
+			sceneWithBody("{\"angle\": \"1\"}"),
+			sceneWithBody("{\"angle\": null}"),
+			sceneWithBody("{\"awake\": 1}"),
+			sceneWithBody("{\"position\": [1]}"),
+			sceneWithBody("{\"position\": [1, 2, \"x\"]}"),
+			sceneWithBody("{\"position\": [true, 2]}"),
+			sceneWithBody("{\"position\": {\"x\": 1, \"y\": 2}}"),
+			sceneWithBody("{\"fixtures\": {}}"),
+			sceneWithBody("{\"fixtures\": [{}]}"),
+			sceneWithBody(
+				"{\"fixtures\": [{\"density\": 2, \"categoryBits\": 65535,"
+				" \"shape\": {\"type\": \"circle\", \"radius\": 1,"
+				" \"position\": [0, 0]}}]}"),
+			sceneWithBody(
+				"{\"fixtures\": [{\"maskBits\": -4, \"groupIndex\": 1e6,"
+				" \"shape\": {\"type\": \"circle\", \"radius\": 1,"
+				" \"position\": [0, 0]}}]}"),
+			sceneWithShape("null"),
+			sceneWithShape("{\"radius\": 1, \"position\": [0, 0]}"),
+			sceneWithShape("{\"type\": \"circle\", \"radius\": 1}"),
+			sceneWithShape(
+				"{\"radius\": 1, \"position\": [0, 0], \"vertices\": 5,"
+				" \"type\": \"circle\"}"),
+			sceneWithShape("{\"type\": 1, \"v1\": [0, 0], \"v2\": [1, 0]}"),
+			sceneWithShape(
+				"{\"type\": \"edge\", \"v1\": [0, 0], \"v2\": [1, 0],"
+				" \"prev\": [1]}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\","
+				" \"vertices\": [[0, 0], [1, 0], [1, 1]]}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\", \"vertices\": [[0, 0], [1, 0]]}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\","
+				" \"vertices\": [[0, 0], [1, 0], [1, \"1\"]]}"),
+			sceneWithShape(
+				"{\"type\": \"chain\", \"vertices\": [[0, 0], [1, 0], [2, 1]],"
+				" \"loop\": \"yes\", \"next\": [3, 3]}"),
+			sceneWithShape(
+				"{\"type\": \"chain\", \"vertices\": [[0, 0], [1, 0], [2, 1]],"
+				" \"loop\": true, \"next\": null}"),
+			sceneWithShape(
+				"{\"type\": \"chain\", \"vertices\": [[0, 0], [1, 0], [2, 1]],"
+				" \"next\": null}"),
+			sceneWithShape("{\"type\": \"chain\", \"vertices\": []}"),
+			sceneWithShape("{\"type\": \"chain\", \"vertices\": [[0, 0]]}"),
+			sceneWithShape(
+				"{\"type\": \"chain\", \"vertices\": [[0, 0], [1, 0]],"
+				" \"loop\": true}"),
+			sceneWithShape(
+				"{\"type\": \"chain\","
+				" \"vertices\": [[0, 0], [1, 0], [1, 0.001]]}"),
+			sceneWithShape(
+				"{\"type\": \"chain\", \"vertices\": [[0, 0], [1, 0], [0, 1],"
+				" [0, 0.001]], \"loop\": true}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\","
+				" \"vertices\": [[0, 0], [1, 1], [2, 2]]}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\","
+				" \"vertices\": [[0, 0], [1, 0], [1, 0.001]]}"),
+			sceneWithShape(
+				"{\"type\": \"polygon\","
+				" \"vertices\": [[0, 0], [1, 0], [1, 0], [1, 1]]}"),
+		};
+
+		THEN("the native parser agrees on each")
+		{
+			for (auto const& json: scenes)
+			{
+				INFO(json);
+				CHECK(nativeAccepts(json) == duktapeAccepts(json));
+			}
+		}
+	}
+
+	GIVEN("a global locale with a decimal comma")
+	{
+		std::string const previous{std::setlocale(LC_NUMERIC, nullptr)};
+		auto const* const pLocale = std::setlocale(LC_NUMERIC, "de_DE.UTF-8");
+
+		THEN("numbers are still read with a decimal point")
+		{
+			float radius = 0.0f;
+			std::istringstream in{sceneWithShape(
+				"{\"type\": \"circle\", \"radius\": 0.25,"
+				" \"position\": [0, 0]}")};
+			auto const readRadius = [&radius](ds::Prefab const& prefab) {
+				radius = prefab.fixtures.front().pShape->m_radius;
+			};
+			CHECK(scene::parseJsonScene(in, readRadius));
+			CHECK(radius == 0.25f);
+		}
+
+		if (pLocale)
+		{
+			std::setlocale(LC_NUMERIC, previous.c_str());
+		}
+	}
+
+		GIVEN("malformed JSON")
+	{
+		THEN("parsing throws")
+		{
+			for (auto const* pJson: {"{", "{\"bodies\": [}", "{} {}", "[1,]"})
+			{
+				INFO(pJson);
+				CHECK_THROWS_AS(nativeAccepts(pJson), std::runtime_error);
+			}
+		}
+	}
+
+	GIVEN("an empty world")
+	{
+		b2World world{b2Vec2{0.0f, -9.8f}};
+
+		WHEN("a valid scene is loaded")
+		{
+			std::istringstream in{R"JSON({"bodies": [
+				{"type": "static", "fixtures": [
+					{"shape": {"type": "chain", "loop": true,
+						"vertices": [[-5, 0], [5, 0], [5, 5], [-5, 5]]}}
+				]},
+				{"type": "dynamic", "position": [1, 2], "angle": 0.5,
+					"fixtures": [{"density": 2, "shape":
+						{"type": "circle", "radius": 0.5, "position": [0, 0]}}]}
+			]})JSON"};
+			bool const loaded = scene::loadJsonScene(in, world);
+
+			THEN("its bodies and fixtures are created")
+			{
+				REQUIRE(loaded);
+				REQUIRE(world.GetBodyCount() == 2);
+
+				// Bodies are listed newest first.
+				auto const* const pBall = world.GetBodyList();
+				CHECK(pBall->GetType() == b2_dynamicBody);
+				CHECK(pBall->GetPosition().x == Approx(1.0f));
+				CHECK(pBall->GetPosition().y == Approx(2.0f));
+				CHECK(pBall->GetAngle() == Approx(0.5f));
+				auto const* const pFixture = pBall->GetFixtureList();
+				REQUIRE(pFixture != nullptr);
+				CHECK(pFixture->GetDensity() == Approx(2.0f));
+				CHECK(pFixture->GetShape()->m_radius == Approx(0.5f));
+
+				auto const* const pGround = pBall->GetNext();
+				CHECK(pGround->GetType() == b2_staticBody);
+				CHECK(
+					pGround->GetFixtureList()->GetType() == b2Shape::e_chain);
+			}
+		}
+
+		WHEN("a later body is invalid")
+		{
+			std::istringstream in{sceneWithBody("{}, {}, {\"angle\": true}")};
+			bool const loaded = scene::loadJsonScene(in, world);
+
+			THEN("no bodies are left in the world")
+			{
+				CHECK_FALSE(loaded);
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+
+		WHEN("the JSON is malformed after some bodies")
+		{
+			std::istringstream in{"{\"bodies\": [{}, {}, {]}"};
+
+			THEN("loading throws and no bodies are left in the world")
+			{
+				CHECK_THROWS_AS(
+					scene::loadJsonScene(in, world), std::runtime_error);
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+	}
+}
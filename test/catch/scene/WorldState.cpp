@@ -0,0 +1,496 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/scene/BinaryScene.h"
+#include "dukdemo/scene/WorldState.h"
+
+
+namespace scene = dukdemo::scene;
+
+
+namespace {
+
+
+/** Calls of the global `operator new`, to check what allocates. */
+std::size_t g_allocations = 0u;
+
+
+} // namespace
+
+
+void*
+operator new(std::size_t size)
+{
+	++g_allocations;
+	if (auto* const pMemory = std::malloc(size > 0u ? size : 1u))
+	{
+		return pMemory;
+	}
+	throw std::bad_alloc{};
+}
+
+
+void
+operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+
+namespace {
+
+
+constexpr float timeStep = 1.0f / 60.0f;
+
+
+/** Serials which also record the bodies forgotten, as a restore destroys. */
+class RecordingSerials: public scene::BodySerials
+{
+public:
+	RecordingSerials()
+		:	scene::BodySerials{}
+		,	forgotten{}
+	{
+	}
+
+	void
+	forget(b2Body const& body) override
+	{
+		forgotten.push_back(&body);
+		BodySerials::forget(body);
+	}
+
+	std::vector<b2Body const*> forgotten;
+};
+
+
+/**
+ * A ground edge with a stack of boxes and a ball rolling towards it.
+ *
+ * Sleep timers aren't captured, so sleeping is disabled.
+ */
+void
+buildStack(b2World& world)
+{
+	world.SetAllowSleeping(false);
+	b2BodyDef groundDef;
+	auto* const pGround = world.CreateBody(&groundDef);
+	b2EdgeShape edge;
+	edge.Set(b2Vec2{-20.0f, 0.0f}, b2Vec2{20.0f, 0.0f});
+	pGround->CreateFixture(&edge, 0.0f);
+
+	b2PolygonShape box;
+	box.SetAsBox(0.5f, 0.5f);
+	for (int i = 0; i < 4; ++i)
+	{
+		b2BodyDef def;
+		def.type = b2_dynamicBody;
+		def.position.Set(0.0f, 0.5f + float(i));
+		world.CreateBody(&def)->CreateFixture(&box, 1.0f);
+	}
+
+	b2BodyDef ballDef;
+	ballDef.type = b2_dynamicBody;
+	ballDef.position.Set(3.0f, 2.0f);
+	ballDef.linearVelocity.Set(-1.0f, 0.0f);
+	b2CircleShape circle;
+	circle.m_radius = 0.5f;
+	world.CreateBody(&ballDef)->CreateFixture(&circle, 2.0f);
+}
+
+
+void
+step(b2World& world, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		world.Step(timeStep, 8, 3);
+	}
+}
+
+
+std::vector<b2Body*>
+bodiesOf(b2World& world)
+{
+	std::vector<b2Body*> bodies;
+	for (auto* pBody = world.GetBodyList(); pBody; pBody = pBody->GetNext())
+	{
+		bodies.push_back(pBody);
+	}
+	return bodies;
+}
+
+
+std::vector<b2Fixture*>
+fixturesOf(b2World& world)
+{
+	std::vector<b2Fixture*> fixtures;
+	for (auto* pBody = world.GetBodyList(); pBody; pBody = pBody->GetNext())
+	{
+		for (auto* pFixture = pBody->GetFixtureList(); pFixture;
+			pFixture = pFixture->GetNext())
+		{
+			fixtures.push_back(pFixture);
+		}
+	}
+	return fixtures;
+}
+
+
+/** Each body's transform and velocities, in body list order. */
+std::vector<float>
+motionOf(b2World const& world)
+{
+	std::vector<float> motion;
+	for (auto const* pBody = world.GetBodyList(); pBody;
+		pBody = pBody->GetNext())
+	{
+		motion.insert(motion.end(), {
+			pBody->GetPosition().x, pBody->GetPosition().y,
+			pBody->GetAngle(),
+			pBody->GetLinearVelocity().x, pBody->GetLinearVelocity().y,
+			pBody->GetAngularVelocity(),
+		});
+	}
+	return motion;
+}
+
+
+/** Check that motions are equal, but for rounding. */
+void
+checkCloseTo(
+	std::vector<float> const& expected,
+	std::vector<float> const& actual
+)
+{
+	REQUIRE(actual.size() == expected.size());
+	for (std::size_t i = 0u; i < actual.size(); ++i)
+	{
+		CHECK(std::abs(actual[i] - expected[i]) < 1e-4f);
+	}
+}
+
+
+scene::WorldStateHeader
+headerOf(b2World const& world)
+{
+	scene::BodySerials ids;
+	std::vector<unsigned char> state;
+	scene::saveWorldState(world, ids, state);
+	scene::WorldStateHeader header;
+	std::memcpy(&header, state.data(), sizeof(header));
+	return header;
+}
+
+
+/**
+ * Check that a world holds the bodies and shapes of a state. Contacts are
+ * only found again by stepping, so aren't compared.
+ */
+void
+checkSameShapes(
+	scene::WorldStateHeader const& expected,
+	b2World const& world
+)
+{
+	auto const actual = headerOf(world);
+	CHECK(actual.bodyCount == expected.bodyCount);
+	CHECK(actual.fixtureCount == expected.fixtureCount);
+	CHECK(actual.vertexCount == expected.vertexCount);
+}
+
+
+bool
+restore(
+	b2World& world,
+	std::vector<unsigned char> const& state,
+	scene::BodyIds& ids
+)
+{
+	return scene::restoreWorldState(world, state.data(), state.size(), ids);
+}
+
+
+} // namespace
+
+
+SCENARIO("Saving and restoring world states", "[WorldState]")
+{
+	GIVEN("a world which has been stepped until its bodies touch")
+	{
+		b2World world{b2Vec2{0.0f, -10.0f}};
+		buildStack(world);
+		step(world, 30);
+		RecordingSerials ids;
+		std::vector<unsigned char> state;
+		scene::saveWorldState(world, ids, state);
+		auto const bodies = bodiesOf(world);
+		auto const fixtures = fixturesOf(world);
+		auto const motion = motionOf(world);
+
+		scene::WorldStateHeader header;
+		std::memcpy(&header, state.data(), sizeof(header));
+
+		THEN("the state holds each body, contact and fixture")
+		{
+			CHECK(header.version == scene::g_worldStateVersion);
+			CHECK(header.bodyCount == 6u);
+			CHECK(header.fixtureCount == 6u);
+			auto const contactCount = std::uint32_t(world.GetContactCount());
+			CHECK(header.contactCount == contactCount);
+			CHECK(header.contactCount > 0u);
+			CHECK(header.gravity[1] == -10.0f);
+		}
+
+		WHEN("it is stepped further, then restored")
+		{
+			step(world, 1);
+			auto const next = motionOf(world);
+			step(world, 29);
+			REQUIRE(restore(world, state, ids));
+
+			THEN("every body and fixture is kept, and has its old motion")
+			{
+				CHECK(bodiesOf(world) == bodies);
+				CHECK(fixturesOf(world) == fixtures);
+				CHECK(motionOf(world) == motion);
+			}
+
+			THEN("stepping again warm starts as before")
+			{
+				step(world, 1);
+				checkCloseTo(next, motionOf(world));
+			}
+
+			THEN("saving it again gives the same state")
+			{
+				std::vector<unsigned char> again;
+				scene::saveWorldState(world, ids, again);
+				CHECK(again == state);
+			}
+		}
+
+		WHEN("a body's fixture and properties are changed, then restored")
+		{
+			auto* const pBall = bodies.front();
+			pBall->SetFixedRotation(true);
+			pBall->SetGravityScale(0.5f);
+			pBall->GetFixtureList()->SetFriction(0.0f);
+			pBall->GetFixtureList()->SetSensor(true);
+			pBall->SetAwake(false);
+			REQUIRE(restore(world, state, ids));
+
+			THEN("they and its fixture are restored in place")
+			{
+				CHECK(fixturesOf(world) == fixtures);
+				CHECK_FALSE(pBall->IsFixedRotation());
+				CHECK(pBall->GetGravityScale() == 1.0f);
+				CHECK(pBall->GetFixtureList()->GetFriction() == 0.2f);
+				CHECK_FALSE(pBall->GetFixtureList()->IsSensor());
+				CHECK(pBall->IsAwake());
+				CHECK(motionOf(world) == motion);
+			}
+		}
+
+		WHEN("a body's shape is replaced, then restored")
+		{
+			auto* const pBall = bodies.front();
+			pBall->DestroyFixture(pBall->GetFixtureList());
+			b2PolygonShape box;
+			box.SetAsBox(1.0f, 1.0f);
+			pBall->CreateFixture(&box, 1.0f);
+			REQUIRE(restore(world, state, ids));
+
+			THEN("the body is kept with its old shape and mass")
+			{
+				auto const* const pShape = pBall->GetFixtureList()->GetShape();
+				CHECK(bodiesOf(world) == bodies);
+				CHECK(pShape->GetType() == b2Shape::e_circle);
+				checkSameShapes(header, world);
+				CHECK(motionOf(world) == motion);
+			}
+		}
+
+		WHEN("a body is destroyed and another created, then restored")
+		{
+			auto* const pLost = bodies[1];
+			ids.forget(*pLost);
+			world.DestroyBody(pLost);
+			b2BodyDef def;
+			auto* const pExtra = world.CreateBody(&def);
+			ids.forgotten.clear();
+			bool const restored = restore(world, state, ids);
+
+			THEN("the new body took the lost body's address")
+			{
+				CHECK(pExtra == pLost);
+			}
+
+			THEN("the new body is destroyed and the lost one recreated")
+			{
+				REQUIRE(restored);
+				CHECK(ids.forgotten == std::vector<b2Body const*>{pExtra});
+				checkSameShapes(header, world);
+			}
+
+			THEN("the recreated body keeps its id, so restoring again keeps it")
+			{
+				REQUIRE(restored);
+				auto const restoredBodies = bodiesOf(world);
+				ids.forgotten.clear();
+				REQUIRE(restore(world, state, ids));
+				CHECK(ids.forgotten.empty());
+				CHECK(bodiesOf(world) == restoredBodies);
+			}
+		}
+
+		WHEN("it is restored repeatedly")
+		{
+			REQUIRE(restore(world, state, ids));
+			auto const before = g_allocations;
+			bool restored = true;
+			for (int i = 0; i < 10; ++i)
+			{
+				step(world, 1);
+				restored = restore(world, state, ids) && restored;
+			}
+			auto const allocations = g_allocations - before;
+
+			THEN("no restore allocates")
+			{
+				CHECK(restored);
+				CHECK(allocations == 0u);
+				CHECK(bodiesOf(world) == bodies);
+				CHECK(motionOf(world) == motion);
+			}
+		}
+
+		WHEN("the state is invalid")
+		{
+			step(world, 30);
+			auto const later = motionOf(world);
+			auto* const pBodies = reinterpret_cast<scene::BodyState*>(
+				state.data() + sizeof(scene::WorldStateHeader));
+			auto const rejected = [&world, &state, &ids, &later, &bodies]() {
+				return
+					!restore(world, state, ids) &&
+					bodiesOf(world) == bodies &&
+					motionOf(world) == later;
+			};
+
+			SECTION("it is truncated")
+			{
+				state.pop_back();
+				CHECK(rejected());
+			}
+			SECTION("its version differs")
+			{
+				auto* const pHeader =
+					reinterpret_cast<scene::WorldStateHeader*>(state.data());
+				pHeader->version = scene::g_worldStateVersion + 1u;
+				CHECK(rejected());
+			}
+			SECTION("a later body's velocity is NaN")
+			{
+				pBodies[5].linearVelocity[0] =
+					std::numeric_limits<float>::quiet_NaN();
+				CHECK(rejected());
+			}
+			SECTION("a body is recorded twice")
+			{
+				pBodies[5].id = pBodies[4].id;
+				CHECK(rejected());
+			}
+			SECTION("a body's mass is negative")
+			{
+				pBodies[0].mass = -1.0f;
+				CHECK(rejected());
+			}
+		}
+	}
+
+
+	GIVEN("two worlds built alike")
+	{
+		b2World world{b2Vec2{0.0f, -10.0f}};
+		b2World other{b2Vec2{0.0f, 0.0f}};
+		buildStack(world);
+		buildStack(other);
+		step(world, 10);
+		scene::BodySerials ids;
+		scene::BodySerials otherIds;
+		std::vector<unsigned char> state;
+		scene::saveWorldState(world, ids, state);
+
+		WHEN("one's state is restored into the other")
+		{
+			REQUIRE(restore(other, state, otherIds));
+
+			THEN("the other's bodies are changed to match")
+			{
+				CHECK(other.GetGravity() == world.GetGravity());
+				checkSameShapes(headerOf(world), other);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Numbering bodies", "[WorldState]")
+{
+	GIVEN("a world with a numbered body")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		b2BodyDef def;
+		auto* const pBody = world.CreateBody(&def);
+		scene::BodySerials serials;
+		auto const id = serials.idOf(*pBody);
+
+		THEN("it keeps its number")
+		{
+			CHECK(serials.idOf(*pBody) == id);
+		}
+
+		WHEN("it's destroyed without being forgotten, and another created")
+		{
+			world.DestroyBody(pBody);
+			auto* const pOther = world.CreateBody(&def);
+			auto const otherId = serials.issue(*pOther);
+
+			THEN("the new body is issued a number of its own")
+			{
+				CHECK(pOther == pBody);
+				CHECK(otherId != id);
+				CHECK(serials.idOf(*pOther) == otherId);
+			}
+		}
+
+		WHEN("a body is assigned a recorded id")
+		{
+			auto* const pOther = world.CreateBody(&def);
+			serials.assign(*pOther, id + 10u);
+
+			THEN("it has that id, and later numbers are greater")
+			{
+				CHECK(serials.idOf(*pOther) == id + 10u);
+				auto* const pLater = world.CreateBody(&def);
+				CHECK(serials.issue(*pLater) > id + 10u);
+			}
+		}
+	}
+}
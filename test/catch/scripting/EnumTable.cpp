@@ -0,0 +1,142 @@
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/EnumTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+
+#include "physics/test_utils.h"
+
+
+namespace ds = dukdemo::scripting;
+
+
+constexpr auto colourTable = ds::makeEnumTable({"red", "green", "blue"});
+constexpr auto sizeTable = ds::makeEnumTable({"small", "large"});
+constexpr ds::EnumNames colours = ds::enumNames<colourTable>();
+constexpr ds::EnumNames sizes = ds::enumNames<sizeTable>();
+
+
+/** Decode the result of a JS expression. */
+duk_uint_t
+decode(duk_context* pContext, char const* pSource, ds::EnumNames const& names)
+{
+	duk_eval_string(pContext, pSource);
+	auto const value = ds::getEnum(pContext, -1, names);
+	duk_pop(pContext);
+	return value;
+}
+
+
+void
+checkDecoding(duk_context* pContext)
+{
+	auto const top = duk_get_top(pContext);
+
+	THEN("names and indices are decoded")
+	{
+		CHECK(decode(pContext, "'red'", colours) == 0u);
+		CHECK(decode(pContext, "'blue'", colours) == 2u);
+		CHECK(decode(pContext, "'bl' + 'ue'", colours) == 2u);
+		CHECK(decode(pContext, "1", colours) == 1u);
+		CHECK(decode(pContext, "'large'", sizes) == 1u);
+	}
+
+	THEN("repeated names decode the same")
+	{
+		CHECK(decode(pContext, "'green'", colours) == 1u);
+		CHECK(decode(pContext, "'green'", colours) == 1u);
+		CHECK(decode(pContext, "'small'", sizes) == 0u);
+		CHECK(decode(pContext, "'green'", colours) == 1u);
+	}
+
+	THEN("invalid values give the table's own count")
+	{
+		CHECK(decode(pContext, "'purple'", colours) == 3u);
+		CHECK(decode(pContext, "'red'", sizes) == 2u);
+		CHECK(decode(pContext, "3", colours) == 3u);
+		CHECK(decode(pContext, "true", sizes) == 2u);
+		CHECK(decode(pContext, "'Red'", colours) == 3u);
+	}
+
+	THEN("the value stack is left as it was")
+	{
+		decode(pContext, "'red'", colours);
+		decode(pContext, "'orange'", colours);
+		CHECK(duk_get_top(pContext) == top);
+	}
+}
+
+
+SCENARIO("Decoding enumerated values", "[EnumTable]")
+{
+	GIVEN("a heap without a name cache")
+	{
+		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		checkDecoding(pContext.get());
+	}
+
+	GIVEN("a heap with a name cache")
+	{
+		ds::EnumNameCache cache;
+		ds::HeapState state;
+		state.pEnumNameCache = &cache;
+		testutils::duk_context_ptr pContext{ds::createHeap(&state)};
+		REQUIRE(pContext);
+		checkDecoding(pContext.get());
+
+		WHEN("the cache is reused by a new heap")
+		{
+			decode(pContext.get(), "'red'", colours);
+			pContext.reset(ds::createHeap(&state));
+
+			THEN("names are interned again")
+			{
+				CHECK(decode(pContext.get(), "'red'", colours) == 0u);
+				CHECK(decode(pContext.get(), "'blue'", colours) == 2u);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Decoding enumerated values without memory to pin", "[EnumTable]")
+{
+	GIVEN("a heap with a name cache at its memory limit")
+	{
+		ds::HeapAllocator allocator;
+		ds::EnumNameCache cache;
+		ds::HeapState state;
+		state.pAllocator = &allocator;
+		state.pEnumNameCache = &cache;
+		testutils::duk_context_ptr pContext{ds::createHeap(&state)};
+		REQUIRE(pContext);
+		duk_push_string(pContext.get(), "blue");
+		auto const top = duk_get_top(pContext.get());
+		allocator.setMemoryLimit(allocator.stats().bytesLive);
+
+		WHEN("a name is decoded")
+		{
+			auto const value = ds::getEnum(pContext.get(), -1, colours);
+
+			THEN("it's found by hashing")
+			{
+				CHECK(value == 2u);
+				CHECK(allocator.stats().limitFailures > 0u);
+				CHECK(duk_get_top(pContext.get()) == top);
+			}
+
+			AND_WHEN("the limit is lifted")
+			{
+				allocator.setMemoryLimit(0u);
+
+				THEN("the names are pinned and decoded")
+				{
+					CHECK(decode(pContext.get(), "'green'", colours) == 1u);
+					CHECK(ds::getEnum(pContext.get(), -1, colours) == 2u);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/Heap.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::ExecBudget;
+using dukdemo::scripting::HeapState;
+
+
+SCENARIO("Bounding script execution time", "[ExecBudget]")
+{
+	GIVEN("a heap with an execution budget")
+	{
+		ExecBudget budget;
+		HeapState state;
+		state.pExecBudget = &budget;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		REQUIRE(dukdemo::scripting::getHeapState(pCtx) == &state);
+
+		WHEN("a quick call is made within the budget")
+		{
+			budget.setCallBudget(std::chrono::seconds{10});
+			duk_eval_string(pCtx, "(function (x) { return x * 2; })");
+			duk_push_int(pCtx, 21);
+			auto const result = budget.pcall(pCtx, 1, "quick");
+
+			THEN("it succeeds and no overrun is recorded")
+			{
+				CHECK(result == DUK_EXEC_SUCCESS);
+				CHECK(duk_get_int(pCtx, -1) == 42);
+				CHECK(budget.stats().calls == 1u);
+				CHECK(budget.stats().callOverruns == 0u);
+				CHECK(budget.stats().sites.empty());
+			}
+		}
+
+		WHEN("a call runs longer than the call budget")
+		{
+			budget.setCallBudget(std::chrono::microseconds{1});
+			duk_eval_string(
+				pCtx, "(function () { for (var i = 0; i < 1e6; ++i) {} })");
+			auto const result = budget.pcall(pCtx, 0, "slow");
+
+			THEN("the overrun is recorded against its call site")
+			{
+				CHECK(result == (ExecBudget::isEnforced()
+					? DUK_EXEC_ERROR
+					: DUK_EXEC_SUCCESS));
+				CHECK(budget.stats().callOverruns == 1u);
+				CHECK(budget.stats().frameOverruns == 0u);
+				CHECK(budget.stats().sites.at("slow").callOverruns == 1u);
+			}
+		}
+
+		WHEN("the frame budget is already spent")
+		{
+			budget.setFrameBudget(std::chrono::nanoseconds{1});
+			budget.beginFrame();
+			auto const spent =
+				ExecBudget::Clock::now() + std::chrono::microseconds{10};
+			while (ExecBudget::Clock::now() < spent)
+			{
+			}
+
+			auto const top = duk_get_top(pCtx);
+			duk_eval_string(pCtx, "(function () { throw 'called'; })");
+			duk_push_int(pCtx, 1);
+			auto const result = budget.pcall(pCtx, 1, "late");
+
+			THEN("the call is skipped, leaving an error")
+			{
+				CHECK(result == DUK_EXEC_ERROR);
+				CHECK(duk_get_top(pCtx) == top + 1);
+				CHECK(duk_get_error_code(pCtx, -1) == DUK_ERR_RANGE_ERROR);
+				CHECK(budget.stats().skippedCalls == 1u);
+				CHECK(budget.stats().frameOverruns == 1u);
+				CHECK(budget.stats().sites.at("late").frameOverruns == 1u);
+			}
+
+			AND_WHEN("the frame ends")
+			{
+				budget.endFrame();
+				duk_eval_string(pCtx, "(function () { return 1; })");
+
+				THEN("calls are made again")
+				{
+					CHECK(budget.pcall(pCtx, 0, "late") == DUK_EXEC_SUCCESS);
+				}
+			}
+		}
+
+#ifdef DUKDEMO_EXEC_TIMEOUT
+		WHEN("a call never finishes")
+		{
+			budget.setCallBudget(std::chrono::milliseconds{10});
+			duk_eval_string(pCtx, "(function () { while (true) {} })");
+			auto const result = budget.pcall(pCtx, 0, "forever");
+
+			THEN("it is interrupted with a RangeError")
+			{
+				CHECK(result == DUK_EXEC_ERROR);
+				CHECK(duk_get_error_code(pCtx, -1) == DUK_ERR_RANGE_ERROR);
+				CHECK(budget.stats().callOverruns == 1u);
+			}
+
+			AND_THEN("the heap is still usable")
+			{
+				duk_eval_string(pCtx, "1 + 1");
+				CHECK(duk_get_int(pCtx, -1) == 2);
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/GcScheduler.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/util/FrameProfiler.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::GcOptions;
+using dukdemo::scripting::GcScheduler;
+using dukdemo::scripting::HeapState;
+using dukdemo::util::FrameProfiler;
+
+
+SCENARIO("Scheduling garbage collection between frames", "[GcScheduler]")
+{
+	GIVEN("a heap with cyclic garbage and a long-lived global")
+	{
+		FrameProfiler profiler;
+		HeapState state;
+		state.pProfiler = &profiler;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		duk_eval_string_noresult(pCtx,
+			"var proto = {a: 1, b: 2};"
+			"for (var i = 0; i < 100; ++i) { var x = {}; x.self = x; }");
+
+		GcOptions options;
+		options.minFramesBetween = 1u;
+		options.maxFramesBetween = 3u;
+		GcScheduler scheduler{options};
+		scheduler.addLongLived("proto");
+
+		WHEN("a frame ends with plenty of idle time")
+		{
+			auto const collected =
+				scheduler.endFrame(pCtx, std::chrono::seconds{1});
+
+			THEN("garbage is collected and the global compacted")
+			{
+				CHECK(collected);
+				auto const& stats = scheduler.stats();
+				CHECK(stats.collections == 1u);
+				CHECK(stats.forcedCollections == 0u);
+				CHECK(stats.compactions == 1u);
+				CHECK(stats.secondsPerFrame.size() == 1u);
+				CHECK(scheduler.estimatedCost().count() > 0.0);
+				CHECK(profiler.phases().back().name == "gc");
+			}
+
+			AND_WHEN("later frames have no idle time")
+			{
+				GcScheduler::Duration const none{0.0};
+				CHECK_FALSE(scheduler.endFrame(pCtx, none));
+				CHECK_FALSE(scheduler.endFrame(pCtx, none));
+				auto const collected = scheduler.endFrame(pCtx, none);
+
+				THEN("a collection is only forced once overdue")
+				{
+					CHECK(collected);
+					auto const& stats = scheduler.stats();
+					CHECK(stats.collections == 2u);
+					CHECK(stats.forcedCollections == 1u);
+					CHECK(stats.frames == 4u);
+					CHECK(stats.secondsPerFrame.size() == 4u);
+				}
+
+				THEN("long-lived objects are only compacted once")
+				{
+					CHECK(scheduler.stats().compactions == 1u);
+				}
+			}
+		}
+	}
+
+
+	GIVEN("a scheduler that waits for garbage to build up")
+	{
+		testutils::Heap pContext;
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+
+		GcOptions options;
+		options.minFramesBetween = 3u;
+		options.minGrowthBytes = std::size_t{64u} << 10u;
+		GcScheduler scheduler{options};
+		GcScheduler::Duration const plenty{1.0};
+
+		WHEN("frames with idle time but little allocation end")
+		{
+			CHECK_FALSE(scheduler.endFrame(pCtx, plenty));
+			CHECK_FALSE(scheduler.endFrame(pCtx, plenty));
+			auto const collected = scheduler.endFrame(pCtx, plenty);
+
+			THEN("garbage is only collected once enough frames have passed")
+			{
+				CHECK(collected);
+				CHECK(scheduler.stats().collections == 1u);
+				CHECK(scheduler.stats().forcedCollections == 0u);
+			}
+		}
+
+		WHEN("the heap grows quickly")
+		{
+			duk_eval_string_noresult(pCtx,
+				"var kept = [];"
+				"for (var i = 0; i < 4096; ++i) { kept.push({i: i}); }");
+			auto const collected = scheduler.endFrame(pCtx, plenty);
+
+			THEN("garbage is collected in the first frame with idle time")
+			{
+				CHECK(collected);
+				CHECK(scheduler.stats().collections == 1u);
+			}
+		}
+	}
+}
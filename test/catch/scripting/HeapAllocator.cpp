@@ -0,0 +1,200 @@
+#include <cstdint>
+#include <cstring>
+
+#include <catch.hpp>
+
+#include <Box2D/Dynamics/b2World.h>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
+#include "dukdemo/scripting/World.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::HeapAllocator;
+using dukdemo::scripting::HeapState;
+
+
+SCENARIO("Allocating from size-class pools", "[HeapAllocator]")
+{
+	GIVEN("an allocator")
+	{
+		HeapAllocator allocator;
+
+		WHEN("small blocks are allocated")
+		{
+			auto* const pFirst = allocator.allocate(10u);
+			auto* const pSecond = allocator.allocate(20u);
+
+			THEN("they are aligned and counted")
+			{
+				REQUIRE(pFirst != nullptr);
+				REQUIRE(pSecond != nullptr);
+				constexpr auto alignment = alignof(std::max_align_t);
+				CHECK(std::uintptr_t(pFirst) % alignment == 0u);
+				CHECK(std::uintptr_t(pSecond) % alignment == 0u);
+				CHECK(allocator.stats().bytesLive == 48u);
+				CHECK(allocator.stats().allocations == 2u);
+				CHECK(allocator.stats().systemAllocations == 2u);
+				CHECK(allocator.stats().classes[0].liveBlocks == 1u);
+				CHECK(allocator.stats().classes[1].liveBlocks == 1u);
+			}
+
+			AND_WHEN("a block is freed and reallocated")
+			{
+				allocator.deallocate(pFirst);
+				auto* const pReused = allocator.allocate(16u);
+
+				THEN("the freed block is reused")
+				{
+					CHECK(pReused == pFirst);
+					CHECK(allocator.stats().classes[0].hits == 1u);
+					CHECK(allocator.stats().bytesLive == 48u);
+					CHECK(allocator.stats().systemAllocations == 2u);
+				}
+				allocator.deallocate(pReused);
+			}
+
+			AND_WHEN("a block grows beyond its class")
+			{
+				std::memset(pSecond, 0x5a, 20u);
+				auto* const pGrown = static_cast<unsigned char*>(
+					allocator.reallocate(pSecond, 300u));
+
+				THEN("its contents are kept")
+				{
+					REQUIRE(pGrown != nullptr);
+					CHECK(pGrown[0] == 0x5a);
+					CHECK(pGrown[19] == 0x5a);
+					CHECK(allocator.stats().largeAllocations == 1u);
+					CHECK(allocator.stats().bytesLive == 316u);
+				}
+				allocator.deallocate(pGrown);
+				allocator.deallocate(pFirst);
+			}
+
+			AND_WHEN("more blocks of a class are allocated")
+			{
+				auto* const pThird =
+					static_cast<char*>(allocator.allocate(16u));
+				auto* const pFourth =
+					static_cast<char*>(allocator.allocate(16u));
+
+				THEN("they are packed without headers")
+				{
+					CHECK(pFourth - pThird == 16);
+					CHECK(allocator.stats().systemAllocations == 2u);
+				}
+				allocator.deallocate(pThird);
+				allocator.deallocate(pFourth);
+				allocator.deallocate(pFirst);
+				allocator.deallocate(pSecond);
+			}
+
+			AND_WHEN("everything is freed")
+			{
+				allocator.deallocate(pFirst);
+				allocator.deallocate(pSecond);
+
+				THEN("no bytes are live but the peak is kept")
+				{
+					CHECK(allocator.stats().bytesLive == 0u);
+					CHECK(allocator.stats().peakBytes == 48u);
+					CHECK(allocator.stats().frees == 2u);
+				}
+			}
+		}
+	}
+
+	GIVEN("an allocator with a memory limit")
+	{
+		HeapAllocator allocator{100u};
+
+		THEN("allocations beyond the limit fail")
+		{
+			auto* const pBlock = allocator.allocate(60u);
+			CHECK(pBlock != nullptr);
+			CHECK(allocator.allocate(60u) == nullptr);
+			CHECK(allocator.stats().limitFailures == 1u);
+			allocator.deallocate(pBlock);
+		}
+	}
+}
+
+
+SCENARIO("Backing a Duktape heap with pools", "[HeapAllocator]")
+{
+	GIVEN("a heap using the allocator")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		HeapAllocator allocator;
+		dukdemo::scripting::BodyTable bodyTable;
+		HeapState state;
+		state.pAllocator = &allocator;
+		state.pBodyTable = &bodyTable;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		dukdemo::scripting::world::init(pCtx);
+		dukdemo::scripting::body::init(pCtx);
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(pCtx, &world);
+		duk_put_global_string(pCtx, "world");
+
+		WHEN("bodies are created and destroyed from JS")
+		{
+			auto const before = allocator.stats().systemAllocations;
+			REQUIRE(duk_peval_string(pCtx, R"JS(
+				for (var i = 0; i < 1000; ++i) {
+					world.destroyBody(world.createBody({}));
+				}
+			)JS") == DUK_EXEC_SUCCESS);
+
+			THEN("most allocations are served from the pools")
+			{
+				auto const& stats = allocator.stats();
+				std::size_t pooled = 0u;
+				std::size_t hits = 0u;
+				for (auto const& classStats: stats.classes)
+				{
+					pooled += classStats.allocations;
+					hits += classStats.hits;
+				}
+				CHECK(stats.bytesLive > 0u);
+				CHECK(stats.systemAllocations - before < 100u);
+				CHECK(double(hits) > 0.9 * double(pooled));
+			}
+		}
+	}
+
+	GIVEN("a heap with a memory limit")
+	{
+		HeapAllocator allocator{1024u * 1024u};
+		HeapState state;
+		state.pAllocator = &allocator;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		REQUIRE(pContext);
+
+		WHEN("a script exceeds the limit")
+		{
+			auto const result = duk_peval_string(pContext.get(), R"JS(
+				var chunks = [];
+				for (var i = 0; i < 1e6; ++i) {
+					chunks.push(new Array(1024).join('x') + i);
+				}
+			)JS");
+
+			THEN("it fails with an error rather than taking more memory")
+			{
+				CHECK(result != DUK_EXEC_SUCCESS);
+				CHECK(allocator.stats().limitFailures > 0u);
+				CHECK(allocator.stats().peakBytes <= allocator.memoryLimit());
+			}
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#include <sstream>
+#include <string>
+
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/ExecBudget.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/JsSampler.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::ExecBudget;
+using dukdemo::scripting::HeapState;
+using dukdemo::scripting::JsSampler;
+
+
+/** Sample the calling script's stack. */
+duk_ret_t
+sampleNow(duk_context* pContext)
+{
+	dukdemo::scripting::getHeapState(pContext)->pSampler->sample(pContext);
+	return 0;
+}
+
+
+SCENARIO("Sampling JS call stacks", "[JsSampler]")
+{
+	GIVEN("a heap with a sampler")
+	{
+		JsSampler sampler;
+		HeapState state;
+		state.pSampler = &sampler;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		duk_push_c_function(pCtx, sampleNow, 0);
+		duk_put_global_string(pCtx, "sampleNow");
+
+		WHEN("nothing is running")
+		{
+			THEN("no sample is taken")
+			{
+				CHECK_FALSE(sampler.sample(pCtx));
+				CHECK(sampler.samples() == 0u);
+			}
+		}
+
+		WHEN("a nested function is sampled twice")
+		{
+			duk_push_string(pCtx, "scene.js");
+			duk_compile_string_filename(pCtx, 0,
+				"function inner() { sampleNow(); }\n"
+				"function outer() { inner(); }\n"
+				"outer(); outer();\n");
+			duk_call(pCtx, 0);
+			duk_pop(pCtx);
+
+			std::ostringstream folded;
+			sampler.writeFolded(folded);
+
+			THEN("the stack is folded outermost first, and counted")
+			{
+				CHECK(sampler.samples() == 2u);
+				auto const text = folded.str();
+				auto const outer = text.find("outer (scene.js:2)");
+				auto const inner = text.find("inner (scene.js:1)");
+				REQUIRE(outer != std::string::npos);
+				REQUIRE(inner != std::string::npos);
+				CHECK(outer < inner);
+				CHECK(text.find("[native] 2\n") != std::string::npos);
+			}
+
+			AND_WHEN("the samples are cleared")
+			{
+				sampler.clear();
+
+				THEN("none are left")
+				{
+					std::ostringstream cleared;
+					sampler.writeFolded(cleared);
+					CHECK(sampler.samples() == 0u);
+					CHECK(cleared.str().empty());
+				}
+			}
+		}
+
+		WHEN("samples come due while a script runs")
+		{
+			sampler.setInterval(JsSampler::Duration{0.0});
+			// As the interrupt hook does.
+			sampler.poll();
+			sampler.poll();
+			sampler.poll();
+
+			THEN("they wait for the call to return")
+			{
+				CHECK(sampler.pending() == 3u);
+				CHECK(sampler.samples() == 0u);
+			}
+
+			AND_WHEN("a budgeted call returns")
+			{
+				ExecBudget budget;
+				duk_eval_string(pCtx, "(function step() {})");
+				REQUIRE(budget.pcall(pCtx, 0, "step") == DUK_EXEC_SUCCESS);
+				duk_pop(pCtx);
+
+				std::ostringstream folded;
+				sampler.writeFolded(folded);
+
+				THEN("they're charged to its call site")
+				{
+					CHECK(sampler.pending() == 0u);
+					CHECK(sampler.samples() == 3u);
+					CHECK(folded.str() == "step 3\n");
+				}
+			}
+		}
+
+#ifdef DUKDEMO_EXEC_TIMEOUT
+		WHEN("a busy script never calls a native binding")
+		{
+			sampler.setInterval(JsSampler::Duration{0.0});
+			ExecBudget budget;
+			duk_eval_string(pCtx,
+				"(function busy() {\n"
+				"  var x = 0;\n"
+				"  for (var i = 0; i < 1000000; ++i) { x += i; }\n"
+				"})");
+			REQUIRE(budget.pcall(pCtx, 0, "busy") == DUK_EXEC_SUCCESS);
+			duk_pop(pCtx);
+
+			std::ostringstream folded;
+			sampler.writeFolded(folded);
+
+			THEN("the interrupt hook's samples are charged to its call site")
+			{
+				CHECK(sampler.pending() == 0u);
+				CHECK(sampler.samples() > 0u);
+				CHECK(folded.str().find("busy ") == 0u);
+			}
+		}
+#endif
+	}
+}
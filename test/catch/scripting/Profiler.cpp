@@ -0,0 +1,89 @@
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/Profiler.h"
+#include "dukdemo/util/FrameProfiler.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::HeapState;
+using dukdemo::util::FrameProfiler;
+
+
+SCENARIO("Reading frame timings from scripts", "[Profiler]")
+{
+	GIVEN("a heap with a profiler")
+	{
+		FrameProfiler profiler;
+		auto const step = profiler.addPhase("step");
+		profiler.recordCpu(step, 2e-3);
+		profiler.recordGpu(step, 1e-3);
+		auto const drawn = profiler.addCounter("drawn_fixtures");
+		profiler.recordCount(drawn, 10u);
+		profiler.recordCount(drawn, 20u);
+		profiler.endFrame();
+
+		HeapState state;
+		state.pProfiler = &profiler;
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(&state)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		dukdemo::scripting::profiler::init(pCtx);
+
+		WHEN("a script reads the stats")
+		{
+			duk_eval_string(pCtx,
+				"var stats = profiler.stats();"
+				"[stats.frames, stats.phases.step.cpu.mean,"
+				" stats.phases.step.gpu.max, stats.phases.step.cpu.samples]");
+
+			THEN("they are in milliseconds")
+			{
+				duk_get_prop_index(pCtx, -1, 0);
+				CHECK(duk_get_number(pCtx, -1) == 1.0);
+				duk_get_prop_index(pCtx, -2, 1);
+				CHECK(duk_get_number(pCtx, -1) == Approx(2.0));
+				duk_get_prop_index(pCtx, -3, 2);
+				CHECK(duk_get_number(pCtx, -1) == Approx(1.0));
+				duk_get_prop_index(pCtx, -4, 3);
+				CHECK(duk_get_number(pCtx, -1) == 1.0);
+			}
+		}
+
+		WHEN("a script reads the counters")
+		{
+			duk_eval_string(pCtx,
+				"var drawn = profiler.stats().counters.drawn_fixtures;"
+				"[drawn.latest, drawn.mean, drawn.samples]");
+
+			THEN("each counter's latest value and mean are given")
+			{
+				duk_get_prop_index(pCtx, -1, 0);
+				CHECK(duk_get_number(pCtx, -1) == 20.0);
+				duk_get_prop_index(pCtx, -2, 1);
+				CHECK(duk_get_number(pCtx, -1) == Approx(15.0));
+				duk_get_prop_index(pCtx, -3, 2);
+				CHECK(duk_get_number(pCtx, -1) == 2.0);
+			}
+		}
+	}
+
+	GIVEN("a heap without a profiler")
+	{
+		testutils::duk_context_ptr pContext{
+			dukdemo::scripting::createHeap(nullptr)};
+		auto* const pCtx = pContext.get();
+		REQUIRE(pCtx != nullptr);
+		dukdemo::scripting::profiler::init(pCtx);
+
+		THEN("the stats are undefined")
+		{
+			duk_eval_string(pCtx, "profiler.stats() === undefined");
+			CHECK(duk_get_boolean(pCtx, -1));
+		}
+	}
+}
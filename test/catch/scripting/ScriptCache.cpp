@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <catch.hpp>
+
+#include <duktape.h>
+
+#include "dukdemo/scripting/ScriptCache.h"
+
+#include "physics/test_utils.h"
+
+
+using dukdemo::scripting::ScriptCache;
+
+
+namespace {
+
+
+int
+runCachedScript(ScriptCache& cache, std::string const& source)
+{
+	testutils::Heap pContext;
+	REQUIRE(cache.pushFunction(pContext.get(), source, "cached.js"));
+	REQUIRE(duk_pcall(pContext.get(), 0) == DUK_EXEC_SUCCESS);
+	return duk_get_int(pContext.get(), -1);
+}
+
+
+} // namespace
+
+
+SCENARIO("Caching compiled scripts", "[ScriptCache]")
+{
+	GIVEN("a cache and a script")
+	{
+		ScriptCache cache{P_tmpdir};
+		std::string const source{
+			"var sum = 0; for (var i = 1; i <= 10; ++i) { sum += i; } sum;"};
+		auto const path = cache.pathFor(source, "cached.js");
+		std::remove(path.c_str());
+
+		WHEN("the script is first run")
+		{
+			auto const result = runCachedScript(cache, source);
+
+			THEN("it is compiled and cached")
+			{
+				CHECK(result == 55);
+				CHECK(cache.stats().misses == 1u);
+				CHECK(cache.stats().hits == 0u);
+				CHECK(cache.stats().writeFailures == 0u);
+				CHECK(std::ifstream{path}.good());
+			}
+
+			AND_WHEN("it is run again in a new heap")
+			{
+				auto const rerunResult = runCachedScript(cache, source);
+
+				THEN("the cached bytecode is used")
+				{
+					CHECK(rerunResult == 55);
+					CHECK(cache.stats().hits == 1u);
+					CHECK(cache.stats().misses == 1u);
+				}
+			}
+
+			AND_WHEN("the source changes")
+			{
+				auto const changed = source + " sum * 2;";
+				auto const changedResult = runCachedScript(cache, changed);
+				std::remove(cache.pathFor(changed, "cached.js").c_str());
+
+				THEN("it is recompiled")
+				{
+					CHECK(changedResult == 110);
+					CHECK(cache.stats().hits == 0u);
+					CHECK(cache.stats().misses == 2u);
+				}
+			}
+
+			AND_WHEN("the cache file is truncated")
+			{
+				std::ofstream{path, std::ios::out | std::ios::binary}
+					<< "DUKBC";
+				auto const rerunResult = runCachedScript(cache, source);
+
+				THEN("it is recompiled")
+				{
+					CHECK(rerunResult == 55);
+					CHECK(cache.stats().hits == 0u);
+					CHECK(cache.stats().misses == 2u);
+				}
+			}
+		}
+
+		WHEN("the script has a syntax error")
+		{
+			testutils::Heap pContext;
+			bool const compiled =
+				cache.pushFunction(pContext.get(), "var = ;", "broken.js");
+
+			THEN("false is returned with the error on the stack")
+			{
+				CHECK(!compiled);
+				CHECK(duk_is_error(pContext.get(), -1));
+			}
+		}
+
+		std::remove(path.c_str());
+	}
+}
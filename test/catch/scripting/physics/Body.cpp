@@ -1,3 +1,5 @@
+#include <string>
+
 #include <catch.hpp>
 
 #include <Box2D/Dynamics/b2World.h>
@@ -33,7 +35,7 @@ SCENARIO("Creating Box2D bodies", "[createBody]")
 {
 	GIVEN("a duktape context and world")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 		dukdemo::scripting::world::init(pContext.get());
 		dukdemo::scripting::body::init(pContext.get());
 
@@ -46,8 +48,6 @@ SCENARIO("Creating Box2D bodies", "[createBody]")
 
 		WHEN("we create a body in a script")
 		{
-			using dukdemo::scripting::g_ownBodyPtrSym;
-
 			// THEN("the object is an instanceof Body")
 			// {
 			// 	duk_eval_string(pContext.get(), pCreateBodyScript);
@@ -56,16 +56,14 @@ SCENARIO("Creating Box2D bodies", "[createBody]")
 			THEN("the body pointer is accessible")
 			{
 				duk_eval_string(pContext.get(), pCreateBodyScript);
-				duk_get_prop_string(pContext.get(), -1, g_ownBodyPtrSym);
-				auto const* const pBody = static_cast<b2Body*>(
-					duk_get_pointer(pContext.get(), -1));
+				auto const* const pBody =
+					dukdemo::scripting::body::getBodyPtrAt(pContext.get(), -1);
 				REQUIRE(bool(pBody));
 			}
 			// THEN("the body is inserted into the world")
 			// {
-			// 	duk_get_prop_string(pContext.get(), -1, g_ownBodyPtrSym);
-			// 	auto const* const pBody = static_cast<b2Body*>(
-			// 		duk_get_pointer(pContext.get(), -1));
+			// 	auto const* const pBody = dukdemo::scripting::body::
+			// 		getBodyPtrAt(pContext.get(), -1);
 			// 	REQUIRE(bool(pBody));
 			// 	CHECK(pBody->GetWorld() == &world);
 			// 	CHECK(world.GetBodyList() == pBody);
@@ -73,3 +71,188 @@ SCENARIO("Creating Box2D bodies", "[createBody]")
 		}
 	}
 }
+
+
+SCENARIO("Creating Box2D bodies in bulk", "[createBodies]")
+{
+	GIVEN("a duktape context and world")
+	{
+		// Declare the world first so it outlives any body finalizers.
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+
+		WHEN("we create several bodies in a script")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				world.createBodies([
+					{position: [1, 0]},
+					{position: [2, 0]},
+					{position: [3, 0]}
+				]);
+			)JS");
+
+			THEN("an array with one Body per definition is returned")
+			{
+				REQUIRE(duk_is_array(pContext.get(), -1));
+				CHECK(duk_get_length(pContext.get(), -1) == 3);
+			}
+			THEN("every body is inserted into the world")
+			{
+				CHECK(world.GetBodyCount() == 3);
+			}
+			THEN("the bodies are returned in definition order")
+			{
+				duk_get_prop_index(pContext.get(), -1, 2);
+				auto const* const pBody =
+					dukdemo::scripting::body::getBodyPtrAt(pContext.get(), -1);
+				REQUIRE(bool(pBody));
+				CHECK(pBody->GetPosition().x == Approx(3.0f));
+			}
+		}
+
+		WHEN("one of the definitions is invalid")
+		{
+			auto const rc = duk_peval_string(pContext.get(), R"JS(
+				world.createBodies([{position: [1, 0]}, {type: 'wobbly'}]);
+			)JS");
+
+			THEN("an error is thrown and no bodies are created")
+			{
+				CHECK(rc != 0);
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+
+		WHEN("a huge sparse array is given")
+		{
+			auto const rc = duk_peval_string(pContext.get(), R"JS(
+				var defs = [];
+				defs.length = 0xffffffff;
+				world.createBodies(defs);
+			)JS");
+
+			THEN("a RangeError is thrown and no bodies are created")
+			{
+				CHECK(rc != 0);
+				CHECK(duk_get_error_code(pContext.get(), -1)
+					== DUK_ERR_RANGE_ERROR);
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Destroying Box2D bodies", "[destroyBody]")
+{
+	GIVEN("a body created in a script")
+	{
+		// Declare the world first so it outlives any body finalizers.
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+		duk_eval_string(pContext.get(), pCreateBodyScript);
+
+		THEN("the body handle is not enumerable")
+		{
+			duk_eval_string(pContext.get(), "Object.keys(body).join(',')");
+			std::string const keys{duk_get_string(pContext.get(), -1)};
+			CHECK(keys == "world");
+		}
+
+		WHEN("the body is destroyed")
+		{
+			duk_eval_string(pContext.get(), "world.destroyBody(body); body");
+
+			THEN("the Box2D body is removed from the world")
+			{
+				CHECK(world.GetBodyCount() == 0);
+			}
+			THEN("the stale handle resolves to null")
+			{
+				CHECK(!dukdemo::scripting::body::getBodyPtrAt(
+					pContext.get(), -1));
+			}
+			THEN("calling methods on the stale body throws")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "body.setLinearVelocity(1, 2);");
+				CHECK(rc != 0);
+			}
+			THEN("destroying it again is harmless")
+			{
+				duk_eval_string(pContext.get(), "world.destroyBody(body);");
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Bodies owned by their world", "[BodyLifetime]")
+{
+	GIVEN("a world created in JS")
+	{
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+		duk_eval_string(pContext.get(), R"JS(
+			world = new World([0, 0]);
+			body = world.createBody({type: 'dynamic'});
+		)JS");
+		auto const bodyIdx = duk_normalize_index(pContext.get(), -1);
+
+		THEN("bodies are created without a finalizer")
+		{
+			duk_get_finalizer(pContext.get(), bodyIdx);
+			CHECK(!duk_get_c_function(pContext.get(), -1));
+		}
+
+		WHEN("the world is finalized")
+		{
+			duk_push_c_function(
+				pContext.get(), dukdemo::scripting::world::finalizer, 1);
+			duk_get_global_string(pContext.get(), "world");
+			duk_call(pContext.get(), 1);
+
+			THEN("the handles of its bodies become stale")
+			{
+				CHECK(!dukdemo::scripting::body::getBodyPtrAt(
+					pContext.get(), bodyIdx));
+			}
+			THEN("destroying a stale body is harmless")
+			{
+				duk_eval_string(pContext.get(), "world.destroyBody(body);");
+			}
+		}
+	}
+
+	GIVEN("a world pushed without a finalizer")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+		duk_eval_string(pContext.get(), pCreateBodyScript);
+
+		THEN("bodies keep their own finalizer")
+		{
+			duk_get_finalizer(pContext.get(), -1);
+			CHECK(bool(duk_get_c_function(pContext.get(), -1)));
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#include <catch.hpp>
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+
+#include "dukdemo/scripting/BodyTable.h"
+
+
+using dukdemo::scripting::BodyTable;
+
+
+SCENARIO("Storing bodies in a BodyTable", "[BodyTable]")
+{
+	GIVEN("a table and some bodies")
+	{
+		BodyTable table;
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		b2BodyDef const bodyDef;
+		auto* const pFirst = world.CreateBody(&bodyDef);
+		auto* const pSecond = world.CreateBody(&bodyDef);
+
+		WHEN("bodies are inserted")
+		{
+			auto const first = table.insert(pFirst);
+			auto const second = table.insert(pSecond);
+
+			THEN("their handles resolve to them")
+			{
+				CHECK(table.get(first) == pFirst);
+				CHECK(table.get(second) == pSecond);
+				CHECK(table.size() == 2u);
+			}
+			THEN("handles are never the invalid handle")
+			{
+				CHECK(first != BodyTable::s_invalidHandle);
+				CHECK(second != BodyTable::s_invalidHandle);
+			}
+			THEN("reinserting a body returns its existing handle")
+			{
+				CHECK(table.insert(pFirst) == first);
+				CHECK(table.size() == 2u);
+			}
+			THEN("bodies can be found by pointer")
+			{
+				CHECK(table.find(pFirst) == first);
+				CHECK(table.find(pSecond) == second);
+			}
+			THEN("the bodies' user data is left alone")
+			{
+				CHECK(pFirst->GetUserData() == nullptr);
+				CHECK(pSecond->GetUserData() == nullptr);
+			}
+		}
+
+		WHEN("a body is removed")
+		{
+			auto const first = table.insert(pFirst);
+			REQUIRE(table.remove(first) == pFirst);
+
+			THEN("its handle becomes stale")
+			{
+				CHECK(table.get(first) == nullptr);
+				CHECK(table.remove(first) == nullptr);
+				CHECK(table.find(pFirst) == BodyTable::s_invalidHandle);
+				CHECK(table.size() == 0u);
+			}
+			THEN("a reused slot does not revive the stale handle")
+			{
+				auto const second = table.insert(pSecond);
+				CHECK(second != first);
+				CHECK(table.get(first) == nullptr);
+				CHECK(table.get(second) == pSecond);
+			}
+		}
+
+		WHEN("looking up a handle which was never issued")
+		{
+			THEN("null is returned")
+			{
+				CHECK(table.get(BodyTable::s_invalidHandle) == nullptr);
+				CHECK(table.get(12345u) == nullptr);
+			}
+		}
+	}
+}
@@ -0,0 +1,238 @@
+#include <vector>
+
+#include <catch.hpp>
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#include <duktape.h>
+
+#include "./test_utils.h"
+
+#include "dukdemo/scripting/World.h"
+#include "dukdemo/scripting/Body.h"
+#include "dukdemo/scripting/Prefab.h"
+
+
+namespace ds = dukdemo::scripting;
+
+
+constexpr char const* const pCratePrefabJSON = R"JSON({
+	"type": "dynamic",
+	"angularDamping": 0.5,
+	"fixtures": [
+		{
+			"density": 2,
+			"friction": 0.7,
+			"shape": {
+				"type": "polygon",
+				"vertices": [[-1, -1], [1, -1], [1, 1], [-1, 1]]
+			}
+		},
+		{
+			"isSensor": true,
+			"shape": {"type": "circle", "radius": 2, "position": [0, 0]}
+		}
+	]
+})JSON";
+
+
+/** Runs a script when contact begins, while the world is locked. */
+class ScriptOnContact: public b2ContactListener
+{
+public:
+	ScriptOnContact(duk_context* pContext, char const* pScript)
+		:	m_pContext{pContext}
+		,	m_pScript{pScript}
+		,	m_results{}
+	{}
+
+	ScriptOnContact(ScriptOnContact const&) = delete;
+	ScriptOnContact& operator=(ScriptOnContact const&) = delete;
+
+	void
+	BeginContact(b2Contact*) override
+	{
+		m_results.push_back(duk_peval_string(m_pContext, m_pScript));
+		duk_pop(m_pContext);
+	}
+
+	std::vector<duk_int_t> const&
+	results() const noexcept
+	{ return m_results; }
+
+private:
+	duk_context* m_pContext;
+	char const* m_pScript;
+	std::vector<duk_int_t> m_results;
+};
+
+
+SCENARIO("Loading prefabs", "[loadPrefab]")
+{
+	GIVEN("a duktape context")
+	{
+		testutils::Heap pContext;
+
+		WHEN("loading a valid prefab")
+		{
+			testutils::pushJSONObject(pContext.get(), pCratePrefabJSON);
+			ds::Prefab prefab;
+			bool const valid = ds::loadPrefab(pContext.get(), -1, &prefab);
+
+			THEN("the body and fixture definitions are loaded")
+			{
+				REQUIRE(valid);
+				CHECK(prefab.bodyDef.type == b2_dynamicBody);
+				CHECK(prefab.bodyDef.angularDamping == Approx(0.5f));
+				REQUIRE(prefab.fixtures.size() == 2u);
+				CHECK(prefab.fixtures[0].def.density == Approx(2.0f));
+				CHECK(prefab.fixtures[1].def.isSensor);
+			}
+			THEN("shapes are converted up front")
+			{
+				REQUIRE(valid);
+				auto const* const pShape = prefab.fixtures[0].pShape.get();
+				REQUIRE(pShape->GetType() == b2Shape::e_polygon);
+				CHECK(prefab.fixtures[0].def.shape == pShape);
+				auto const* const pPolygon =
+					static_cast<b2PolygonShape const*>(pShape);
+				CHECK(pPolygon->m_count == 4);
+			}
+			THEN("the stack is left as it was")
+			{
+				CHECK(duk_get_top(pContext.get()) == 2);
+			}
+		}
+
+		WHEN("a fixture has an invalid shape")
+		{
+			testutils::pushJSONObject(pContext.get(), R"JSON({
+				"fixtures": [{"shape": {"type": "blob"}}]
+			})JSON");
+			ds::Prefab prefab;
+			prefab.bodyDef.angle = 1.0f;
+
+			THEN("loading fails and the prefab is unmodified")
+			{
+				REQUIRE(!ds::loadPrefab(pContext.get(), -1, &prefab));
+				CHECK(prefab.bodyDef.angle == Approx(1.0f));
+				CHECK(prefab.fixtures.empty());
+			}
+		}
+	}
+}
+
+
+SCENARIO("Spawning bodies from prefabs", "[spawn]")
+{
+	GIVEN("a world and a compiled prefab")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		ds::world::init(pContext.get());
+		ds::body::init(pContext.get());
+		ds::world::pushWorldWithoutFinalizer(pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+
+		duk_push_global_object(pContext.get());
+		testutils::pushJSONObject(pContext.get(), pCratePrefabJSON);
+		duk_put_prop_string(pContext.get(), -2, "crateDef");
+		duk_eval_string(
+			pContext.get(), "crate = World.compilePrefab(crateDef);");
+
+		WHEN("the prefab is spawned")
+		{
+			duk_eval_string(pContext.get(), "world.spawn(crate, 3, 4, 0.25);");
+
+			THEN("a body with the prefab's fixtures is created")
+			{
+				auto* const pBody = ds::body::getBodyPtrAt(pContext.get(), -1);
+				REQUIRE(bool(pBody));
+				CHECK(pBody->GetType() == b2_dynamicBody);
+				CHECK(pBody->GetPosition().x == Approx(3.0f));
+				CHECK(pBody->GetPosition().y == Approx(4.0f));
+				CHECK(pBody->GetAngle() == Approx(0.25f));
+
+				int fixtureCount = 0;
+				for (
+					auto* pFixture = pBody->GetFixtureList();
+					pFixture;
+					pFixture = pFixture->GetNext()
+				)
+				{
+					++fixtureCount;
+				}
+				CHECK(fixtureCount == 2);
+			}
+		}
+
+		WHEN("spawning many times")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				for (var i = 0; i < 100; ++i) {
+					world.spawn(crate, i, 0);
+				}
+			)JS");
+
+			THEN("every spawn creates a body")
+			{
+				CHECK(world.GetBodyCount() == 100);
+			}
+		}
+
+		WHEN("the prefab is spawned without a position or angle")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				crateDef.position = [5, 6];
+				crateDef.angle = 0.5;
+				world.spawn(World.compilePrefab(crateDef));
+			)JS");
+
+			THEN("the prefab's position and angle are used")
+			{
+				auto* const pBody = ds::body::getBodyPtrAt(pContext.get(), -1);
+				REQUIRE(bool(pBody));
+				CHECK(pBody->GetPosition().x == Approx(5.0f));
+				CHECK(pBody->GetPosition().y == Approx(6.0f));
+				CHECK(pBody->GetAngle() == Approx(0.5f));
+			}
+		}
+
+		WHEN("spawning while the world is stepping")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				world.spawn(crate, 0, 0);
+				world.spawn(crate, 0.5, 0);
+			)JS");
+			ScriptOnContact listener{pContext.get(), "world.spawn(crate);"};
+			world.SetContactListener(&listener);
+			world.Step(1.0f / 60.0f, 8, 3);
+			world.SetContactListener(nullptr);
+
+			THEN("an error is thrown and no body is created")
+			{
+				REQUIRE(!listener.results().empty());
+				for (auto const rc: listener.results())
+				{
+					CHECK(rc != 0);
+				}
+				CHECK(world.GetBodyCount() == 2);
+			}
+		}
+
+		WHEN("spawning something which is not a prefab")
+		{
+			THEN("a TypeError is thrown")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "world.spawn(crateDef, 0, 0);");
+				CHECK(rc != 0);
+				CHECK(world.GetBodyCount() == 0);
+			}
+		}
+	}
+}
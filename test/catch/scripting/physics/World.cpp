@@ -1,3 +1,7 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include <catch.hpp>
 
 #include <Box2D/Dynamics/b2World.h>
@@ -8,6 +12,7 @@
 
 #include "dukdemo/scripting/util.h"
 #include "dukdemo/scripting/World.h"
+#include "dukdemo/scripting/Body.h"
 
 
 void checkIsWorldInstance(duk_context* pContext, duk_idx_t index)
@@ -22,7 +27,7 @@ SCENARIO("Creating a Box2D world", "[scripting::world]")
 {
 	GIVEN("a duktape context initialised by the world module")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 		dukdemo::scripting::world::init(pContext.get());
 
 		THEN("the World constructor exists on the global object")
@@ -138,3 +143,295 @@ SCENARIO("Creating a Box2D world", "[scripting::world]")
 		}
 	}
 }
+
+
+SCENARIO("Reading body transforms in bulk", "[readTransforms]")
+{
+	GIVEN("a world containing two bodies")
+	{
+		// Declare the world first so it outlives any body finalizers.
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+
+		duk_eval_string(pContext.get(), R"JS(
+			world.createBody({
+				type: 'dynamic',
+				position: [1, 2],
+				angle: 0.5,
+				linearVelocity: [3, 4]
+			});
+			world.createBody({position: [5, 6]});
+		)JS");
+		duk_pop(pContext.get());
+
+		WHEN("the array has room for every body")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				out = new Float32Array(6);
+				world.readTransforms(out);
+			)JS");
+
+			THEN("the body count is returned")
+			{
+				CHECK(duk_get_int(pContext.get(), -1) == 2);
+			}
+
+			THEN("positions and angles are packed in body list order")
+			{
+				// Box2D prepends new bodies to its body list.
+				duk_eval_string(
+					pContext.get(), "Array.prototype.slice.call(out)");
+				float const expected[] = {5.0f, 6.0f, 0.0f, 1.0f, 2.0f, 0.5f};
+				for (duk_uarridx_t i = 0u; i < 6u; ++i)
+				{
+					duk_get_prop_index(pContext.get(), -1, i);
+					auto const value = duk_get_number(pContext.get(), -1);
+					CHECK(value == Approx(expected[i]));
+					duk_pop(pContext.get());
+				}
+			}
+		}
+
+		WHEN("velocities are requested")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				out = new Float32Array(12);
+				world.readTransforms(out, true);
+				out[9] + ',' + out[10];
+			)JS");
+
+			THEN("linear velocities follow the transform")
+			{
+				std::string const velocity{duk_get_string(pContext.get(), -1)};
+				CHECK(velocity == "3,4");
+			}
+		}
+
+		WHEN("the array is too small")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				out = new Float32Array(4);
+				out[3] = 99;
+				world.readTransforms(out);
+			)JS");
+
+			THEN("only whole bodies are written")
+			{
+				CHECK(duk_get_int(pContext.get(), -1) == 2);
+				duk_eval_string(pContext.get(), "out[3]");
+				CHECK(duk_get_number(pContext.get(), -1) == Approx(99.0f));
+			}
+		}
+
+		WHEN("given something other than a Float32Array")
+		{
+			THEN("a TypeError is thrown")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "world.readTransforms([0, 0, 0]);");
+				CHECK(rc != 0);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Snapshotting and restoring a world", "[snapshot]")
+{
+	GIVEN("a world containing a moving body")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+
+		duk_eval_string(pContext.get(), R"JS(
+			body = world.createBody({type: 'dynamic', linearVelocity: [3, 4]});
+			state = world.snapshot();
+		)JS");
+		duk_pop(pContext.get());
+
+		THEN("the snapshot is a buffer")
+		{
+			duk_get_global_string(pContext.get(), "state");
+			CHECK(duk_is_buffer_data(pContext.get(), -1));
+		}
+
+		WHEN("the world changes, then is restored")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				extra = world.createBody({});
+				body.setLinearVelocity(5, 6);
+				world.setGravity(0, -10);
+				world.restore(state);
+				out = new Float32Array(6);
+				world.readTransforms(out, true) + ':' + out[3] + ',' + out[4];
+			)JS");
+
+			THEN("the body keeps its object and regains its velocity")
+			{
+				std::string const result{duk_get_string(pContext.get(), -1)};
+				CHECK(result == "1:3,4");
+				CHECK(world.GetGravity().y == 0.0f);
+				auto const rc = duk_peval_string(
+					pContext.get(), "body.setLinearVelocity(1, 1);");
+				CHECK(rc == 0);
+			}
+
+			THEN("the body created since is destroyed, with its handle")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "extra.setLinearVelocity(1, 1);");
+				CHECK(rc != 0);
+			}
+		}
+
+		WHEN("the body is destroyed and another created, then restored")
+		{
+			// The new body may take the destroyed body's address.
+			duk_eval_string(pContext.get(), R"JS(
+				world.destroyBody(body);
+				other = world.createBody({});
+				world.restore(state);
+				out = new Float32Array(6);
+				world.readTransforms(out, true) + ':' + out[3] + ',' + out[4];
+			)JS");
+
+			THEN("the lost body is recreated with its velocity")
+			{
+				std::string const result{duk_get_string(pContext.get(), -1)};
+				CHECK(result == "1:3,4");
+			}
+
+			THEN("the new body is destroyed, with its handle")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "other.setLinearVelocity(1, 1);");
+				CHECK(rc != 0);
+			}
+		}
+
+		WHEN("given something other than a snapshot")
+		{
+			THEN("a TypeError is thrown")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "world.restore({});");
+				CHECK(rc != 0);
+				auto const rcShort = duk_peval_string(
+					pContext.get(), "world.restore(new Uint8Array(8));");
+				CHECK(rcShort != 0);
+				CHECK(world.GetBodyCount() == 1);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Tracking a world's static geometry version", "[scripting::world]")
+{
+	GIVEN("a world in a heap with a static geometry version")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		testutils::Heap pContext;
+		std::uint64_t staticVersion = 1u;
+		pContext.state().pStaticVersion = &staticVersion;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		dukdemo::scripting::world::pushWorldWithoutFinalizer(
+			pContext.get(), &world);
+		duk_put_global_string(pContext.get(), "world");
+
+		WHEN("dynamic bodies are created and destroyed")
+		{
+			duk_eval_string_noresult(pContext.get(), R"JS(
+				world.destroyBody(world.createBody({type: 'dynamic'}));
+				world.createBodies([{type: 'kinematic'}]);
+			)JS");
+
+			THEN("the version is unchanged")
+			{
+				CHECK(staticVersion == 1u);
+			}
+		}
+
+		WHEN("a static body is created, then destroyed")
+		{
+			duk_eval_string_noresult(
+				pContext.get(), "ground = world.createBody({});");
+			auto const created = staticVersion;
+			duk_eval_string_noresult(
+				pContext.get(), "world.destroyBody(ground);");
+
+			THEN("each bumps the version")
+			{
+				CHECK(created == 2u);
+				CHECK(staticVersion == 3u);
+			}
+		}
+
+		WHEN("the world is restored")
+		{
+			duk_eval_string_noresult(
+				pContext.get(), "world.restore(world.snapshot());");
+
+			THEN("the version is bumped")
+			{
+				CHECK(staticVersion == 2u);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Detaching a world destroyed natively", "[scripting::world]")
+{
+	GIVEN("a world pushed without a finalizer, with a body")
+	{
+		auto pWorld = std::make_unique<b2World>(b2Vec2{0.0f, 0.0f});
+		testutils::Heap pContext;
+		dukdemo::scripting::world::init(pContext.get());
+		dukdemo::scripting::body::init(pContext.get());
+
+		using dukdemo::scripting::world::pushWorldWithoutFinalizer;
+		auto const worldIdx = pushWorldWithoutFinalizer(
+			pContext.get(), pWorld.get());
+		duk_dup(pContext.get(), worldIdx);
+		duk_put_global_string(pContext.get(), "world");
+		duk_eval_string(pContext.get(), "body = world.createBody({});");
+		duk_pop(pContext.get());
+		REQUIRE(pContext.bodyTable().size() == 1u);
+
+		WHEN("it is detached, then destroyed")
+		{
+			dukdemo::scripting::world::detach(pContext.get(), worldIdx);
+			pWorld.reset();
+
+			THEN("the body's handle is cleared")
+			{
+				CHECK(pContext.bodyTable().size() == 0u);
+				auto const rc = duk_peval_string(
+					pContext.get(), "body.setLinearVelocity(1, 1);");
+				CHECK(rc != 0);
+			}
+
+			THEN("the world can no longer be used")
+			{
+				auto const rc = duk_peval_string(
+					pContext.get(), "world.createBody({});");
+				CHECK(rc != 0);
+			}
+		}
+	}
+}
@@ -55,7 +55,7 @@ SCENARIO("When loading body defs from duktape", "[loadBodyDef]")
 {
 	GIVEN("a duktape context")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 		// Push some junk to the value stack.
 		duk_push_number(pContext.get(), 123);
 		duk_push_string(pContext.get(), "dummy test data");
@@ -193,6 +193,27 @@ SCENARIO("When loading body defs from duktape", "[loadBodyDef]")
 			testString("dynamic works", "static", b2_dynamicBody);
 		}
 
+		WHEN("the definition has other properties")
+		{
+			auto const top = duk_get_top(pContext.get());
+			duk_eval_string(pContext.get(),
+				"({angle: 1.5, shape: {type: 'circle'},"
+				" gravityScale: undefined, name: 'crate', 0: 'index'})");
+			bool const result = ds::loadBodyDef(pContext.get(), -1, &bodyDef);
+
+			THEN("they and undefined properties are ignored")
+			{
+				REQUIRE(result);
+				CHECK(bodyDef.angle == Approx(1.5f));
+				CHECK(bodyDef.gravityScale == Approx(1.0f));
+			}
+
+			THEN("the value stack is left as it was")
+			{
+				CHECK(duk_get_top(pContext.get()) == top + 1);
+			}
+		}
+
 		WHEN("using a partial definition")
 		{
 			// Set some specific, non-default values.
@@ -42,7 +42,7 @@ SCENARIO("Loading fixture defs from duktape", "[loadFixtureDefWithoutShape]")
 {
 	GIVEN("a duktape context")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 		// Push some junk to the value stack.
 		duk_push_number(pContext.get(), 123);
 		duk_push_string(pContext.get(), "dummy test data");
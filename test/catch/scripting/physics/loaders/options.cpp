@@ -51,7 +51,7 @@ testOptionGetter(
 	ResultChecker<Result> checkChangedResultIsCorrect
 )
 {
-	testutils::duk_context_ptr pContext{duk_create_heap_default()};
+	testutils::Heap pContext;
 	auto const ownerIdx = duk_normalize_index(
 		pContext.get(), prepContextForOptionLoad(pContext.get()));
 
@@ -42,7 +42,7 @@ testObjectLoader(
 	ObjectChecker<Result> checkUnmodified
 )
 {
-	testutils::duk_context_ptr pContext{duk_create_heap_default()};
+	testutils::Heap pContext;
 	duk_push_number(pContext.get(), 123);
 	duk_push_string(pContext.get(), "dummy test data");
 
@@ -149,7 +149,7 @@ SCENARIO("Loading a b2CircleShape from JS", "[loadCircle]")
 
 	GIVEN("incomplete data")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 
 		THEN("a missing radius is invalid")
 		{
@@ -250,7 +250,7 @@ SCENARIO("Loading a b2PolygonShape from JS", "[loadPolygon]")
 		{
 			THEN("the operation fails")
 			{
-				testutils::duk_context_ptr pContext{duk_create_heap_default()};
+				testutils::Heap pContext;
 				b2PolygonShape polygon;
 				testutils::pushJSONObject(pContext.get(), "{}");
 				bool const success = ds::loadPolygon(
@@ -425,3 +425,106 @@ SCENARIO("Loading a b2ChainShape from JS", "[loadChain]")
 		);
 	}
 }
+
+
+SCENARIO("Loading a shape of any type from JS", "[loadShape]")
+{
+	GIVEN("a duktape context")
+	{
+		testutils::Heap pContext;
+
+		THEN("the shape type is read from the type property")
+		{
+			testutils::pushJSONObject(pContext.get(), "{\"type\": \"edge\"}");
+			CHECK(ds::getShapeType(pContext.get(), -1) == b2Shape::e_edge);
+		}
+
+		THEN("unknown shape types are rejected")
+		{
+			testutils::pushJSONObject(pContext.get(), "{\"type\": \"blob\"}");
+			CHECK(ds::getShapeType(pContext.get(), -1) == b2Shape::e_typeCount);
+			CHECK(!ds::loadShape(pContext.get(), -1));
+		}
+
+		THEN("the matching loader is used")
+		{
+			testutils::pushJSONObject(pContext.get(), R"JSON({
+				"type": "chain",
+				"vertices": [[0, 0], [1, 1], [2, 2]],
+				"prev": [-1, -1]
+			})JSON");
+			duk_push_number(pContext.get(), 123);
+			auto const pShape = ds::loadShape(pContext.get(), -2);
+			REQUIRE(bool(pShape));
+			REQUIRE(pShape->GetType() == b2Shape::e_chain);
+			auto const& chain = static_cast<b2ChainShape const&>(*pShape);
+			CHECK(chain.m_count == 3);
+			CHECK(chain.m_hasPrevVertex);
+			CHECK(duk_get_top(pContext.get()) == 2);
+		}
+	}
+}
+
+
+SCENARIO("Loading vertices from typed arrays", "[loadPolygon][loadChain]")
+{
+	GIVEN("a duktape context")
+	{
+		testutils::Heap pContext;
+
+		THEN("a polygon can be loaded from a Float32Array")
+		{
+			duk_eval_string(pContext.get(), R"JS(({
+				vertices: new Float32Array([-1, -1, 1, -1, 1, 1, -1, 1])
+			}))JS");
+			b2PolygonShape polygon;
+			initPolygonShape(&polygon);
+			REQUIRE(ds::loadPolygon(pContext.get(), -1, &polygon));
+			checkPolygonShapeFullyLoaded(polygon);
+		}
+
+		THEN("a polygon with too many vertices is rejected")
+		{
+			duk_eval_string(pContext.get(), R"JS(({
+				vertices: new Float64Array(2 * 9)
+			}))JS");
+			b2PolygonShape polygon;
+			initPolygonShape(&polygon);
+			CHECK(!ds::loadPolygon(pContext.get(), -1, &polygon));
+			checkPolygonUnmodified(polygon);
+		}
+
+		THEN("a chain can be loaded from a Float32Array")
+		{
+			duk_eval_string(pContext.get(), R"JS(({
+				vertices: new Float32Array([0, 0, 1, 1, 2, 2]),
+				prev: [-1, -1],
+				next: new Float32Array([3, 3])
+			}))JS");
+			b2ChainShape chain;
+			REQUIRE(ds::loadChain(pContext.get(), -1, &chain));
+			checkChainShapeFullyLoaded(chain);
+		}
+
+		THEN("a chain can be loaded from a Float64Array")
+		{
+			duk_eval_string(pContext.get(), R"JS(({
+				vertices: new Float64Array([0, 0, 1, 1, 2, 2])
+			}))JS");
+			b2ChainShape chain;
+			REQUIRE(ds::loadChain(pContext.get(), -1, &chain));
+			checkChainShapePartiallyLoaded(chain);
+		}
+
+		THEN("a chain with an odd number of coordinates is rejected")
+		{
+			duk_eval_string(pContext.get(), R"JS(({
+				vertices: new Float32Array([0, 0, 1, 1, 2])
+			}))JS");
+			b2ChainShape chain;
+			initChainShape(&chain);
+			CHECK(!ds::loadChain(pContext.get(), -1, &chain));
+			checkChainUnmodified(chain);
+		}
+	}
+}
@@ -18,7 +18,7 @@ SCENARIO("Loading a b2Vec2 from duktape", "[loadVec2]")
 {
 	GIVEN("a duktape context")
 	{
-		testutils::duk_context_ptr pContext{duk_create_heap_default()};
+		testutils::Heap pContext;
 
 		constexpr duk_double_t value0 = 123.0;
 		constexpr char const* const pValue1 = "dummy test data";
@@ -88,3 +88,76 @@ SCENARIO("Loading a b2Vec2 from duktape", "[loadVec2]")
 		}
 	}
 }
+
+
+SCENARIO("Loading a b2Vec2 from a typed array", "[loadVec2]")
+{
+	GIVEN("a duktape context")
+	{
+		testutils::Heap pContext;
+		b2Vec2 result{0.0f, 0.0f};
+
+		THEN("a Float32Array is accepted")
+		{
+			duk_eval_string(pContext.get(), "new Float32Array([1.5, -2.5])");
+			REQUIRE(ds::loadVec2(pContext.get(), -1, &result));
+			CHECK(result.x == Approx(1.5f));
+			CHECK(result.y == Approx(-2.5f));
+		}
+
+		THEN("a Float64Array is accepted")
+		{
+			duk_eval_string(pContext.get(), "new Float64Array([3, 4])");
+			REQUIRE(ds::loadVec2(pContext.get(), -1, &result));
+			CHECK(result.x == Approx(3.0f));
+			CHECK(result.y == Approx(4.0f));
+		}
+
+		THEN("non-finite coordinates are rejected")
+		{
+			duk_eval_string(pContext.get(), "new Float32Array([1, Infinity])");
+			CHECK(!ds::loadVec2(pContext.get(), -1, &result));
+			duk_eval_string(pContext.get(), "new Float64Array([NaN, 1])");
+			CHECK(!ds::loadVec2(pContext.get(), -1, &result));
+		}
+
+		THEN("short or integer typed arrays are rejected")
+		{
+			duk_eval_string(pContext.get(), "new Float32Array([1])");
+			CHECK(!ds::loadVec2(pContext.get(), -1, &result));
+			duk_eval_string(pContext.get(), "new Int32Array([1, 2])");
+			CHECK(!ds::loadVec2(pContext.get(), -1, &result));
+		}
+
+		THEN("only the two coordinates read must be finite")
+		{
+			duk_eval_string(pContext.get(), "new Float32Array([1, 2, NaN])");
+			REQUIRE(ds::loadVec2(pContext.get(), -1, &result));
+			CHECK(result.x == Approx(1.0f));
+			CHECK(result.y == Approx(2.0f));
+		}
+
+		THEN("replacing the global constructors changes nothing")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				var coords = new Float64Array([5, 6]);
+				Float32Array = 1;
+				Float64Array = 2;
+				coords
+			)JS");
+			REQUIRE(ds::loadVec2(pContext.get(), -1, &result));
+			CHECK(result.x == Approx(5.0f));
+			CHECK(result.y == Approx(6.0f));
+		}
+
+		THEN("a misaligned buffer is rejected")
+		{
+			duk_eval_string(pContext.get(), R"JS(
+				var coords = new Uint8Array(new ArrayBuffer(12), 1, 8);
+				Object.setPrototypeOf(coords, Float32Array.prototype);
+				coords
+			)JS");
+			CHECK(!ds::loadVec2(pContext.get(), -1, &result));
+		}
+	}
+}
@@ -4,6 +4,9 @@
 
 #include <duktape.h>
 
+#include "dukdemo/scripting/BodyTable.h"
+#include "dukdemo/scripting/Heap.h"
+#include "dukdemo/scripting/HeapAllocator.h"
 #include "dukdemo/util/deleters.h"
 
 
@@ -14,6 +17,51 @@ using duk_context_ptr =
 	std::unique_ptr<duk_context, dukdemo::util::DukContextDeleter>;
 
 
+/**
+ * A heap set up as the demo's are, on a @ref HeapAllocator and with its own
+ * body table, as the physics bindings need.
+ *
+ * Used like a @ref duk_context_ptr.
+ */
+class Heap
+{
+public:
+	Heap()
+		:	m_allocator{}
+		,	m_bodyTable{}
+		,	m_state{}
+		,	m_pContext{}
+	{
+		m_state.pAllocator = &m_allocator;
+		m_state.pBodyTable = &m_bodyTable;
+		m_pContext.reset(dukdemo::scripting::createHeap(&m_state));
+	}
+
+	inline duk_context*
+	get() const noexcept
+	{ return m_pContext.get(); }
+
+	inline dukdemo::scripting::BodyTable&
+	bodyTable() noexcept
+	{ return m_bodyTable; }
+
+	inline dukdemo::scripting::HeapState&
+	state() noexcept
+	{ return m_state; }
+
+	inline dukdemo::scripting::HeapAllocator const&
+	allocator() const noexcept
+	{ return m_allocator; }
+
+private:
+	// Declared first so that they outlive the heap and its body finalizers.
+	dukdemo::scripting::HeapAllocator m_allocator;
+	dukdemo::scripting::BodyTable m_bodyTable;
+	dukdemo::scripting::HeapState m_state;
+	duk_context_ptr m_pContext;
+};
+
+
 inline void
 pushJSONObject(duk_context* pContext, char const* const pJSON)
 {
@@ -0,0 +1,156 @@
+#include <vector>
+
+#include <catch.hpp>
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+
+#include "dukdemo/sim/FixedStepClock.h"
+#include "dukdemo/sim/TransformHistory.h"
+
+
+using dukdemo::sim::FixedStepClock;
+using dukdemo::sim::TransformHistory;
+
+
+SCENARIO("Converting elapsed time into fixed steps", "[FixedStepClock]")
+{
+	GIVEN("a clock with a quarter-second step")
+	{
+		FixedStepClock clock{0.25, 4u};
+
+		WHEN("less than a step has elapsed")
+		{
+			auto const steps = clock.advance(0.125);
+
+			THEN("no step is due, and the time is kept")
+			{
+				CHECK(steps == 0u);
+				CHECK(clock.alpha() == Approx(0.5));
+				CHECK(clock.secondsUntilNextStep() == Approx(0.125));
+			}
+
+			AND_WHEN("the rest of the step elapses")
+			{
+				THEN("a step is due")
+				{
+					CHECK(clock.advance(0.125) == 1u);
+					CHECK(clock.alpha() == Approx(0.0));
+				}
+			}
+		}
+
+		WHEN("several steps have elapsed")
+		{
+			auto const steps = clock.advance(0.8);
+
+			THEN("they are all due, leaving the remainder")
+			{
+				CHECK(steps == 3u);
+				CHECK(clock.alpha() == Approx(0.2));
+				CHECK(clock.droppedSteps() == 0u);
+			}
+		}
+
+		WHEN("more steps have elapsed than the catch-up limit")
+		{
+			auto const steps = clock.advance(2.0);
+
+			THEN("the excess steps are dropped")
+			{
+				CHECK(steps == 4u);
+				CHECK(clock.droppedSteps() == 4u);
+				CHECK(clock.alpha() == Approx(0.0));
+			}
+		}
+
+		WHEN("the clock is reset")
+		{
+			clock.advance(0.2);
+			clock.reset();
+
+			THEN("the accumulated time is discarded")
+			{
+				CHECK(clock.alpha() == Approx(0.0));
+				CHECK(clock.advance(0.2) == 0u);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Interpolating body transforms", "[TransformHistory]")
+{
+	GIVEN("a moving body whose transform has been captured")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		bodyDef.linearVelocity.Set(60.0f, 0.0f);
+		bodyDef.angularVelocity = 6.0f;
+		auto* const pBody = world.CreateBody(&bodyDef);
+
+		TransformHistory history;
+		history.capture(world);
+		world.Step(1.0f / 60.0f, 8, 3);
+
+		WHEN("it is interpolated halfway")
+		{
+			auto const transform = history.interpolate(*pBody, 0.5f);
+
+			THEN("it lies between the captured and current transforms")
+			{
+				CHECK(transform.p.x == Approx(0.5f * pBody->GetPosition().x));
+				CHECK(transform.p.y == Approx(0.0f));
+				CHECK(transform.q.GetAngle() ==
+					Approx(0.5f * pBody->GetAngle()));
+			}
+		}
+
+		WHEN("it is interpolated fully")
+		{
+			auto const transform = history.interpolate(*pBody, 1.0f);
+
+			THEN("it is the current transform")
+			{
+				CHECK(transform.p.x == Approx(pBody->GetPosition().x));
+				CHECK(transform.q.GetAngle() == Approx(pBody->GetAngle()));
+			}
+		}
+
+		WHEN("many more bodies are captured")
+		{
+			std::vector<b2Body*> bodies;
+			for (int i = 0; i < 100; ++i)
+			{
+				bodyDef.position.Set(float(i), 0.0f);
+				bodies.push_back(world.CreateBody(&bodyDef));
+			}
+			history.capture(world);
+			world.Step(1.0f / 60.0f, 8, 3);
+
+			THEN("each body's own pose is found")
+			{
+				for (int i = 0; i < 100; ++i)
+				{
+					auto const pose = history.previous(*bodies[i]);
+					CHECK(pose.position.x == Approx(float(i)));
+				}
+			}
+		}
+
+		WHEN("a body is created after the capture")
+		{
+			b2BodyDef newDef;
+			newDef.position.Set(3.0f, 4.0f);
+			auto* const pNewBody = world.CreateBody(&newDef);
+
+			THEN("its current transform is used")
+			{
+				auto const transform = history.interpolate(*pNewBody, 0.5f);
+				CHECK(transform.p.x == Approx(3.0f));
+				CHECK(transform.p.y == Approx(4.0f));
+			}
+		}
+	}
+}
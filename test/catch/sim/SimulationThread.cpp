@@ -0,0 +1,447 @@
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include <catch.hpp>
+
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "dukdemo/sim/SimulationThread.h"
+#include "dukdemo/sim/Snapshot.h"
+#include "dukdemo/sim/TransformHistory.h"
+#include "dukdemo/sim/VisibleBodies.h"
+
+
+using dukdemo::sim::SimulationThread;
+using dukdemo::sim::Snapshot;
+using dukdemo::sim::TransformHistory;
+using dukdemo::sim::VisibleBodies;
+
+
+constexpr float timeStep = 1.0f / 60.0f;
+
+
+SCENARIO("Capturing world snapshots", "[Snapshot]")
+{
+	GIVEN("a world with a moving body")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		bodyDef.linearVelocity.Set(60.0f, 0.0f);
+		auto* const pBody = world.CreateBody(&bodyDef);
+
+		b2CircleShape circle;
+		circle.m_p.Set(1.0f, 2.0f);
+		circle.m_radius = 0.5f;
+		pBody->CreateFixture(&circle, 1.0f);
+		b2PolygonShape box;
+		box.SetAsBox(1.0f, 1.0f);
+		pBody->CreateFixture(&box, 1.0f);
+
+		TransformHistory history;
+		history.capture(world);
+		world.Step(timeStep, 8, 3);
+
+		WHEN("a snapshot is captured")
+		{
+			Snapshot snapshot;
+			snapshot.capture(world, history, nullptr, 1u);
+			auto const& geometry = snapshot.dynamicGeometry;
+
+			THEN("it holds the body's poses and local geometry")
+			{
+				REQUIRE(geometry.bodies.size() == 1u);
+				auto const& body = geometry.bodies[0];
+				CHECK(body.previous.position.x == Approx(0.0f));
+				CHECK(body.current.position.x ==
+					Approx(pBody->GetPosition().x));
+				CHECK(body.type == b2_dynamicBody);
+				REQUIRE(body.shapeCount == 2u);
+				REQUIRE(geometry.shapes.size() == 2u);
+				CHECK(geometry.vertices.size() == 5u);
+
+				// Fixtures are prepended, so the box comes first.
+				auto const& polygon = geometry.shapesOf(body)[0];
+				CHECK(polygon.type == Snapshot::ShapeType::polygon);
+				CHECK(polygon.vertexCount == 4u);
+				auto const& shape = geometry.shapesOf(body)[1];
+				CHECK(shape.type == Snapshot::ShapeType::circle);
+				CHECK(shape.radius == Approx(0.5f));
+				CHECK(geometry.verticesOf(shape)[0].y == Approx(2.0f));
+			}
+
+			AND_WHEN("it is captured again")
+			{
+				auto const* const pVertices = geometry.vertices.data();
+				snapshot.capture(world, history, snapshot.pStaticGeometry, 1u);
+
+				THEN("the storage is reused")
+				{
+					CHECK(geometry.vertices.data() == pVertices);
+					CHECK(geometry.shapes.size() == 2u);
+				}
+			}
+		}
+	}
+
+	GIVEN("a world with static and dynamic bodies")
+	{
+		b2World world{b2Vec2{0.0f, -10.0f}};
+		b2PolygonShape box;
+		box.SetAsBox(1.0f, 1.0f);
+
+		b2BodyDef groundDef;
+		auto* const pGround = world.CreateBody(&groundDef);
+		pGround->CreateFixture(&box, 0.0f);
+
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		world.CreateBody(&bodyDef)->CreateFixture(&box, 1.0f);
+
+		TransformHistory history;
+		Snapshot first;
+		first.capture(world, history, nullptr, 1u);
+
+		THEN("static bodies are kept apart")
+		{
+			REQUIRE(first.pStaticGeometry);
+			CHECK(first.pStaticGeometry->version == 1u);
+			CHECK(first.pStaticGeometry->geometry.bodies.size() == 1u);
+			CHECK(first.dynamicGeometry.bodies.size() == 1u);
+		}
+
+		WHEN("the world is stepped and captured again")
+		{
+			world.Step(timeStep, 8, 3);
+			Snapshot second;
+			second.capture(world, history, first.pStaticGeometry, 1u);
+
+			THEN("the static geometry is shared")
+			{
+				CHECK(second.pStaticGeometry == first.pStaticGeometry);
+			}
+		}
+
+		WHEN("a static fixture is added without a new version")
+		{
+			b2CircleShape circle;
+			circle.m_radius = 1.0f;
+			pGround->CreateFixture(&circle, 0.0f);
+			Snapshot second;
+			second.capture(world, history, first.pStaticGeometry, 1u);
+
+			THEN("the static geometry isn't walked again")
+			{
+				CHECK(second.pStaticGeometry == first.pStaticGeometry);
+				CHECK(second.pStaticGeometry->geometry.shapes.size() == 1u);
+			}
+		}
+
+		WHEN("a static fixture is added")
+		{
+			b2CircleShape circle;
+			circle.m_radius = 1.0f;
+			pGround->CreateFixture(&circle, 0.0f);
+			Snapshot second;
+			second.capture(world, history, first.pStaticGeometry, 2u);
+
+			THEN("new static geometry is captured")
+			{
+				REQUIRE(second.pStaticGeometry);
+				CHECK(second.pStaticGeometry != first.pStaticGeometry);
+				CHECK(second.pStaticGeometry->version == 2u);
+				CHECK(second.pStaticGeometry->geometry.shapes.size() == 2u);
+			}
+		}
+
+		WHEN("a static body is destroyed")
+		{
+			world.DestroyBody(pGround);
+			Snapshot second;
+			second.capture(world, history, first.pStaticGeometry, 2u);
+
+			THEN("the static geometry is emptied")
+			{
+				REQUIRE(second.pStaticGeometry);
+				CHECK(second.pStaticGeometry->version == 2u);
+				CHECK(second.pStaticGeometry->geometry.bodies.empty());
+			}
+		}
+
+		WHEN("a static fixture is replaced by another shape")
+		{
+			// Box2D is likely to reuse the old fixture's address.
+			pGround->DestroyFixture(pGround->GetFixtureList());
+			b2PolygonShape wide;
+			wide.SetAsBox(2.0f, 1.0f);
+			pGround->CreateFixture(&wide, 0.0f);
+			Snapshot second;
+			second.capture(world, history, first.pStaticGeometry, 2u);
+
+			THEN("new static geometry is captured")
+			{
+				REQUIRE(second.pStaticGeometry);
+				CHECK(second.pStaticGeometry->version == 2u);
+				auto const& vertices =
+					second.pStaticGeometry->geometry.vertices;
+				REQUIRE(!vertices.empty());
+				CHECK(std::abs(vertices.front().x) == Approx(2.0f));
+			}
+		}
+	}
+
+	GIVEN("a paused snapshot")
+	{
+		Snapshot snapshot;
+		snapshot.stepSeconds = timeStep;
+		snapshot.stepTime = Snapshot::Clock::now();
+		snapshot.paused = true;
+
+		THEN("it isn't interpolated")
+		{
+			CHECK(snapshot.alpha(snapshot.stepTime) == 1.0f);
+		}
+
+		WHEN("it is unpaused")
+		{
+			snapshot.paused = false;
+
+			THEN("the factor grows with time until the next step")
+			{
+				auto const halfStep = std::chrono::duration_cast<
+					Snapshot::Clock::duration>(
+						std::chrono::duration<double>{timeStep / 2.0});
+				CHECK(snapshot.alpha(snapshot.stepTime) == 0.0f);
+				CHECK(snapshot.alpha(snapshot.stepTime + halfStep) ==
+					Approx(0.5f));
+				CHECK(snapshot.alpha(snapshot.stepTime + 4 * halfStep) == 1.0f);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Culling bodies outside a view", "[Snapshot]")
+{
+	GIVEN("a world with near and far bodies, and a static ground")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		b2CircleShape circle;
+		circle.m_radius = 0.5f;
+
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		auto* const pNear = world.CreateBody(&bodyDef);
+		pNear->CreateFixture(&circle, 1.0f);
+		pNear->CreateFixture(&circle, 1.0f);
+		bodyDef.position.Set(100.0f, 0.0f);
+		auto* const pFar = world.CreateBody(&bodyDef);
+		pFar->CreateFixture(&circle, 1.0f);
+
+		bodyDef.type = b2_staticBody;
+		bodyDef.position.Set(0.0f, -2.0f);
+		b2PolygonShape box;
+		box.SetAsBox(200.0f, 1.0f);
+		world.CreateBody(&bodyDef)->CreateFixture(&box, 0.0f);
+
+		TransformHistory history;
+		history.capture(world);
+
+		b2AABB view;
+		view.lowerBound.Set(-10.0f, -10.0f);
+		view.upperBound.Set(10.0f, 10.0f);
+
+		WHEN("the view is queried")
+		{
+			VisibleBodies visible;
+			visible.query(world, view);
+
+			THEN("each non-static body in view is found once")
+			{
+				CHECK(visible.size() == 1u);
+				CHECK(visible.contains(*pNear));
+				CHECK_FALSE(visible.contains(*pFar));
+			}
+
+			AND_WHEN("a snapshot is captured with it")
+			{
+				Snapshot snapshot;
+				snapshot.capture(world, history, nullptr, 1u, &visible);
+
+				THEN("only visible bodies are captured, but all static ones")
+				{
+					REQUIRE(snapshot.dynamicGeometry.bodies.size() == 1u);
+					CHECK(snapshot.dynamicGeometry.bodies[0].current.position.x
+						== Approx(0.0f));
+					CHECK(snapshot.drawnFixtures == 2u);
+					CHECK(snapshot.culledBodies == 1u);
+					REQUIRE(snapshot.pStaticGeometry);
+					auto const& ground = snapshot.pStaticGeometry->geometry;
+					CHECK(ground.bodies.size() == 1u);
+				}
+			}
+		}
+
+		WHEN("a snapshot is captured without a view")
+		{
+			Snapshot snapshot;
+			snapshot.capture(world, history, nullptr, 1u);
+
+			THEN("nothing is culled")
+			{
+				CHECK(snapshot.dynamicGeometry.bodies.size() == 2u);
+				CHECK(snapshot.drawnFixtures == 3u);
+				CHECK(snapshot.culledBodies == 0u);
+			}
+		}
+	}
+}
+
+
+/** Wait up to a second for a snapshot matching a predicate. */
+template <typename Predicate>
+Snapshot const&
+waitForSnapshot(SimulationThread& simulation, Predicate const& predicate)
+{
+	auto const deadline =
+		std::chrono::steady_clock::now() + std::chrono::seconds{1};
+	while (true)
+	{
+		auto const& snapshot = simulation.latestSnapshot();
+		if (predicate(snapshot) || std::chrono::steady_clock::now() > deadline)
+		{
+			return snapshot;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+}
+
+
+SCENARIO("Stepping a world on a simulation thread", "[SimulationThread]")
+{
+	GIVEN("a world and a simulation thread")
+	{
+		b2World world{b2Vec2{0.0f, -10.0f}};
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		world.CreateBody(&bodyDef);
+
+		SimulationThread simulation{
+			world,
+			[&world] { world.Step(timeStep, 8, 3); },
+			timeStep
+		};
+
+		WHEN("it runs")
+		{
+			simulation.start();
+			auto const& snapshot = waitForSnapshot(
+				simulation,
+				[](Snapshot const& s) { return s.stepCount >= 3u; });
+
+			THEN("snapshots of the stepped world are published")
+			{
+				CHECK(simulation.running());
+				CHECK(snapshot.stepCount >= 3u);
+				auto const& bodies = snapshot.dynamicGeometry.bodies;
+				REQUIRE(bodies.size() == 1u);
+				CHECK(bodies[0].current.position.y < 0.0f);
+				CHECK(bodies[0].previous.position.y >
+					bodies[0].current.position.y);
+			}
+
+			AND_WHEN("it is paused, then asked to step")
+			{
+				simulation.setPaused(true);
+				auto const pausedSteps = waitForSnapshot(
+					simulation,
+					[](Snapshot const& s) { return s.paused; }).stepCount;
+				simulation.requestStep();
+				auto const& stepped = waitForSnapshot(
+					simulation,
+					[pausedSteps](Snapshot const& s) {
+						return s.stepCount > pausedSteps;
+					});
+
+				THEN("exactly one step is taken")
+				{
+					CHECK(stepped.paused);
+					CHECK(stepped.stepCount == pausedSteps + 1u);
+				}
+			}
+
+			simulation.stop();
+			CHECK_FALSE(simulation.running());
+		}
+	}
+
+	GIVEN("a simulation thread whose step adds a static body")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		SimulationThread* pSimulation = nullptr;
+		SimulationThread simulation{
+			world,
+			[&world, &pSimulation] {
+				if (world.GetBodyCount() == 0)
+				{
+					b2BodyDef groundDef;
+					world.CreateBody(&groundDef);
+					++pSimulation->staticVersion();
+				}
+				world.Step(timeStep, 8, 3);
+			},
+			timeStep
+		};
+		pSimulation = &simulation;
+
+		WHEN("it runs")
+		{
+			simulation.start();
+			auto const& snapshot = waitForSnapshot(
+				simulation,
+				[](Snapshot const& s) { return s.stepCount >= 1u; });
+
+			THEN("the new static geometry is captured")
+			{
+				REQUIRE(snapshot.pStaticGeometry);
+				CHECK(snapshot.pStaticGeometry->version == 2u);
+				CHECK(snapshot.pStaticGeometry->geometry.bodies.size() == 1u);
+			}
+
+			simulation.stop();
+		}
+	}
+
+	GIVEN("a simulation thread whose step fails")
+	{
+		b2World world{b2Vec2{0.0f, 0.0f}};
+		SimulationThread simulation{
+			world,
+			[] { throw std::runtime_error{"step failed"}; },
+			timeStep
+		};
+
+		WHEN("it runs")
+		{
+			simulation.start();
+			auto const deadline =
+				std::chrono::steady_clock::now() + std::chrono::seconds{1};
+			while (simulation.running()
+				&& std::chrono::steady_clock::now() < deadline)
+			{
+				std::this_thread::yield();
+			}
+
+			THEN("it stops, and the error is raised on stopping")
+			{
+				CHECK_FALSE(simulation.running());
+				CHECK_THROWS_AS(simulation.stop(), std::runtime_error);
+			}
+		}
+	}
+}
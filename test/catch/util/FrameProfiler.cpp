@@ -0,0 +1,179 @@
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <catch.hpp>
+
+#include "dukdemo/util/FrameProfiler.h"
+#include "dukdemo/util/RollingHistogram.h"
+
+
+using dukdemo::util::FrameProfiler;
+using dukdemo::util::RollingHistogram;
+
+
+SCENARIO("Keeping a rolling histogram of durations", "[RollingHistogram]")
+{
+	GIVEN("an empty histogram")
+	{
+		RollingHistogram histogram{4u};
+
+		THEN("its statistics are zero")
+		{
+			CHECK(histogram.size() == 0u);
+			CHECK(histogram.mean() == 0.0);
+			CHECK(histogram.max() == 0.0);
+			CHECK(histogram.percentile(50.0) == 0.0);
+		}
+
+		WHEN("fewer samples than the window are added")
+		{
+			histogram.add(1e-3);
+			histogram.add(3e-3);
+			histogram.add(2e-3);
+
+			THEN("every sample is counted")
+			{
+				CHECK(histogram.size() == 3u);
+				CHECK(histogram.mean() == Approx(2e-3));
+				CHECK(histogram.max() == Approx(3e-3));
+				CHECK(histogram.percentile(50.0) == Approx(2e-3));
+				CHECK(histogram.percentile(100.0) == Approx(3e-3));
+				CHECK(histogram.bucket(RollingHistogram::bucketOf(1e-3)) == 1u);
+			}
+
+			AND_WHEN("the window overflows")
+			{
+				histogram.add(4e-3);
+				histogram.add(5e-3);
+
+				THEN("the oldest sample is replaced")
+				{
+					CHECK(histogram.size() == 4u);
+					CHECK(histogram.mean() == Approx(3.5e-3));
+					CHECK(histogram.percentile(0.0) == Approx(2e-3));
+					CHECK(histogram.bucket(
+						RollingHistogram::bucketOf(1e-3)) == 0u);
+				}
+			}
+		}
+	}
+
+	GIVEN("durations across the bucket range")
+	{
+		THEN("each bucket's bound doubles, and the last is unbounded")
+		{
+			CHECK(RollingHistogram::bucketOf(0.0) == 0u);
+			CHECK(RollingHistogram::bucketOf(0.5e-6) == 0u);
+			CHECK(RollingHistogram::bucketOf(1e-6) == 1u);
+			CHECK(RollingHistogram::bucketOf(3e-6) == 2u);
+			CHECK(RollingHistogram::bucketUpperBound(2u) == Approx(4e-6));
+			CHECK(RollingHistogram::bucketOf(100.0) ==
+				RollingHistogram::s_bucketCount - 1u);
+			CHECK(RollingHistogram::bucketUpperBound(
+				RollingHistogram::s_bucketCount - 1u) ==
+				std::numeric_limits<double>::infinity());
+		}
+	}
+}
+
+
+SCENARIO("Timing the phases of frames", "[FrameProfiler]")
+{
+	GIVEN("a profiler")
+	{
+		FrameProfiler profiler{8u};
+
+		THEN("it starts with only the frame phase")
+		{
+			auto const phases = profiler.phases();
+			REQUIRE(phases.size() == 1u);
+			CHECK(phases[FrameProfiler::s_framePhase].name == "frame");
+			CHECK(profiler.frames() == 0u);
+		}
+
+		WHEN("phases are registered")
+		{
+			auto const step = profiler.addPhase("step");
+			auto const draw = profiler.addPhase("draw");
+
+			THEN("each name has one index")
+			{
+				CHECK(step != draw);
+				CHECK(profiler.addPhase("step") == step);
+			}
+
+			AND_WHEN("they are timed over some frames")
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					{
+						FrameProfiler::ScopedTimer timer{&profiler, step};
+						std::this_thread::sleep_for(
+							std::chrono::microseconds{100});
+					}
+					profiler.recordGpu(draw, 2e-3);
+					profiler.endFrame();
+				}
+
+				THEN("their timings are kept")
+				{
+					auto const phases = profiler.phases();
+					CHECK(profiler.frames() == 3u);
+					CHECK(phases[FrameProfiler::s_framePhase].cpu.size() == 2u);
+					CHECK(phases[step].cpu.size() == 3u);
+					CHECK(phases[step].cpu.percentile(0.0) >= 100e-6);
+					CHECK(phases[step].gpu.size() == 0u);
+					CHECK(phases[draw].gpu.mean() == Approx(2e-3));
+				}
+
+				THEN("the report lists every timed phase")
+				{
+					std::ostringstream report;
+					profiler.writeReport(report);
+					auto const text = report.str();
+					auto const npos = std::string::npos;
+					CHECK(text.find("profile_frames: 3") != npos);
+					CHECK(text.find("profile_cpu_ms[step]") != npos);
+					CHECK(text.find("profile_gpu_ms[draw]") != npos);
+					CHECK(text.find("profile_cpu_ms[draw]") == npos);
+				}
+			}
+		}
+
+		WHEN("a counter is recorded over some frames")
+		{
+			auto const drawn = profiler.addCounter("drawn");
+			profiler.recordCount(drawn, 10u);
+			profiler.recordCount(drawn, 20u);
+
+			THEN("its mean and latest value are kept and reported")
+			{
+				CHECK(profiler.addCounter("drawn") == drawn);
+				auto const counters = profiler.counters();
+				REQUIRE(counters.size() == 1u);
+				CHECK(counters[drawn].latest == 20u);
+				CHECK(counters[drawn].mean() == Approx(15.0));
+
+				std::ostringstream report;
+				profiler.writeReport(report);
+				CHECK(report.str().find(
+					"profile_count[drawn]: mean 15 latest 20 samples 2") !=
+					std::string::npos);
+			}
+		}
+
+		WHEN("a scoped timer has no profiler")
+		{
+			{
+				FrameProfiler::ScopedTimer timer{nullptr, 0u};
+			}
+
+			THEN("nothing is recorded")
+			{
+				CHECK(profiler.phases()[0].cpu.size() == 0u);
+			}
+		}
+	}
+}
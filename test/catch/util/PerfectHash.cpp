@@ -0,0 +1,51 @@
+#include <catch.hpp>
+
+#include "dukdemo/util/PerfectHash.h"
+
+
+using dukdemo::util::PerfectHash;
+
+
+constexpr PerfectHash<5> names{{{
+	"position", "angle", "awake", "active", "allowSleep",
+}}};
+
+
+// Lookups work at compile time too.
+static_assert(names.find("angle") == 1u, "angle is at index 1");
+static_assert(names.find("bullet") == 5u, "bullet is not a name");
+
+
+SCENARIO("Looking up names in a perfect hash", "[PerfectHash]")
+{
+	GIVEN("a table of names")
+	{
+		THEN("each name maps to its index")
+		{
+			for (std::size_t i = 0u; i < 5u; ++i)
+			{
+				CHECK(names.find(names.name(i)) == i);
+			}
+		}
+
+		THEN("other names are not found")
+		{
+			CHECK(names.find("") == 5u);
+			CHECK(names.find("awak") == 5u);
+			CHECK(names.find("awakes") == 5u);
+			CHECK(names.find("Angle") == 5u);
+		}
+
+		THEN("keys needn't be null terminated")
+		{
+			char const key[] = {'a', 'w', 'a', 'k', 'e', 'n'};
+			CHECK(names.find(key, 5u) == 2u);
+			CHECK(names.find(key, 6u) == 5u);
+		}
+
+		THEN("there are at least twice as many slots as names")
+		{
+			CHECK(PerfectHash<5>::s_slotCount == 16u);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <catch.hpp>
+
+#include "dukdemo/util/Trace.h"
+
+
+namespace trace = dukdemo::util::trace;
+
+
+SCENARIO("Recording a Chrome trace", "[Trace]")
+{
+	GIVEN("an empty trace")
+	{
+		trace::clear();
+		trace::setEnabled(true);
+
+		WHEN("events are recorded on two threads")
+		{
+			auto const start = trace::Clock::now();
+			trace::complete("test", "outer", start, start);
+			trace::instant("test", "mark");
+			std::thread other{[] {
+				trace::setThreadName("worker \"1\"");
+				trace::Scope scope{"test", "inner"};
+			}};
+			other.join();
+
+			std::ostringstream out;
+			trace::writeChromeTrace(out);
+			auto const json = out.str();
+			auto const npos = std::string::npos;
+
+			THEN("they are written as trace events")
+			{
+				CHECK(json.find("\"traceEvents\":[") != npos);
+				CHECK(json.find("\"name\":\"outer\",\"ts\":") != npos);
+				CHECK(json.find("\"ph\":\"X\",\"dur\":0.000}") != npos);
+				CHECK(json.find("\"name\":\"mark\"") != npos);
+				CHECK(json.find("\"ph\":\"i\"") != npos);
+				CHECK(json.find("\"name\":\"inner\"") != npos);
+			}
+
+			THEN("thread names are escaped")
+			{
+				CHECK(json.find("{\"name\":\"worker \\\"1\\\"\"}") != npos);
+			}
+
+			AND_WHEN("the trace is cleared")
+			{
+				trace::clear();
+				std::ostringstream cleared;
+				trace::writeChromeTrace(cleared);
+
+				THEN("no events are left")
+				{
+					CHECK(cleared.str().find("\"name\":\"outer\"") == npos);
+				}
+			}
+		}
+
+		WHEN("recording is disabled")
+		{
+			trace::setEnabled(false);
+			trace::instant("test", "ignored");
+			trace::setEnabled(true);
+
+			std::ostringstream out;
+			trace::writeChromeTrace(out);
+
+			THEN("nothing is recorded")
+			{
+				CHECK(out.str().find("ignored") == std::string::npos);
+			}
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#include <thread>
+
+#include <catch.hpp>
+
+#include "dukdemo/util/TripleBuffer.h"
+
+
+using dukdemo::util::TripleBuffer;
+
+
+SCENARIO("Passing values through a triple buffer", "[TripleBuffer]")
+{
+	GIVEN("an empty buffer")
+	{
+		TripleBuffer<int> buffer;
+
+		THEN("there is nothing new to read")
+		{
+			CHECK_FALSE(buffer.update());
+			CHECK(buffer.readBuffer() == 0);
+		}
+
+		WHEN("a value is published")
+		{
+			buffer.writeBuffer() = 1;
+			buffer.publish();
+
+			THEN("the reader sees it once")
+			{
+				CHECK(buffer.update());
+				CHECK(buffer.readBuffer() == 1);
+				CHECK_FALSE(buffer.update());
+				CHECK(buffer.readBuffer() == 1);
+			}
+		}
+
+		WHEN("several values are published between reads")
+		{
+			for (int i = 1; i <= 3; ++i)
+			{
+				buffer.writeBuffer() = i;
+				buffer.publish();
+			}
+
+			THEN("the reader sees only the latest")
+			{
+				CHECK(buffer.update());
+				CHECK(buffer.readBuffer() == 3);
+			}
+
+			AND_WHEN("the writer carries on")
+			{
+				buffer.writeBuffer() = 4;
+
+				THEN("the read value is untouched until published")
+				{
+					CHECK(buffer.update());
+					CHECK(buffer.readBuffer() == 3);
+					buffer.publish();
+					CHECK(buffer.update());
+					CHECK(buffer.readBuffer() == 4);
+				}
+			}
+		}
+	}
+
+	GIVEN("a writer and a reader on separate threads")
+	{
+		struct Pair
+		{
+			int first;
+			int second;
+		};
+		TripleBuffer<Pair> buffer;
+		constexpr int count = 100000;
+
+		std::thread writer{[&buffer] {
+			for (int i = 1; i <= count; ++i)
+			{
+				auto& pair = buffer.writeBuffer();
+				pair.first = i;
+				pair.second = -i;
+				buffer.publish();
+			}
+		}};
+
+		bool torn = false;
+		bool ordered = true;
+		int last = 0;
+		while (last != count)
+		{
+			if (buffer.update())
+			{
+				auto const& pair = buffer.readBuffer();
+				torn = torn || pair.first != -pair.second;
+				ordered = ordered && pair.first > last;
+				last = pair.first;
+			}
+		}
+		writer.join();
+
+		THEN("every value read is whole, and newer than the last")
+		{
+			CHECK_FALSE(torn);
+			CHECK(ordered);
+		}
+	}
+}